@@ -121,7 +121,8 @@ void Agent::readPendingDatagrams() {
                     _voxelViewer.processDatagram(mutablePacket, sourceNode);
                 }
 
-            } else if (datagramPacketType == PacketTypeMixedAudio) {
+            } else if (datagramPacketType == PacketTypeMixedAudio
+                       || datagramPacketType == PacketTypeSilentAudioFrame) {
                 // parse the data and grab the average loudness
                 _receivedAudioBuffer.parseData(receivedPacket);
                 
@@ -147,6 +148,9 @@ void Agent::readPendingDatagrams() {
             }
         }
     }
+    
+    // let the avatar mixer know which of its avatar packets made it here
+    _avatarHashMap.sendBulkAvatarDataAcks();
 }
 
 const QString AGENT_LOGGING_NAME = "agent";
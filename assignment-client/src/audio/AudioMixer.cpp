@@ -9,7 +9,6 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
-#include <mmintrin.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <fstream>
@@ -29,11 +28,10 @@
 #endif //_WIN32
 
 #include <glm/glm.hpp>
-#include <glm/gtx/norm.hpp>
-#include <glm/gtx/vector_angle.hpp>
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QJsonObject>
+#include <QtCore/QStringList>
 #include <QtCore/QTimer>
 
 #include <Logging.h>
@@ -44,18 +42,20 @@
 #include <StdDev.h>
 #include <UUID.h>
 
+#include "AudioMixKernel.h"
 #include "AudioRingBuffer.h"
+#include "MixedAudioCodec.h"
 #include "AudioMixerClientData.h"
+#include "AudioMixerWorker.h"
 #include "AvatarAudioRingBuffer.h"
 #include "InjectedAudioRingBuffer.h"
 
 #include "AudioMixer.h"
 
-const short JITTER_BUFFER_MSECS = 12;
-const short JITTER_BUFFER_SAMPLES = JITTER_BUFFER_MSECS * (SAMPLE_RATE / 1000.0);
-
 const float LOUDNESS_TO_DISTANCE_RATIO = 0.00305f;
 
+const int TRAILING_AVERAGE_FRAMES = 100;
+
 const QString AUDIO_MIXER_LOGGING_TARGET_NAME = "audio-mixer";
 
 void attachNewBufferToNode(Node *newNode) {
@@ -69,269 +69,261 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
     _trailingSleepRatio(1.0f),
     _minAudibilityThreshold(LOUDNESS_TO_DISTANCE_RATIO / 2.0f),
     _performanceThrottlingRatio(0.0f),
+    _framesSinceCutoffEvent(TRAILING_AVERAGE_FRAMES),
     _numStatFrames(0),
     _sumListeners(0),
-    _sumMixes(0)
+    _sumMixes(0),
+    _sumClusters(0),
+    _sumClusterMixes(0),
+    _frameScheduler(BUFFER_SEND_INTERVAL_USECS),
+    _numMixThreads(1),
+    _mixThreadPool(),
+    _workers(),
+    _frameSources(),
+    _frameSourceGrid(),
+    _frameSourceGeometry(),
+    _frameSourceClusters(),
+    _frameListeners(),
+    _preferredMixedAudioEncoding(MixedAudioEncodingMidSideADPCM),
+    _sumListenerBytes(0),
+    _framePackets(),
+    _framePacketSizes(),
+    _framePacketHeader(),
+    _frameSilentPacketHeader()
 {
     
 }
 
-void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
-                                                          AvatarAudioRingBuffer* listeningNodeBuffer) {
-    float bearingRelativeAngleToSource = 0.0f;
-    float attenuationCoefficient = 1.0f;
-    int numSamplesDelay = 0;
-    float weakChannelAmplitudeRatio = 1.0f;
-    
-    if (bufferToAdd != listeningNodeBuffer) {
-        // if the two buffer pointers do not match then these are different buffers
-        glm::vec3 relativePosition = bufferToAdd->getPosition() - listeningNodeBuffer->getPosition();
-        
-        float distanceBetween = glm::length(relativePosition);
-       
-        if (distanceBetween < EPSILON) {
-            distanceBetween = EPSILON;
-        }
-        
-        if (bufferToAdd->getNextOutputTrailingLoudness() / distanceBetween <= _minAudibilityThreshold) {
-            // according to mixer performance we have decided this does not get to be mixed in
-            // bail out
-            return;
-        }
-        
-        ++_sumMixes;
-        
-        glm::quat inverseOrientation = glm::inverse(listeningNodeBuffer->getOrientation());
-        
-        float distanceSquareToSource = glm::dot(relativePosition, relativePosition);
-        float radius = 0.0f;
-
-        if (bufferToAdd->getType() == PositionalAudioRingBuffer::Injector) {
-            InjectedAudioRingBuffer* injectedBuffer = (InjectedAudioRingBuffer*) bufferToAdd;
-            radius = injectedBuffer->getRadius();
-            attenuationCoefficient *= injectedBuffer->getAttenuationRatio();
-        }
-
-        if (radius == 0 || (distanceSquareToSource > radius * radius)) {
-            // this is either not a spherical source, or the listener is outside the sphere
-
-            if (radius > 0) {
-                // this is a spherical source - the distance used for the coefficient
-                // needs to be the closest point on the boundary to the source
-
-                // ovveride the distance to the node with the distance to the point on the
-                // boundary of the sphere
-                distanceSquareToSource -= (radius * radius);
-
-            } else {
-                // calculate the angle delivery for off-axis attenuation
-                glm::vec3 rotatedListenerPosition = glm::inverse(bufferToAdd->getOrientation()) * relativePosition;
-
-                float angleOfDelivery = glm::angle(glm::vec3(0.0f, 0.0f, -1.0f),
-                                                   glm::normalize(rotatedListenerPosition));
-
-                const float MAX_OFF_AXIS_ATTENUATION = 0.2f;
-                const float OFF_AXIS_ATTENUATION_FORMULA_STEP = (1 - MAX_OFF_AXIS_ATTENUATION) / 2.0f;
-
-                float offAxisCoefficient = MAX_OFF_AXIS_ATTENUATION +
-                    (OFF_AXIS_ATTENUATION_FORMULA_STEP * (angleOfDelivery / PI_OVER_TWO));
-
-                // multiply the current attenuation coefficient by the calculated off axis coefficient
-                attenuationCoefficient *= offAxisCoefficient;
-            }
-
-            glm::vec3 rotatedSourcePosition = inverseOrientation * relativePosition;
-
-            const float DISTANCE_SCALE = 2.5f;
-            const float GEOMETRIC_AMPLITUDE_SCALAR = 0.3f;
-            const float DISTANCE_LOG_BASE = 2.5f;
-            const float DISTANCE_SCALE_LOG = logf(DISTANCE_SCALE) / logf(DISTANCE_LOG_BASE);
-
-            // calculate the distance coefficient using the distance to this node
-            float distanceCoefficient = powf(GEOMETRIC_AMPLITUDE_SCALAR,
-                                             DISTANCE_SCALE_LOG +
-                                             (0.5f * logf(distanceSquareToSource) / logf(DISTANCE_LOG_BASE)) - 1);
-            distanceCoefficient = std::min(1.0f, distanceCoefficient);
-
-            // multiply the current attenuation coefficient by the distance coefficient
-            attenuationCoefficient *= distanceCoefficient;
+AudioMixer::~AudioMixer() {
+    _mixThreadPool.waitForDone();
+    qDeleteAll(_workers);
+}
 
-            // project the rotated source position vector onto the XZ plane
-            rotatedSourcePosition.y = 0.0f;
+void AudioMixer::parsePayload() {
+    // the payload is a space separated list of --option value pairs
+    QStringList payloadArguments = QString(getPayload()).split(" ", QString::SkipEmptyParts);
+    
+    const QString MIX_THREADS_OPTION = "--mixThreads";
+    QString mixThreadsValue = getCmdOption(payloadArguments, MIX_THREADS_OPTION);
+    
+    if (!mixThreadsValue.isEmpty()) {
+        const int MAX_MIX_THREADS = 64;
+        _numMixThreads = glm::clamp(mixThreadsValue.toInt(), 1, MAX_MIX_THREADS);
+    }
+    
+    const QString CLUSTER_CELL_SIZE_OPTION = "--clusterCellSize";
+    QString clusterCellSizeValue = getCmdOption(payloadArguments, CLUSTER_CELL_SIZE_OPTION);
+    
+    if (!clusterCellSizeValue.isEmpty()) {
+        const float MIN_CLUSTER_CELL_SIZE = 1.0f;
+        _frameSourceClusters.setCellSize(std::max(clusterCellSizeValue.toFloat(), MIN_CLUSTER_CELL_SIZE));
+    }
+    
+    // mixed audio goes out compressed to the clients that can decode it, unless this asks for raw frames
+    const QString MIXED_AUDIO_ENCODING_OPTION = "--mixedAudioEncoding";
+    const QString RAW_MIXED_AUDIO_ENCODING = "raw";
+    
+    if (getCmdOption(payloadArguments, MIXED_AUDIO_ENCODING_OPTION) == RAW_MIXED_AUDIO_ENCODING) {
+        _preferredMixedAudioEncoding = MixedAudioEncodingRaw;
+    }
+    
+    // an angular threshold of zero turns far-field clustering off
+    const QString CLUSTER_ANGULAR_THRESHOLD_OPTION = "--clusterAngularThreshold";
+    QString clusterAngularThresholdValue = getCmdOption(payloadArguments, CLUSTER_ANGULAR_THRESHOLD_OPTION);
+    
+    if (!clusterAngularThresholdValue.isEmpty()) {
+        const float MAX_CLUSTER_ANGULAR_THRESHOLD = 0.5f;
+        _frameSourceClusters.setAngularThreshold(glm::clamp(clusterAngularThresholdValue.toFloat(),
+                                                            0.0f, MAX_CLUSTER_ANGULAR_THRESHOLD));
+    }
+    
+    // keeps the thread that paces the frames on one core, so it is not migrated away from its warm cache
+    const QString PIN_TO_CORE_OPTION = "--pinToCore";
+    QString pinToCoreValue = getCmdOption(payloadArguments, PIN_TO_CORE_OPTION);
+    
+    if (!pinToCoreValue.isEmpty()) {
+        _frameScheduler.setPinnedCore(pinToCoreValue.toInt());
+    }
+}
 
-            // produce an oriented angle about the y-axis
-            bearingRelativeAngleToSource = glm::orientedAngle(glm::vec3(0.0f, 0.0f, -1.0f),
-                                                              glm::normalize(rotatedSourcePosition),
-                                                              glm::vec3(0.0f, 1.0f, 0.0f));
+void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
+                                                          const SpatializedMixParameters& mixParameters,
+                                                          int32_t* mixBus) const {
+    int numSamplesDelay = mixParameters.numSamplesDelay;
+    
+    // if there is a sample delay for this buffer, we need the samples prior to the nextOutput
+    // to stick at the beginning of the delayed channel
+    int16_t delayHistory[SAMPLE_PHASE_DELAY_AT_90];
+    for (int i = 0; i < numSamplesDelay; i++) {
+        delayHistory[i] = (*bufferToAdd)[i - numSamplesDelay];
+    }
+    
+    AudioMixKernel::addSpatializedFrame(mixBus, bufferToAdd->getNextOutput(), delayHistory, mixParameters);
+}
 
-            const float PHASE_AMPLITUDE_RATIO_AT_90 = 0.5;
+void AudioMixer::addClusterToMixForListeningNode(const AudioSourceCluster& cluster,
+                                                 const SpatializedMixParameters& mixParameters,
+                                                 int32_t* mixBus) const {
+    SpatializedMixParameters clusterParameters = mixParameters;
+    clusterParameters.attenuationCoefficient *= cluster.submixGain;
+    
+    // the submix keeps its own history ahead of the frame for the delayed channel
+    const int16_t* frameSamples = cluster.submix + SAMPLE_PHASE_DELAY_AT_90;
+    AudioMixKernel::addSpatializedFrame(mixBus, frameSamples, frameSamples - mixParameters.numSamplesDelay,
+                                        clusterParameters);
+}
 
-            // figure out the number of samples of delay and the ratio of the amplitude
-            // in the weak channel for audio spatialization
-            float sinRatio = fabsf(sinf(bearingRelativeAngleToSource));
-            numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90 * sinRatio;
-            weakChannelAmplitudeRatio = 1 - (PHASE_AMPLITUDE_RATIO_AT_90 * sinRatio);
+bool AudioMixer::isClusterFarFieldForListeningNode(int clusterIndex, const Node* node,
+                                                   const glm::vec3& listenerPosition) const {
+    if (!_frameSourceClusters.isFarFieldForListener(clusterIndex, listenerPosition)) {
+        return false;
+    }
+    
+    // a node's own sources are left out of its mix, which a submix cannot do
+    const int* clusterSources = _frameSourceClusters.getClusterSources(clusterIndex);
+    for (int i = 0; i < _frameSourceClusters.getNumClusterSources(clusterIndex); i++) {
+        if (_frameSources[clusterSources[i]].node == node) {
+            return false;
         }
     }
+    
+    return true;
+}
 
-    // if the bearing relative angle to source is > 0 then the delayed channel is the right one
-    int delayedChannelOffset = (bearingRelativeAngleToSource > 0.0f) ? 1 : 0;
-    int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+int AudioMixer::prepareMixForListeningNode(const Node* node, int32_t* mixBus, AudioMixerListenerScratch& scratch,
+                                           int& numClusterMixes) const {
+    AvatarAudioRingBuffer* nodeRingBuffer = ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer();
     
-    const int16_t* nextOutputStart = bufferToAdd->getNextOutput();
-   
-    const int16_t* bufferStart = bufferToAdd->getBuffer();
-    int ringBufferSampleCapacity = bufferToAdd->getSampleCapacity();
+    // zero out the client mix bus for this node, including the tail the delayed channel spills into
+    AudioMixKernel::clearMixBus(mixBus);
 
-    int16_t correctBufferSample[2], delayBufferSample[2];
-    int delayedChannelIndex = 0;
+    // find the buffers that have sufficient audio to mix and are close enough to be heard
+    QVector<int>& candidateIndices = scratch.candidateSourceIndices;
+    _frameSourceGrid.findPotentiallyAudibleSources(nodeRingBuffer->getPosition(), candidateIndices);
     
-    const int SINGLE_STEREO_OFFSET = 2;
+    // clusters far enough away are mixed from their submix, they follow the sources in the frame geometry
+    QVector<bool>& isClusterFarField = scratch.isClusterFarField;
+    isClusterFarField.resize(_frameSourceClusters.getNumClusters());
     
-    for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
-        
-        // setup the int16_t variables for the two sample sets
-        correctBufferSample[0] = nextOutputStart[s / 2] * attenuationCoefficient;
-        correctBufferSample[1] = nextOutputStart[(s / 2) + 1] * attenuationCoefficient;
-        
-        delayedChannelIndex = s + (numSamplesDelay * 2) + delayedChannelOffset;
-        
-        delayBufferSample[0] = correctBufferSample[0] * weakChannelAmplitudeRatio;
-        delayBufferSample[1] = correctBufferSample[1] * weakChannelAmplitudeRatio;
-        
-        __m64 bufferSamples = _mm_set_pi16(_clientSamples[s + goodChannelOffset],
-                                           _clientSamples[s + goodChannelOffset + SINGLE_STEREO_OFFSET],
-                                           _clientSamples[delayedChannelIndex],
-                                           _clientSamples[delayedChannelIndex + SINGLE_STEREO_OFFSET]);
-        __m64 addedSamples = _mm_set_pi16(correctBufferSample[0], correctBufferSample[1],
-                                         delayBufferSample[0], delayBufferSample[1]);
-        
-        // perform the MMX add (with saturation) of two correct and delayed samples
-        __m64 mmxResult = _mm_adds_pi16(bufferSamples, addedSamples);
-        int16_t* shortResults = reinterpret_cast<int16_t*>(&mmxResult);
-        
-        // assign the results from the result of the mmx arithmetic
-        _clientSamples[s + goodChannelOffset] = shortResults[3];
-        _clientSamples[s + goodChannelOffset + SINGLE_STEREO_OFFSET] = shortResults[2];
-        _clientSamples[delayedChannelIndex] = shortResults[1];
-        _clientSamples[delayedChannelIndex + SINGLE_STEREO_OFFSET] = shortResults[0];
+    for (int i = 0; i < isClusterFarField.size(); i++) {
+        isClusterFarField[i] = isClusterFarFieldForListeningNode(i, node, nodeRingBuffer->getPosition());
     }
     
-    // The following code is pretty gross and redundant, but AFAIK it's the best way to avoid
-    // too many conditionals in handling the delay samples at the beginning of _clientSamples.
-    // Basically we try to take the samples in batches of four, and then handle the remainder
-    // conditionally to get rid of the rest.
-    
-    const int DOUBLE_STEREO_OFFSET = 4;
-    const int TRIPLE_STEREO_OFFSET = 6;
-    
-    if (numSamplesDelay > 0) {
-        // if there was a sample delay for this buffer, we need to pull samples prior to the nextOutput
-        // to stick at the beginning
-        float attenuationAndWeakChannelRatio = attenuationCoefficient * weakChannelAmplitudeRatio;
-        const int16_t* delayNextOutputStart = nextOutputStart - numSamplesDelay;
-        if (delayNextOutputStart < bufferStart) {
-            delayNextOutputStart = bufferStart + ringBufferSampleCapacity - numSamplesDelay;
-        }
-        
-        int i = 0;
+    // drop this node's own buffers, unless it asked to hear itself, and the sources already in a far-field submix
+    int listenerSourceIndex = -1;
+    int numCandidates = 0;
+    
+    for (int i = 0; i < candidateIndices.size(); i++) {
+        const AudioMixerSource& source = _frameSources[candidateIndices[i]];
+        int clusterIndex = _frameSourceClusters.getClusterIndexForSource(candidateIndices[i]);
         
-        while (i + 3 < numSamplesDelay) {
-            // handle the first cases where we can MMX add four samples at once
-            int parentIndex = i * 2;
-            __m64 bufferSamples = _mm_set_pi16(_clientSamples[parentIndex + delayedChannelOffset],
-                                               _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset],
-                                               _clientSamples[parentIndex + DOUBLE_STEREO_OFFSET + delayedChannelOffset],
-                                               _clientSamples[parentIndex + TRIPLE_STEREO_OFFSET + delayedChannelOffset]);
-            __m64 addSamples = _mm_set_pi16(delayNextOutputStart[i] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 1] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 2] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 3] * attenuationAndWeakChannelRatio);
-            __m64 mmxResult = _mm_adds_pi16(bufferSamples, addSamples);
-            int16_t* shortResults = reinterpret_cast<int16_t*>(&mmxResult);
-            
-            _clientSamples[parentIndex + delayedChannelOffset] = shortResults[3];
-            _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[2];
-            _clientSamples[parentIndex + DOUBLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[1];
-            _clientSamples[parentIndex + TRIPLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[0];
-            
-            // push the index
-            i += 4;
+        if (clusterIndex != -1 && isClusterFarField[clusterIndex]) {
+            continue;
         }
         
-        int parentIndex = i * 2;
+        if (source.node != node || source.ringBuffer->shouldLoopbackForNode()) {
+            if (source.ringBuffer == nodeRingBuffer) {
+                listenerSourceIndex = candidateIndices[i];
+            }
+            candidateIndices[numCandidates++] = candidateIndices[i];
+        }
+    }
+    candidateIndices.resize(numCandidates);
+    
+    for (int i = 0; i < isClusterFarField.size(); i++) {
+        if (isClusterFarField[i]) {
+            candidateIndices.append(_frameSources.size() + i);
+        }
+    }
+    
+    _frameSourceGeometry.computeAudibleMixParameters(nodeRingBuffer->getPosition(), nodeRingBuffer->getOrientation(),
+                                                     _minAudibilityThreshold, candidateIndices, listenerSourceIndex,
+                                                     scratch.audibleSourceIndices, scratch.audibleParameters);
+    
+    numClusterMixes = 0;
+    
+    for (int i = 0; i < scratch.audibleSourceIndices.size(); i++) {
+        int sourceIndex = scratch.audibleSourceIndices[i];
         
-        if (i + 2 < numSamplesDelay) {
-            // MMX add only three delayed samples
-            
-            __m64 bufferSamples = _mm_set_pi16(_clientSamples[parentIndex + delayedChannelOffset],
-                                               _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset],
-                                               _clientSamples[parentIndex + DOUBLE_STEREO_OFFSET + delayedChannelOffset],
-                                               0);
-            __m64 addSamples = _mm_set_pi16(delayNextOutputStart[i] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 1] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 2] * attenuationAndWeakChannelRatio,
-                                            0);
-            __m64 mmxResult = _mm_adds_pi16(bufferSamples, addSamples);
-            int16_t* shortResults = reinterpret_cast<int16_t*>(&mmxResult);
-            
-            _clientSamples[parentIndex + delayedChannelOffset] = shortResults[3];
-            _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[2];
-            _clientSamples[parentIndex + DOUBLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[1];
-            
-        } else if (i + 1 < numSamplesDelay) {
-            // MMX add two delayed samples
-            __m64 bufferSamples = _mm_set_pi16(_clientSamples[parentIndex + delayedChannelOffset],
-                                               _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset], 0, 0);
-            __m64 addSamples = _mm_set_pi16(delayNextOutputStart[i] * attenuationAndWeakChannelRatio,
-                                            delayNextOutputStart[i + 1] * attenuationAndWeakChannelRatio, 0, 0);
-            
-            __m64 mmxResult = _mm_adds_pi16(bufferSamples, addSamples);
-            int16_t* shortResults = reinterpret_cast<int16_t*>(&mmxResult);
-            
-            _clientSamples[parentIndex + delayedChannelOffset] = shortResults[3];
-            _clientSamples[parentIndex + SINGLE_STEREO_OFFSET + delayedChannelOffset] = shortResults[2];
-            
-        } else if (i < numSamplesDelay) {
-            // MMX add a single delayed sample
-            __m64 bufferSamples = _mm_set_pi16(_clientSamples[parentIndex + delayedChannelOffset], 0, 0, 0);
-            __m64 addSamples = _mm_set_pi16(delayNextOutputStart[i] * attenuationAndWeakChannelRatio, 0, 0, 0);
-            
-            __m64 mmxResult = _mm_adds_pi16(bufferSamples, addSamples);
-            int16_t* shortResults = reinterpret_cast<int16_t*>(&mmxResult);
-            
-            _clientSamples[parentIndex + delayedChannelOffset] = shortResults[3];
+        if (sourceIndex < _frameSources.size()) {
+            addBufferToMixForListeningNodeWithBuffer(_frameSources[sourceIndex].ringBuffer,
+                                                     scratch.audibleParameters[i], mixBus);
+        } else {
+            addClusterToMixForListeningNode(_frameSourceClusters.getCluster(sourceIndex - _frameSources.size()),
+                                            scratch.audibleParameters[i], mixBus);
+            ++numClusterMixes;
         }
     }
+    
+    // the listener hearing itself does not count as a mix
+    return scratch.audibleSourceIndices.size() - (listenerSourceIndex != -1 ? 1 : 0);
 }
 
-void AudioMixer::prepareMixForListeningNode(Node* node) {
-    AvatarAudioRingBuffer* nodeRingBuffer = ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer();
-
-    // zero out the client mix for this node
-    memset(_clientSamples, 0, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-
-    // loop through all other nodes that have sufficient audio to mix
-    foreach (const SharedNodePointer& otherNode, NodeList::getInstance()->getNodeHash()) {
-        if (otherNode->getLinkedData()) {
-
-            AudioMixerClientData* otherNodeClientData = (AudioMixerClientData*) otherNode->getLinkedData();
-
-            // enumerate the ARBs attached to the otherNode and add all that should be added to mix
-            for (unsigned int i = 0; i < otherNodeClientData->getRingBuffers().size(); i++) {
-                PositionalAudioRingBuffer* otherNodeBuffer = otherNodeClientData->getRingBuffers()[i];
-
-                if ((*otherNode != *node
-                     || otherNodeBuffer->shouldLoopbackForNode())
-                    && otherNodeBuffer->willBeAddedToMix()
-                    && otherNodeBuffer->getNextOutputTrailingLoudness() > 0) {
-                    addBufferToMixForListeningNodeWithBuffer(otherNodeBuffer, nodeRingBuffer);
+void AudioMixer::prepareFrameSnapshot(const NodeHash& nodeHash) {
+    _frameSources.clear();
+    _frameSourceGeometry.clear();
+    _frameListeners.clear();
+    
+    foreach (const SharedNodePointer& node, nodeHash) {
+        AudioMixerClientData* clientData = (AudioMixerClientData*) node->getLinkedData();
+        
+        if (clientData) {
+            // enumerate the ARBs attached to the node and keep all that should be added to mix
+            for (unsigned int i = 0; i < clientData->getRingBuffers().size(); i++) {
+                PositionalAudioRingBuffer* ringBuffer = clientData->getRingBuffers()[i];
+                
+                if (ringBuffer->willBeAddedToMix() && ringBuffer->getNextOutputTrailingLoudness() > 0) {
+                    AudioMixerSource source = { ringBuffer, node.data() };
+                    _frameSources.append(source);
+                    _frameSourceGeometry.addSource(ringBuffer);
                 }
             }
+            
+            if (node->getType() == NodeType::Agent && node->getActiveSocket() && clientData->getAvatarAudioRingBuffer()) {
+                _frameListeners.append(node);
+            }
         }
     }
+    
+    // the threshold already includes any performance throttling, so the grid backs off with it
+    _frameSourceGrid.rebuild(_frameSources, _minAudibilityThreshold);
+    
+    _frameSourceClusters.rebuild(_frameSources, _frameSourceGeometry);
+    
+    for (int i = 0; i < _frameSourceClusters.getNumClusters(); i++) {
+        const AudioSourceCluster& cluster = _frameSourceClusters.getCluster(i);
+        _frameSourceGeometry.addOmnidirectionalSource(cluster.position, cluster.loudness);
+    }
 }
 
+void AudioMixer::mixFrameSnapshot() {
+    // every mixed audio packet starts with the same header, so it only needs to be built once per frame
+    populatePacketHeader(_framePacketHeader, PacketTypeMixedAudio);
+    populatePacketHeader(_frameSilentPacketHeader, PacketTypeSilentAudioFrame);
+    
+    _framePackets.resize(_frameListeners.size() * getMaxFramePacketBytes());
+    _framePacketSizes.resize(_frameListeners.size());
+    
+    // the mixer thread takes the first share itself, the pool takes the rest
+    for (int i = 1; i < _workers.size(); i++) {
+        _mixThreadPool.start(_workers[i]);
+    }
+    
+    _workers[0]->run();
+    _mixThreadPool.waitForDone();
+    
+    for (int i = 0; i < _workers.size(); i++) {
+        _sumMixes += _workers[i]->getNumMixes();
+        _sumClusterMixes += _workers[i]->getNumClusterMixes();
+    }
+    
+    _sumClusters += _frameSourceClusters.getNumClusters();
+}
+
+int AudioMixer::getMaxFramePacketBytes() const {
+    return std::max(_framePacketHeader.size() + MAX_NUM_BYTES_MIXED_AUDIO_FRAME,
+                    _frameSilentPacketHeader.size() + (int) sizeof(int16_t));
+}
 
 void AudioMixer::readPendingDatagrams() {
     QByteArray receivedPacket;
@@ -365,121 +357,180 @@ void AudioMixer::sendStatsPacket() {
     
     if (_sumListeners > 0) {
         statsObject["average_mixes_per_listener"] = (float) _sumMixes / (float) _sumListeners;
+        statsObject["average_cluster_mixes_per_listener"] = (float) _sumClusterMixes / (float) _sumListeners;
     } else {
         statsObject["average_mixes_per_listener"] = 0.0;
+        statsObject["average_cluster_mixes_per_listener"] = 0.0;
+    }
+    
+    if (_sumListeners > 0) {
+        statsObject["average_bytes_per_listener"] = (float) _sumListenerBytes / (float) _sumListeners;
+    } else {
+        statsObject["average_bytes_per_listener"] = 0.0;
     }
     
+    statsObject["cluster_cell_size"] = _frameSourceClusters.getCellSize();
+    statsObject["cluster_angular_threshold"] = _frameSourceClusters.getAngularThreshold();
+    statsObject["average_clusters_per_frame"] = (float) _sumClusters / (float) _numStatFrames;
+    
+    // the jitter buffer of every stream, by the node sending it
+    QJsonObject jitterBuffersObject;
+    
+    foreach (const SharedNodePointer& node, NodeList::getInstance()->getNodeHash()) {
+        if (node->getLinkedData()) {
+            jitterBuffersObject[uuidStringWithoutCurlyBraces(node->getUUID())] =
+                ((AudioMixerClientData*) node->getLinkedData())->getJitterBufferStats();
+        }
+    }
+    
+    statsObject["jitter_buffers"] = jitterBuffersObject;
+    
+    // how late the mixer woke up for its frames, in buckets bounded by FRAME_LATENESS_BUCKET_USECS
+    statsObject["frame_scheduler"] = _frameScheduler.getStats();
+    _frameScheduler.resetStats();
+    
 //    ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
     
     _sumListeners = 0;
     _sumMixes = 0;
+    _sumClusters = 0;
+    _sumClusterMixes = 0;
+    _sumListenerBytes = 0;
     _numStatFrames = 0;
 }
 
+void AudioMixer::prepareToMix() {
+    parsePayload();
+    
+    // the mixer thread does one share of the mixing, the pool threads stay alive for the rest
+    _mixThreadPool.setMaxThreadCount(std::max(_numMixThreads - 1, 1));
+    _mixThreadPool.setExpiryTimeout(-1);
+    
+    for (int i = 0; i < _numMixThreads; i++) {
+        _workers.append(new AudioMixerWorker(this, i, _numMixThreads));
+    }
+    
+    qDebug() << "Mixing listeners on" << _numMixThreads << "thread(s).";
+}
+
+void AudioMixer::updatePerformanceThrottling(int usecToSleep) {
+    const float STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.10f;
+    const float BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.20f;
+    
+    const float RATIO_BACK_OFF = 0.02f;
+    
+    const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
+    const float PREVIOUS_FRAMES_RATIO = 1.0f - CURRENT_FRAME_RATIO;
+    
+    if (usecToSleep < 0) {
+        usecToSleep = 0;
+    }
+    
+    _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
+        + (usecToSleep * CURRENT_FRAME_RATIO / (float) BUFFER_SEND_INTERVAL_USECS);
+    
+    float lastCutoffRatio = _performanceThrottlingRatio;
+    bool hasRatioChanged = false;
+    
+    if (_framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
+        if (_trailingSleepRatio <= STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD) {
+            // we're struggling - change our min required loudness to reduce some load
+            _performanceThrottlingRatio = _performanceThrottlingRatio + (0.5f * (1.0f - _performanceThrottlingRatio));
+            
+            qDebug() << "Mixer is struggling, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
+                << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
+            hasRatioChanged = true;
+        } else if (_trailingSleepRatio >= BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD && _performanceThrottlingRatio != 0) {
+            // we've recovered and can back off the required loudness
+            _performanceThrottlingRatio = _performanceThrottlingRatio - RATIO_BACK_OFF;
+            
+            if (_performanceThrottlingRatio < 0) {
+                _performanceThrottlingRatio = 0;
+            }
+            
+            qDebug() << "Mixer is recovering, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
+                << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
+            hasRatioChanged = true;
+        }
+        
+        if (hasRatioChanged) {
+            // set out min audability threshold from the new ratio
+            _minAudibilityThreshold = LOUDNESS_TO_DISTANCE_RATIO / (2.0f * (1.0f - _performanceThrottlingRatio));
+            qDebug() << "Minimum audability required to be mixed is now" << _minAudibilityThreshold;
+            
+            _framesSinceCutoffEvent = 0;
+        }
+    }
+    
+    if (!hasRatioChanged) {
+        ++_framesSinceCutoffEvent;
+    }
+}
+
+int AudioMixer::mixFrame(const NodeHash& nodeHash) {
+    foreach (const SharedNodePointer& node, nodeHash) {
+        if (node->getLinkedData()) {
+            ((AudioMixerClientData*) node->getLinkedData())->checkBuffersBeforeFrameSend();
+        }
+    }
+    
+    int previousSumMixes = _sumMixes;
+    
+    // nothing below reads the network until the buffers are pushed, so this snapshot holds for the whole mix
+    prepareFrameSnapshot(nodeHash);
+    mixFrameSnapshot();
+    
+    NodeList* nodeList = NodeList::getInstance();
+    int maxFramePacketBytes = getMaxFramePacketBytes();
+    
+    // every listener's packet for this frame goes out together
+    nodeList->beginDatagramBatch();
+    
+    for (int i = 0; i < _frameListeners.size(); i++) {
+        nodeList->writeDatagram(&_framePackets[i * maxFramePacketBytes], _framePacketSizes[i], _frameListeners[i]);
+        _sumListenerBytes += _framePacketSizes[i];
+    }
+    
+    nodeList->flushDatagramBatch();
+    
+    _sumListeners += _frameListeners.size();
+    
+    // push forward the next output pointers for any audio buffers we used
+    foreach (const SharedNodePointer& node, nodeHash) {
+        if (node->getLinkedData()) {
+            ((AudioMixerClientData*) node->getLinkedData())->pushBuffersAfterFrameSend();
+        }
+    }
+    
+    ++_numStatFrames;
+    
+    return _sumMixes - previousSumMixes;
+}
+
 void AudioMixer::run() {
 
     ThreadedAssignment::commonInit(AUDIO_MIXER_LOGGING_TARGET_NAME, NodeType::AudioMixer);
+    
+    qDebug() << "Mixing with the" << AudioMixKernel::getInstructionSetName(AudioMixKernel::getBestAvailableInstructionSet())
+        << "kernel.";
 
     NodeList* nodeList = NodeList::getInstance();
 
     nodeList->addNodeTypeToInterestSet(NodeType::Agent);
 
     nodeList->linkedDataCreateCallback = attachNewBufferToNode;
-
-    int nextFrame = 0;
-    QElapsedTimer timer;
-    timer.start();
     
-    char* clientMixBuffer = new char[NETWORK_BUFFER_LENGTH_BYTES_STEREO
-                                     + numBytesForPacketHeaderGivenPacketType(PacketTypeMixedAudio)];
+    prepareToMix();
+
+    _frameScheduler.start();
     
     int usecToSleep = BUFFER_SEND_INTERVAL_USECS;
-    
-    const int TRAILING_AVERAGE_FRAMES = 100;
-    int framesSinceCutoffEvent = TRAILING_AVERAGE_FRAMES;
 
     while (!_isFinished) {
         
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-            if (node->getLinkedData()) {
-                ((AudioMixerClientData*) node->getLinkedData())->checkBuffersBeforeFrameSend(JITTER_BUFFER_SAMPLES);
-            }
-        }
-        
-        const float STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.10f;
-        const float BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.20f;
-        
-        const float RATIO_BACK_OFF = 0.02f;
-        
-        const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
-        const float PREVIOUS_FRAMES_RATIO = 1.0f - CURRENT_FRAME_RATIO;
-        
-        if (usecToSleep < 0) {
-            usecToSleep = 0;
-        }
-        
-        _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
-            + (usecToSleep * CURRENT_FRAME_RATIO / (float) BUFFER_SEND_INTERVAL_USECS);
+        updatePerformanceThrottling(usecToSleep);
         
-        float lastCutoffRatio = _performanceThrottlingRatio;
-        bool hasRatioChanged = false;
-        
-        if (framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
-            if (_trailingSleepRatio <= STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD) {
-                // we're struggling - change our min required loudness to reduce some load
-                _performanceThrottlingRatio = _performanceThrottlingRatio + (0.5f * (1.0f - _performanceThrottlingRatio));
-                
-                qDebug() << "Mixer is struggling, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
-                    << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
-                hasRatioChanged = true;
-            } else if (_trailingSleepRatio >= BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD && _performanceThrottlingRatio != 0) {
-                // we've recovered and can back off the required loudness
-                _performanceThrottlingRatio = _performanceThrottlingRatio - RATIO_BACK_OFF;
-                
-                if (_performanceThrottlingRatio < 0) {
-                    _performanceThrottlingRatio = 0;
-                }
-                
-                qDebug() << "Mixer is recovering, sleeping" << _trailingSleepRatio * 100 << "% of frame time. Old cutoff was"
-                    << lastCutoffRatio << "and is now" << _performanceThrottlingRatio;
-                hasRatioChanged = true;
-            }
-            
-            if (hasRatioChanged) {
-                // set out min audability threshold from the new ratio
-                _minAudibilityThreshold = LOUDNESS_TO_DISTANCE_RATIO / (2.0f * (1.0f - _performanceThrottlingRatio));
-                qDebug() << "Minimum audability required to be mixed is now" << _minAudibilityThreshold;
-                
-                framesSinceCutoffEvent = 0;
-            }
-        }
-        
-        if (!hasRatioChanged) {
-            ++framesSinceCutoffEvent;
-        }
-        
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-            if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData()
-                && ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer()) {
-                prepareMixForListeningNode(node.data());
-                
-                int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
-
-                memcpy(clientMixBuffer + numBytesPacketHeader, _clientSamples, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-                nodeList->writeDatagram(clientMixBuffer, NETWORK_BUFFER_LENGTH_BYTES_STEREO + numBytesPacketHeader, node);
-                
-                ++_sumListeners;
-            }
-        }
-
-        // push forward the next output pointers for any audio buffers we used
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-            if (node->getLinkedData()) {
-                ((AudioMixerClientData*) node->getLinkedData())->pushBuffersAfterFrameSend();
-            }
-        }
-        
-        ++_numStatFrames;
+        mixFrame(nodeList->getNodeHash());
         
         QCoreApplication::processEvents();
         
@@ -487,12 +538,6 @@ void AudioMixer::run() {
             break;
         }
 
-        usecToSleep = (++nextFrame * BUFFER_SEND_INTERVAL_USECS) - timer.nsecsElapsed() / 1000; // ns to us
-
-        if (usecToSleep > 0) {
-            usleep(usecToSleep);
-        }
+        usecToSleep = _frameScheduler.waitForNextFrame();
     }
-    
-    delete[] clientMixBuffer;
 }
@@ -12,20 +12,60 @@
 #ifndef hifi_AudioMixer_h
 #define hifi_AudioMixer_h
 
+#include <vector>
+
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <AudioMixKernel.h>
 #include <AudioRingBuffer.h>
+#include <AudioSourceGeometry.h>
+#include <MixedAudioCodec.h>
 
+#include <FrameScheduler.h>
 #include <ThreadedAssignment.h>
 
+#include "AudioSourceClusters.h"
+#include "AudioSourceGrid.h"
+
+class AudioMixerWorker;
 class PositionalAudioRingBuffer;
 class AvatarAudioRingBuffer;
 
-const int SAMPLE_PHASE_DELAY_AT_90 = 20;
+/// A ring buffer that will be mixed this frame, captured once checkBuffersBeforeFrameSend has run.
+/// The buffers are only read until pushBuffersAfterFrameSend, so workers can share them without locking.
+struct AudioMixerSource {
+    PositionalAudioRingBuffer* ringBuffer;
+    const Node* node;
+};
+
+/// Space reused from listener to listener by the thread mixing them, so preparing a mix does not allocate.
+struct AudioMixerListenerScratch {
+    QVector<int> candidateSourceIndices;
+    QVector<int> audibleSourceIndices;
+    QVector<SpatializedMixParameters> audibleParameters;
+    QVector<bool> isClusterFarField;
+};
 
 /// Handles assignments of type AudioMixer - mixing streams of audio and re-distributing to various clients.
 class AudioMixer : public ThreadedAssignment {
     Q_OBJECT
 public:
     AudioMixer(const QByteArray& packet);
+    ~AudioMixer();
+    
+    /// reads the payload and starts the mix workers, run() does this before its first frame
+    void prepareToMix();
+    
+    /// readies, mixes and sends one frame to every listener in nodeHash, then moves their buffers on
+    /// returns the number of buffers mixed across all the listeners
+    int mixFrame(const NodeHash& nodeHash);
+    
+    /// adjusts the loudness a source needs to be mixed from how long the last frame left the mixer to sleep
+    void updatePerformanceThrottling(int usecToSleep);
+    
+    float getPerformanceThrottlingRatio() const { return _performanceThrottlingRatio; }
+    float getTrailingSleepRatio() const { return _trailingSleepRatio; }
 public slots:
     /// threaded run of assignment
     void run();
@@ -34,23 +74,67 @@ public slots:
     
     void sendStatsPacket();
 private:
-    /// adds one buffer to the mix for a listening node
+    friend class AudioMixerWorker;
+    
+    void parsePayload();
+    
+    /// freezes the sources and listeners for this frame
+    void prepareFrameSnapshot(const NodeHash& nodeHash);
+    
+    /// mixes every listener in the frame snapshot, across the worker pool if there is one
+    void mixFrameSnapshot();
+    
+    /// the space each listener's packet has in _framePackets
+    int getMaxFramePacketBytes() const;
+    
+    /// adds one buffer to the mix for a listening node with the spatialization computed for that pair
     void addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
-                                                  AvatarAudioRingBuffer* listeningNodeBuffer);
+                                                  const SpatializedMixParameters& mixParameters,
+                                                  int32_t* mixBus) const;
+    
+    /// adds the submix of a far-field cluster to the mix for a listening node
+    void addClusterToMixForListeningNode(const AudioSourceCluster& cluster,
+                                         const SpatializedMixParameters& mixParameters,
+                                         int32_t* mixBus) const;
     
-    /// prepares and sends a mix to one Node
-    void prepareMixForListeningNode(Node* node);
+    /// true if the listening node can hear the cluster as one source
+    bool isClusterFarFieldForListeningNode(int clusterIndex, const Node* node, const glm::vec3& listenerPosition) const;
     
-    // client samples capacity is larger than what will be sent to optimize mixing
-    // we are MMX adding 4 samples at a time so we need client samples to have an extra 4
-    int16_t _clientSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    /// prepares a mix for one Node from the frame snapshot on a 32-bit bus, returns the number of buffers mixed
+    /// and sets numClusterMixes to how many of those were far-field submixes
+    int prepareMixForListeningNode(const Node* node, int32_t* mixBus, AudioMixerListenerScratch& scratch,
+                                   int& numClusterMixes) const;
     
     float _trailingSleepRatio;
     float _minAudibilityThreshold;
     float _performanceThrottlingRatio;
+    int _framesSinceCutoffEvent;
     int _numStatFrames;
     int _sumListeners;
     int _sumMixes;
+    int _sumClusters;
+    int _sumClusterMixes;
+    
+    FrameScheduler _frameScheduler;
+    
+    int _numMixThreads;
+    QThreadPool _mixThreadPool;
+    QVector<AudioMixerWorker*> _workers;
+    
+    QVector<AudioMixerSource> _frameSources;
+    AudioSourceGrid _frameSourceGrid;
+    AudioSourceGeometry _frameSourceGeometry;
+    AudioSourceClusters _frameSourceClusters;
+    QVector<SharedNodePointer> _frameListeners;
+    
+    MixedAudioEncoding _preferredMixedAudioEncoding;
+    qint64 _sumListenerBytes;
+    
+    // one mixed audio packet per listener, written by the workers and sent once they have all finished
+    std::vector<char> _framePackets;
+    std::vector<int> _framePacketSizes;
+    QByteArray _framePacketHeader;
+    QByteArray _frameSilentPacketHeader;
 };
 
 #endif // hifi_AudioMixer_h
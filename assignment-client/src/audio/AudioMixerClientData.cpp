@@ -19,7 +19,9 @@
 #include "AudioMixerClientData.h"
 
 AudioMixerClientData::AudioMixerClientData() :
-    _ringBuffers()
+    _ringBuffers(),
+    _mixLimiter(),
+    _mixedAudioEncoder()
 {
     
 }
@@ -53,7 +55,8 @@ int AudioMixerClientData::parseData(const QByteArray& packet) {
 
         if (!avatarRingBuffer) {
             // we don't have an AvatarAudioRingBuffer yet, so add it
-            avatarRingBuffer = new AvatarAudioRingBuffer();
+            // the mixer reads its ring buffers lock-free so that packets can be parsed off the mixing thread
+            avatarRingBuffer = new AvatarAudioRingBuffer(true);
             _ringBuffers.push_back(avatarRingBuffer);
         }
 
@@ -76,7 +79,7 @@ int AudioMixerClientData::parseData(const QByteArray& packet) {
 
         if (!matchingInjectedRingBuffer) {
             // we don't have a matching injected audio ring buffer, so add it
-            matchingInjectedRingBuffer = new InjectedAudioRingBuffer(streamIdentifier);
+            matchingInjectedRingBuffer = new InjectedAudioRingBuffer(streamIdentifier, true);
             _ringBuffers.push_back(matchingInjectedRingBuffer);
         }
 
@@ -86,9 +89,9 @@ int AudioMixerClientData::parseData(const QByteArray& packet) {
     return 0;
 }
 
-void AudioMixerClientData::checkBuffersBeforeFrameSend(int jitterBufferLengthSamples) {
+void AudioMixerClientData::checkBuffersBeforeFrameSend() {
     for (unsigned int i = 0; i < _ringBuffers.size(); i++) {
-        if (_ringBuffers[i]->shouldBeAddedToMix(jitterBufferLengthSamples)) {
+        if (_ringBuffers[i]->shouldBeAddedToMix()) {
             // this is a ring buffer that is ready to go
             // set its flag so we know to push its buffer when all is said and done
             _ringBuffers[i]->setWillBeAddedToMix(true);
@@ -117,3 +120,31 @@ void AudioMixerClientData::pushBuffersAfterFrameSend() {
         }
     }
 }
+
+QJsonObject AudioMixerClientData::getJitterBufferStats() const {
+    QJsonObject statsObject;
+    
+    for (unsigned int i = 0; i < _ringBuffers.size(); i++) {
+        PositionalAudioRingBuffer* ringBuffer = _ringBuffers[i];
+        const JitterBufferDepth& jitterBufferDepth = ringBuffer->getJitterBufferDepth();
+        
+        QJsonObject streamObject;
+        streamObject["desired_frames"] = jitterBufferDepth.getDesiredFrames();
+        streamObject["available_frames"] = (int) (ringBuffer->samplesAvailable()
+                                                  / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
+        streamObject["jitter_usecs"] = jitterBufferDepth.getJitterUsecs();
+        streamObject["starves"] = jitterBufferDepth.getNumStarves();
+        streamObject["dropped_frames"] = jitterBufferDepth.getNumDroppedFrames();
+        streamObject["overflows"] = ringBuffer->getNumOverflows();
+        
+        // the microphone stream goes by its type, injected streams by their identifier
+        QString streamName = "microphone";
+        if (ringBuffer->getType() == PositionalAudioRingBuffer::Injector) {
+            streamName = uuidStringWithoutCurlyBraces(((InjectedAudioRingBuffer*) ringBuffer)->getStreamIdentifier());
+        }
+        
+        statsObject[streamName] = streamObject;
+    }
+    
+    return statsObject;
+}
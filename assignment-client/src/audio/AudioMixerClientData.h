@@ -14,6 +14,10 @@
 
 #include <vector>
 
+#include <QtCore/QJsonObject>
+
+#include <AudioLimiter.h>
+#include <MixedAudioCodec.h>
 #include <NodeData.h>
 #include <PositionalAudioRingBuffer.h>
 
@@ -28,10 +32,21 @@ public:
     AvatarAudioRingBuffer* getAvatarAudioRingBuffer() const;
     
     int parseData(const QByteArray& packet);
-    void checkBuffersBeforeFrameSend(int jitterBufferLengthSamples);
+    void checkBuffersBeforeFrameSend();
     void pushBuffersAfterFrameSend();
+    
+    /// the depth, jitter, starves and overflows of each stream, by stream
+    QJsonObject getJitterBufferStats() const;
+    
+    /// the limiter for the mix sent to this node, only touched by the worker mixing for it
+    AudioLimiter& getMixLimiter() { return _mixLimiter; }
+    
+    /// the encoder for the mix sent to this node, only touched by the worker mixing for it
+    MixedAudioEncoder& getMixedAudioEncoder() { return _mixedAudioEncoder; }
 private:
     std::vector<PositionalAudioRingBuffer*> _ringBuffers;
+    AudioLimiter _mixLimiter;
+    MixedAudioEncoder _mixedAudioEncoder;
 };
 
 #endif // hifi_AudioMixerClientData_h
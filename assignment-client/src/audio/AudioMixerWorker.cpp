@@ -0,0 +1,83 @@
+//
+//  AudioMixerWorker.cpp
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include "AudioMixerClientData.h"
+
+#include "AudioMixerWorker.h"
+
+AudioMixerWorker::AudioMixerWorker(AudioMixer* mixer, int workerIndex, int numWorkers) :
+    _mixer(mixer),
+    _workerIndex(workerIndex),
+    _numWorkers(numWorkers),
+    _numMixes(0),
+    _numClusterMixes(0),
+    _scratch()
+{
+    // the worker is re-used every frame, the mixer owns it
+    setAutoDelete(false);
+}
+
+void AudioMixerWorker::run() {
+    _numMixes = 0;
+    _numClusterMixes = 0;
+    
+    int maxFramePacketBytes = _mixer->getMaxFramePacketBytes();
+    
+    // listeners are dealt out to the workers in turn, which keeps the shares even as nodes come and go
+    for (int i = _workerIndex; i < _mixer->_frameListeners.size(); i += _numWorkers) {
+        const Node* listener = _mixer->_frameListeners[i].data();
+        AudioMixerClientData* listenerData = (AudioMixerClientData*) listener->getLinkedData();
+        
+        int numClusterMixes = 0;
+        _numMixes += _mixer->prepareMixForListeningNode(listener, _mixBus, _scratch, numClusterMixes);
+        _numClusterMixes += numClusterMixes;
+        
+        // the only place the mix is saturated, the limiter keeps its gain per listener from frame to frame
+        listenerData->getMixLimiter().render(_mixBus, _clientSamples, NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
+        
+        char* packet = &_mixer->_framePackets[i * maxFramePacketBytes];
+        
+        if (isSilent(_clientSamples)) {
+            // a silent frame only needs to say how many samples of silence it stands for
+            const QByteArray& packetHeader = _mixer->_frameSilentPacketHeader;
+            memcpy(packet, packetHeader.constData(), packetHeader.size());
+            
+            int16_t numSilentSamples = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO;
+            memcpy(packet + packetHeader.size(), &numSilentSamples, sizeof(numSilentSamples));
+            
+            _mixer->_framePacketSizes[i] = packetHeader.size() + sizeof(numSilentSamples);
+        } else {
+            const QByteArray& packetHeader = _mixer->_framePacketHeader;
+            memcpy(packet, packetHeader.constData(), packetHeader.size());
+            
+            MixedAudioEncoding encoding = MixedAudioEncodingRaw;
+            quint8 encodingMask = maskForMixedAudioEncoding(_mixer->_preferredMixedAudioEncoding);
+            
+            if (listenerData->getAvatarAudioRingBuffer()->getAcceptedMixedAudioEncodings() & encodingMask) {
+                encoding = _mixer->_preferredMixedAudioEncoding;
+            }
+            
+            _mixer->_framePacketSizes[i] = packetHeader.size()
+                + listenerData->getMixedAudioEncoder().encodeFrame(encoding, _clientSamples,
+                                                                   packet + packetHeader.size());
+        }
+    }
+}
+
+bool AudioMixerWorker::isSilent(const int16_t* stereoSamples) {
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; i++) {
+        if (stereoSamples[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
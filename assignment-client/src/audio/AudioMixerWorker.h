@@ -0,0 +1,43 @@
+//
+//  AudioMixerWorker.h
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixerWorker_h
+#define hifi_AudioMixerWorker_h
+
+#include <QtCore/QRunnable>
+
+#include "AudioMixer.h"
+
+/// Mixes one share of the listeners in an AudioMixer frame snapshot into that mixer's packet buffer.
+/// Each worker has its own mix buffer so that workers never write to the same memory.
+class AudioMixerWorker : public QRunnable {
+public:
+    AudioMixerWorker(AudioMixer* mixer, int workerIndex, int numWorkers);
+    
+    void run();
+    
+    int getNumMixes() const { return _numMixes; }
+    int getNumClusterMixes() const { return _numClusterMixes; }
+private:
+    static bool isSilent(const int16_t* stereoSamples);
+    
+    AudioMixer* _mixer;
+    int _workerIndex;
+    int _numWorkers;
+    int _numMixes;
+    int _numClusterMixes;
+    AudioMixerListenerScratch _scratch;
+    
+    // the mix bus is larger than what will be sent so the delayed channel can run past the end
+    int32_t _mixBus[SPATIALIZED_MIX_BUFFER_SAMPLES];
+    int16_t _clientSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+};
+
+#endif // hifi_AudioMixerWorker_h
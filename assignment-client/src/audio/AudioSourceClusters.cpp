@@ -0,0 +1,144 @@
+//
+//  AudioSourceClusters.cpp
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#include <AudioSourceGeometry.h>
+#include <PositionalAudioRingBuffer.h>
+
+#include "AudioMixer.h"
+#include "AudioSourceGrid.h"
+
+#include "AudioSourceClusters.h"
+
+AudioSourceClusters::AudioSourceClusters() :
+    _cellSize(DEFAULT_AUDIO_CLUSTER_CELL_SIZE),
+    _angularThreshold(DEFAULT_AUDIO_CLUSTER_ANGULAR_THRESHOLD),
+    _entries(),
+    _clusters(),
+    _sourceClusterIndices(),
+    _clusterSources(),
+    _clusterFirstSources()
+{
+    
+}
+
+void AudioSourceClusters::rebuild(const QVector<AudioMixerSource>& sources, const AudioSourceGeometry& geometry) {
+    _entries.clear();
+    _clusters.clear();
+    _clusterSources.clear();
+    _clusterFirstSources.clear();
+    _sourceClusterIndices.fill(-1, sources.size());
+    
+    if (_angularThreshold <= 0.0f) {
+        // clustering is turned off, every source is mixed on its own
+        _clusterFirstSources.append(0);
+        return;
+    }
+    
+    for (int i = 0; i < sources.size(); i++) {
+        // spherical sources are heard from inside and have no single position to stand in for them
+        if (geometry.getRadius(i) == 0.0f) {
+            glm::ivec3 cell = glm::ivec3(glm::floor(geometry.getPosition(i) / _cellSize));
+            
+            Entry entry = { AudioSourceGrid::cellKeyForCell(cell.x, cell.y, cell.z), i };
+            _entries.append(entry);
+        }
+    }
+    
+    std::sort(_entries.begin(), _entries.end());
+    
+    int firstEntry = 0;
+    for (int i = 1; i <= _entries.size(); i++) {
+        if (i == _entries.size() || _entries[i].cellKey != _entries[firstEntry].cellKey) {
+            if (i - firstEntry >= MIN_AUDIO_CLUSTER_SOURCES) {
+                addCluster(sources, geometry, firstEntry, i);
+            }
+            firstEntry = i;
+        }
+    }
+    
+    _clusterFirstSources.append(_clusterSources.size());
+}
+
+void AudioSourceClusters::addCluster(const QVector<AudioMixerSource>& sources, const AudioSourceGeometry& geometry,
+                                     int firstEntry, int lastEntry) {
+    int clusterIndex = _clusters.size();
+    _clusters.resize(clusterIndex + 1);
+    AudioSourceCluster& cluster = _clusters[clusterIndex];
+    
+    _clusterFirstSources.append(_clusterSources.size());
+    
+    glm::vec3 weightedPositionSum;
+    float loudnessSum = 0.0f;
+    cluster.loudness = 0.0f;
+    
+    for (int i = firstEntry; i < lastEntry; i++) {
+        int sourceIndex = _entries[i].sourceIndex;
+        
+        _sourceClusterIndices[sourceIndex] = clusterIndex;
+        _clusterSources.append(sourceIndex);
+        
+        float loudness = geometry.getLoudness(sourceIndex);
+        weightedPositionSum += geometry.getPosition(sourceIndex) * loudness;
+        loudnessSum += loudness;
+        
+        // culling the cluster by its loudest source keeps it audible as far out as that source alone would be
+        cluster.loudness = std::max(cluster.loudness, loudness);
+    }
+    
+    cluster.position = weightedPositionSum / loudnessSum;
+    cluster.radius = 0.0f;
+    
+    float submix[AUDIO_CLUSTER_SUBMIX_SAMPLES];
+    memset(submix, 0, sizeof(submix));
+    
+    for (int i = firstEntry; i < lastEntry; i++) {
+        int sourceIndex = _entries[i].sourceIndex;
+        cluster.radius = std::max(cluster.radius, glm::distance(cluster.position, geometry.getPosition(sourceIndex)));
+        
+        const PositionalAudioRingBuffer* ringBuffer = sources[sourceIndex].ringBuffer;
+        float attenuationRatio = geometry.getAttenuationRatio(sourceIndex);
+        
+        // the history before the frame can wrap around the ring buffer, the frame itself cannot
+        for (int s = 0; s < SAMPLE_PHASE_DELAY_AT_90; s++) {
+            submix[s] += (*ringBuffer)[s - SAMPLE_PHASE_DELAY_AT_90] * attenuationRatio;
+        }
+        
+        const int16_t* frameSamples = ringBuffer->getNextOutput();
+        for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; s++) {
+            submix[SAMPLE_PHASE_DELAY_AT_90 + s] += frameSamples[s] * attenuationRatio;
+        }
+    }
+    
+    float peak = 0.0f;
+    for (int s = 0; s < AUDIO_CLUSTER_SUBMIX_SAMPLES; s++) {
+        peak = std::max(peak, fabsf(submix[s]));
+    }
+    
+    cluster.submixGain = peak > MAX_SAMPLE_VALUE ? peak / MAX_SAMPLE_VALUE : 1.0f;
+    float storedScale = 1.0f / cluster.submixGain;
+    
+    for (int s = 0; s < AUDIO_CLUSTER_SUBMIX_SAMPLES; s++) {
+        cluster.submix[s] = glm::clamp(submix[s] * storedScale, (float) MIN_SAMPLE_VALUE, (float) MAX_SAMPLE_VALUE);
+    }
+}
+
+bool AudioSourceClusters::isFarFieldForListener(int clusterIndex, const glm::vec3& listenerPosition) const {
+    const AudioSourceCluster& cluster = _clusters[clusterIndex];
+    
+    // within a cell the direction each source faces still matters, past that the submix's average facing will do
+    float distance = glm::distance(cluster.position, listenerPosition);
+    
+    // the cluster radius seen from the listener, compared without the atan since the threshold is small
+    return distance > _cellSize && cluster.radius < distance * _angularThreshold;
+}
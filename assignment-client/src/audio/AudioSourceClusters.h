@@ -0,0 +1,98 @@
+//
+//  AudioSourceClusters.h
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceClusters_h
+#define hifi_AudioSourceClusters_h
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+#include <AudioMixKernel.h>
+
+class AudioSourceGeometry;
+struct AudioMixerSource;
+
+const float DEFAULT_AUDIO_CLUSTER_CELL_SIZE = 16.0f;
+const float DEFAULT_AUDIO_CLUSTER_ANGULAR_THRESHOLD = 0.1f;
+const int MIN_AUDIO_CLUSTER_SOURCES = 2;
+
+// a submix carries the samples the delayed channel needs from before the frame, followed by the frame
+const int AUDIO_CLUSTER_SUBMIX_SAMPLES = SAMPLE_PHASE_DELAY_AT_90 + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+
+/// A group of sources that share a cell, pre-mixed once per frame into a mono submix.
+struct AudioSourceCluster {
+    glm::vec3 position;
+    float radius;
+    float loudness;
+    
+    // the submix is stored divided by this so it fits in int16_t, the attenuation of a mix multiplies it back
+    float submixGain;
+    int16_t submix[AUDIO_CLUSTER_SUBMIX_SAMPLES];
+};
+
+/// Far-field submixes for one mixer frame. Point sources are binned into cells of the cluster cell size and every cell
+/// with at least MIN_AUDIO_CLUSTER_SOURCES sources becomes a cluster, placed at the loudness-weighted centre of its
+/// sources. A listener that sees a cluster under an angle smaller than the angular threshold mixes its submix as one
+/// omnidirectional source instead of mixing each of its sources.
+class AudioSourceClusters {
+public:
+    AudioSourceClusters();
+    
+    float getCellSize() const { return _cellSize; }
+    void setCellSize(float cellSize) { _cellSize = cellSize; }
+    
+    /// the largest angle, in radians, the radius of a cluster can cover for a listener to hear it as one source
+    float getAngularThreshold() const { return _angularThreshold; }
+    void setAngularThreshold(float angularThreshold) { _angularThreshold = angularThreshold; }
+    
+    /// rebuilds the clusters and their submixes from this frame's sources, geometry must hold the same sources
+    void rebuild(const QVector<AudioMixerSource>& sources, const AudioSourceGeometry& geometry);
+    
+    int getNumClusters() const { return _clusters.size(); }
+    const AudioSourceCluster& getCluster(int clusterIndex) const { return _clusters[clusterIndex]; }
+    
+    /// the cluster the source at sourceIndex was grouped into, or -1 if it is always mixed on its own
+    int getClusterIndexForSource(int sourceIndex) const { return _sourceClusterIndices[sourceIndex]; }
+    
+    /// the sources grouped into a cluster
+    const int* getClusterSources(int clusterIndex) const {
+        return _clusterSources.constData() + _clusterFirstSources[clusterIndex];
+    }
+    int getNumClusterSources(int clusterIndex) const {
+        return _clusterFirstSources[clusterIndex + 1] - _clusterFirstSources[clusterIndex];
+    }
+    
+    /// true if a listener at listenerPosition is far enough away to hear the cluster as one source
+    bool isFarFieldForListener(int clusterIndex, const glm::vec3& listenerPosition) const;
+private:
+    struct Entry {
+        quint64 cellKey;
+        int sourceIndex;
+        
+        bool operator<(const Entry& other) const { return cellKey < other.cellKey; }
+    };
+    
+    void addCluster(const QVector<AudioMixerSource>& sources, const AudioSourceGeometry& geometry,
+                    int firstEntry, int lastEntry);
+    
+    float _cellSize;
+    float _angularThreshold;
+    
+    QVector<Entry> _entries;
+    QVector<AudioSourceCluster> _clusters;
+    QVector<int> _sourceClusterIndices;
+    
+    // the sources of cluster i are _clusterSources[_clusterFirstSources[i]] up to _clusterFirstSources[i + 1]
+    QVector<int> _clusterSources;
+    QVector<int> _clusterFirstSources;
+};
+
+#endif // hifi_AudioSourceClusters_h
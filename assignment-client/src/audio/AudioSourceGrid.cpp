@@ -0,0 +1,111 @@
+//
+//  AudioSourceGrid.cpp
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include <PositionalAudioRingBuffer.h>
+
+#include "AudioMixer.h"
+
+#include "AudioSourceGrid.h"
+
+// cell coordinates are packed into 21 bits each, which is plenty at the smallest cell size
+const int CELL_COORDINATE_BITS = 21;
+const int CELL_COORDINATE_OFFSET = 1 << (CELL_COORDINATE_BITS - 1);
+const quint64 CELL_COORDINATE_MASK = (1 << CELL_COORDINATE_BITS) - 1;
+
+AudioSourceGrid::AudioSourceGrid() :
+    _occupiedLevels(),
+    _unboundedSources()
+{
+    
+}
+
+quint64 AudioSourceGrid::cellKeyForCell(int x, int y, int z) {
+    return (((quint64) (x + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << (CELL_COORDINATE_BITS * 2))
+        | (((quint64) (y + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << CELL_COORDINATE_BITS)
+        | ((quint64) (z + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK);
+}
+
+float AudioSourceGrid::cellSizeForLevel(int level) {
+    return MIN_AUDIO_SOURCE_GRID_CELL_SIZE * (1 << level);
+}
+
+glm::ivec3 AudioSourceGrid::cellForPosition(const glm::vec3& position, int level) {
+    return glm::ivec3(glm::floor(position / cellSizeForLevel(level)));
+}
+
+void AudioSourceGrid::rebuild(const QVector<AudioMixerSource>& sources, float minAudibilityThreshold) {
+    for (int i = 0; i < _occupiedLevels.size(); i++) {
+        _levels[_occupiedLevels[i]].clear();
+    }
+    _occupiedLevels.clear();
+    _unboundedSources.clear();
+    
+    for (int i = 0; i < sources.size(); i++) {
+        const PositionalAudioRingBuffer* ringBuffer = sources[i].ringBuffer;
+        
+        // past this distance trailing loudness / distance drops under the threshold and the mixer will skip it
+        float audibleRadius = ringBuffer->getNextOutputTrailingLoudness() / minAudibilityThreshold;
+        
+        // find the narrowest level whose cells are at least as wide as the audible radius
+        int level = 0;
+        while (level < NUM_AUDIO_SOURCE_GRID_LEVELS && cellSizeForLevel(level) < audibleRadius) {
+            ++level;
+        }
+        
+        if (level >= NUM_AUDIO_SOURCE_GRID_LEVELS) {
+            _unboundedSources.append(i);
+        } else {
+            glm::ivec3 cell = cellForPosition(ringBuffer->getPosition(), level);
+            
+            Entry entry = { cellKeyForCell(cell.x, cell.y, cell.z), i };
+            _levels[level].append(entry);
+        }
+    }
+    
+    for (int level = 0; level < NUM_AUDIO_SOURCE_GRID_LEVELS; level++) {
+        if (!_levels[level].isEmpty()) {
+            std::sort(_levels[level].begin(), _levels[level].end());
+            _occupiedLevels.append(level);
+        }
+    }
+}
+
+void AudioSourceGrid::findPotentiallyAudibleSources(const glm::vec3& position, QVector<int>& sourceIndices) const {
+    // resizing keeps the capacity of the caller's scratch vector from frame to frame
+    sourceIndices.resize(0);
+    sourceIndices += _unboundedSources;
+    
+    for (int i = 0; i < _occupiedLevels.size(); i++) {
+        const QVector<Entry>& entries = _levels[_occupiedLevels[i]];
+        glm::ivec3 center = cellForPosition(position, _occupiedLevels[i]);
+        
+        // the cells are at least as wide as the audible radius of anything in them
+        // so only the neighbouring cells can hold a source we would hear
+        for (int x = center.x - 1; x <= center.x + 1; x++) {
+            for (int y = center.y - 1; y <= center.y + 1; y++) {
+                for (int z = center.z - 1; z <= center.z + 1; z++) {
+                    Entry searchEntry = { cellKeyForCell(x, y, z), 0 };
+                    
+                    const Entry* cellEntry = std::lower_bound(entries.constBegin(), entries.constEnd(), searchEntry);
+                    while (cellEntry != entries.constEnd() && cellEntry->cellKey == searchEntry.cellKey) {
+                        sourceIndices.append(cellEntry->sourceIndex);
+                        ++cellEntry;
+                    }
+                }
+            }
+        }
+    }
+    
+    // keep the order of the frame snapshot so the mix does not depend on the grid layout
+    std::sort(sourceIndices.begin(), sourceIndices.end());
+}
@@ -0,0 +1,59 @@
+//
+//  AudioSourceGrid.h
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceGrid_h
+#define hifi_AudioSourceGrid_h
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+struct AudioMixerSource;
+
+const float MIN_AUDIO_SOURCE_GRID_CELL_SIZE = 1.0f;
+const int NUM_AUDIO_SOURCE_GRID_LEVELS = 16;
+
+/// A uniform spatial hash of the audio sources in one mixer frame, used to skip sources that cannot be heard.
+/// A source can be heard out to the distance where its trailing loudness falls to the minimum audibility threshold.
+/// Sources are binned by that radius into levels whose cells are at least as wide as the radii they hold, so a
+/// listener only needs to visit the 27 cells around it on each level.
+class AudioSourceGrid {
+public:
+    AudioSourceGrid();
+    
+    /// rebuilds the grid from this frame's sources, source indices refer to positions in sources
+    void rebuild(const QVector<AudioMixerSource>& sources, float minAudibilityThreshold);
+    
+    /// replaces sourceIndices with the sorted indices of sources that may be audible at position
+    void findPotentiallyAudibleSources(const glm::vec3& position, QVector<int>& sourceIndices) const;
+    
+    int getNumOccupiedLevels() const { return _occupiedLevels.size(); }
+    
+    /// packs integer cell coordinates into one sortable key
+    static quint64 cellKeyForCell(int x, int y, int z);
+private:
+    struct Entry {
+        quint64 cellKey;
+        int sourceIndex;
+        
+        bool operator<(const Entry& other) const { return cellKey < other.cellKey; }
+    };
+    
+    static float cellSizeForLevel(int level);
+    static glm::ivec3 cellForPosition(const glm::vec3& position, int level);
+    
+    QVector<Entry> _levels[NUM_AUDIO_SOURCE_GRID_LEVELS];
+    QVector<int> _occupiedLevels;
+    
+    // sources loud enough to be heard beyond the widest level are checked by every listener
+    QVector<int> _unboundedSources;
+};
+
+#endif // hifi_AudioSourceGrid_h
@@ -9,16 +9,37 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstring>
+
+#include <MixedAudioCodec.h>
 #include <PacketHeaders.h>
 
 #include "AvatarAudioRingBuffer.h"
 
-AvatarAudioRingBuffer::AvatarAudioRingBuffer() :
-    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Microphone) {
+AvatarAudioRingBuffer::AvatarAudioRingBuffer(bool isLockFree) :
+    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Microphone, isLockFree),
+    _acceptedMixedAudioEncodings(maskForMixedAudioEncoding(MixedAudioEncodingRaw)) {
     
 }
 
 int AvatarAudioRingBuffer::parseData(const QByteArray& packet) {
-    _shouldLoopbackForNode = (packetTypeForPacket(packet) == PacketTypeMicrophoneAudioWithEcho);
-    return PositionalAudioRingBuffer::parseData(packet);
+    PacketType packetType = packetTypeForPacket(packet);
+    _shouldLoopbackForNode = (packetType == PacketTypeMicrophoneAudioWithEcho);
+    
+    // skip the packet header (includes the source UUID)
+    int readBytes = numBytesForPacketHeader(packet);
+    
+    readBytes += parsePositionalData(packet.mid(readBytes));
+    
+    // the client tells us with every packet which encodings it can decode the mix we send back in,
+    // a packet too short to hold that is dropped before any of its audio is read
+    if (readBytes + (int) sizeof(_acceptedMixedAudioEncodings) > packet.size()) {
+        return readBytes;
+    }
+    memcpy(&_acceptedMixedAudioEncodings, packet.data() + readBytes, sizeof(_acceptedMixedAudioEncodings));
+    readBytes += sizeof(_acceptedMixedAudioEncodings);
+    
+    readBytes += parseAudioData(packetType, packet.data() + readBytes, packet.size() - readBytes);
+    
+    return readBytes;
 }
@@ -18,13 +18,18 @@
 
 class AvatarAudioRingBuffer : public PositionalAudioRingBuffer {
 public:
-    AvatarAudioRingBuffer();
+    AvatarAudioRingBuffer(bool isLockFree = false);
     
     int parseData(const QByteArray& packet);
+    
+    /// a mask of the MixedAudioEncoding values the client will accept, see maskForMixedAudioEncoding
+    quint8 getAcceptedMixedAudioEncodings() const { return _acceptedMixedAudioEncodings; }
 private:
     // disallow copying of AvatarAudioRingBuffer objects
     AvatarAudioRingBuffer(const AvatarAudioRingBuffer&);
     AvatarAudioRingBuffer& operator= (const AvatarAudioRingBuffer&);
+    
+    quint8 _acceptedMixedAudioEncodings;
 };
 
 #endif // hifi_AvatarAudioRingBuffer_h
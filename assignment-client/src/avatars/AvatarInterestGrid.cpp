@@ -0,0 +1,70 @@
+//
+//  AvatarInterestGrid.cpp
+//  assignment-client/src/avatars
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include "AvatarMixer.h"
+
+#include "AvatarInterestGrid.h"
+
+// cell coordinates are packed into 21 bits each, which covers any domain at this cell size
+const int CELL_COORDINATE_BITS = 21;
+const int CELL_COORDINATE_OFFSET = 1 << (CELL_COORDINATE_BITS - 1);
+const quint64 CELL_COORDINATE_MASK = (1 << CELL_COORDINATE_BITS) - 1;
+
+AvatarInterestGrid::AvatarInterestGrid() :
+    _entries()
+{
+    
+}
+
+glm::ivec3 AvatarInterestGrid::cellForPosition(const glm::vec3& position) {
+    return glm::ivec3(glm::floor(position / AVATAR_INTEREST_RADIUS));
+}
+
+quint64 AvatarInterestGrid::cellKeyForCell(int x, int y, int z) {
+    return (((quint64) (x + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << (CELL_COORDINATE_BITS * 2))
+        | (((quint64) (y + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK) << CELL_COORDINATE_BITS)
+        | ((quint64) (z + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK);
+}
+
+void AvatarInterestGrid::rebuild(const QVector<AvatarMixerFrameAvatar>& avatars) {
+    _entries.resize(0);
+    
+    for (int i = 0; i < avatars.size(); i++) {
+        glm::ivec3 cell = cellForPosition(avatars[i].position);
+        
+        Entry entry = { cellKeyForCell(cell.x, cell.y, cell.z), i };
+        _entries.append(entry);
+    }
+    
+    std::sort(_entries.begin(), _entries.end());
+}
+
+void AvatarInterestGrid::findNearbyAvatars(const glm::vec3& position, QVector<int>& avatarIndices) const {
+    // resizing keeps the capacity of the caller's scratch vector from frame to frame
+    avatarIndices.resize(0);
+    
+    glm::ivec3 center = cellForPosition(position);
+    
+    for (int x = center.x - 1; x <= center.x + 1; x++) {
+        for (int y = center.y - 1; y <= center.y + 1; y++) {
+            for (int z = center.z - 1; z <= center.z + 1; z++) {
+                Entry searchEntry = { cellKeyForCell(x, y, z), 0 };
+                
+                const Entry* cellEntry = std::lower_bound(_entries.constBegin(), _entries.constEnd(), searchEntry);
+                while (cellEntry != _entries.constEnd() && cellEntry->cellKey == searchEntry.cellKey) {
+                    avatarIndices.append(cellEntry->avatarIndex);
+                    ++cellEntry;
+                }
+            }
+        }
+    }
+}
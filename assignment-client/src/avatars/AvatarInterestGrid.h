@@ -0,0 +1,48 @@
+//
+//  AvatarInterestGrid.h
+//  assignment-client/src/avatars
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarInterestGrid_h
+#define hifi_AvatarInterestGrid_h
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QVector>
+
+struct AvatarMixerFrameAvatar;
+
+/// how close an avatar has to be for a listener to get all of its updates, while the listener can see it
+const float AVATAR_INTEREST_RADIUS = 50.0f;
+
+/// A uniform spatial hash of the avatars in one broadcast frame, in cells as wide as AVATAR_INTEREST_RADIUS, so a
+/// listener finds every avatar within that radius of it by visiting the 27 cells around it.
+class AvatarInterestGrid {
+public:
+    AvatarInterestGrid();
+    
+    /// rebuilds the grid from this frame's avatars, avatar indices refer to positions in avatars
+    void rebuild(const QVector<AvatarMixerFrameAvatar>& avatars);
+    
+    /// replaces avatarIndices with the indices of the avatars that may be within AVATAR_INTEREST_RADIUS of position
+    void findNearbyAvatars(const glm::vec3& position, QVector<int>& avatarIndices) const;
+private:
+    struct Entry {
+        quint64 cellKey;
+        int avatarIndex;
+        
+        bool operator<(const Entry& other) const { return cellKey < other.cellKey; }
+    };
+    
+    static glm::ivec3 cellForPosition(const glm::vec3& position);
+    static quint64 cellKeyForCell(int x, int y, int z);
+    
+    QVector<Entry> _entries;
+};
+
+#endif // hifi_AvatarInterestGrid_h
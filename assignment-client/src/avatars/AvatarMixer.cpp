@@ -9,9 +9,13 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+#include <cstring>
+
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
 #include <QtCore/QJsonObject>
+#include <QtCore/QStringList>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
 
@@ -22,24 +26,38 @@
 #include <UUID.h>
 
 #include "AvatarMixerClientData.h"
+#include "AvatarMixerWorker.h"
 
 #include "AvatarMixer.h"
 
 const QString AVATAR_MIXER_LOGGING_NAME = "avatar-mixer";
 
-const unsigned int AVATAR_DATA_SEND_INTERVAL_MSECS = (1.0f / 60.0f) * 1000;
+const int TRAILING_AVERAGE_FRAMES = 100;
 
 AvatarMixer::AvatarMixer(const QByteArray& packet) :
     ThreadedAssignment(packet),
     _broadcastThread(),
+    _numBroadcastThreads(QThread::idealThreadCount()),
+    _broadcastThreadPool(),
+    _workers(),
     _lastFrameTimestamp(QDateTime::currentMSecsSinceEpoch()),
     _trailingSleepRatio(1.0f),
     _performanceThrottlingRatio(0.0f),
+    _framesSinceCutoffEvent(TRAILING_AVERAGE_FRAMES),
     _sumListeners(0),
     _numStatFrames(0),
     _sumBillboardPackets(0),
-    _sumIdentityPackets(0)
+    _sumIdentityPackets(0),
+    _sumAvatarsSent(0),
+    _sumAvatarBytesSent(0),
+    _numBroadcastFrames(0),
+    _frameAvatars(),
+    _frameAvatarGrid(),
+    _frameListeners()
 {
+    memset(_sumBandAvatarFrames, 0, sizeof(_sumBandAvatarFrames));
+    memset(_sumBandAvatarsSent, 0, sizeof(_sumBandAvatarsSent));
+    
     // make sure we hear about node kills so we can tell the other nodes
     connect(NodeList::getInstance(), &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
 }
@@ -47,6 +65,9 @@ AvatarMixer::AvatarMixer(const QByteArray& packet) :
 AvatarMixer::~AvatarMixer() {
     _broadcastThread.quit();
     _broadcastThread.wait();
+    
+    _broadcastThreadPool.waitForDone();
+    qDeleteAll(_workers);
 }
 
 void attachAvatarDataToNode(Node* newNode) {
@@ -55,35 +76,121 @@ void attachAvatarDataToNode(Node* newNode) {
     }
 }
 
-const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
+// avatars this close to a listener count as in view even when it is looking away from them
+const float AVATAR_KEYHOLE_RADIUS = DEFAULT_KEYHOLE_RADIUS;
 
-// NOTE: some additional optimizations to consider.
-//    1) use the view frustum to cull those avatars that are out of view. Since avatar data doesn't need to be present
-//       if the avatar is not in view or in the keyhole.
-void AvatarMixer::broadcastAvatarData() {
+// generous enough that an avatar whose position is just outside the frustum but whose body is in it still counts
+const float AVATAR_BOUNDING_RADIUS = 1.0f;
+
+// an avatar out of view builds up priority this much slower than the same avatar in view
+const float OUT_OF_VIEW_PRIORITY_SCALE = 0.2f;
+
+// an avatar moving this many meters per second builds up priority twice as fast as when it stands still
+const float MOTION_PRIORITY_SPEED = 1.0f;
+
+// the upper distance of every band but the last, which takes the rest
+const float AVATAR_DISTANCE_BAND_LIMITS[NUM_AVATAR_DISTANCE_BANDS - 1] = { 5.0f, 10.0f, 25.0f, 50.0f, 100.0f };
+const char* const AVATAR_DISTANCE_BAND_NAMES[NUM_AVATAR_DISTANCE_BANDS] = {
+    "within_5m", "within_10m", "within_25m", "within_50m", "within_100m", "beyond_100m"
+};
+
+static int distanceBandForDistance(float distance) {
+    int band = 0;
+    while (band < NUM_AVATAR_DISTANCE_BANDS - 1 && distance > AVATAR_DISTANCE_BAND_LIMITS[band]) {
+        band++;
+    }
+    return band;
+}
+
+// each avatar in a PacketTypeBulkAvatarData starts with its UUID, the frame its state was taken in and how many frames
+// before that the baseline of its delta was taken, zero for a whole state
+static void appendAvatarStateHeader(QByteArray& avatarByteArray, const QUuid& nodeUUID, int frame,
+                                    int baselineAge) {
+    quint16 sequence = frame;
+    quint8 age = baselineAge;
     
-    int idleTime = QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp;
+    avatarByteArray.append(nodeUUID.toRfc4122());
+    avatarByteArray.append(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+    avatarByteArray.append(reinterpret_cast<const char*>(&age), sizeof(age));
+}
+
+void AvatarMixer::parsePayload() {
+    // the payload is a space separated list of --option value pairs
+    QStringList payloadArguments = QString(getPayload()).split(" ", QString::SkipEmptyParts);
     
-    ++_numStatFrames;
+    const QString BROADCAST_THREADS_OPTION = "--broadcastThreads";
+    QString broadcastThreadsValue = getCmdOption(payloadArguments, BROADCAST_THREADS_OPTION);
+    
+    if (!broadcastThreadsValue.isEmpty()) {
+        _numBroadcastThreads = broadcastThreadsValue.toInt();
+    }
+    
+    const int MAX_BROADCAST_THREADS = 64;
+    _numBroadcastThreads = glm::clamp(_numBroadcastThreads, 1, MAX_BROADCAST_THREADS);
+}
+
+void AvatarMixer::prepareToBroadcast() {
+    parsePayload();
+    
+    // the broadcast thread does one share of the listeners, the pool threads stay alive for the rest
+    _broadcastThreadPool.setMaxThreadCount(std::max(_numBroadcastThreads - 1, 1));
+    _broadcastThreadPool.setExpiryTimeout(-1);
     
+    for (int i = 0; i < _numBroadcastThreads; i++) {
+        _workers.append(new AvatarMixerWorker(this, i, _numBroadcastThreads));
+    }
+    
+    qDebug() << "Broadcasting avatars on" << _numBroadcastThreads << "thread(s).";
+}
+
+// sends the packets of a frame to their listeners through the node list, in one datagram batch
+class NodeListPacketSender : public AvatarMixerPacketSender {
+public:
+    NodeListPacketSender(NodeList* nodeList) : _nodeList(nodeList) { }
+    
+    void sendPacket(PacketBuffer& packet, const SharedNodePointer& destinationNode) {
+        _nodeList->writeDatagram(packet, destinationNode);
+    }
+    
+    void sendPacket(const QByteArray& packet, const SharedNodePointer& destinationNode) {
+        _nodeList->writeDatagram(packet, destinationNode);
+    }
+private:
+    NodeList* _nodeList;
+};
+
+void AvatarMixer::broadcastAvatarData() {
+    updatePerformanceThrottling(QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp);
+    
+    NodeList* nodeList = NodeList::getInstance();
+    NodeListPacketSender sender(nodeList);
+    
+    // the packets for every agent this frame go out together once they are all built
+    nodeList->beginDatagramBatch();
+    broadcastFrame(nodeList->getNodeHash(), sender);
+    nodeList->flushDatagramBatch();
+}
+
+void AvatarMixer::updatePerformanceThrottling(int idleMsecs) {
     const float STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.10f;
     const float BACK_OFF_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD = 0.20f;
     
     const float RATIO_BACK_OFF = 0.02f;
     
-    const int TRAILING_AVERAGE_FRAMES = 100;
-    int framesSinceCutoffEvent = TRAILING_AVERAGE_FRAMES;
-    
     const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
     const float PREVIOUS_FRAMES_RATIO = 1.0f - CURRENT_FRAME_RATIO;
     
+    if (idleMsecs < 0) {
+        idleMsecs = 0;
+    }
+    
     _trailingSleepRatio = (PREVIOUS_FRAMES_RATIO * _trailingSleepRatio)
-        + (idleTime * CURRENT_FRAME_RATIO / (float) AVATAR_DATA_SEND_INTERVAL_MSECS);
+        + (idleMsecs * CURRENT_FRAME_RATIO / (float) AVATAR_DATA_SEND_INTERVAL_MSECS);
     
     float lastCutoffRatio = _performanceThrottlingRatio;
     bool hasRatioChanged = false;
     
-    if (framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
+    if (_framesSinceCutoffEvent >= TRAILING_AVERAGE_FRAMES) {
         if (_trailingSleepRatio <= STRUGGLE_TRIGGER_SLEEP_PERCENTAGE_THRESHOLD) {
             // we're struggling - change our min required loudness to reduce some load
             _performanceThrottlingRatio = _performanceThrottlingRatio + (0.5f * (1.0f - _performanceThrottlingRatio));
@@ -105,113 +212,234 @@ void AvatarMixer::broadcastAvatarData() {
         }
         
         if (hasRatioChanged) {
-            framesSinceCutoffEvent = 0;
+            _framesSinceCutoffEvent = 0;
         }
     }
     
     if (!hasRatioChanged) {
-        ++framesSinceCutoffEvent;
+        ++_framesSinceCutoffEvent;
     }
+}
+
+void AvatarMixer::broadcastFrame(const NodeHash& nodeHash, AvatarMixerPacketSender& sender) {
+    ++_numStatFrames;
     
-    static QByteArray mixedAvatarByteArray;
+    prepareFrameAvatars(nodeHash);
     
-    int numPacketHeaderBytes = populatePacketHeader(mixedAvatarByteArray, PacketTypeBulkAvatarData);
+    _sumListeners += _frameListeners.size();
     
-    NodeList* nodeList = NodeList::getInstance();
+    // the broadcast thread takes the first share itself, the pool takes the rest
+    for (int i = 1; i < _workers.size(); i++) {
+        _broadcastThreadPool.start(_workers[i]);
+    }
     
-    AvatarMixerClientData* nodeData = NULL;
-    AvatarMixerClientData* otherNodeData = NULL;
+    _workers[0]->run();
+    _broadcastThreadPool.waitForDone();
     
-    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-        if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
-            && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
-            ++_sumListeners;
-            
-            // reset packet pointers for this node
-            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-            
-            AvatarData& avatar = nodeData->getAvatar();
-            glm::vec3 myPosition = avatar.getPosition();
-            
-            // this is an AGENT we have received head data from
-            // send back a packet with other active node data to this node
-            foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
-                if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
-                    && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
-                    
-                    AvatarMixerClientData* otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData());
-                    AvatarData& otherAvatar = otherNodeData->getAvatar();
-                    glm::vec3 otherPosition = otherAvatar.getPosition();
-            
-                    float distanceToAvatar = glm::length(myPosition - otherPosition);
-                    //  The full rate distance is the distance at which EVERY update will be sent for this avatar
-                    //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
-                    const float FULL_RATE_DISTANCE = 2.f;
-                    
-                    //  Decide whether to send this avatar's data based on it's distance from us
-                    if ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
-                        && (distanceToAvatar == 0.f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar)) {
-                        QByteArray avatarByteArray;
-                        avatarByteArray.append(otherNode->getUUID().toRfc4122());
-                        avatarByteArray.append(otherAvatar.toByteArray());
-                        
-                        if (avatarByteArray.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
-                            nodeList->writeDatagram(mixedAvatarByteArray, node);
-                            
-                            // reset the packet
-                            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-                        }
-                        
-                        // copy the avatar into the mixedAvatarByteArray packet
-                        mixedAvatarByteArray.append(avatarByteArray);
-                        
-                        // if the receiving avatar has just connected make sure we send out the mesh and billboard
-                        // for this avatar (assuming they exist)
-                        bool forceSend = !nodeData->checkAndSetHasReceivedFirstPackets();
-                        
-                        // we will also force a send of billboard or identity packet
-                        // if either has changed in the last frame
-                        
-                        if (otherNodeData->getBillboardChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getBillboardChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                            QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
-                            billboardPacket.append(otherNode->getUUID().toRfc4122());
-                            billboardPacket.append(otherNodeData->getAvatar().getBillboard());
-                            nodeList->writeDatagram(billboardPacket, node);
-                            
-                            ++_sumBillboardPackets;
-                        }
-                        
-                        if (otherNodeData->getIdentityChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getIdentityChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                                
-                            QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
-                            
-                            QByteArray individualData = otherNodeData->getAvatar().identityByteArray();
-                            individualData.replace(0, NUM_BYTES_RFC4122_UUID, otherNode->getUUID().toRfc4122());
-                            identityPacket.append(individualData);
-                            
-                            nodeList->writeDatagram(identityPacket, node);
-                                
-                            ++_sumIdentityPackets;
-                        }
-                    }
-                
-                    otherNodeData->getMutex().unlock();
-                }
-            }
-            
-            nodeList->writeDatagram(mixedAvatarByteArray, node);
-            
-            nodeData->getMutex().unlock();
+    for (int i = 0; i < _workers.size(); i++) {
+        const AvatarMixerWorker* worker = _workers[i];
+        
+        for (int j = 0; j < worker->getPackets().size(); j++) {
+            sender.sendPacket(*worker->getPackets()[j], _frameListeners[worker->getPacketListenerIndices()[j]].node);
+        }
+        
+        for (int j = 0; j < worker->getLargePackets().size(); j++) {
+            const SharedNodePointer& listenerNode = _frameListeners[worker->getLargePacketListenerIndices()[j]].node;
+            sender.sendPacket(worker->getLargePackets()[j], listenerNode);
+        }
+        
+        _sumAvatarsSent += worker->getNumAvatarsSent();
+        _sumAvatarBytesSent += worker->getNumAvatarBytesSent();
+        _sumBillboardPackets += worker->getNumBillboardPackets();
+        _sumIdentityPackets += worker->getNumIdentityPackets();
+        
+        for (int band = 0; band < NUM_AVATAR_DISTANCE_BANDS; band++) {
+            _sumBandAvatarFrames[band] += worker->getNumBandAvatarFrames(band);
+            _sumBandAvatarsSent[band] += worker->getNumBandAvatarsSent(band);
         }
     }
     
     _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
+    ++_numBroadcastFrames;
+}
+
+void AvatarMixer::prepareFrameAvatars(const NodeHash& nodeHash) {
+    // the listener packets are put together from these, so no avatar is packed more than once a frame
+    _frameAvatars.resize(0);
+    _frameListeners.resize(0);
+    
+    for (int i = 0; i < NUM_AVATAR_LOW_RATE_SLOTS; i++) {
+        _frameLowRateAvatars[i].resize(0);
+    }
+    
+    foreach (const SharedNodePointer& node, nodeHash) {
+        AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+        
+        if (!nodeData) {
+            continue;
+        }
+        
+        // taking the snapshot never waits on the receive path, so an avatar being parsed is not skipped
+        const AvatarMixerSnapshot& snapshot = nodeData->acquireSnapshot();
+        
+        if (node->getType() == NodeType::Agent && node->getActiveSocket()) {
+            AvatarMixerFrameListener frameListener = { node, nodeData, snapshot.position };
+            _frameListeners.append(frameListener);
+        }
+        
+        if (snapshot.stateByteArray.isEmpty()) {
+            continue;
+        }
+        
+        AvatarMixerFrameAvatar frameAvatar;
+        frameAvatar.node = node;
+        frameAvatar.nodeData = nodeData;
+        frameAvatar.snapshot = &snapshot;
+        frameAvatar.position = snapshot.position;
+        frameAvatar.radius = AVATAR_BOUNDING_RADIUS * snapshot.targetScale;
+        frameAvatar.speed = nodeData->recordFramePosition(frameAvatar.position) * AVATAR_DATA_SENDS_PER_SECOND;
+        
+        // the state is kept as it was sent, so the listeners that acknowledge it can be sent deltas against it
+        nodeData->recordState(_numBroadcastFrames, snapshot.stateByteArray);
+        
+        appendAvatarStateHeader(frameAvatar.avatarByteArray, node->getUUID(), _numBroadcastFrames, 0);
+        frameAvatar.avatarByteArray.append(snapshot.stateByteArray);
+        
+        // the turn follows the node rather than its place in the hash, so it stays put as others come and go
+        frameAvatar.lowRateSlot = qHash(node->getUUID()) % NUM_AVATAR_LOW_RATE_SLOTS;
+        _frameLowRateAvatars[frameAvatar.lowRateSlot].append(_frameAvatars.size());
+        
+        _frameAvatars.append(frameAvatar);
+    }
+    
+    _frameAvatarGrid.rebuild(_frameAvatars);
+}
+
+void AvatarMixer::selectAvatarsForListener(const AvatarMixerFrameListener& listener,
+                                           AvatarMixerListenerScratch& scratch) const {
+    const QUuid& listenerUUID = listener.node->getUUID();
+    AvatarMixerClientData* listenerData = listener.nodeData;
+    int lowRateSlot = _numBroadcastFrames % NUM_AVATAR_LOW_RATE_SLOTS;
+    
+    scratch.candidateAvatars.resize(0);
+    
+    _frameAvatarGrid.findNearbyAvatars(listener.position, scratch.nearbyAvatarIndices);
+    
+    for (int i = 0; i < scratch.nearbyAvatarIndices.size(); i++) {
+        int avatarIndex = scratch.nearbyAvatarIndices[i];
+        const AvatarMixerFrameAvatar& otherAvatar = _frameAvatars[avatarIndex];
+        float distance = glm::distance(otherAvatar.position, listener.position);
+        
+        // the avatars past the interest radius are picked up on their low rate turns below
+        if (distance <= AVATAR_INTEREST_RADIUS && otherAvatar.node->getUUID() != listenerUUID) {
+            addCandidateAvatar(avatarIndex, distance, 1, listenerData, scratch);
+        }
+    }
+    
+    // each of these has gone NUM_AVATAR_LOW_RATE_SLOTS frames since it was last considered
+    const QVector<int>& lowRateAvatarIndices = _frameLowRateAvatars[lowRateSlot];
+    for (int i = 0; i < lowRateAvatarIndices.size(); i++) {
+        int avatarIndex = lowRateAvatarIndices[i];
+        const AvatarMixerFrameAvatar& otherAvatar = _frameAvatars[avatarIndex];
+        float distance = glm::distance(otherAvatar.position, listener.position);
+        
+        if (distance > AVATAR_INTEREST_RADIUS && otherAvatar.node->getUUID() != listenerUUID) {
+            addCandidateAvatar(avatarIndex, distance, NUM_AVATAR_LOW_RATE_SLOTS, listenerData, scratch);
+        }
+    }
+    
+    std::sort(scratch.candidateAvatars.begin(), scratch.candidateAvatars.end());
+    
+    // a struggling mixer shrinks every listener's budget rather than dropping avatars at random
+    int budgetBytes = (1.0f - _performanceThrottlingRatio) * listenerData->getMaxAvatarBytesPerSecond()
+        / AVATAR_DATA_SENDS_PER_SECOND;
+    
+    scratch.listenerAvatarIndices.resize(0);
+    scratch.listenerAvatarByteArrays.resize(0);
+    
+    for (int i = 0; i < scratch.candidateAvatars.size(); i++) {
+        int avatarIndex = scratch.candidateAvatars[i].avatarIndex;
+        const QByteArray& avatarByteArray = avatarByteArrayForListener(avatarIndex, listenerData, scratch);
+        
+        // the top avatar always goes, or one too big for a tight budget would block everyone behind it for good,
+        // and past it an avatar that does not fit leaves the rest of the budget to smaller ones
+        if (i > 0 && avatarByteArray.size() > budgetBytes) {
+            continue;
+        }
+        budgetBytes -= avatarByteArray.size();
+        
+        scratch.listenerAvatarIndices.append(avatarIndex);
+        scratch.listenerAvatarByteArrays.append(avatarByteArray);
+        
+        listenerData->clearAvatarPriority(_frameAvatars[avatarIndex].node->getUUID());
+        ++scratch.bandAvatarsSent[distanceBandForDistance(scratch.candidateAvatars[i].distance)];
+    }
+}
+
+void AvatarMixer::addCandidateAvatar(int avatarIndex, float distance, int numFrames,
+                                     AvatarMixerClientData* listenerData, AvatarMixerListenerScratch& scratch) const {
+    const AvatarMixerFrameAvatar& otherAvatar = _frameAvatars[avatarIndex];
+    
+    // how large the avatar looks, up to one when the listener is inside it
+    float priority = otherAvatar.radius / glm::max(distance, otherAvatar.radius);
+    
+    priority *= 1.0f + otherAvatar.speed / MOTION_PRIORITY_SPEED;
+    
+    if (listenerData->hasViewFrustum() && distance > AVATAR_KEYHOLE_RADIUS
+        && listenerData->getViewFrustum().sphereInFrustum(otherAvatar.position, otherAvatar.radius)
+            == ViewFrustum::OUTSIDE) {
+        priority *= OUT_OF_VIEW_PRIORITY_SCALE;
+    }
+    
+    AvatarMixerInterest interest;
+    interest.priority = listenerData->addToAvatarPriority(otherAvatar.node->getUUID(), priority * numFrames,
+                                                          _numBroadcastFrames);
+    interest.distance = distance;
+    interest.avatarIndex = avatarIndex;
+    scratch.candidateAvatars.append(interest);
+    
+    scratch.bandAvatarFrames[distanceBandForDistance(distance)] += numFrames;
+}
+
+const QByteArray& AvatarMixer::avatarByteArrayForListener(int avatarIndex, AvatarMixerClientData* listenerData,
+                                                          AvatarMixerListenerScratch& scratch) const {
+    const AvatarMixerFrameAvatar& frameAvatar = _frameAvatars[avatarIndex];
+    int baselineFrame = listenerData->getAckedStateFrame(frameAvatar.node->getUUID());
+    int baselineAge = _numBroadcastFrames - baselineFrame;
+    
+    // the listener only holds on to its last NUM_AVATAR_STATE_HISTORY states, past that it needs a whole one
+    if (baselineFrame < 0 || baselineAge <= 0 || baselineAge >= NUM_AVATAR_STATE_HISTORY) {
+        return frameAvatar.avatarByteArray;
+    }
+    
+    int deltaKey = avatarIndex * NUM_AVATAR_STATE_HISTORY + baselineAge;
+    QHash<int, QByteArray>::iterator deltaByteArray = scratch.deltaByteArrays.find(deltaKey);
+    
+    if (deltaByteArray == scratch.deltaByteArrays.end()) {
+        const QByteArray& state = frameAvatar.snapshot->stateByteArray;
+        QByteArray baseline = frameAvatar.nodeData->getState(baselineFrame);
+        QByteArray delta;
+        if (!baseline.isEmpty()) {
+            delta = AvatarDelta::encode(baseline, state);
+        }
+        
+        QByteArray newDeltaByteArray;
+        
+        if (delta.isEmpty() || delta.size() >= state.size()) {
+            // the baseline is gone or the avatar changed so much that the whole state is no bigger
+            newDeltaByteArray = frameAvatar.avatarByteArray;
+        } else {
+            quint16 deltaSize = delta.size();
+            
+            appendAvatarStateHeader(newDeltaByteArray, frameAvatar.node->getUUID(), _numBroadcastFrames, baselineAge);
+            newDeltaByteArray.append(reinterpret_cast<const char*>(&deltaSize), sizeof(deltaSize));
+            newDeltaByteArray.append(delta);
+        }
+        
+        deltaByteArray = scratch.deltaByteArrays.insert(deltaKey, newDeltaByteArray);
+    }
+    
+    return deltaByteArray.value();
 }
 
 void AvatarMixer::nodeKilled(SharedNodePointer killedNode) {
@@ -251,8 +479,8 @@ void AvatarMixer::readPendingDatagrams() {
                         
                         // parse the identity packet and update the change timestamp if appropriate
                         if (avatar.hasIdentityChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
+                            nodeData->publishSnapshot(avatarNode->getUUID());
                         }
                     }
                     break;
@@ -268,13 +496,28 @@ void AvatarMixer::readPendingDatagrams() {
                         
                         // parse the billboard packet and update the change timestamp if appropriate
                         if (avatar.hasBillboardChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setBillboardChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
+                            nodeData->publishSnapshot(avatarNode->getUUID());
                         }
                         
                     }
                     break;
                 }
+                case PacketTypeAvatarQuery:
+                case PacketTypeBulkAvatarDataAck: {
+                    
+                    // check if we have a matching node in our list
+                    SharedNodePointer avatarNode = nodeList->sendingNodeForPacket(receivedPacket);
+                    
+                    if (avatarNode && avatarNode->getLinkedData()) {
+                        AvatarMixerClientData* nodeData =
+                            static_cast<AvatarMixerClientData*>(avatarNode->getLinkedData());
+                        
+                        // the worker sending to this node applies it, in between building its packets
+                        nodeData->queueListenerPacket(receivedPacket);
+                    }
+                    break;
+                }
                 case PacketTypeKillAvatar: {
                     nodeList->processKillNode(receivedPacket);
                     break;
@@ -289,21 +532,49 @@ void AvatarMixer::readPendingDatagrams() {
 }
 
 void AvatarMixer::sendStatsPacket() {
+    QJsonObject statsObject = collectStats();
+    ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
+}
+
+QJsonObject AvatarMixer::collectStats() {
     QJsonObject statsObject;
     statsObject["average_listeners_last_second"] = (float) _sumListeners / (float) _numStatFrames;
     
     statsObject["average_billboard_packets_per_frame"] = (float) _sumBillboardPackets / (float) _numStatFrames;
     statsObject["average_identity_packets_per_frame"] = (float) _sumIdentityPackets / (float) _numStatFrames;
     
+    if (_sumListeners > 0) {
+        statsObject["average_avatars_per_listener"] = (float) _sumAvatarsSent / (float) _sumListeners;
+        statsObject["average_avatar_bytes_per_listener"] = (float) _sumAvatarBytesSent / (float) _sumListeners;
+    } else {
+        statsObject["average_avatars_per_listener"] = 0.0;
+        statsObject["average_avatar_bytes_per_listener"] = 0.0;
+    }
+    
+    // the rate a listener was sent the avatars in each band, out of the AVATAR_DATA_SENDS_PER_SECOND it could have been
+    QJsonObject updateRateObject;
+    for (int i = 0; i < NUM_AVATAR_DISTANCE_BANDS; i++) {
+        if (_sumBandAvatarFrames[i] > 0) {
+            float sendsPerFrame = (float) _sumBandAvatarsSent[i] / (float) _sumBandAvatarFrames[i];
+            updateRateObject[AVATAR_DISTANCE_BAND_NAMES[i]] = sendsPerFrame * AVATAR_DATA_SENDS_PER_SECOND;
+        }
+    }
+    statsObject["update_rate_by_distance"] = updateRateObject;
+    
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
     
-    ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
-    
     _sumListeners = 0;
     _sumBillboardPackets = 0;
     _sumIdentityPackets = 0;
+    _sumAvatarsSent = 0;
+    _sumAvatarBytesSent = 0;
     _numStatFrames = 0;
+    
+    memset(_sumBandAvatarFrames, 0, sizeof(_sumBandAvatarFrames));
+    memset(_sumBandAvatarsSent, 0, sizeof(_sumBandAvatarsSent));
+    
+    return statsObject;
 }
 
 void AvatarMixer::run() {
@@ -314,6 +585,8 @@ void AvatarMixer::run() {
     
     nodeList->linkedDataCreateCallback = attachAvatarDataToNode;
     
+    prepareToBroadcast();
+    
     // setup the timer that will be fired on the broadcast thread
     QTimer* broadcastTimer = new QTimer();
     broadcastTimer->setInterval(AVATAR_DATA_SEND_INTERVAL_MSECS);
@@ -15,13 +15,112 @@
 #ifndef hifi_AvatarMixer_h
 #define hifi_AvatarMixer_h
 
+#include <glm/glm.hpp>
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <PacketBuffer.h>
+#include <SharedUtil.h>
 #include <ThreadedAssignment.h>
 
+#include "AvatarInterestGrid.h"
+
+class AvatarMixerClientData;
+class AvatarMixerWorker;
+struct AvatarMixerSnapshot;
+
+const unsigned int AVATAR_DATA_SEND_INTERVAL_MSECS = (1.0f / 60.0f) * 1000;
+const int AVATAR_DATA_SENDS_PER_SECOND = MSECS_PER_SECOND / AVATAR_DATA_SEND_INTERVAL_MSECS;
+
+/// avatars past the interest radius take turns, each being considered for a listener once in this many frames
+const int NUM_AVATAR_LOW_RATE_SLOTS = 15;
+
+/// the update rate each listener gets is reported for avatars within 5, 10, 25, 50 and 100 meters, and beyond
+const int NUM_AVATAR_DISTANCE_BANDS = 6;
+
+/// the name each band's update rate goes by in the stats, nearest first
+extern const char* const AVATAR_DISTANCE_BAND_NAMES[NUM_AVATAR_DISTANCE_BANDS];
+
+/// An avatar as every listener is sent it this frame, put together before any listener's packet is
+struct AvatarMixerFrameAvatar {
+    SharedNodePointer node;
+    AvatarMixerClientData* nodeData; // kept alive by node, holds the states this avatar was sent in before
+    const AvatarMixerSnapshot* snapshot; // the node's published snapshot, left alone until the next frame
+    glm::vec3 position;
+    float radius; // the bounding radius at the avatar's scale
+    float speed; // meters per second since the last frame
+    QByteArray avatarByteArray; // the node's UUID, the state's sequence number and the whole state
+    int lowRateSlot; // the frame, modulo NUM_AVATAR_LOW_RATE_SLOTS, in which this avatar takes its low rate turn
+};
+
+/// A node the avatars are sent to this frame
+struct AvatarMixerFrameListener {
+    SharedNodePointer node;
+    AvatarMixerClientData* nodeData; // kept alive by node
+    glm::vec3 position;
+};
+
+/// An avatar a listener may be sent this frame, ordered highest priority first and nearest first between equals
+struct AvatarMixerInterest {
+    float priority;
+    float distance;
+    int avatarIndex;
+    
+    bool operator<(const AvatarMixerInterest& other) const {
+        return priority > other.priority || (priority == other.priority && distance < other.distance);
+    }
+};
+
+/// The working space a worker reuses from listener to listener
+struct AvatarMixerListenerScratch {
+    QVector<int> nearbyAvatarIndices;
+    QVector<AvatarMixerInterest> candidateAvatars;
+    QVector<int> listenerAvatarIndices;
+    QVector<QByteArray> listenerAvatarByteArrays;
+    
+    // by avatar index and baseline age, each encoded once for the listeners of the worker that share it
+    QHash<int, QByteArray> deltaByteArrays;
+    
+    // how many frames avatars in each distance band could have been sent to a listener, and how many they were
+    int bandAvatarFrames[NUM_AVATAR_DISTANCE_BANDS];
+    int bandAvatarsSent[NUM_AVATAR_DISTANCE_BANDS];
+};
+
+/// Where the packets of an AvatarMixer frame go, the node list or a stand-in that only counts them
+class AvatarMixerPacketSender {
+public:
+    virtual ~AvatarMixerPacketSender() { }
+    
+    /// sends a packet the sender may sign in place
+    virtual void sendPacket(PacketBuffer& packet, const SharedNodePointer& destinationNode) = 0;
+    
+    /// sends a packet too large for a PacketBuffer
+    virtual void sendPacket(const QByteArray& packet, const SharedNodePointer& destinationNode) = 0;
+};
+
 /// Handles assignments of type AvatarMixer - distribution of avatar data to various clients
 class AvatarMixer : public ThreadedAssignment {
 public:
     AvatarMixer(const QByteArray& packet);
     ~AvatarMixer();
+    
+    /// sets up the workers the listeners are split across
+    void prepareToBroadcast();
+    
+    /// moves the throttling on from how long the mixer was idle between the last frame and this one
+    void updatePerformanceThrottling(int idleMsecs);
+    
+    /// sends every listener in nodeHash its avatars for one frame through sender
+    void broadcastFrame(const NodeHash& nodeHash, AvatarMixerPacketSender& sender);
+    
+    /// \return the stats of the frames since the last call, which starts them over
+    QJsonObject collectStats();
+    
+    float getPerformanceThrottlingRatio() const { return _performanceThrottlingRatio; }
+    
 public slots:
     /// runs the avatar mixer
     void run();
@@ -34,19 +133,60 @@ public slots:
     void sendStatsPacket();
     
 private:
+    friend class AvatarMixerWorker;
+    
+    void parsePayload();
+    
     void broadcastAvatarData();
     
+    /// takes the snapshot of every avatar into _frameAvatars and every node to send to into _frameListeners
+    void prepareFrameAvatars(const NodeHash& nodeHash);
+    
+    /// fills the scratch's listenerAvatarIndices and listenerAvatarByteArrays with the avatars to send a listener
+    /// this frame, highest priority first and within its budget
+    /// every avatar the listener is not sent builds up priority, faster the larger it looks, the faster it moves
+    /// and if it is in view, so the budget goes round the avatars in proportion to how much they matter
+    void selectAvatarsForListener(const AvatarMixerFrameListener& listener, AvatarMixerListenerScratch& scratch) const;
+    
+    /// adds the priority the avatar built up over numFrames to the listener's and appends it to the candidates
+    void addCandidateAvatar(int avatarIndex, float distance, int numFrames, AvatarMixerClientData* listenerData,
+                            AvatarMixerListenerScratch& scratch) const;
+    
+    /// the bytes that send an avatar to a listener, a delta against the last state the listener acknowledged while
+    /// that state is recent enough, otherwise the whole state
+    const QByteArray& avatarByteArrayForListener(int avatarIndex, AvatarMixerClientData* listenerData,
+                                                 AvatarMixerListenerScratch& scratch) const;
+    
     QThread _broadcastThread;
     
+    int _numBroadcastThreads;
+    QThreadPool _broadcastThreadPool;
+    QVector<AvatarMixerWorker*> _workers;
+    
     quint64 _lastFrameTimestamp;
     
     float _trailingSleepRatio;
     float _performanceThrottlingRatio;
+    int _framesSinceCutoffEvent;
     
     int _sumListeners;
     int _numStatFrames;
     int _sumBillboardPackets;
     int _sumIdentityPackets;
+    
+    int _sumAvatarsSent;
+    int _sumAvatarBytesSent;
+    int _numBroadcastFrames;
+    
+    // how many frames avatars in each distance band could have been sent to a listener, and how many they were
+    int _sumBandAvatarFrames[NUM_AVATAR_DISTANCE_BANDS];
+    int _sumBandAvatarsSent[NUM_AVATAR_DISTANCE_BANDS];
+    
+    // the frame the workers read, only written before they start
+    QVector<AvatarMixerFrameAvatar> _frameAvatars;
+    AvatarInterestGrid _frameAvatarGrid;
+    QVector<int> _frameLowRateAvatars[NUM_AVATAR_LOW_RATE_SLOTS];
+    QVector<AvatarMixerFrameListener> _frameListeners;
 };
 
 #endif // hifi_AvatarMixer_h
@@ -9,23 +9,124 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstring>
+#include <limits>
+
+#include <QtCore/QMutexLocker>
+
 #include <PacketHeaders.h>
+#include <UUID.h>
 
 #include "AvatarMixerClientData.h"
 
+// set on _publishedSnapshot alongside the slot when it holds a snapshot the broadcast has not taken yet
+const int NEW_SNAPSHOT_FLAG = 4;
+
+// past this many the packets of a listener the broadcast has not got to are dropped, they only make the
+// listener's deltas smaller or its view newer
+const int MAX_QUEUED_LISTENER_PACKETS = 256;
+
 AvatarMixerClientData::AvatarMixerClientData() :
     NodeData(),
-    _hasReceivedFirstPackets(false),
     _billboardChangeTimestamp(0),
-    _identityChangeTimestamp(0)
+    _identityChangeTimestamp(0),
+    _billboardPacket(),
+    _billboardPacketTimestamp(0),
+    _identityPacket(),
+    _identityPacketTimestamp(0),
+    _writtenSnapshot(0),
+    _readSnapshot(1),
+    _publishedSnapshot(2),
+    _queuedListenerPacketsMutex(),
+    _queuedListenerPackets(),
+    _processedListenerPackets(),
+    _hasReceivedFirstPackets(false),
+    _avatarQuery(),
+    _hasViewFrustum(false),
+    _viewFrustum(),
+    _framePosition(),
+    _hasFramePosition(false),
+    _ackedStateFrames(),
+    _nextSentPacketSequence(0),
+    _avatarPriorities()
 {
+    for (int i = 0; i < NUM_SNAPSHOT_SLOTS; i++) {
+        _snapshots[i].position = glm::vec3();
+        _snapshots[i].targetScale = 1.0f;
+        _snapshots[i].billboardChangeTimestamp = 0;
+        _snapshots[i].identityChangeTimestamp = 0;
+    }
     
+    for (int i = 0; i < NUM_AVATAR_STATE_HISTORY; i++) {
+        _stateFrames[i] = -1;
+    }
+    
+    for (int i = 0; i < NUM_SENT_BULK_AVATAR_PACKETS; i++) {
+        _sentPackets[i].sequence = -1;
+    }
 }
 
 int AvatarMixerClientData::parseData(const QByteArray& packet) {
     // compute the offset to the data payload
     int offset = numBytesForPacketHeader(packet);
-    return _avatar.parseDataAtOffset(packet, offset);
+    int bytesRead = _avatar.parseDataAtOffset(packet, offset);
+    
+    publishSnapshot(uuidFromPacketHeader(packet));
+    
+    return bytesRead;
+}
+
+void AvatarMixerClientData::publishSnapshot(const QUuid& nodeUUID) {
+    AvatarMixerSnapshot& snapshot = _snapshots[_writtenSnapshot];
+    
+    snapshot.position = _avatar.getPosition();
+    snapshot.targetScale = _avatar.getTargetScale();
+    
+    // the state is packed once here rather than for every frame it is sent in
+    snapshot.stateByteArray = _avatar.toByteArray();
+    
+    // the cached packets are shared with the snapshot, not copied
+    snapshot.billboardChangeTimestamp = _billboardChangeTimestamp;
+    snapshot.billboardPacket = _billboardChangeTimestamp > 0 ? getBillboardPacket(nodeUUID) : QByteArray();
+    
+    snapshot.identityChangeTimestamp = _identityChangeTimestamp;
+    snapshot.identityPacket = _identityChangeTimestamp > 0 ? getIdentityPacket(nodeUUID) : QByteArray();
+    
+    // the slot published before this one, whether or not the broadcast took it, is the next one written
+    _writtenSnapshot = _publishedSnapshot.fetchAndStoreOrdered(_writtenSnapshot | NEW_SNAPSHOT_FLAG)
+        & ~NEW_SNAPSHOT_FLAG;
+}
+
+const AvatarMixerSnapshot& AvatarMixerClientData::acquireSnapshot() {
+    if (_publishedSnapshot.loadAcquire() & NEW_SNAPSHOT_FLAG) {
+        _readSnapshot = _publishedSnapshot.fetchAndStoreOrdered(_readSnapshot) & ~NEW_SNAPSHOT_FLAG;
+    }
+    return _snapshots[_readSnapshot];
+}
+
+void AvatarMixerClientData::queueListenerPacket(const QByteArray& packet) {
+    QMutexLocker queuedListenerPacketsLocker(&_queuedListenerPacketsMutex);
+    
+    if (_queuedListenerPackets.size() < MAX_QUEUED_LISTENER_PACKETS) {
+        _queuedListenerPackets.append(packet);
+    }
+}
+
+void AvatarMixerClientData::processQueuedListenerPackets() {
+    // the queue is swapped out so the receive path is only held up for as long as the swap takes
+    _queuedListenerPacketsMutex.lock();
+    _processedListenerPackets.swap(_queuedListenerPackets);
+    _queuedListenerPacketsMutex.unlock();
+    
+    for (int i = 0; i < _processedListenerPackets.size(); i++) {
+        if (packetTypeForPacket(_processedListenerPackets[i]) == PacketTypeAvatarQuery) {
+            parseAvatarQuery(_processedListenerPackets[i]);
+        } else {
+            parseBulkAvatarDataAck(_processedListenerPackets[i]);
+        }
+    }
+    
+    _processedListenerPackets.resize(0);
 }
 
 bool AvatarMixerClientData::checkAndSetHasReceivedFirstPackets() {
@@ -33,3 +134,149 @@ bool AvatarMixerClientData::checkAndSetHasReceivedFirstPackets() {
     _hasReceivedFirstPackets = true;
     return oldValue;
 }
+
+void AvatarMixerClientData::parseAvatarQuery(const QByteArray& packet) {
+    if (_avatarQuery.parseData(packet) > 0) {
+        _avatarQuery.loadViewFrustum(_viewFrustum);
+        _hasViewFrustum = true;
+    }
+}
+
+const QByteArray& AvatarMixerClientData::getBillboardPacket(const QUuid& nodeUUID) {
+    if (_billboardPacket.isEmpty() || _billboardPacketTimestamp != _billboardChangeTimestamp) {
+        _billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
+        _billboardPacket.append(nodeUUID.toRfc4122());
+        _billboardPacket.append(_avatar.getBillboard());
+        
+        _billboardPacketTimestamp = _billboardChangeTimestamp;
+    }
+    
+    return _billboardPacket;
+}
+
+const QByteArray& AvatarMixerClientData::getIdentityPacket(const QUuid& nodeUUID) {
+    if (_identityPacket.isEmpty() || _identityPacketTimestamp != _identityChangeTimestamp) {
+        _identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
+        
+        QByteArray individualData = _avatar.identityByteArray();
+        individualData.replace(0, NUM_BYTES_RFC4122_UUID, nodeUUID.toRfc4122());
+        _identityPacket.append(individualData);
+        
+        _identityPacketTimestamp = _identityChangeTimestamp;
+    }
+    
+    return _identityPacket;
+}
+
+float AvatarMixerClientData::recordFramePosition(const glm::vec3& position) {
+    float distanceMoved = _hasFramePosition ? glm::distance(position, _framePosition) : 0.0f;
+    
+    _framePosition = position;
+    _hasFramePosition = true;
+    
+    return distanceMoved;
+}
+
+void AvatarMixerClientData::recordState(int frame, const QByteArray& state) {
+    _states[frame % NUM_AVATAR_STATE_HISTORY] = state;
+    _stateFrames[frame % NUM_AVATAR_STATE_HISTORY] = frame;
+}
+
+QByteArray AvatarMixerClientData::getState(int frame) const {
+    if (_stateFrames[frame % NUM_AVATAR_STATE_HISTORY] != frame) {
+        return QByteArray();
+    }
+    return _states[frame % NUM_AVATAR_STATE_HISTORY];
+}
+
+quint16 AvatarMixerClientData::beginBulkAvatarPacket() {
+    // sequence numbers wrap where the quint16 on the wire does
+    int sequence = _nextSentPacketSequence;
+    _nextSentPacketSequence = (_nextSentPacketSequence + 1) % (std::numeric_limits<quint16>::max() + 1);
+    
+    // the oldest packet gives up its slot, if it has not been acknowledged by now it is taken as lost
+    AvatarMixerSentPacket& sentPacket = _sentPackets[sequence % NUM_SENT_BULK_AVATAR_PACKETS];
+    sentPacket.sequence = sequence;
+    sentPacket.avatarUUIDs.resize(0);
+    sentPacket.stateFrames.resize(0);
+    
+    return sequence;
+}
+
+void AvatarMixerClientData::addToBulkAvatarPacket(const QUuid& avatarUUID, int stateFrame) {
+    // the packet begun last sits in the slot before the next one's
+    int slot = (_nextSentPacketSequence + NUM_SENT_BULK_AVATAR_PACKETS - 1) % NUM_SENT_BULK_AVATAR_PACKETS;
+    AvatarMixerSentPacket& sentPacket = _sentPackets[slot];
+    sentPacket.avatarUUIDs.append(avatarUUID);
+    sentPacket.stateFrames.append(stateFrame);
+}
+
+void AvatarMixerClientData::parseBulkAvatarDataAck(const QByteArray& packet) {
+    const char* sourceBuffer = packet.constData() + numBytesForPacketHeader(packet);
+    const char* endOfPacket = packet.constData() + packet.size();
+    
+    while (endOfPacket - sourceBuffer >= (int) sizeof(quint16)) {
+        quint16 sequence;
+        memcpy(&sequence, sourceBuffer, sizeof(sequence));
+        sourceBuffer += sizeof(sequence);
+        
+        AvatarMixerSentPacket& sentPacket = _sentPackets[sequence % NUM_SENT_BULK_AVATAR_PACKETS];
+        if (sentPacket.sequence != sequence) {
+            continue;
+        }
+        
+        for (int i = 0; i < sentPacket.avatarUUIDs.size(); i++) {
+            QHash<QUuid, int>::iterator ackedStateFrame = _ackedStateFrames.find(sentPacket.avatarUUIDs[i]);
+            if (ackedStateFrame == _ackedStateFrames.end()) {
+                _ackedStateFrames.insert(sentPacket.avatarUUIDs[i], sentPacket.stateFrames[i]);
+            } else if (ackedStateFrame.value() < sentPacket.stateFrames[i]) {
+                ackedStateFrame.value() = sentPacket.stateFrames[i];
+            }
+        }
+        
+        // a packet is only acknowledged once
+        sentPacket.sequence = -1;
+    }
+}
+
+float AvatarMixerClientData::addToAvatarPriority(const QUuid& avatarUUID, float priority, int frame) {
+    QHash<QUuid, AvatarMixerPriority>::iterator avatarPriority = _avatarPriorities.find(avatarUUID);
+    
+    if (avatarPriority == _avatarPriorities.end()) {
+        AvatarMixerPriority newPriority = { 0.0f, frame };
+        avatarPriority = _avatarPriorities.insert(avatarUUID, newPriority);
+    }
+    
+    avatarPriority.value().priority += priority;
+    avatarPriority.value().lastConsideredFrame = frame;
+    
+    return avatarPriority.value().priority;
+}
+
+void AvatarMixerClientData::clearAvatarPriority(const QUuid& avatarUUID) {
+    QHash<QUuid, AvatarMixerPriority>::iterator avatarPriority = _avatarPriorities.find(avatarUUID);
+    
+    if (avatarPriority != _avatarPriorities.end()) {
+        avatarPriority.value().priority = 0.0f;
+    }
+}
+
+void AvatarMixerClientData::forgetAvatarsBefore(int frame) {
+    QHash<QUuid, AvatarMixerPriority>::iterator avatarPriority = _avatarPriorities.begin();
+    while (avatarPriority != _avatarPriorities.end()) {
+        if (avatarPriority.value().lastConsideredFrame < frame) {
+            avatarPriority = _avatarPriorities.erase(avatarPriority);
+        } else {
+            ++avatarPriority;
+        }
+    }
+    
+    QHash<QUuid, int>::iterator ackedStateFrame = _ackedStateFrames.begin();
+    while (ackedStateFrame != _ackedStateFrames.end()) {
+        if (ackedStateFrame.value() < frame) {
+            ackedStateFrame = _ackedStateFrames.erase(ackedStateFrame);
+        } else {
+            ++ackedStateFrame;
+        }
+    }
+}
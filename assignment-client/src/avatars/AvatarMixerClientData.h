@@ -12,32 +12,165 @@
 #ifndef hifi_AvatarMixerClientData_h
 #define hifi_AvatarMixerClientData_h
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
 #include <QtCore/QUrl>
+#include <QtCore/QVector>
 
 #include <AvatarData.h>
+#include <AvatarDelta.h>
+#include <AvatarQuery.h>
 #include <NodeData.h>
+#include <ViewFrustum.h>
+
+/// how many of the PacketTypeBulkAvatarData packets last sent to a listener can still be acknowledged
+const int NUM_SENT_BULK_AVATAR_PACKETS = 64;
+
+/// The avatar states that went out in one PacketTypeBulkAvatarData packet, by the frame they were taken in
+struct AvatarMixerSentPacket {
+    int sequence;
+    QVector<QUuid> avatarUUIDs;
+    QVector<int> stateFrames;
+};
+
+/// a slot for the receive path to write, one for the broadcast to read and one for the snapshot published last
+const int NUM_SNAPSHOT_SLOTS = 3;
+
+/// An avatar as the receive path last published it for the broadcast to read
+struct AvatarMixerSnapshot {
+    glm::vec3 position;
+    float targetScale;
+    QByteArray stateByteArray; // AvatarData::toByteArray, empty until the first AvatarData
+    quint64 billboardChangeTimestamp;
+    quint64 identityChangeTimestamp;
+    QByteArray billboardPacket;
+    QByteArray identityPacket;
+};
+
+/// The priority an avatar has built up with a listener since it was last sent to it
+struct AvatarMixerPriority {
+    float priority;
+    int lastConsideredFrame;
+};
 
 class AvatarMixerClientData : public NodeData {
     Q_OBJECT
 public:
     AvatarMixerClientData();
 
+    /// parses the avatar and publishes a snapshot of it
     int parseData(const QByteArray& packet);
     AvatarData& getAvatar() { return _avatar; }
     
-    bool checkAndSetHasReceivedFirstPackets();
-    
     quint64 getBillboardChangeTimestamp() const { return _billboardChangeTimestamp; }
     void setBillboardChangeTimestamp(quint64 billboardChangeTimestamp) { _billboardChangeTimestamp = billboardChangeTimestamp; }
     
     quint64 getIdentityChangeTimestamp() const { return _identityChangeTimestamp; }
     void setIdentityChangeTimestamp(quint64 identityChangeTimestamp) { _identityChangeTimestamp = identityChangeTimestamp; }
     
+    /// publishes the avatar as it stands now, only called from the thread that reads the avatar's packets
+    void publishSnapshot(const QUuid& nodeUUID);
+    
+    /// takes the snapshot published last, only called from the broadcast thread and once a frame
+    /// the snapshot returned is left alone until the next call, however many are published in the meantime
+    const AvatarMixerSnapshot& acquireSnapshot();
+    
+    /// hands a PacketTypeAvatarQuery or PacketTypeBulkAvatarDataAck from this listener over to the broadcast
+    void queueListenerPacket(const QByteArray& packet);
+    
+    /// from here down is only touched by the broadcast, what is about this node as a listener by the one worker
+    /// sending to it this frame
+    
+    /// applies the packets queued since the last call
+    void processQueuedListenerPackets();
+    
+    bool checkAndSetHasReceivedFirstPackets();
+    
+    /// false until the node has sent a query, nodes that never do are treated as seeing every direction
+    bool hasViewFrustum() const { return _hasViewFrustum; }
+    const ViewFrustum& getViewFrustum() const { return _viewFrustum; }
+    
+    int getMaxAvatarBytesPerSecond() const { return _avatarQuery.getMaxBytesPerSecond(); }
+    
+    /// \return how far this avatar has moved since the position last recorded for a frame
+    float recordFramePosition(const glm::vec3& position);
+    
+    /// keeps the state of this avatar sent in a frame, as a baseline for the deltas of later frames
+    /// states are only recorded before the workers start, which then all read them
+    void recordState(int frame, const QByteArray& state);
+    
+    /// \return the state of this avatar sent in frame, or an empty array if it is no longer held
+    QByteArray getState(int frame) const;
+    
+    /// \return the latest frame whose state of the avatar this listener has acknowledged, or -1 if there is none
+    int getAckedStateFrame(const QUuid& avatarUUID) const { return _ackedStateFrames.value(avatarUUID, -1); }
+    
+    /// starts recording the avatar states of a new packet to this listener
+    /// \return the sequence number that goes in the packet
+    quint16 beginBulkAvatarPacket();
+    void addToBulkAvatarPacket(const QUuid& avatarUUID, int stateFrame);
+    
+    /// adds to the priority this listener has for an avatar
+    /// \return the priority built up since the avatar was last sent to this listener
+    float addToAvatarPriority(const QUuid& avatarUUID, float priority, int frame);
+    
+    /// starts the avatar's priority over once it has been sent to this listener
+    void clearAvatarPriority(const QUuid& avatarUUID);
+    
+    /// forgets the priorities of avatars not considered since frame and the acknowledged states taken before it,
+    /// so avatars that have gone away do not pile up
+    void forgetAvatarsBefore(int frame);
+    
 private:
+    /// the billboard packet the mixer sends for this avatar, only rebuilt once the billboard has changed
+    const QByteArray& getBillboardPacket(const QUuid& nodeUUID);
+    
+    /// the identity packet the mixer sends for this avatar, only rebuilt once the identity has changed
+    const QByteArray& getIdentityPacket(const QUuid& nodeUUID);
+    
+    /// takes the view and budget from a PacketTypeAvatarQuery
+    void parseAvatarQuery(const QByteArray& packet);
+    
+    /// marks the states in the packets acknowledged by a PacketTypeBulkAvatarDataAck as held by this listener
+    void parseBulkAvatarDataAck(const QByteArray& packet);
+    
     AvatarData _avatar;
-    bool _hasReceivedFirstPackets;
     quint64 _billboardChangeTimestamp;
     quint64 _identityChangeTimestamp;
+    
+    QByteArray _billboardPacket;
+    quint64 _billboardPacketTimestamp;
+    QByteArray _identityPacket;
+    quint64 _identityPacketTimestamp;
+    
+    // each side swaps its slot for the one published last, so neither waits on the other
+    AvatarMixerSnapshot _snapshots[NUM_SNAPSHOT_SLOTS];
+    int _writtenSnapshot;
+    int _readSnapshot;
+    QAtomicInt _publishedSnapshot; // the slot published last, flagged until the broadcast has taken it
+    
+    QMutex _queuedListenerPacketsMutex;
+    QVector<QByteArray> _queuedListenerPackets;
+    QVector<QByteArray> _processedListenerPackets;
+    
+    bool _hasReceivedFirstPackets;
+    
+    AvatarQuery _avatarQuery;
+    bool _hasViewFrustum;
+    ViewFrustum _viewFrustum;
+    
+    glm::vec3 _framePosition;
+    bool _hasFramePosition;
+    
+    QByteArray _states[NUM_AVATAR_STATE_HISTORY];
+    int _stateFrames[NUM_AVATAR_STATE_HISTORY];
+    
+    QHash<QUuid, int> _ackedStateFrames;
+    AvatarMixerSentPacket _sentPackets[NUM_SENT_BULK_AVATAR_PACKETS];
+    int _nextSentPacketSequence;
+    
+    QHash<QUuid, AvatarMixerPriority> _avatarPriorities;
 };
 
 #endif // hifi_AvatarMixerClientData_h
@@ -0,0 +1,162 @@
+//
+//  AvatarMixerWorker.cpp
+//  assignment-client/src/avatars
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include <LimitedNodeList.h>
+#include <SharedUtil.h>
+
+#include "AvatarMixerClientData.h"
+
+#include "AvatarMixerWorker.h"
+
+const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
+
+// the packets a worker builds in a frame, enough for most frames without the lists growing
+const int EXPECTED_PACKETS_PER_FRAME = 256;
+
+AvatarMixerWorker::AvatarMixerWorker(AvatarMixer* mixer, int workerIndex, int numWorkers) :
+    _mixer(mixer),
+    _workerIndex(workerIndex),
+    _numWorkers(numWorkers),
+    _numAvatarsSent(0),
+    _numAvatarBytesSent(0),
+    _numBillboardPackets(0),
+    _numIdentityPackets(0),
+    _scratch(),
+    _packetPool(),
+    _packets(),
+    _packetListenerIndices(),
+    _largePackets(),
+    _largePacketListenerIndices()
+{
+    // the worker is re-used every frame, the mixer owns it
+    setAutoDelete(false);
+    
+    // a reserved QVector keeps its capacity through resize(0), so the lists stop allocating once they have held a
+    // busy frame
+    _packets.reserve(EXPECTED_PACKETS_PER_FRAME);
+    _packetListenerIndices.reserve(EXPECTED_PACKETS_PER_FRAME);
+    _largePackets.reserve(EXPECTED_PACKETS_PER_FRAME);
+    _largePacketListenerIndices.reserve(EXPECTED_PACKETS_PER_FRAME);
+}
+
+void AvatarMixerWorker::run() {
+    _numAvatarsSent = 0;
+    _numAvatarBytesSent = 0;
+    _numBillboardPackets = 0;
+    _numIdentityPackets = 0;
+    
+    memset(_scratch.bandAvatarFrames, 0, sizeof(_scratch.bandAvatarFrames));
+    memset(_scratch.bandAvatarsSent, 0, sizeof(_scratch.bandAvatarsSent));
+    _scratch.deltaByteArrays.clear();
+    
+    // the mixer has sent the last run's packets by now
+    for (int i = 0; i < _packets.size(); i++) {
+        _packetPool.release(_packets[i]);
+    }
+    
+    _packets.resize(0);
+    _packetListenerIndices.resize(0);
+    _largePackets.resize(0);
+    _largePacketListenerIndices.resize(0);
+    
+    int frame = _mixer->_numBroadcastFrames;
+    
+    // listeners are dealt out to the workers in turn, which keeps the shares even as nodes come and go
+    for (int i = _workerIndex; i < _mixer->_frameListeners.size(); i += _numWorkers) {
+        const AvatarMixerFrameListener& listener = _mixer->_frameListeners[i];
+        AvatarMixerClientData* listenerData = listener.nodeData;
+        
+        // what the listener has acknowledged and where it looks are only touched by the worker sending to it
+        listenerData->processQueuedListenerPackets();
+        
+        // once a second clear out what the listener holds for avatars that have gone away
+        if (frame % AVATAR_DATA_SENDS_PER_SECOND == 0) {
+            listenerData->forgetAvatarsBefore(frame - AVATAR_DATA_SENDS_PER_SECOND);
+        }
+        
+        PacketBuffer* packet = acquireBulkAvatarPacket(listenerData);
+        
+        _mixer->selectAvatarsForListener(listener, _scratch);
+        _numAvatarsSent += _scratch.listenerAvatarIndices.size();
+        
+        for (int j = 0; j < _scratch.listenerAvatarIndices.size(); j++) {
+            const AvatarMixerFrameAvatar& otherAvatar = _mixer->_frameAvatars[_scratch.listenerAvatarIndices[j]];
+            const QByteArray& otherAvatarByteArray = _scratch.listenerAvatarByteArrays[j];
+            
+            if (otherAvatarByteArray.size() > packet->getBytesAvailable()) {
+                appendPacket(packet, i);
+                packet = acquireBulkAvatarPacket(listenerData);
+            }
+            
+            if (!packet->append(otherAvatarByteArray)) {
+                // too large for a packet of its own, the listener is not told it was sent
+                continue;
+            }
+            listenerData->addToBulkAvatarPacket(otherAvatar.node->getUUID(), frame);
+            _numAvatarBytesSent += otherAvatarByteArray.size();
+            
+            // if the receiving avatar has just connected make sure we send out the mesh and billboard
+            // for this avatar (assuming they exist)
+            bool forceSend = !listenerData->checkAndSetHasReceivedFirstPackets();
+            
+            // we will also force a send of billboard or identity packet
+            // if either has changed in the last frame
+            const AvatarMixerSnapshot& otherSnapshot = *otherAvatar.snapshot;
+            
+            if (otherSnapshot.billboardChangeTimestamp > 0
+                && (forceSend
+                    || otherSnapshot.billboardChangeTimestamp > _mixer->_lastFrameTimestamp
+                    || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                appendCachedPacket(otherSnapshot.billboardPacket, i);
+                ++_numBillboardPackets;
+            }
+            
+            if (otherSnapshot.identityChangeTimestamp > 0
+                && (forceSend
+                    || otherSnapshot.identityChangeTimestamp > _mixer->_lastFrameTimestamp
+                    || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
+                appendCachedPacket(otherSnapshot.identityPacket, i);
+                ++_numIdentityPackets;
+            }
+        }
+        
+        appendPacket(packet, i);
+    }
+}
+
+PacketBuffer* AvatarMixerWorker::acquireBulkAvatarPacket(AvatarMixerClientData* listenerData) {
+    PacketBuffer* packet = _packetPool.acquire(PacketTypeBulkAvatarData);
+    
+    quint16 sequence = listenerData->beginBulkAvatarPacket();
+    packet->append(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+    
+    return packet;
+}
+
+void AvatarMixerWorker::appendPacket(PacketBuffer* packet, int listenerIndex) {
+    _packets.append(packet);
+    _packetListenerIndices.append(listenerIndex);
+}
+
+void AvatarMixerWorker::appendCachedPacket(const QByteArray& packet, int listenerIndex) {
+    PacketBuffer* buffer = _packetPool.acquire(PacketTypeUnknown);
+    
+    if (buffer->assign(packet)) {
+        appendPacket(buffer, listenerIndex);
+    } else {
+        _packetPool.release(buffer);
+        
+        // the cached packet is shared rather than copied
+        _largePackets.append(packet);
+        _largePacketListenerIndices.append(listenerIndex);
+    }
+}
@@ -0,0 +1,70 @@
+//
+//  AvatarMixerWorker.h
+//  assignment-client/src/avatars
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarMixerWorker_h
+#define hifi_AvatarMixerWorker_h
+
+#include <QtCore/QRunnable>
+
+#include <PacketBufferPool.h>
+
+#include "AvatarMixer.h"
+
+/// Puts together the packets for one share of the listeners in an AvatarMixer frame.
+/// The worker keeps the packets until the mixer sends them, so that workers never write to the same memory, and takes
+/// their buffers back for the next frame's packets when it next runs.
+class AvatarMixerWorker : public QRunnable {
+public:
+    AvatarMixerWorker(AvatarMixer* mixer, int workerIndex, int numWorkers);
+    
+    void run();
+    
+    /// the packets of the last run, each going to the frame listener at the same place in getPacketListenerIndices
+    const QVector<PacketBuffer*>& getPackets() const { return _packets; }
+    const QVector<int>& getPacketListenerIndices() const { return _packetListenerIndices; }
+    
+    /// the billboard packets of the last run too large for a buffer, each going to the frame listener at the same
+    /// place in getLargePacketListenerIndices
+    const QVector<QByteArray>& getLargePackets() const { return _largePackets; }
+    const QVector<int>& getLargePacketListenerIndices() const { return _largePacketListenerIndices; }
+    
+    int getNumAvatarsSent() const { return _numAvatarsSent; }
+    int getNumAvatarBytesSent() const { return _numAvatarBytesSent; }
+    int getNumBillboardPackets() const { return _numBillboardPackets; }
+    int getNumIdentityPackets() const { return _numIdentityPackets; }
+    int getNumBandAvatarFrames(int band) const { return _scratch.bandAvatarFrames[band]; }
+    int getNumBandAvatarsSent(int band) const { return _scratch.bandAvatarsSent[band]; }
+private:
+    /// \return a buffer holding a PacketTypeBulkAvatarData header and the sequence number the listener acknowledges
+    PacketBuffer* acquireBulkAvatarPacket(AvatarMixerClientData* listenerData);
+    
+    void appendPacket(PacketBuffer* packet, int listenerIndex);
+    
+    /// copies a packet cached by an avatar's client data into a buffer of its own, or keeps it as it is if it is too
+    /// large for one
+    void appendCachedPacket(const QByteArray& packet, int listenerIndex);
+    
+    AvatarMixer* _mixer;
+    int _workerIndex;
+    int _numWorkers;
+    int _numAvatarsSent;
+    int _numAvatarBytesSent;
+    int _numBillboardPackets;
+    int _numIdentityPackets;
+    AvatarMixerListenerScratch _scratch;
+    
+    PacketBufferPool _packetPool;
+    QVector<PacketBuffer*> _packets;
+    QVector<int> _packetListenerIndices;
+    QVector<QByteArray> _largePackets;
+    QVector<int> _largePacketListenerIndices;
+};
+
+#endif // hifi_AvatarMixerWorker_h
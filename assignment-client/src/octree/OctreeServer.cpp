@@ -713,6 +713,8 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += "                                 -----------\r\n";
         statsString += QString().sprintf("                         Total:  %8.2f %s\r\n",
                                          OctreeElement::getTotalMemoryUsage() / memoryScale, memoryScaleLabel);
+        statsString += QString().sprintf("          Slab Memory Reserved:  %8.2f %s\r\n",
+                                         OctreeAllocator::getTotalSlabBytes() / memoryScale, memoryScaleLabel);
         statsString += "\r\n";
 
         statsString += "OctreeElement Children Population Statistics...\r\n";
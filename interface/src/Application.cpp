@@ -1427,7 +1427,8 @@ bool Application::sendVoxelsOperation(OctreeElement* element, void* extraData) {
     VoxelTreeElement* voxel = (VoxelTreeElement*)element;
     SendVoxelsOperationArgs* args = (SendVoxelsOperationArgs*)extraData;
     if (voxel->isColored()) {
-        const unsigned char* nodeOctalCode = voxel->getOctalCode();
+        unsigned char nodeCodeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+        const unsigned char* nodeOctalCode = voxel->getOctalCode(nodeCodeBuffer);
         unsigned char* codeColorBuffer = NULL;
         int codeLength  = 0;
         int bytesInCode = 0;
@@ -1548,9 +1549,10 @@ void Application::pasteVoxels(const VoxelDetail& sourceVoxel) {
     // we only need the selected voxel to get the newBaseOctCode, which we can actually calculate from the
     // voxel size/position details. If we don't have an actual selectedNode then use the mouseVoxel to create a
     // target octalCode for where the user is pointing.
+    unsigned char selectedCodeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
     const unsigned char* octalCodeDestination;
     if (selectedNode) {
-        octalCodeDestination = selectedNode->getOctalCode();
+        octalCodeDestination = selectedNode->getOctalCode(selectedCodeBuffer);
     } else {
         octalCodeDestination = calculatedOctCode = pointToVoxel(sourceVoxel.x, sourceVoxel.y, sourceVoxel.z, sourceVoxel.s);
     }
@@ -2004,6 +2006,9 @@ void Application::updateMyAvatar(float deltaTime) {
 
     controlledBroadcastToNodes(packet, NodeSet() << NodeType::AvatarMixer);
 
+    // and let it know which of its avatar packets made it, so it can send the avatars as deltas against those
+    _avatarManager.sendBulkAvatarDataAcks();
+
     // Update _viewFrustum with latest camera and view frustum data...
     // NOTE: we get this from the view frustum, to make it simpler, since the
     // loadViewFrumstum() method will get the correct details from the camera
@@ -2024,10 +2029,25 @@ void Application::updateMyAvatar(float deltaTime) {
         _lastQueriedTime = now;
         queryOctree(NodeType::VoxelServer, PacketTypeVoxelQuery, _voxelServerJurisdictions);
         queryOctree(NodeType::ParticleServer, PacketTypeParticleQuery, _particleServerJurisdictions);
+        queryAvatarMixer();
         _lastQueriedViewFrustum = _viewFrustum;
     }
 }
 
+void Application::queryAvatarMixer() {
+    // the avatar mixer sends the avatars in this view every frame, and the rest only now and then
+    _avatarQuery.setViewFrustum(_viewFrustum);
+
+    QByteArray avatarQueryPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarQuery);
+    int numPacketHeaderBytes = avatarQueryPacket.size();
+
+    avatarQueryPacket.resize(MAX_PACKET_SIZE);
+    unsigned char* queryData = reinterpret_cast<unsigned char*>(avatarQueryPacket.data()) + numPacketHeaderBytes;
+    avatarQueryPacket.resize(numPacketHeaderBytes + _avatarQuery.getBroadcastData(queryData));
+
+    controlledBroadcastToNodes(avatarQueryPacket, NodeSet() << NodeType::AvatarMixer);
+}
+
 void Application::queryOctree(NodeType_t serverType, PacketType packetType, NodeToJurisdictionMap& jurisdictions) {
 
     // if voxels are disabled, then don't send this at all...
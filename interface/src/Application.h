@@ -34,6 +34,7 @@
 #include <ParticleCollisionSystem.h>
 #include <ParticleEditPacketSender.h>
 #include <ScriptEngine.h>
+#include <AvatarQuery.h>
 #include <OctreeQuery.h>
 #include <ViewFrustum.h>
 #include <VoxelEditPacketSender.h>
@@ -349,6 +350,7 @@ private:
 
     void updateMyAvatar(float deltaTime);
     void queryOctree(NodeType_t serverType, PacketType packetType, NodeToJurisdictionMap& jurisdictions);
+    void queryAvatarMixer();
     void loadViewFrustum(Camera& camera, ViewFrustum& viewFrustum);
 
     glm::vec3 getSunDirection();
@@ -424,6 +426,7 @@ private:
     float _trailingAudioLoudness;
 
     OctreeQuery _octreeQuery; // NodeData derived class for querying voxels from voxel server
+    AvatarQuery _avatarQuery; // the view the avatar mixer sends us the most avatar updates for
 
     AvatarManager _avatarManager;
     MyAvatar* _myAvatar;            // TODO: move this and relevant code to AvatarManager (or MyAvatar as the case may be)
@@ -32,6 +32,7 @@
 #include <QtMultimedia/QAudioOutput>
 #include <QSvgRenderer>
 
+#include <MixedAudioCodec.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
@@ -401,7 +402,8 @@ void Audio::handleAudioInput() {
     static char monoAudioDataPacket[MAX_PACKET_SIZE];
 
     static int numBytesPacketHeader = numBytesForPacketHeaderGivenPacketType(PacketTypeMicrophoneAudioNoEcho);
-    static int leadingBytes = numBytesPacketHeader + sizeof(glm::vec3) + sizeof(glm::quat);
+    static int leadingBytes = numBytesPacketHeader + sizeof(glm::vec3) + sizeof(glm::quat)
+        + sizeof(SUPPORTED_MIXED_AUDIO_ENCODINGS);
 
     static int16_t* monoAudioSamples = (int16_t*) (monoAudioDataPacket + leadingBytes);
 
@@ -631,6 +633,10 @@ void Audio::handleAudioInput() {
             memcpy(currentPacketPtr, &headOrientation, sizeof(headOrientation));
             currentPacketPtr += sizeof(headOrientation);
             
+            // let the mixer know which encodings we can decode the mix it sends back in
+            memcpy(currentPacketPtr, &SUPPORTED_MIXED_AUDIO_ENCODINGS, sizeof(SUPPORTED_MIXED_AUDIO_ENCODINGS));
+            currentPacketPtr += sizeof(SUPPORTED_MIXED_AUDIO_ENCODINGS);
+            
             nodeList->writeDatagram(monoAudioDataPacket, numAudioBytes + leadingBytes, audioMixer);
 
             Application::getInstance()->getBandwidthMeter()->outputStream(BandwidthMeter::AUDIO)
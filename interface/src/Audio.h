@@ -29,6 +29,7 @@
 
 #include <AbstractAudioInterface.h>
 #include <AudioRingBuffer.h>
+#include <MixedAudioRingBuffer.h>
 #include <StdDev.h>
 
 static const int NUM_AUDIO_CHANNELS = 2;
@@ -123,7 +124,7 @@ private:
     QAudioOutput* _proceduralAudioOutput;
     QIODevice* _proceduralOutputDevice;
     AudioRingBuffer _inputRingBuffer;
-    AudioRingBuffer _ringBuffer;
+    MixedAudioRingBuffer _ringBuffer;
 
     QString _inputAudioDeviceName;
     QString _outputAudioDeviceName;
@@ -308,11 +308,11 @@ void MyAvatar::simulate(float deltaTime) {
 
     _skeletonModel.simulate(deltaTime);
 
-    // copy out the skeleton joints from the model
+    // copy out the skeleton joints from the model, those barely off their default rotation are not worth sending
     _jointData.resize(_skeletonModel.getJointStateCount());
     for (int i = 0; i < _jointData.size(); i++) {
         JointData& data = _jointData[i];
-        data.valid = _skeletonModel.getJointState(i, data.rotation);
+        data.valid = _skeletonModel.getJointState(i, data.rotation, JOINT_ROTATION_DEFAULT_THRESHOLD);
     }
 
     Head* head = getHead();
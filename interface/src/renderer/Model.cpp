@@ -357,16 +357,16 @@ Extents Model::getBindExtents() const {
     return scaledExtents;
 }
 
-bool Model::getJointState(int index, glm::quat& rotation) const {
+bool Model::getJointState(int index, glm::quat& rotation, float threshold) const {
     if (index == -1 || index >= _jointStates.size()) {
         return false;
     }
     rotation = _jointStates.at(index).rotation;
     const glm::quat& defaultRotation = _geometry->getFBXGeometry().joints.at(index).rotation;
-    return glm::abs(rotation.x - defaultRotation.x) >= EPSILON ||
-        glm::abs(rotation.y - defaultRotation.y) >= EPSILON ||
-        glm::abs(rotation.z - defaultRotation.z) >= EPSILON ||
-        glm::abs(rotation.w - defaultRotation.w) >= EPSILON;
+    return glm::abs(rotation.x - defaultRotation.x) >= threshold ||
+        glm::abs(rotation.y - defaultRotation.y) >= threshold ||
+        glm::abs(rotation.z - defaultRotation.z) >= threshold ||
+        glm::abs(rotation.w - defaultRotation.w) >= threshold;
 }
 
 void Model::setJointState(int index, bool valid, const glm::quat& rotation) {
@@ -16,6 +16,7 @@
 #include <QUrl>
 
 #include <CapsuleShape.h>
+#include <SharedUtil.h>
 
 #include "GeometryCache.h"
 #include "InterfaceConfig.h"
@@ -87,8 +88,9 @@ public:
     int getJointStateCount() const { return _jointStates.size(); }
     
     /// Fetches the joint state at the specified index.
+    /// \param threshold how far any component of the rotation may be from the default's and still count as default
     /// \return whether or not the joint state is "valid" (that is, non-default)
-    bool getJointState(int index, glm::quat& rotation) const;
+    bool getJointState(int index, glm::quat& rotation, float threshold = EPSILON) const;
     
     /// Sets the joint state at the specified index.
     void setJointState(int index, bool valid, const glm::quat& rotation = glm::quat());
@@ -11,6 +11,7 @@
 
 #include <QtCore/QDataStream>
 
+#include <FrameScheduler.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
@@ -71,9 +72,8 @@ void AudioInjector::injectAudio() {
         quint8 volume = MAX_INJECTOR_VOLUME * _options.getVolume();
         packetStream << volume;
         
-        QElapsedTimer timer;
-        timer.start();
-        int nextFrame = 0;
+        FrameScheduler frameScheduler(BUFFER_SEND_INTERVAL_USECS);
+        frameScheduler.start();
         
         int currentSendPosition = 0;
         
@@ -103,12 +103,8 @@ void AudioInjector::injectAudio() {
             
             if (currentSendPosition != bytesToCopy && currentSendPosition < soundByteArray.size()) {
                 // not the first packet and not done
-                // sleep for the appropriate time
-                int usecToSleep = (++nextFrame * BUFFER_SEND_INTERVAL_USECS) - timer.nsecsElapsed() / 1000;
-                
-                if (usecToSleep > 0) {
-                    usleep(usecToSleep);
-                }
+                // sleep until the next packet is due
+                frameScheduler.waitForNextFrame();
             }
         }
     }
@@ -0,0 +1,99 @@
+//
+//  AudioLimiter.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "AudioMixKernel.h"
+#include "AudioRingBuffer.h"
+
+#include "AudioLimiter.h"
+
+const int MAX_LIMITER_BLOCKS = (NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + LIMITER_BLOCK_FRAMES - 1)
+    / LIMITER_BLOCK_FRAMES;
+
+static inline int16_t limitedSample(int32_t sample, float gain) {
+    float scaled = sample * gain;
+
+    if (scaled >= MAX_SAMPLE_VALUE) {
+        return MAX_SAMPLE_VALUE;
+    } else if (scaled <= MIN_SAMPLE_VALUE) {
+        return MIN_SAMPLE_VALUE;
+    } else {
+        return (int16_t) scaled;
+    }
+}
+
+AudioLimiter::AudioLimiter() :
+    _gain(1.0f)
+{
+
+}
+
+void AudioLimiter::render(const int32_t* mixBus, int16_t* outputSamples, int numFrames) {
+    int numBlocks = (numFrames + LIMITER_BLOCK_FRAMES - 1) / LIMITER_BLOCK_FRAMES;
+
+    // the gain each block needs for its peak to fit in int16_t
+    float requiredGain[MAX_LIMITER_BLOCKS];
+    bool needsLimiting = _gain < 1.0f;
+
+    for (int block = 0; block < numBlocks; block++) {
+        int lastSample = std::min((block + 1) * LIMITER_BLOCK_FRAMES, numFrames) * 2;
+        int32_t peak = 0;
+
+        for (int i = block * LIMITER_BLOCK_FRAMES * 2; i < lastSample; i++) {
+            peak = std::max(peak, std::abs(mixBus[i]));
+        }
+
+        requiredGain[block] = 1.0f;
+        if (peak > MAX_SAMPLE_VALUE) {
+            requiredGain[block] = (float) MAX_SAMPLE_VALUE / peak;
+            needsLimiting = true;
+        }
+    }
+
+    if (!needsLimiting) {
+        AudioMixKernel::saturateMixBus(mixBus, outputSamples, numFrames * 2);
+        return;
+    }
+
+    // there is no look-ahead past the end of the last frame, so a peak at the start of this one is caught with a step
+    _gain = std::min(_gain, requiredGain[0]);
+
+    for (int block = 0; block < numBlocks; block++) {
+        float targetGain = requiredGain[block];
+        for (int ahead = block + 1; ahead <= block + LIMITER_LOOKAHEAD_BLOCKS && ahead < numBlocks; ahead++) {
+            targetGain = std::min(targetGain, requiredGain[ahead]);
+        }
+
+        // attack reaches the target by the end of the block, release only moves part of the way there
+        float endGain = targetGain < _gain ? targetGain : _gain + (targetGain - _gain) * LIMITER_RELEASE_RATIO;
+
+        int firstFrame = block * LIMITER_BLOCK_FRAMES;
+        int blockFrames = std::min(LIMITER_BLOCK_FRAMES, numFrames - firstFrame);
+        float gainStep = (endGain - _gain) / blockFrames;
+
+        for (int i = 0; i < blockFrames; i++) {
+            float gain = _gain + gainStep * (i + 1);
+            int sample = (firstFrame + i) * 2;
+
+            outputSamples[sample] = limitedSample(mixBus[sample], gain);
+            outputSamples[sample + 1] = limitedSample(mixBus[sample + 1], gain);
+        }
+
+        _gain = endGain;
+    }
+
+    // close enough to unity that the plain saturation can take over again
+    const float UNITY_GAIN_THRESHOLD = 0.999f;
+    if (_gain > UNITY_GAIN_THRESHOLD) {
+        _gain = 1.0f;
+    }
+}
@@ -0,0 +1,35 @@
+//
+//  AudioLimiter.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioLimiter_h
+#define hifi_AudioLimiter_h
+
+#include <stdint.h>
+
+const int LIMITER_BLOCK_FRAMES = 32;
+const int LIMITER_LOOKAHEAD_BLOCKS = 2;
+const float LIMITER_RELEASE_RATIO = 0.05f;
+
+/// Brings a 32-bit stereo mix bus down to int16_t samples for one listener, frame after frame.
+/// The gain is ramped per block of LIMITER_BLOCK_FRAMES frames and looks ahead LIMITER_LOOKAHEAD_BLOCKS blocks within
+/// the frame, so a loud block is already attenuated when it starts. When nothing is loud it is a plain saturation.
+class AudioLimiter {
+public:
+    AudioLimiter();
+
+    /// renders numFrames interleaved stereo frames, numFrames can be at most NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL
+    void render(const int32_t* mixBus, int16_t* outputSamples, int numFrames);
+
+    float getGain() const { return _gain; }
+private:
+    float _gain;
+};
+
+#endif // hifi_AudioLimiter_h
@@ -0,0 +1,331 @@
+//
+//  AudioMixKernel.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AUDIO_MIX_KERNEL_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#endif
+
+#include "AudioMixKernel.h"
+
+#if defined(AUDIO_MIX_KERNEL_X86) && defined(__GNUC__)
+// let the compiler emit wider instructions for a single function without raising the ISA of the whole build
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define SSE2_FUNCTION
+#define AVX2_FUNCTION
+#endif
+
+// the padded scratch buffers leave room for a full vector to be read past the last delayed frame
+const int MAX_MIX_FRAMES = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + SAMPLE_PHASE_DELAY_AT_90;
+const int MAX_VECTOR_FRAMES = 16;
+const int SCRATCH_BUFFER_SAMPLES = MAX_MIX_FRAMES + MAX_VECTOR_FRAMES;
+
+// truncates toward zero like the float to int16_t conversion the mixer has always used, then clamps
+static inline int16_t saturatedSample(float sample) {
+    if (sample >= MAX_SAMPLE_VALUE) {
+        return MAX_SAMPLE_VALUE;
+    } else if (sample <= MIN_SAMPLE_VALUE) {
+        return MIN_SAMPLE_VALUE;
+    } else {
+        return (int16_t) sample;
+    }
+}
+
+// Every kernel below splits the mix into three passes so that each one runs over whole vectors:
+// 1. attenuate the source frame into the strong channel samples
+// 2. scale the strong channel samples by the weak channel ratio, behind the delayed history
+// 3. interleave the two channels and add them to the 32-bit stereo mix bus
+
+static void prepareDelayHistory(int16_t* delayedSamples, const int16_t* delayHistory,
+                                const SpatializedMixParameters& parameters) {
+    // history samples were never attenuated on their own, so they take the combined ratio in one step
+    float attenuationAndWeakChannelRatio = parameters.attenuationCoefficient * parameters.weakChannelAmplitudeRatio;
+
+    for (int i = 0; i < parameters.numSamplesDelay; i++) {
+        delayedSamples[i] = saturatedSample(delayHistory[i] * attenuationAndWeakChannelRatio);
+    }
+}
+
+static void addInterleavedTail(int32_t* mixBus, const int16_t* strongSamples, const int16_t* delayedSamples,
+                               int firstFrame, int numFrames, const SpatializedMixParameters& parameters) {
+    int delayedChannelOffset = parameters.isRightChannelDelayed ? 1 : 0;
+    int strongChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+
+    for (int i = firstFrame; i < numFrames; i++) {
+        mixBus[(i * 2) + strongChannelOffset] += strongSamples[i];
+        mixBus[(i * 2) + delayedChannelOffset] += delayedSamples[i];
+    }
+}
+
+static void saturateMixBusTail(const int32_t* mixBus, int16_t* outputSamples, int firstSample, int numSamples) {
+    for (int i = firstSample; i < numSamples; i++) {
+        outputSamples[i] = mixBus[i] > MAX_SAMPLE_VALUE
+            ? MAX_SAMPLE_VALUE : (mixBus[i] < MIN_SAMPLE_VALUE ? MIN_SAMPLE_VALUE : mixBus[i]);
+    }
+}
+
+static void addSpatializedFrameScalar(int32_t* mixBus, const int16_t* frameSamples, const int16_t* delayHistory,
+                                      const SpatializedMixParameters& parameters) {
+    int16_t strongSamples[SCRATCH_BUFFER_SAMPLES];
+    int16_t delayedSamples[SCRATCH_BUFFER_SAMPLES];
+    int numFrames = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + parameters.numSamplesDelay;
+
+    memset(strongSamples + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, 0, SAMPLE_PHASE_DELAY_AT_90 * sizeof(int16_t));
+    prepareDelayHistory(delayedSamples, delayHistory, parameters);
+
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+        strongSamples[i] = saturatedSample(frameSamples[i] * parameters.attenuationCoefficient);
+        delayedSamples[i + parameters.numSamplesDelay] = saturatedSample(strongSamples[i]
+                                                                         * parameters.weakChannelAmplitudeRatio);
+    }
+
+    addInterleavedTail(mixBus, strongSamples, delayedSamples, 0, numFrames, parameters);
+}
+
+#ifdef AUDIO_MIX_KERNEL_X86
+
+SSE2_FUNCTION static inline __m128i scaleSamplesSSE2(__m128i samples, __m128 ratio) {
+    // sign extend the eight int16_t samples to two sets of four int32_t
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+    low = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(low), ratio));
+    high = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(high), ratio));
+
+    return _mm_packs_epi32(low, high);
+}
+
+SSE2_FUNCTION static inline void addInterleavedSSE2(int32_t* mixBus, __m128i interleaved) {
+    // sign extend the eight int16_t samples to two sets of four int32_t
+    __m128i* low = (__m128i*) mixBus;
+    __m128i* high = (__m128i*) (mixBus + 4);
+
+    _mm_storeu_si128(low, _mm_add_epi32(_mm_loadu_si128(low),
+                                        _mm_srai_epi32(_mm_unpacklo_epi16(interleaved, interleaved), 16)));
+    _mm_storeu_si128(high, _mm_add_epi32(_mm_loadu_si128(high),
+                                         _mm_srai_epi32(_mm_unpackhi_epi16(interleaved, interleaved), 16)));
+}
+
+SSE2_FUNCTION static void addSpatializedFrameSSE2(int32_t* mixBus, const int16_t* frameSamples,
+                                                  const int16_t* delayHistory,
+                                                  const SpatializedMixParameters& parameters) {
+    const int FRAMES_PER_VECTOR = 8;
+
+    int16_t strongSamples[SCRATCH_BUFFER_SAMPLES];
+    int16_t delayedSamples[SCRATCH_BUFFER_SAMPLES];
+    int numFrames = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + parameters.numSamplesDelay;
+
+    memset(strongSamples + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, 0, SAMPLE_PHASE_DELAY_AT_90 * sizeof(int16_t));
+    prepareDelayHistory(delayedSamples, delayHistory, parameters);
+
+    __m128 attenuation = _mm_set1_ps(parameters.attenuationCoefficient);
+    __m128 weakChannelRatio = _mm_set1_ps(parameters.weakChannelAmplitudeRatio);
+
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i += FRAMES_PER_VECTOR) {
+        __m128i strong = scaleSamplesSSE2(_mm_loadu_si128((const __m128i*) (frameSamples + i)), attenuation);
+        _mm_storeu_si128((__m128i*) (strongSamples + i), strong);
+        _mm_storeu_si128((__m128i*) (delayedSamples + i + parameters.numSamplesDelay),
+                         scaleSamplesSSE2(strong, weakChannelRatio));
+    }
+
+    int i = 0;
+    for (; i + FRAMES_PER_VECTOR <= numFrames; i += FRAMES_PER_VECTOR) {
+        __m128i strong = _mm_loadu_si128((const __m128i*) (strongSamples + i));
+        __m128i delayed = _mm_loadu_si128((const __m128i*) (delayedSamples + i));
+
+        __m128i left = parameters.isRightChannelDelayed ? strong : delayed;
+        __m128i right = parameters.isRightChannelDelayed ? delayed : strong;
+
+        addInterleavedSSE2(mixBus + (i * 2), _mm_unpacklo_epi16(left, right));
+        addInterleavedSSE2(mixBus + (i * 2) + FRAMES_PER_VECTOR, _mm_unpackhi_epi16(left, right));
+    }
+
+    addInterleavedTail(mixBus, strongSamples, delayedSamples, i, numFrames, parameters);
+}
+
+AVX2_FUNCTION static inline __m256i scaleSamplesAVX2(__m256i samples, __m256 ratio) {
+    __m256i low = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(samples));
+    __m256i high = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(samples, 1));
+
+    low = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(low), ratio));
+    high = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(high), ratio));
+
+    // the pack works within each 128-bit lane, so put the 64-bit quarters back in order afterwards
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+}
+
+AVX2_FUNCTION static inline void addInterleavedAVX2(int32_t* mixBus, __m256i interleaved) {
+    __m256i* low = (__m256i*) mixBus;
+    __m256i* high = (__m256i*) (mixBus + 8);
+
+    _mm256_storeu_si256(low, _mm256_add_epi32(_mm256_loadu_si256(low),
+                                              _mm256_cvtepi16_epi32(_mm256_castsi256_si128(interleaved))));
+    _mm256_storeu_si256(high, _mm256_add_epi32(_mm256_loadu_si256(high),
+                                               _mm256_cvtepi16_epi32(_mm256_extracti128_si256(interleaved, 1))));
+}
+
+AVX2_FUNCTION static void addSpatializedFrameAVX2(int32_t* mixBus, const int16_t* frameSamples,
+                                                  const int16_t* delayHistory,
+                                                  const SpatializedMixParameters& parameters) {
+    const int FRAMES_PER_VECTOR = 16;
+
+    int16_t strongSamples[SCRATCH_BUFFER_SAMPLES];
+    int16_t delayedSamples[SCRATCH_BUFFER_SAMPLES];
+    int numFrames = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + parameters.numSamplesDelay;
+
+    memset(strongSamples + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, 0, SAMPLE_PHASE_DELAY_AT_90 * sizeof(int16_t));
+    prepareDelayHistory(delayedSamples, delayHistory, parameters);
+
+    __m256 attenuation = _mm256_set1_ps(parameters.attenuationCoefficient);
+    __m256 weakChannelRatio = _mm256_set1_ps(parameters.weakChannelAmplitudeRatio);
+
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i += FRAMES_PER_VECTOR) {
+        __m256i strong = scaleSamplesAVX2(_mm256_loadu_si256((const __m256i*) (frameSamples + i)), attenuation);
+        _mm256_storeu_si256((__m256i*) (strongSamples + i), strong);
+        _mm256_storeu_si256((__m256i*) (delayedSamples + i + parameters.numSamplesDelay),
+                            scaleSamplesAVX2(strong, weakChannelRatio));
+    }
+
+    int i = 0;
+    for (; i + FRAMES_PER_VECTOR <= numFrames; i += FRAMES_PER_VECTOR) {
+        __m256i strong = _mm256_loadu_si256((const __m256i*) (strongSamples + i));
+        __m256i delayed = _mm256_loadu_si256((const __m256i*) (delayedSamples + i));
+
+        __m256i left = parameters.isRightChannelDelayed ? strong : delayed;
+        __m256i right = parameters.isRightChannelDelayed ? delayed : strong;
+
+        // the unpacks also work per 128-bit lane, swap the middle halves to get frames 0-7 and 8-15
+        __m256i low = _mm256_unpacklo_epi16(left, right);
+        __m256i high = _mm256_unpackhi_epi16(left, right);
+
+        addInterleavedAVX2(mixBus + (i * 2), _mm256_permute2x128_si256(low, high, 0x20));
+        addInterleavedAVX2(mixBus + (i * 2) + FRAMES_PER_VECTOR, _mm256_permute2x128_si256(low, high, 0x31));
+    }
+
+    addInterleavedTail(mixBus, strongSamples, delayedSamples, i, numFrames, parameters);
+}
+
+SSE2_FUNCTION static void saturateMixBusSSE2(const int32_t* mixBus, int16_t* outputSamples, int numSamples) {
+    const int SAMPLES_PER_VECTOR = 8;
+
+    int i = 0;
+    for (; i + SAMPLES_PER_VECTOR <= numSamples; i += SAMPLES_PER_VECTOR) {
+        __m128i low = _mm_loadu_si128((const __m128i*) (mixBus + i));
+        __m128i high = _mm_loadu_si128((const __m128i*) (mixBus + i + 4));
+        _mm_storeu_si128((__m128i*) (outputSamples + i), _mm_packs_epi32(low, high));
+    }
+
+    saturateMixBusTail(mixBus, outputSamples, i, numSamples);
+}
+
+#endif // AUDIO_MIX_KERNEL_X86
+
+void AudioMixKernel::clearMixBus(int32_t* mixBus) {
+    memset(mixBus, 0, SPATIALIZED_MIX_BUFFER_SAMPLES * sizeof(int32_t));
+}
+
+AudioMixKernel::InstructionSet AudioMixKernel::getBestAvailableInstructionSet() {
+#if defined(AUDIO_MIX_KERNEL_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return SSE2;
+    }
+#elif defined(AUDIO_MIX_KERNEL_X86) && defined(_MSC_VER)
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    int highestFunction = cpuInfo[0];
+
+    __cpuid(cpuInfo, 1);
+    bool hasSSE2 = (cpuInfo[3] & (1 << 26)) != 0;
+
+    // AVX2 needs the OS to save the YMM registers as well as CPU support
+    const int OSXSAVE_BIT = 1 << 27;
+    const int XCR0_SSE_AND_AVX_STATE = 0x6;
+    bool hasYMMState = (cpuInfo[2] & OSXSAVE_BIT) && (_xgetbv(0) & XCR0_SSE_AND_AVX_STATE) == XCR0_SSE_AND_AVX_STATE;
+
+    if (highestFunction >= 7 && hasYMMState) {
+        __cpuidex(cpuInfo, 7, 0);
+        if (cpuInfo[1] & (1 << 5)) {
+            return AVX2;
+        }
+    }
+
+    if (hasSSE2) {
+        return SSE2;
+    }
+#endif
+    return Scalar;
+}
+
+const char* AudioMixKernel::getInstructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+        case AVX2:
+            return "AVX2";
+        case SSE2:
+            return "SSE2";
+        default:
+            return "scalar";
+    }
+}
+
+void AudioMixKernel::addSpatializedFrameWithInstructionSet(InstructionSet instructionSet, int32_t* mixBus,
+                                                           const int16_t* frameSamples, const int16_t* delayHistory,
+                                                           const SpatializedMixParameters& parameters) {
+    switch (instructionSet) {
+#ifdef AUDIO_MIX_KERNEL_X86
+        case AVX2:
+            addSpatializedFrameAVX2(mixBus, frameSamples, delayHistory, parameters);
+            break;
+        case SSE2:
+            addSpatializedFrameSSE2(mixBus, frameSamples, delayHistory, parameters);
+            break;
+#endif
+        default:
+            addSpatializedFrameScalar(mixBus, frameSamples, delayHistory, parameters);
+            break;
+    }
+}
+
+void AudioMixKernel::addSpatializedFrame(int32_t* mixBus, const int16_t* frameSamples, const int16_t* delayHistory,
+                                         const SpatializedMixParameters& parameters) {
+    static InstructionSet bestInstructionSet = getBestAvailableInstructionSet();
+    addSpatializedFrameWithInstructionSet(bestInstructionSet, mixBus, frameSamples, delayHistory, parameters);
+}
+
+void AudioMixKernel::saturateMixBusWithInstructionSet(InstructionSet instructionSet, const int32_t* mixBus,
+                                                      int16_t* outputSamples, int numSamples) {
+#ifdef AUDIO_MIX_KERNEL_X86
+    // a saturating pack is as wide as it gets, AVX2 would only add a lane fix-up
+    if (instructionSet >= SSE2) {
+        saturateMixBusSSE2(mixBus, outputSamples, numSamples);
+        return;
+    }
+#endif
+    saturateMixBusTail(mixBus, outputSamples, 0, numSamples);
+}
+
+void AudioMixKernel::saturateMixBus(const int32_t* mixBus, int16_t* outputSamples, int numSamples) {
+    static InstructionSet bestInstructionSet = getBestAvailableInstructionSet();
+    saturateMixBusWithInstructionSet(bestInstructionSet, mixBus, outputSamples, numSamples);
+}
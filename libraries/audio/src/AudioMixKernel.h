@@ -0,0 +1,68 @@
+//
+//  AudioMixKernel.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixKernel_h
+#define hifi_AudioMixKernel_h
+
+#include <stdint.h>
+
+#include "AudioRingBuffer.h"
+
+const int SAMPLE_PHASE_DELAY_AT_90 = 20;
+
+// a spatialized mix can push the delayed channel up to SAMPLE_PHASE_DELAY_AT_90 frames past the end of a network buffer
+const int SPATIALIZED_MIX_BUFFER_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2);
+
+/// The per source/listener pair values that decide how a mono frame is added to a stereo mix
+struct SpatializedMixParameters {
+    float attenuationCoefficient;
+    float weakChannelAmplitudeRatio;
+    int numSamplesDelay;
+    bool isRightChannelDelayed;
+};
+
+namespace AudioMixKernel {
+    enum InstructionSet {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /// the widest instruction set supported by the CPU we are running on
+    InstructionSet getBestAvailableInstructionSet();
+
+    const char* getInstructionSetName(InstructionSet instructionSet);
+
+    /// zeroes a mix bus for the next frame, all SPATIALIZED_MIX_BUFFER_SAMPLES of it, so the delayed channel's tail
+    /// past the network buffer does not carry over and build up on a reused bus
+    void clearMixBus(int32_t* mixBus);
+
+    /// Adds one frame of NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL mono samples to an interleaved 32-bit stereo mix bus.
+    /// The strong channel gets the attenuated samples, the weak channel gets them scaled by the weak channel ratio and
+    /// delayed by numSamplesDelay frames. The first numSamplesDelay frames of the weak channel come from delayHistory,
+    /// the samples that immediately precede frameSamples in the source. Nothing saturates on the bus, so the result
+    /// does not depend on the order frames are added. mixBus must hold at least SPATIALIZED_MIX_BUFFER_SAMPLES samples.
+    void addSpatializedFrame(int32_t* mixBus, const int16_t* frameSamples, const int16_t* delayHistory,
+                             const SpatializedMixParameters& parameters);
+
+    /// same as addSpatializedFrame but forces the given instruction set, which must be supported by this CPU
+    void addSpatializedFrameWithInstructionSet(InstructionSet instructionSet, int32_t* mixBus,
+                                               const int16_t* frameSamples, const int16_t* delayHistory,
+                                               const SpatializedMixParameters& parameters);
+
+    /// clamps numSamples samples of a mix bus to int16_t, the one saturation a mix goes through
+    void saturateMixBus(const int32_t* mixBus, int16_t* outputSamples, int numSamples);
+
+    /// same as saturateMixBus but forces the given instruction set, which must be supported by this CPU
+    void saturateMixBusWithInstructionSet(InstructionSet instructionSet, const int32_t* mixBus,
+                                          int16_t* outputSamples, int numSamples);
+}
+
+#endif // hifi_AudioMixKernel_h
@@ -18,25 +18,25 @@
 
 #include "AudioRingBuffer.h"
 
-AudioRingBuffer::AudioRingBuffer(int numFrameSamples, bool randomAccessMode) :
+AudioRingBuffer::AudioRingBuffer(int numFrameSamples, bool randomAccessMode, bool isLockFree) :
     NodeData(),
     _sampleCapacity(numFrameSamples * RING_BUFFER_LENGTH_FRAMES),
     _numFrameSamples(numFrameSamples),
     _isStarved(true),
     _hasStarted(false),
-    _randomAccessMode(randomAccessMode)
+    _randomAccessMode(randomAccessMode),
+    _isLockFree(isLockFree),
+    _nextOutput(),
+    _endOfLastWrite(),
+    _numOverflows(0)
 {
     if (numFrameSamples) {
         _buffer = new int16_t[_sampleCapacity];
         if (_randomAccessMode) {
             memset(_buffer, 0, _sampleCapacity * sizeof(int16_t));
         }
-        _nextOutput = _buffer;
-        _endOfLastWrite = _buffer;
     } else {
         _buffer = NULL;
-        _nextOutput = NULL;
-        _endOfLastWrite = NULL;
     }
 };
 
@@ -45,8 +45,13 @@ AudioRingBuffer::~AudioRingBuffer() {
 }
 
 void AudioRingBuffer::reset() {
-    _endOfLastWrite = _buffer;
-    _nextOutput = _buffer;
+    if (_isLockFree) {
+        // the write position belongs to the writer, so skip ahead to it instead
+        _nextOutput.store(_endOfLastWrite.load());
+    } else {
+        _endOfLastWrite.store(0);
+        _nextOutput.store(0);
+    }
     _isStarved = true;
 }
 
@@ -57,8 +62,8 @@ void AudioRingBuffer::resizeForFrameSize(qint64 numFrameSamples) {
     if (_randomAccessMode) {
         memset(_buffer, 0, _sampleCapacity * sizeof(int16_t));
     }
-    _nextOutput = _buffer;
-    _endOfLastWrite = _buffer;
+    _nextOutput.store(0);
+    _endOfLastWrite.store(0);
 }
 
 int AudioRingBuffer::parseData(const QByteArray& packet) {
@@ -79,17 +84,19 @@ qint64 AudioRingBuffer::readData(char *data, qint64 maxSize) {
     // differently. Namely, if anything has been written, we say we have as many samples as they ask for
     // otherwise we say we have nothing available
     if (_randomAccessMode) {
-        numReadSamples = _endOfLastWrite ? (maxSize / sizeof(int16_t)) : 0;
+        numReadSamples = _buffer ? (maxSize / sizeof(int16_t)) : 0;
     }
 
-    if (_nextOutput + numReadSamples > _buffer + _sampleCapacity) {
+    int16_t* nextOutput = _buffer + _nextOutput.load();
+
+    if (nextOutput + numReadSamples > _buffer + _sampleCapacity) {
         // we're going to need to do two reads to get this data, it wraps around the edge
 
         // read to the end of the buffer
-        int numSamplesToEnd = (_buffer + _sampleCapacity) - _nextOutput;
-        memcpy(data, _nextOutput, numSamplesToEnd * sizeof(int16_t));
+        int numSamplesToEnd = (_buffer + _sampleCapacity) - nextOutput;
+        memcpy(data, nextOutput, numSamplesToEnd * sizeof(int16_t));
         if (_randomAccessMode) {
-            memset(_nextOutput, 0, numSamplesToEnd * sizeof(int16_t)); // clear it
+            memset(nextOutput, 0, numSamplesToEnd * sizeof(int16_t)); // clear it
         }
         
         // read the rest from the beginning of the buffer
@@ -99,14 +106,14 @@ qint64 AudioRingBuffer::readData(char *data, qint64 maxSize) {
         }
     } else {
         // read the data
-        memcpy(data, _nextOutput, numReadSamples * sizeof(int16_t));
+        memcpy(data, nextOutput, numReadSamples * sizeof(int16_t));
         if (_randomAccessMode) {
-            memset(_nextOutput, 0, numReadSamples * sizeof(int16_t)); // clear it
+            memset(nextOutput, 0, numReadSamples * sizeof(int16_t)); // clear it
         }
     }
 
-    // push the position of _nextOutput by the number of samples read
-    _nextOutput = shiftedPositionAccomodatingWrap(_nextOutput, numReadSamples);
+    // push the position of _nextOutput by the number of samples read, which publishes the space to the writer
+    _nextOutput.store(shiftedOffsetAccomodatingWrap(nextOutput - _buffer, numReadSamples));
 
     return numReadSamples * sizeof(int16_t);
 }
@@ -121,49 +128,62 @@ qint64 AudioRingBuffer::writeData(const char* data, qint64 maxSize) {
 
     int samplesToCopy = std::min((quint64)(maxSize / sizeof(int16_t)), (quint64)_sampleCapacity);
 
-    std::less<int16_t*> less;
-    std::less_equal<int16_t*> lessEqual;
-
-    if (_hasStarted
-        && (less(_endOfLastWrite, _nextOutput)
-            && lessEqual(_nextOutput, shiftedPositionAccomodatingWrap(_endOfLastWrite, samplesToCopy)))) {
-        // this read will cross the next output, so call us starved and reset the buffer
-        qDebug() << "Filled the ring buffer. Resetting.";
-        _endOfLastWrite = _buffer;
-        _nextOutput = _buffer;
-        _isStarved = true;
+    if (_isLockFree) {
+        if (samplesToCopy > samplesWritable()) {
+            // the read position is not ours to move, so this audio is dropped instead of resetting the buffer
+            qDebug() << "Filled the ring buffer. Dropping" << samplesToCopy << "samples.";
+            _numOverflows.store(_numOverflows.load() + 1);
+            return 0;
+        }
+    } else {
+        int nextOutput = _nextOutput.load();
+        int endOfLastWrite = _endOfLastWrite.load();
+
+        if (_hasStarted
+            && (endOfLastWrite < nextOutput
+                && nextOutput <= shiftedOffsetAccomodatingWrap(endOfLastWrite, samplesToCopy))) {
+            // this read will cross the next output, so call us starved and reset the buffer
+            qDebug() << "Filled the ring buffer. Resetting.";
+            _numOverflows.store(_numOverflows.load() + 1);
+            _endOfLastWrite.store(0);
+            _nextOutput.store(0);
+            _isStarved = true;
+        }
     }
 
-    if (_endOfLastWrite + samplesToCopy <= _buffer + _sampleCapacity) {
-        memcpy(_endOfLastWrite, data, samplesToCopy * sizeof(int16_t));
+    int16_t* endOfLastWrite = _buffer + _endOfLastWrite.load();
+
+    if (endOfLastWrite + samplesToCopy <= _buffer + _sampleCapacity) {
+        memcpy(endOfLastWrite, data, samplesToCopy * sizeof(int16_t));
     } else {
-        int numSamplesToEnd = (_buffer + _sampleCapacity) - _endOfLastWrite;
-        memcpy(_endOfLastWrite, data, numSamplesToEnd * sizeof(int16_t));
+        int numSamplesToEnd = (_buffer + _sampleCapacity) - endOfLastWrite;
+        memcpy(endOfLastWrite, data, numSamplesToEnd * sizeof(int16_t));
         memcpy(_buffer, data + (numSamplesToEnd * sizeof(int16_t)), (samplesToCopy - numSamplesToEnd) * sizeof(int16_t));
     }
 
-    _endOfLastWrite = shiftedPositionAccomodatingWrap(_endOfLastWrite, samplesToCopy);
+    // the samples are in place before the reader can see the new write position
+    _endOfLastWrite.store(shiftedOffsetAccomodatingWrap(endOfLastWrite - _buffer, samplesToCopy));
 
     return samplesToCopy * sizeof(int16_t);
 }
 
 int16_t& AudioRingBuffer::operator[](const int index) {
-    return *shiftedPositionAccomodatingWrap(_nextOutput, index);
+    return *shiftedPositionAccomodatingWrap(_buffer + _nextOutput.load(), index);
 }
 
 const int16_t& AudioRingBuffer::operator[] (const int index) const {
-    return *shiftedPositionAccomodatingWrap(_nextOutput, index);
+    return *shiftedPositionAccomodatingWrap(_buffer + _nextOutput.load(), index);
 }
 
 void AudioRingBuffer::shiftReadPosition(unsigned int numSamples) {
-    _nextOutput = shiftedPositionAccomodatingWrap(_nextOutput, numSamples);
+    _nextOutput.store(shiftedOffsetAccomodatingWrap(_nextOutput.load(), numSamples));
 }
 
 unsigned int AudioRingBuffer::samplesAvailable() const {
-    if (!_endOfLastWrite) {
+    if (!_buffer) {
         return 0;
     } else {
-        int sampleDifference = _endOfLastWrite - _nextOutput;
+        int sampleDifference = _endOfLastWrite.load() - _nextOutput.load();
 
         if (sampleDifference < 0) {
             sampleDifference += _sampleCapacity;
@@ -174,17 +194,28 @@ unsigned int AudioRingBuffer::samplesAvailable() const {
 }
 
 void AudioRingBuffer::addSilentFrame(int numSilentSamples) {
+    // as in writeData, never more than the ring holds, and a negative count is no silence at all
+    numSilentSamples = std::max(0, std::min(numSilentSamples, _sampleCapacity));
+    
+    if (_isLockFree && numSilentSamples > samplesWritable()) {
+        // as in writeData, silence that does not fit is dropped
+        _numOverflows.store(_numOverflows.load() + 1);
+        return;
+    }
+    
     // memset zeroes into the buffer, accomodate a wrap around the end
     // push the _endOfLastWrite to the correct spot
-    if (_endOfLastWrite + numSilentSamples <= _buffer + _sampleCapacity) {
-        memset(_endOfLastWrite, 0, numSilentSamples * sizeof(int16_t));
-        _endOfLastWrite += numSilentSamples;
+    int16_t* endOfLastWrite = _buffer + _endOfLastWrite.load();
+    
+    if (endOfLastWrite + numSilentSamples <= _buffer + _sampleCapacity) {
+        memset(endOfLastWrite, 0, numSilentSamples * sizeof(int16_t));
+        _endOfLastWrite.store(shiftedOffsetAccomodatingWrap(endOfLastWrite - _buffer, numSilentSamples));
     } else {
-        int numSamplesToEnd = (_buffer + _sampleCapacity) - _endOfLastWrite;
-        memset(_endOfLastWrite, 0, numSamplesToEnd * sizeof(int16_t));
+        int numSamplesToEnd = (_buffer + _sampleCapacity) - endOfLastWrite;
+        memset(endOfLastWrite, 0, numSamplesToEnd * sizeof(int16_t));
         memset(_buffer, 0, (numSilentSamples - numSamplesToEnd) * sizeof(int16_t));
         
-        _endOfLastWrite = _buffer + (numSilentSamples - numSamplesToEnd);
+        _endOfLastWrite.store(numSilentSamples - numSamplesToEnd);
     }
 }
 
@@ -208,3 +239,19 @@ int16_t* AudioRingBuffer::shiftedPositionAccomodatingWrap(int16_t* position, int
         return position + numSamplesShift;
     }
 }
+
+int AudioRingBuffer::shiftedOffsetAccomodatingWrap(int offset, int numSamplesShift) const {
+    return shiftedPositionAccomodatingWrap(_buffer + offset, numSamplesShift) - _buffer;
+}
+
+int AudioRingBuffer::samplesWritable() const {
+    int samplesWritable = _sampleCapacity - samplesAvailable();
+    
+    if (_isLockFree) {
+        // the reader may still be looking back into the frame behind its read position, and keeping it clear also
+        // stops the write position from ever catching up to the read position where the buffer would look empty
+        samplesWritable -= _numFrameSamples;
+    }
+    
+    return samplesWritable;
+}
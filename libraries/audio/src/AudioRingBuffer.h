@@ -17,6 +17,7 @@
 
 #include <glm/glm.hpp>
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QIODevice>
 
 #include "NodeData.h"
@@ -36,12 +37,32 @@ const short RING_BUFFER_LENGTH_FRAMES = 10;
 const int MAX_SAMPLE_VALUE = std::numeric_limits<int16_t>::max();
 const int MIN_SAMPLE_VALUE = std::numeric_limits<int16_t>::min();
 
+const int AUDIO_RING_BUFFER_CACHE_LINE_BYTES = 64;
+
+/// A sample offset into the ring that one thread moves and the other reads. It fills a cache line of its own so the
+/// producer moving the write position does not keep invalidating the line the consumer's read position is on.
+class AudioRingBufferPosition {
+public:
+    AudioRingBufferPosition() : _offset(0) { }
+    
+    int load() const { return _offset.loadAcquire(); }
+    void store(int offset) { _offset.storeRelease(offset); }
+private:
+    QAtomicInt _offset;
+    char _padding[AUDIO_RING_BUFFER_CACHE_LINE_BYTES - sizeof(QAtomicInt)];
+};
+
+/// In lock-free mode one thread may write (parseData, writeData, addSilentFrame) while another reads (readData,
+/// shiftReadPosition, samplesAvailable, reset) without a lock. The writer then never moves the read position: audio
+/// that does not fit is dropped instead of resetting the buffer, and a frame behind the read position is kept clear
+/// for readers that look back into it.
 class AudioRingBuffer : public NodeData {
     Q_OBJECT
 public:
-    AudioRingBuffer(int numFrameSamples, bool randomAccessMode = false);
+    AudioRingBuffer(int numFrameSamples, bool randomAccessMode = false, bool isLockFree = false);
     ~AudioRingBuffer();
 
+    /// empties the buffer, in lock-free mode only from the reading thread
     void reset();
     void resizeForFrameSize(qint64 numFrameSamples);
     
@@ -50,7 +71,7 @@ public:
     int parseData(const QByteArray& packet);
     
     // assume callers using this will never wrap around the end
-    const int16_t* getNextOutput() const { return _nextOutput; }
+    const int16_t* getNextOutput() const { return _buffer + _nextOutput.load(); }
     const int16_t* getBuffer() const { return _buffer; }
 
     qint64 readSamples(int16_t* destination, qint64 maxSamples);
@@ -74,21 +95,33 @@ public:
     bool hasStarted() const { return _hasStarted; }
     
     void addSilentFrame(int numSilentSamples);
+    
+    bool isLockFree() const { return _isLockFree; }
+    
+    /// the number of writes that did not fit, dropped in lock-free mode and resetting the buffer otherwise
+    int getNumOverflows() const { return _numOverflows.load(); }
 protected:
     // disallow copying of AudioRingBuffer objects
     AudioRingBuffer(const AudioRingBuffer&);
     AudioRingBuffer& operator= (const AudioRingBuffer&);
     
     int16_t* shiftedPositionAccomodatingWrap(int16_t* position, int numSamplesShift) const;
+    int shiftedOffsetAccomodatingWrap(int offset, int numSamplesShift) const;
+    
+    /// the number of samples a write can add, in lock-free mode without reaching the frame behind the read position
+    int samplesWritable() const;
     
     int _sampleCapacity;
     int _numFrameSamples;
-    int16_t* _nextOutput;
-    int16_t* _endOfLastWrite;
     int16_t* _buffer;
     bool _isStarved;
     bool _hasStarted;
     bool _randomAccessMode; /// will this ringbuffer be used for random access? if so, do some special processing
+    bool _isLockFree;
+    
+    AudioRingBufferPosition _nextOutput; /// moved only by the reader
+    AudioRingBufferPosition _endOfLastWrite; /// moved only by the writer
+    QAtomicInt _numOverflows; /// counted only by the writer
 };
 
 #endif // hifi_AudioRingBuffer_h
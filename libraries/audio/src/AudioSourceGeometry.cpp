@@ -0,0 +1,460 @@
+//
+//  AudioSourceGeometry.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AUDIO_SOURCE_GEOMETRY_X86
+#include <emmintrin.h>
+#endif
+
+#include <SharedUtil.h>
+
+#include "InjectedAudioRingBuffer.h"
+#include "PositionalAudioRingBuffer.h"
+
+#include "AudioSourceGeometry.h"
+
+#if defined(AUDIO_SOURCE_GEOMETRY_X86) && defined(__GNUC__)
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+#else
+#define SSE2_FUNCTION
+#endif
+
+const float MAX_OFF_AXIS_ATTENUATION = 0.2f;
+const float OFF_AXIS_ATTENUATION_FORMULA_STEP = (1 - MAX_OFF_AXIS_ATTENUATION) / 2.0f;
+
+// the distance coefficient is GEOMETRIC_AMPLITUDE_SCALAR ^ (DISTANCE_SCALE_LOG + log(distance, DISTANCE_LOG_BASE) - 1)
+// which is evaluated here as exp2(LOG2_GEOMETRIC_AMPLITUDE_SCALAR * exponent) on the squared distance
+const float DISTANCE_SCALE = 2.5f;
+const float GEOMETRIC_AMPLITUDE_SCALAR = 0.3f;
+const float DISTANCE_LOG_BASE = 2.5f;
+const float LOG2_GEOMETRIC_AMPLITUDE_SCALAR = logf(GEOMETRIC_AMPLITUDE_SCALAR) / logf(2.0f);
+const float DISTANCE_EXPONENT_OFFSET = (logf(DISTANCE_SCALE) / logf(DISTANCE_LOG_BASE)) - 1.0f;
+const float DISTANCE_EXPONENT_SCALE = 0.5f * logf(2.0f) / logf(DISTANCE_LOG_BASE);
+
+const float PHASE_AMPLITUDE_RATIO_AT_90 = 0.5f;
+
+// sources are gathered from the candidate list into fixed size blocks so the math runs over contiguous arrays
+const int SOURCE_BLOCK_SIZE = 64;
+
+// least squares fits of log2(1 + t) and exp2(t) for t in [0, 1), good to about 1e-5 and 4e-6
+const float LOG2_COEFFICIENTS[] = { 1.4390931e-05f, 1.4415921f, -0.70725343f, 0.41156148f, -0.18983245f, 0.043928628f };
+const float EXP2_COEFFICIENTS[] = { 1.0000036f, 0.69296955f, 0.24162132f, 0.051717735f, 0.013683983f };
+
+// Abramowitz and Stegun 4.4.45, acos(x) for x in [0, 1] to within 7e-5 radians
+const float ACOS_COEFFICIENTS[] = { 1.5707288f, -0.2121144f, 0.0742610f, -0.0187293f };
+
+struct SourceBlock {
+    float relativeX[SOURCE_BLOCK_SIZE];
+    float relativeY[SOURCE_BLOCK_SIZE];
+    float relativeZ[SOURCE_BLOCK_SIZE];
+    float axisX[SOURCE_BLOCK_SIZE];
+    float axisY[SOURCE_BLOCK_SIZE];
+    float axisZ[SOURCE_BLOCK_SIZE];
+    float loudness[SOURCE_BLOCK_SIZE];
+    float radius[SOURCE_BLOCK_SIZE];
+    float attenuationRatio[SOURCE_BLOCK_SIZE];
+};
+
+struct ListenerAxes {
+    glm::vec3 right;
+    glm::vec3 back;
+    float minAudibilityThreshold;
+};
+
+struct CoefficientBlock {
+    float attenuation[SOURCE_BLOCK_SIZE];
+    float sinRatio[SOURCE_BLOCK_SIZE];
+    float bearingX[SOURCE_BLOCK_SIZE];
+    float isAudible[SOURCE_BLOCK_SIZE];
+};
+
+static inline float fastLog2(float x) {
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    float exponent = (float) (((bits >> 23) & 0xFF) - 127);
+
+    int32_t mantissaBits = (bits & 0x007FFFFF) | 0x3F800000;
+    float mantissa;
+    memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+
+    float t = mantissa - 1.0f;
+    const float* c = LOG2_COEFFICIENTS;
+    return exponent + (c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * c[5])))));
+}
+
+// only valid for x in [-126, 0], which is all the distance coefficient needs
+static inline float fastExp2(float x) {
+    int32_t wholePart = (int32_t) x;
+    if ((float) wholePart > x) {
+        --wholePart;
+    }
+    float t = x - wholePart;
+
+    int32_t scaleBits = (wholePart + 127) << 23;
+    float scale;
+    memcpy(&scale, &scaleBits, sizeof(scale));
+
+    const float* c = EXP2_COEFFICIENTS;
+    return scale * (c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * c[4]))));
+}
+
+static inline float fastAcos(float x) {
+    float t = fabsf(x);
+    const float* c = ACOS_COEFFICIENTS;
+    float angle = sqrtf(1.0f - t) * (c[0] + t * (c[1] + t * (c[2] + t * c[3])));
+    return x < 0.0f ? PI - angle : angle;
+}
+
+static void computeCoefficientsScalar(const SourceBlock& sources, int numSources, const ListenerAxes& listener,
+                                      CoefficientBlock& coefficients) {
+    for (int i = 0; i < numSources; i++) {
+        float relativeX = sources.relativeX[i];
+        float relativeY = sources.relativeY[i];
+        float relativeZ = sources.relativeZ[i];
+
+        float distanceSquared = relativeX * relativeX + relativeY * relativeY + relativeZ * relativeZ;
+        float distance = std::max(sqrtf(distanceSquared), EPSILON);
+
+        coefficients.isAudible[i] = sources.loudness[i] > listener.minAudibilityThreshold * distance;
+
+        float radius = sources.radius[i];
+        bool isSpherical = radius > 0.0f;
+
+        if (isSpherical && distanceSquared <= radius * radius) {
+            // the listener is inside a spherical source, which is heard at its plain attenuation from both sides
+            coefficients.attenuation[i] = sources.attenuationRatio[i];
+            coefficients.sinRatio[i] = 0.0f;
+            coefficients.bearingX[i] = 0.0f;
+            continue;
+        }
+
+        float attenuation = sources.attenuationRatio[i];
+
+        if (isSpherical) {
+            // the distance used for the coefficient is to the closest point on the boundary of the sphere
+            distanceSquared -= radius * radius;
+        } else {
+            // off-axis attenuation from the angle between the source's forward and the listener
+            float cosDelivery = -(sources.axisX[i] * relativeX + sources.axisY[i] * relativeY
+                                  + sources.axisZ[i] * relativeZ) / distance;
+            cosDelivery = glm::clamp(cosDelivery, -1.0f, 1.0f);
+
+            attenuation *= MAX_OFF_AXIS_ATTENUATION
+                + ((OFF_AXIS_ATTENUATION_FORMULA_STEP / PI_OVER_TWO) * fastAcos(cosDelivery));
+        }
+
+        float distanceExponent = LOG2_GEOMETRIC_AMPLITUDE_SCALAR
+            * (DISTANCE_EXPONENT_OFFSET + DISTANCE_EXPONENT_SCALE * fastLog2(distanceSquared));
+        attenuation *= fastExp2(glm::clamp(distanceExponent, -126.0f, 0.0f));
+
+        coefficients.attenuation[i] = attenuation;
+
+        // bearing of the source in the listener's horizontal plane
+        float bearingX = glm::dot(listener.right, glm::vec3(relativeX, relativeY, relativeZ));
+        float bearingZ = glm::dot(listener.back, glm::vec3(relativeX, relativeY, relativeZ));
+        float bearingLength = sqrtf(bearingX * bearingX + bearingZ * bearingZ);
+
+        coefficients.sinRatio[i] = bearingLength > EPSILON ? fabsf(bearingX) / bearingLength : 0.0f;
+        coefficients.bearingX[i] = bearingX;
+    }
+}
+
+#ifdef AUDIO_SOURCE_GEOMETRY_X86
+
+SSE2_FUNCTION static inline __m128 selectMask(__m128 mask, __m128 ifTrue, __m128 ifFalse) {
+    return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+SSE2_FUNCTION static inline __m128 fastLog2SSE2(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)),
+                                                    _mm_set1_epi32(127)));
+    __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                    _mm_set1_epi32(0x3F800000)));
+
+    __m128 t = _mm_sub_ps(mantissa, _mm_set1_ps(1.0f));
+    const float* c = LOG2_COEFFICIENTS;
+    __m128 polynomial = _mm_set1_ps(c[5]);
+    for (int i = 4; i >= 0; i--) {
+        polynomial = _mm_add_ps(_mm_set1_ps(c[i]), _mm_mul_ps(t, polynomial));
+    }
+    return _mm_add_ps(exponent, polynomial);
+}
+
+SSE2_FUNCTION static inline __m128 fastExp2SSE2(__m128 x) {
+    // truncation rounds toward zero, which is one too high for the negative inputs with a fraction
+    __m128i wholePart = _mm_cvttps_epi32(x);
+    __m128 wholePartFloat = _mm_cvtepi32_ps(wholePart);
+    __m128i isTooHigh = _mm_castps_si128(_mm_cmpgt_ps(wholePartFloat, x));
+    wholePart = _mm_add_epi32(wholePart, isTooHigh);
+    wholePartFloat = _mm_cvtepi32_ps(wholePart);
+
+    __m128 t = _mm_sub_ps(x, wholePartFloat);
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(wholePart, _mm_set1_epi32(127)), 23));
+
+    const float* c = EXP2_COEFFICIENTS;
+    __m128 polynomial = _mm_set1_ps(c[4]);
+    for (int i = 3; i >= 0; i--) {
+        polynomial = _mm_add_ps(_mm_set1_ps(c[i]), _mm_mul_ps(t, polynomial));
+    }
+    return _mm_mul_ps(scale, polynomial);
+}
+
+SSE2_FUNCTION static inline __m128 fastAcosSSE2(__m128 x) {
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 t = _mm_andnot_ps(signMask, x);
+
+    const float* c = ACOS_COEFFICIENTS;
+    __m128 polynomial = _mm_set1_ps(c[3]);
+    for (int i = 2; i >= 0; i--) {
+        polynomial = _mm_add_ps(_mm_set1_ps(c[i]), _mm_mul_ps(t, polynomial));
+    }
+    __m128 angle = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), t)), polynomial);
+
+    return selectMask(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), angle), angle);
+}
+
+SSE2_FUNCTION static void computeCoefficientsSSE2(const SourceBlock& sources, int numSources,
+                                                  const ListenerAxes& listener, CoefficientBlock& coefficients) {
+    const int SOURCES_PER_VECTOR = 4;
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 minSourceDistance = _mm_set1_ps(EPSILON);
+
+    int i = 0;
+    for (; i + SOURCES_PER_VECTOR <= numSources; i += SOURCES_PER_VECTOR) {
+        __m128 relativeX = _mm_loadu_ps(sources.relativeX + i);
+        __m128 relativeY = _mm_loadu_ps(sources.relativeY + i);
+        __m128 relativeZ = _mm_loadu_ps(sources.relativeZ + i);
+
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(relativeX, relativeX),
+                                                       _mm_mul_ps(relativeY, relativeY)),
+                                            _mm_mul_ps(relativeZ, relativeZ));
+        __m128 distance = _mm_max_ps(_mm_sqrt_ps(distanceSquared), minSourceDistance);
+
+        __m128 isAudible = _mm_cmpgt_ps(_mm_loadu_ps(sources.loudness + i),
+                                        _mm_mul_ps(_mm_set1_ps(listener.minAudibilityThreshold), distance));
+        _mm_storeu_ps(coefficients.isAudible + i, _mm_and_ps(isAudible, one));
+
+        __m128 radius = _mm_loadu_ps(sources.radius + i);
+        __m128 radiusSquared = _mm_mul_ps(radius, radius);
+        __m128 isSpherical = _mm_cmpgt_ps(radius, zero);
+        __m128 isInside = _mm_and_ps(isSpherical, _mm_cmple_ps(distanceSquared, radiusSquared));
+
+        __m128 attenuationRatio = _mm_loadu_ps(sources.attenuationRatio + i);
+
+        // off-axis attenuation, which spherical sources do not get
+        __m128 deliveryDot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(sources.axisX + i), relativeX),
+                                                   _mm_mul_ps(_mm_loadu_ps(sources.axisY + i), relativeY)),
+                                        _mm_mul_ps(_mm_loadu_ps(sources.axisZ + i), relativeZ));
+        __m128 cosDelivery = _mm_div_ps(_mm_sub_ps(zero, deliveryDot), distance);
+        cosDelivery = _mm_min_ps(_mm_max_ps(cosDelivery, _mm_set1_ps(-1.0f)), one);
+
+        __m128 offAxisCoefficient = _mm_add_ps(_mm_set1_ps(MAX_OFF_AXIS_ATTENUATION),
+                                               _mm_mul_ps(_mm_set1_ps(OFF_AXIS_ATTENUATION_FORMULA_STEP / PI_OVER_TWO),
+                                                          fastAcosSSE2(cosDelivery)));
+        __m128 attenuation = _mm_mul_ps(attenuationRatio, selectMask(isSpherical, one, offAxisCoefficient));
+
+        __m128 coefficientDistanceSquared = selectMask(isSpherical, _mm_sub_ps(distanceSquared, radiusSquared),
+                                                   distanceSquared);
+        __m128 distanceExponent = _mm_mul_ps(_mm_set1_ps(LOG2_GEOMETRIC_AMPLITUDE_SCALAR),
+                                             _mm_add_ps(_mm_set1_ps(DISTANCE_EXPONENT_OFFSET),
+                                                        _mm_mul_ps(_mm_set1_ps(DISTANCE_EXPONENT_SCALE),
+                                                                   fastLog2SSE2(coefficientDistanceSquared))));
+        distanceExponent = _mm_min_ps(_mm_max_ps(distanceExponent, _mm_set1_ps(-126.0f)), zero);
+        attenuation = _mm_mul_ps(attenuation, fastExp2SSE2(distanceExponent));
+
+        _mm_storeu_ps(coefficients.attenuation + i, selectMask(isInside, attenuationRatio, attenuation));
+
+        // bearing of the source in the listener's horizontal plane
+        __m128 bearingX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(listener.right.x), relativeX),
+                                                _mm_mul_ps(_mm_set1_ps(listener.right.y), relativeY)),
+                                     _mm_mul_ps(_mm_set1_ps(listener.right.z), relativeZ));
+        __m128 bearingZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(listener.back.x), relativeX),
+                                                _mm_mul_ps(_mm_set1_ps(listener.back.y), relativeY)),
+                                     _mm_mul_ps(_mm_set1_ps(listener.back.z), relativeZ));
+        __m128 bearingLength = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(bearingX, bearingX), _mm_mul_ps(bearingZ, bearingZ)));
+
+        __m128 hasBearing = _mm_andnot_ps(isInside, _mm_cmpgt_ps(bearingLength, minSourceDistance));
+        __m128 sinRatio = _mm_div_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), bearingX),
+                                     _mm_max_ps(bearingLength, minSourceDistance));
+
+        _mm_storeu_ps(coefficients.sinRatio + i, _mm_and_ps(hasBearing, sinRatio));
+        _mm_storeu_ps(coefficients.bearingX + i, _mm_andnot_ps(isInside, bearingX));
+    }
+
+    if (i < numSources) {
+        // finish the last few sources one at a time
+        SourceBlock remainingSources;
+        CoefficientBlock remainingCoefficients;
+        int numRemaining = numSources - i;
+
+        memcpy(remainingSources.relativeX, sources.relativeX + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.relativeY, sources.relativeY + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.relativeZ, sources.relativeZ + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.axisX, sources.axisX + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.axisY, sources.axisY + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.axisZ, sources.axisZ + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.loudness, sources.loudness + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.radius, sources.radius + i, numRemaining * sizeof(float));
+        memcpy(remainingSources.attenuationRatio, sources.attenuationRatio + i, numRemaining * sizeof(float));
+
+        computeCoefficientsScalar(remainingSources, numRemaining, listener, remainingCoefficients);
+
+        memcpy(coefficients.attenuation + i, remainingCoefficients.attenuation, numRemaining * sizeof(float));
+        memcpy(coefficients.sinRatio + i, remainingCoefficients.sinRatio, numRemaining * sizeof(float));
+        memcpy(coefficients.bearingX + i, remainingCoefficients.bearingX, numRemaining * sizeof(float));
+        memcpy(coefficients.isAudible + i, remainingCoefficients.isAudible, numRemaining * sizeof(float));
+    }
+}
+
+#endif // AUDIO_SOURCE_GEOMETRY_X86
+
+AudioSourceGeometry::AudioSourceGeometry() :
+    _positionX(),
+    _positionY(),
+    _positionZ(),
+    _axisX(),
+    _axisY(),
+    _axisZ(),
+    _loudness(),
+    _radius(),
+    _attenuationRatio()
+{
+
+}
+
+void AudioSourceGeometry::clear() {
+    _positionX.clear();
+    _positionY.clear();
+    _positionZ.clear();
+    _axisX.clear();
+    _axisY.clear();
+    _axisZ.clear();
+    _loudness.clear();
+    _radius.clear();
+    _attenuationRatio.clear();
+}
+
+void AudioSourceGeometry::addSource(const PositionalAudioRingBuffer* ringBuffer) {
+    const glm::vec3& position = ringBuffer->getPosition();
+    _positionX.push_back(position.x);
+    _positionY.push_back(position.y);
+    _positionZ.push_back(position.z);
+
+    glm::vec3 axis = ringBuffer->getOrientation() * glm::vec3(0.0f, 0.0f, 1.0f);
+    _axisX.push_back(axis.x);
+    _axisY.push_back(axis.y);
+    _axisZ.push_back(axis.z);
+
+    _loudness.push_back(ringBuffer->getNextOutputTrailingLoudness());
+
+    if (ringBuffer->getType() == PositionalAudioRingBuffer::Injector) {
+        const InjectedAudioRingBuffer* injectedBuffer = static_cast<const InjectedAudioRingBuffer*>(ringBuffer);
+        _radius.push_back(injectedBuffer->getRadius());
+        _attenuationRatio.push_back(injectedBuffer->getAttenuationRatio());
+    } else {
+        _radius.push_back(0.0f);
+        _attenuationRatio.push_back(1.0f);
+    }
+}
+
+void AudioSourceGeometry::addOmnidirectionalSource(const glm::vec3& position, float loudness) {
+    _positionX.push_back(position.x);
+    _positionY.push_back(position.y);
+    _positionZ.push_back(position.z);
+
+    // a zero axis puts every listener at 90 degrees, the mean angle of delivery over the sphere
+    _axisX.push_back(0.0f);
+    _axisY.push_back(0.0f);
+    _axisZ.push_back(0.0f);
+
+    _loudness.push_back(loudness);
+    _radius.push_back(0.0f);
+    _attenuationRatio.push_back(1.0f);
+}
+
+void AudioSourceGeometry::computeAudibleMixParameters(const glm::vec3& listenerPosition,
+                                                      const glm::quat& listenerOrientation,
+                                                      float minAudibilityThreshold, const QVector<int>& sourceIndices,
+                                                      int listenerSourceIndex, QVector<int>& audibleSourceIndices,
+                                                      QVector<SpatializedMixParameters>& audibleParameters) const {
+    static bool hasSSE2 = AudioMixKernel::getBestAvailableInstructionSet() >= AudioMixKernel::SSE2;
+
+    audibleSourceIndices.resize(0);
+    audibleParameters.resize(0);
+
+    ListenerAxes listener;
+    listener.right = listenerOrientation * glm::vec3(1.0f, 0.0f, 0.0f);
+    listener.back = listenerOrientation * glm::vec3(0.0f, 0.0f, 1.0f);
+    listener.minAudibilityThreshold = minAudibilityThreshold;
+
+    SourceBlock sources;
+    CoefficientBlock coefficients;
+
+    for (int blockStart = 0; blockStart < sourceIndices.size(); blockStart += SOURCE_BLOCK_SIZE) {
+        int numSources = std::min(SOURCE_BLOCK_SIZE, sourceIndices.size() - blockStart);
+
+        for (int i = 0; i < numSources; i++) {
+            int sourceIndex = sourceIndices[blockStart + i];
+            sources.relativeX[i] = _positionX[sourceIndex] - listenerPosition.x;
+            sources.relativeY[i] = _positionY[sourceIndex] - listenerPosition.y;
+            sources.relativeZ[i] = _positionZ[sourceIndex] - listenerPosition.z;
+            sources.axisX[i] = _axisX[sourceIndex];
+            sources.axisY[i] = _axisY[sourceIndex];
+            sources.axisZ[i] = _axisZ[sourceIndex];
+            sources.loudness[i] = _loudness[sourceIndex];
+            sources.radius[i] = _radius[sourceIndex];
+            sources.attenuationRatio[i] = _attenuationRatio[sourceIndex];
+        }
+
+#ifdef AUDIO_SOURCE_GEOMETRY_X86
+        if (hasSSE2) {
+            computeCoefficientsSSE2(sources, numSources, listener, coefficients);
+        } else {
+            computeCoefficientsScalar(sources, numSources, listener, coefficients);
+        }
+#else
+        computeCoefficientsScalar(sources, numSources, listener, coefficients);
+#endif
+
+        for (int i = 0; i < numSources; i++) {
+            int sourceIndex = sourceIndices[blockStart + i];
+            SpatializedMixParameters parameters;
+
+            if (sourceIndex == listenerSourceIndex) {
+                // the listener's own audio comes back without any spatialization
+                parameters.attenuationCoefficient = 1.0f;
+                parameters.weakChannelAmplitudeRatio = 1.0f;
+                parameters.numSamplesDelay = 0;
+                parameters.isRightChannelDelayed = false;
+            } else if (coefficients.isAudible[i] != 0.0f) {
+                parameters.attenuationCoefficient = coefficients.attenuation[i];
+                parameters.weakChannelAmplitudeRatio = 1.0f - (PHASE_AMPLITUDE_RATIO_AT_90 * coefficients.sinRatio[i]);
+                parameters.numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90 * coefficients.sinRatio[i];
+
+                // a source on the listener's left has the right channel delayed
+                parameters.isRightChannelDelayed = coefficients.bearingX[i] < 0.0f;
+            } else {
+                continue;
+            }
+
+            audibleSourceIndices.append(sourceIndex);
+            audibleParameters.append(parameters);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//
+//  AudioSourceGeometry.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceGeometry_h
+#define hifi_AudioSourceGeometry_h
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <QtCore/QVector>
+
+#include "AudioMixKernel.h"
+
+class PositionalAudioRingBuffer;
+
+/// The positions, orientations and loudness of every source in one mixer frame, packed as structure-of-arrays.
+/// From it the spatialization coefficients for a listener are computed four sources at a time, with polynomial
+/// approximations standing in for the powf, logf and acosf calls of the per-pair math.
+class AudioSourceGeometry {
+public:
+    AudioSourceGeometry();
+
+    void clear();
+
+    /// packs the current state of the ring buffer, sources are indexed in the order they are added
+    void addSource(const PositionalAudioRingBuffer* ringBuffer);
+
+    /// packs a point source with no facing, which is given the off-axis attenuation averaged over every direction
+    void addOmnidirectionalSource(const glm::vec3& position, float loudness);
+
+    int getNumSources() const { return _loudness.size(); }
+
+    glm::vec3 getPosition(int sourceIndex) const {
+        return glm::vec3(_positionX[sourceIndex], _positionY[sourceIndex], _positionZ[sourceIndex]);
+    }
+    float getLoudness(int sourceIndex) const { return _loudness[sourceIndex]; }
+    float getRadius(int sourceIndex) const { return _radius[sourceIndex]; }
+    float getAttenuationRatio(int sourceIndex) const { return _attenuationRatio[sourceIndex]; }
+
+    /// Computes mix parameters for a listener against the sources in sourceIndices, keeping only the ones loud enough
+    /// to be heard. The source at listenerSourceIndex, if any, is the listener's own and is mixed back unchanged.
+    /// The audible indices and their parameters replace the contents of audibleSourceIndices and audibleParameters.
+    void computeAudibleMixParameters(const glm::vec3& listenerPosition, const glm::quat& listenerOrientation,
+                                     float minAudibilityThreshold, const QVector<int>& sourceIndices,
+                                     int listenerSourceIndex, QVector<int>& audibleSourceIndices,
+                                     QVector<SpatializedMixParameters>& audibleParameters) const;
+
+private:
+    std::vector<float> _positionX;
+    std::vector<float> _positionY;
+    std::vector<float> _positionZ;
+
+    // the source's local z axis in world space, which gives the angle of delivery without a quaternion inverse
+    std::vector<float> _axisX;
+    std::vector<float> _axisY;
+    std::vector<float> _axisZ;
+
+    std::vector<float> _loudness;
+    std::vector<float> _radius;
+    std::vector<float> _attenuationRatio;
+};
+
+#endif // hifi_AudioSourceGeometry_h
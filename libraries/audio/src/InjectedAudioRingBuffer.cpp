@@ -19,8 +19,8 @@
 
 #include "InjectedAudioRingBuffer.h"
 
-InjectedAudioRingBuffer::InjectedAudioRingBuffer(const QUuid& streamIdentifier) :
-    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Injector),
+InjectedAudioRingBuffer::InjectedAudioRingBuffer(const QUuid& streamIdentifier, bool isLockFree) :
+    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Injector, isLockFree),
     _streamIdentifier(streamIdentifier),
     _radius(0.0f),
     _attenuationRatio(0)
@@ -53,8 +53,8 @@ int InjectedAudioRingBuffer::parseData(const QByteArray& packet) {
     packetStream >> attenuationByte;
     _attenuationRatio = attenuationByte / (float) MAX_INJECTOR_VOLUME;
     
-    packetStream.skipRawData(writeData(packet.data() + packetStream.device()->pos(),
-                                       packet.size() - packetStream.device()->pos()));
+    packetStream.skipRawData(parseAudioData(packetTypeForPacket(packet), packet.data() + packetStream.device()->pos(),
+                                            packet.size() - packetStream.device()->pos()));
     
     return packetStream.device()->pos();
 }
@@ -0,0 +1,94 @@
+//
+//  JitterBufferDepth.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "AudioRingBuffer.h"
+
+#include "JitterBufferDepth.h"
+
+// the gain RFC 3550 uses to smooth the jitter estimate
+const float JITTER_ESTIMATE_GAIN = 1.0f / 16.0f;
+
+// the estimate is a mean deviation, this many of them cover nearly all late packets
+const float NUM_JITTER_DEVIATIONS = 3.0f;
+
+// a gap this long is the stream pausing rather than jitter
+const quint64 MAX_JITTER_ARRIVAL_GAP_USECS = 1000 * 1000;
+
+JitterBufferDepth::JitterBufferDepth() :
+    _lastArrivalUsecs(0),
+    _jitterEstimateUsecs(0.0f),
+    _jitterUsecs(0),
+    _desiredFrames(MIN_JITTER_BUFFER_FRAMES),
+    _windowFrames(0),
+    _windowMinBufferedFrames(MAX_JITTER_BUFFER_FRAMES),
+    _windowsSinceStarve(0),
+    _numStarves(0),
+    _numDroppedFrames(0)
+{
+    
+}
+
+void JitterBufferDepth::packetArrived(quint64 arrivalUsecs) {
+    if (_lastArrivalUsecs != 0 && arrivalUsecs >= _lastArrivalUsecs
+        && arrivalUsecs - _lastArrivalUsecs < MAX_JITTER_ARRIVAL_GAP_USECS) {
+        float deviation = fabsf((float) (arrivalUsecs - _lastArrivalUsecs) - BUFFER_SEND_INTERVAL_USECS);
+        _jitterEstimateUsecs += (deviation - _jitterEstimateUsecs) * JITTER_ESTIMATE_GAIN;
+        
+        _jitterUsecs.store((int) _jitterEstimateUsecs);
+    }
+    
+    _lastArrivalUsecs = arrivalUsecs;
+}
+
+int JitterBufferDepth::frameMixed(int numBufferedFrames) {
+    // follow a rise in jitter right away, before it turns into starves
+    _desiredFrames = std::max(_desiredFrames, framesForJitter());
+    
+    _windowMinBufferedFrames = std::min(_windowMinBufferedFrames, numBufferedFrames);
+    
+    if (++_windowFrames < JITTER_BUFFER_WINDOW_FRAMES) {
+        return 0;
+    }
+    
+    // never dipping below the desired depth for a whole window means the extra frames are only latency
+    // they go one a window so that the skips stay rare
+    int numFramesToDrop = 0;
+    if (_windowMinBufferedFrames > _desiredFrames) {
+        numFramesToDrop = 1;
+        _numDroppedFrames++;
+    }
+    
+    if (++_windowsSinceStarve >= JITTER_BUFFER_SETTLE_WINDOWS && _desiredFrames > framesForJitter()) {
+        _desiredFrames--;
+        _windowsSinceStarve = 0;
+    }
+    
+    _windowFrames = 0;
+    _windowMinBufferedFrames = MAX_JITTER_BUFFER_FRAMES;
+    
+    return numFramesToDrop;
+}
+
+void JitterBufferDepth::streamStarved() {
+    _numStarves++;
+    _desiredFrames = std::min(std::max(_desiredFrames + 1, framesForJitter()), MAX_JITTER_BUFFER_FRAMES);
+    
+    _windowsSinceStarve = 0;
+    _windowFrames = 0;
+    _windowMinBufferedFrames = MAX_JITTER_BUFFER_FRAMES;
+}
+
+int JitterBufferDepth::framesForJitter() const {
+    int frames = ceilf(NUM_JITTER_DEVIATIONS * _jitterUsecs.load() / BUFFER_SEND_INTERVAL_USECS);
+    return std::max(MIN_JITTER_BUFFER_FRAMES, std::min(frames, MAX_JITTER_BUFFER_FRAMES));
+}
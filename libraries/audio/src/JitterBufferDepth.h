@@ -0,0 +1,68 @@
+//
+//  JitterBufferDepth.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_JitterBufferDepth_h
+#define hifi_JitterBufferDepth_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QtGlobal>
+
+// depths are in frames buffered beyond the one about to be mixed
+const int MIN_JITTER_BUFFER_FRAMES = 0;
+const int MAX_JITTER_BUFFER_FRAMES = 6;
+
+/// the number of frames over which the shallowest depth of a stream is watched before it is trimmed
+const int JITTER_BUFFER_WINDOW_FRAMES = 100;
+
+/// the number of windows without a starve before the desired depth is lowered a frame
+const int JITTER_BUFFER_SETTLE_WINDOWS = 10;
+
+/// Picks how deep the jitter buffer of one inbound audio stream should be. The writing thread reports packet arrivals,
+/// from which an RFC 3550 style inter-arrival jitter is kept. The reading thread reports each mixed frame and each
+/// starve: a starve deepens the buffer straight away, a quiet stream with low jitter is brought back down slowly, and
+/// a buffer that has stayed deeper than desired for a whole window has a frame dropped.
+class JitterBufferDepth {
+public:
+    JitterBufferDepth();
+    
+    /// called by the writer for each packet of the stream
+    void packetArrived(quint64 arrivalUsecs);
+    
+    /// called by the reader for each frame it mixes, with the frames still buffered behind that one
+    /// returns the number of frames the reader should drop to come back down to the desired depth
+    int frameMixed(int numBufferedFrames);
+    
+    /// called by the reader when the stream runs dry and is left out of the mix
+    void streamStarved();
+    
+    int getDesiredFrames() const { return _desiredFrames; }
+    int getJitterUsecs() const { return _jitterUsecs.load(); }
+    int getNumStarves() const { return _numStarves; }
+    int getNumDroppedFrames() const { return _numDroppedFrames; }
+private:
+    /// the depth that covers the current jitter estimate
+    int framesForJitter() const;
+    
+    // only touched by the writer
+    quint64 _lastArrivalUsecs;
+    float _jitterEstimateUsecs;
+    
+    QAtomicInt _jitterUsecs;
+    
+    // only touched by the reader
+    int _desiredFrames;
+    int _windowFrames;
+    int _windowMinBufferedFrames;
+    int _windowsSinceStarve;
+    int _numStarves;
+    int _numDroppedFrames;
+};
+
+#endif // hifi_JitterBufferDepth_h
@@ -0,0 +1,173 @@
+//
+//  MixedAudioCodec.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include "MixedAudioCodec.h"
+
+const int ADPCM_STEP_TABLE[] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107,
+    118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894,
+    6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+const int MAX_ADPCM_STEP_INDEX = sizeof(ADPCM_STEP_TABLE) / sizeof(ADPCM_STEP_TABLE[0]) - 1;
+
+const int ADPCM_INDEX_TABLE[] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+const quint8 ADPCM_SIGN_BIT = 8;
+
+static inline int16_t clampedSample(int sample) {
+    return sample > MAX_SAMPLE_VALUE ? MAX_SAMPLE_VALUE : (sample < MIN_SAMPLE_VALUE ? MIN_SAMPLE_VALUE : sample);
+}
+
+// the decoder half of IMA-ADPCM, which the encoder also runs so that both follow the same predictor
+static inline void updateADPCMState(ADPCMChannelState& state, quint8 nibble) {
+    int step = ADPCM_STEP_TABLE[state.stepIndex];
+
+    int delta = step >> 3;
+    if (nibble & 4) {
+        delta += step;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+
+    state.predictor = clampedSample(state.predictor + ((nibble & ADPCM_SIGN_BIT) ? -delta : delta));
+
+    int stepIndex = state.stepIndex + ADPCM_INDEX_TABLE[nibble];
+    state.stepIndex = stepIndex < 0 ? 0 : (stepIndex > MAX_ADPCM_STEP_INDEX ? MAX_ADPCM_STEP_INDEX : stepIndex);
+}
+
+static inline quint8 encodeADPCMSample(ADPCMChannelState& state, int sample) {
+    int step = ADPCM_STEP_TABLE[state.stepIndex];
+    int difference = sample - state.predictor;
+
+    quint8 nibble = 0;
+    if (difference < 0) {
+        nibble = ADPCM_SIGN_BIT;
+        difference = -difference;
+    }
+
+    if (difference >= step) {
+        nibble |= 4;
+        difference -= step;
+    }
+    if (difference >= (step >> 1)) {
+        nibble |= 2;
+        difference -= step >> 1;
+    }
+    if (difference >= (step >> 2)) {
+        nibble |= 1;
+    }
+
+    updateADPCMState(state, nibble);
+    return nibble;
+}
+
+static char* writeADPCMChannelHeader(char* destination, const ADPCMChannelState& state) {
+    memcpy(destination, &state.predictor, sizeof(state.predictor));
+    destination += sizeof(state.predictor);
+    memcpy(destination, &state.stepIndex, sizeof(state.stepIndex));
+    return destination + sizeof(state.stepIndex);
+}
+
+static const char* readADPCMChannelHeader(const char* source, ADPCMChannelState& state) {
+    memcpy(&state.predictor, source, sizeof(state.predictor));
+    source += sizeof(state.predictor);
+    memcpy(&state.stepIndex, source, sizeof(state.stepIndex));
+
+    if (state.stepIndex > MAX_ADPCM_STEP_INDEX) {
+        state.stepIndex = MAX_ADPCM_STEP_INDEX;
+    }
+    return source + sizeof(state.stepIndex);
+}
+
+MixedAudioEncoder::MixedAudioEncoder() {
+    _midState.predictor = 0;
+    _midState.stepIndex = 0;
+    _sideState.predictor = 0;
+    _sideState.stepIndex = 0;
+}
+
+int MixedAudioEncoder::encodeFrame(MixedAudioEncoding encoding, const int16_t* stereoSamples, char* destination) {
+    char* encodedPointer = destination;
+
+    quint8 encodingByte = encoding;
+    memcpy(encodedPointer, &encodingByte, sizeof(encodingByte));
+    encodedPointer += sizeof(encodingByte);
+
+    if (encoding == MixedAudioEncodingMidSideADPCM) {
+        encodedPointer = writeADPCMChannelHeader(encodedPointer, _midState);
+        encodedPointer = writeADPCMChannelHeader(encodedPointer, _sideState);
+
+        // most of a mix is common to both ears, so the side channel is small and its step size stays low
+        for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+            int left = stereoSamples[i * 2];
+            int right = stereoSamples[(i * 2) + 1];
+
+            quint8 midNibble = encodeADPCMSample(_midState, (left + right) >> 1);
+            quint8 sideNibble = encodeADPCMSample(_sideState, (left - right) >> 1);
+
+            *encodedPointer++ = midNibble | (sideNibble << 4);
+        }
+    } else {
+        memcpy(encodedPointer, stereoSamples, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
+        encodedPointer += NETWORK_BUFFER_LENGTH_BYTES_STEREO;
+    }
+
+    return encodedPointer - destination;
+}
+
+int MixedAudioCodec::decodeFrame(const char* source, int numBytes, int16_t* stereoSamples) {
+    if (numBytes < (int) sizeof(quint8)) {
+        return 0;
+    }
+
+    quint8 encoding;
+    memcpy(&encoding, source, sizeof(encoding));
+    source += sizeof(encoding);
+    numBytes -= sizeof(encoding);
+
+    if (encoding == MixedAudioEncodingMidSideADPCM) {
+        if (numBytes < NUM_BYTES_MID_SIDE_ADPCM_FRAME) {
+            return 0;
+        }
+
+        ADPCMChannelState midState;
+        ADPCMChannelState sideState;
+        source = readADPCMChannelHeader(source, midState);
+        source = readADPCMChannelHeader(source, sideState);
+
+        for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+            quint8 nibbles = source[i];
+            updateADPCMState(midState, nibbles & 0x0F);
+            updateADPCMState(sideState, nibbles >> 4);
+
+            stereoSamples[i * 2] = clampedSample(midState.predictor + sideState.predictor);
+            stereoSamples[(i * 2) + 1] = clampedSample(midState.predictor - sideState.predictor);
+        }
+
+        return NETWORK_BUFFER_LENGTH_SAMPLES_STEREO;
+    } else if (encoding == MixedAudioEncodingRaw) {
+        if (numBytes < NETWORK_BUFFER_LENGTH_BYTES_STEREO) {
+            return 0;
+        }
+
+        memcpy(stereoSamples, source, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
+        return NETWORK_BUFFER_LENGTH_SAMPLES_STEREO;
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+//
+//  MixedAudioCodec.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MixedAudioCodec_h
+#define hifi_MixedAudioCodec_h
+
+#include <stdint.h>
+
+#include <QtCore/QtGlobal>
+
+#include "AudioRingBuffer.h"
+
+/// How the stereo frame in a PacketTypeMixedAudio packet is stored, sent as the first byte after the header
+enum MixedAudioEncoding {
+    MixedAudioEncodingRaw = 0,
+    MixedAudioEncodingMidSideADPCM
+};
+
+/// the bit for an encoding in the accepted encodings mask clients send in their microphone packets
+inline quint8 maskForMixedAudioEncoding(MixedAudioEncoding encoding) { return 1 << encoding; }
+
+/// the encodings this build can decode
+const quint8 SUPPORTED_MIXED_AUDIO_ENCODINGS = (1 << MixedAudioEncodingRaw) | (1 << MixedAudioEncodingMidSideADPCM);
+
+// the predictor and step index that start each ADPCM channel, then one byte holding both nibbles of each frame
+const int NUM_BYTES_ADPCM_CHANNEL_HEADER = sizeof(int16_t) + sizeof(quint8);
+const int NUM_BYTES_MID_SIDE_ADPCM_FRAME = (2 * NUM_BYTES_ADPCM_CHANNEL_HEADER)
+    + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+
+const int MAX_NUM_BYTES_MIXED_AUDIO_FRAME = sizeof(quint8) + NETWORK_BUFFER_LENGTH_BYTES_STEREO;
+
+/// The IMA-ADPCM state of one channel
+struct ADPCMChannelState {
+    int16_t predictor;
+    quint8 stepIndex;
+};
+
+/// Encodes the frames a mixer sends to one listener. The ADPCM state carries over from frame to frame so each frame
+/// starts well adapted, but it is also written at the start of every frame so a lost packet does not affect the next.
+class MixedAudioEncoder {
+public:
+    MixedAudioEncoder();
+
+    /// writes the encoding byte and one NETWORK_BUFFER_LENGTH_SAMPLES_STEREO frame, returns the number of bytes written
+    /// destination must have room for MAX_NUM_BYTES_MIXED_AUDIO_FRAME bytes
+    int encodeFrame(MixedAudioEncoding encoding, const int16_t* stereoSamples, char* destination);
+private:
+    ADPCMChannelState _midState;
+    ADPCMChannelState _sideState;
+};
+
+namespace MixedAudioCodec {
+    /// Decodes a frame written by MixedAudioEncoder into NETWORK_BUFFER_LENGTH_SAMPLES_STEREO samples.
+    /// Returns the number of samples decoded, zero if the frame is truncated or in an unknown encoding.
+    int decodeFrame(const char* source, int numBytes, int16_t* stereoSamples);
+}
+
+#endif // hifi_MixedAudioCodec_h
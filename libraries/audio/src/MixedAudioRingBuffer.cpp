@@ -9,6 +9,12 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstring>
+
+#include <PacketHeaders.h>
+
+#include "MixedAudioCodec.h"
+
 #include "MixedAudioRingBuffer.h"
 
 MixedAudioRingBuffer::MixedAudioRingBuffer(int numFrameSamples) :
@@ -18,11 +24,40 @@ MixedAudioRingBuffer::MixedAudioRingBuffer(int numFrameSamples) :
     
 }
 
+int MixedAudioRingBuffer::parseData(const QByteArray& packet) {
+    int numBytesPacketHeader = numBytesForPacketHeader(packet);
+    
+    if (packetTypeForPacket(packet) == PacketTypeSilentAudioFrame) {
+        // the mixer had nothing for us this frame, it tells us how many samples of silence that is
+        if (packet.size() < numBytesPacketHeader + (int) sizeof(int16_t)) {
+            return packet.size();
+        }
+        int16_t numSilentSamples;
+        memcpy(&numSilentSamples, packet.data() + numBytesPacketHeader, sizeof(int16_t));
+        
+        // a truncated or malformed count is dropped rather than written
+        if (numSilentSamples <= 0 || numSilentSamples > getSampleCapacity()) {
+            return numBytesPacketHeader + sizeof(int16_t);
+        }
+        
+        addSilentFrame(numSilentSamples);
+        return numBytesPacketHeader + sizeof(int16_t);
+    }
+    
+    int16_t stereoSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int numSamples = MixedAudioCodec::decodeFrame(packet.data() + numBytesPacketHeader,
+                                                  packet.size() - numBytesPacketHeader, stereoSamples);
+    writeSamples(stereoSamples, numSamples);
+    
+    return packet.size();
+}
+
 qint64 MixedAudioRingBuffer::readSamples(int16_t* destination, qint64 maxSamples) {
     // calculate the average loudness for the frame about to go out
     
     // read from _nextOutput either _numFrameSamples or to the end of the buffer
-    int samplesFromNextOutput = _buffer + _sampleCapacity - _nextOutput;
+    const int16_t* nextOutput = getNextOutput();
+    int samplesFromNextOutput = _buffer + _sampleCapacity - nextOutput;
     if (samplesFromNextOutput > _numFrameSamples) {
         samplesFromNextOutput = _numFrameSamples;
     }
@@ -30,7 +65,7 @@ qint64 MixedAudioRingBuffer::readSamples(int16_t* destination, qint64 maxSamples
     float averageLoudness = 0.0f;
     
     for (int s = 0; s < samplesFromNextOutput; s++) {
-        averageLoudness += fabsf(_nextOutput[s]);
+        averageLoudness += fabsf(nextOutput[s]);
     }
     
     // read samples from the beginning of the buffer, if any
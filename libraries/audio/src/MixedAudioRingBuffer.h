@@ -21,6 +21,9 @@ public:
     
     float getLastReadFrameAverageLoudness() const { return _lastReadFrameAverageLoudness; }
     
+    /// writes the frame in a mixed audio or silent audio frame packet from an audio mixer, decoding it if needed
+    int parseData(const QByteArray& packet);
+    
     qint64 readSamples(int16_t* destination, qint64 maxSamples);    
 private:
      float _lastReadFrameAverageLoudness;
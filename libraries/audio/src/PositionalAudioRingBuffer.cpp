@@ -16,18 +16,22 @@
 
 #include <Node.h>
 #include <PacketHeaders.h>
+#include <SharedUtil.h>
 #include <UUID.h>
 
 #include "PositionalAudioRingBuffer.h"
 
-PositionalAudioRingBuffer::PositionalAudioRingBuffer(PositionalAudioRingBuffer::Type type) :
-    AudioRingBuffer(NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL),
+PositionalAudioRingBuffer::PositionalAudioRingBuffer(PositionalAudioRingBuffer::Type type, bool isLockFree) :
+    AudioRingBuffer(NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, false, isLockFree),
     _type(type),
     _position(0.0f, 0.0f, 0.0f),
     _orientation(0.0f, 0.0f, 0.0f, 0.0f),
     _willBeAddedToMix(false),
     _shouldLoopbackForNode(false),
-    _shouldOutputStarveDebug(true)
+    _shouldOutputStarveDebug(true),
+    _nextOutputTrailingLoudness(0.0f),
+    _isResetPending(0),
+    _jitterBufferDepth()
 {
 
 }
@@ -41,23 +45,28 @@ int PositionalAudioRingBuffer::parseData(const QByteArray& packet) {
     int readBytes = numBytesForPacketHeader(packet);
     
     readBytes += parsePositionalData(packet.mid(readBytes));
-   
-    if (packetTypeForPacket(packet) == PacketTypeSilentAudioFrame) {
+    readBytes += parseAudioData(packetTypeForPacket(packet), packet.data() + readBytes, packet.size() - readBytes);
+    
+    return readBytes;
+}
+
+int PositionalAudioRingBuffer::parseAudioData(PacketType packetType, const char* audioData, int numAudioBytes) {
+    _jitterBufferDepth.packetArrived(usecTimestampNow());
+    
+    if (packetType == PacketTypeSilentAudioFrame) {
         // this source had no audio to send us, but this counts as a packet
         // write silence equivalent to the number of silent samples they just sent us
         int16_t numSilentSamples;
         
-        memcpy(&numSilentSamples, packet.data() + readBytes, sizeof(int16_t));
-        
-        readBytes += sizeof(int16_t);
+        memcpy(&numSilentSamples, audioData, sizeof(int16_t));
         
         addSilentFrame(numSilentSamples);
+        
+        return sizeof(int16_t);
     } else {
         // there is audio data to read
-        readBytes += writeData(packet.data() + readBytes, packet.size() - readBytes);
+        return writeData(audioData, numAudioBytes);
     }
-    
-    return readBytes;
 }
 
 int PositionalAudioRingBuffer::parsePositionalData(const QByteArray& positionalByteArray) {
@@ -68,7 +77,11 @@ int PositionalAudioRingBuffer::parsePositionalData(const QByteArray& positionalB
 
     // if this node sent us a NaN for first float in orientation then don't consider this good audio and bail
     if (glm::isnan(_orientation.x)) {
-        reset();
+        if (_isLockFree) {
+            _isResetPending.storeRelease(1);
+        } else {
+            reset();
+        }
         return 0;
     }
 
@@ -78,9 +91,10 @@ int PositionalAudioRingBuffer::parsePositionalData(const QByteArray& positionalB
 void PositionalAudioRingBuffer::updateNextOutputTrailingLoudness() {
     // ForBoundarySamples means that we expect the number of samples not to roll of the end of the ring buffer
     float nextLoudness = 0;
+    const int16_t* nextOutput = getNextOutput();
     
     for (int i = 0; i < _numFrameSamples; ++i) {
-        nextLoudness += fabsf(_nextOutput[i]);
+        nextLoudness += fabsf(nextOutput[i]);
     }
     
     nextLoudness /= _numFrameSamples;
@@ -102,7 +116,13 @@ void PositionalAudioRingBuffer::updateNextOutputTrailingLoudness() {
     }
 }
 
-bool PositionalAudioRingBuffer::shouldBeAddedToMix(int numJitterBufferSamples) {
+bool PositionalAudioRingBuffer::shouldBeAddedToMix() {
+    if (_isResetPending.fetchAndStoreAcquire(0)) {
+        reset();
+    }
+    
+    int numJitterBufferSamples = _jitterBufferDepth.getDesiredFrames() * NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+    
     if (!isNotStarvedOrHasMinimumSamples(NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + numJitterBufferSamples)) {
         if (_shouldOutputStarveDebug) {
             _shouldOutputStarveDebug = false;
@@ -112,6 +132,9 @@ bool PositionalAudioRingBuffer::shouldBeAddedToMix(int numJitterBufferSamples) {
     } else if (samplesAvailable() < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL) {
         _isStarved = true;
         
+        // a deeper buffer would have covered this, it now has to fill back up to the new depth
+        _jitterBufferDepth.streamStarved();
+        
         // reset our _shouldOutputStarveDebug to true so the next is printed
         _shouldOutputStarveDebug = true;
         
@@ -122,6 +145,10 @@ bool PositionalAudioRingBuffer::shouldBeAddedToMix(int numJitterBufferSamples) {
 
         // since we've read data from ring buffer at least once - we've started
         _hasStarted = true;
+        
+        // skip frames the stream has been holding for longer than its jitter needs
+        int numBufferedFrames = samplesAvailable() / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL - 1;
+        shiftReadPosition(_jitterBufferDepth.frameMixed(numBufferedFrames) * NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
 
         return true;
     }
@@ -15,7 +15,10 @@
 #include <vector>
 #include <glm/gtx/quaternion.hpp>
 
+#include <PacketHeaders.h>
+
 #include "AudioRingBuffer.h"
+#include "JitterBufferDepth.h"
 
 class PositionalAudioRingBuffer : public AudioRingBuffer {
 public:
@@ -24,7 +27,7 @@ public:
         Injector
     };
     
-    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Type type);
+    PositionalAudioRingBuffer(PositionalAudioRingBuffer::Type type, bool isLockFree = false);
     ~PositionalAudioRingBuffer();
     
     int parseData(const QByteArray& packet);
@@ -34,7 +37,8 @@ public:
     void updateNextOutputTrailingLoudness();
     float getNextOutputTrailingLoudness() const { return _nextOutputTrailingLoudness; }
     
-    bool shouldBeAddedToMix(int numJitterBufferSamples);
+    /// true when a frame is ready to mix, the jitter buffer depth it waits for adapts to how the stream arrives
+    bool shouldBeAddedToMix();
     
     bool willBeAddedToMix() const { return _willBeAddedToMix; }
     void setWillBeAddedToMix(bool willBeAddedToMix) { _willBeAddedToMix = willBeAddedToMix; }
@@ -45,11 +49,16 @@ public:
     const glm::vec3& getPosition() const { return _position; }
     const glm::quat& getOrientation() const { return _orientation; }
     
+    const JitterBufferDepth& getJitterBufferDepth() const { return _jitterBufferDepth; }
+    
 protected:
     // disallow copying of PositionalAudioRingBuffer objects
     PositionalAudioRingBuffer(const PositionalAudioRingBuffer&);
     PositionalAudioRingBuffer& operator= (const PositionalAudioRingBuffer&);
     
+    /// writes the samples, or the silence, that follow the positional data in a microphone packet
+    int parseAudioData(PacketType packetType, const char* audioData, int numAudioBytes);
+    
     PositionalAudioRingBuffer::Type _type;
     glm::vec3 _position;
     glm::quat _orientation;
@@ -58,6 +67,11 @@ protected:
     bool _shouldOutputStarveDebug;
     
     float _nextOutputTrailingLoudness;
+    
+    /// set by the writer when a packet asks for a reset the lock-free reader has to carry out
+    QAtomicInt _isResetPending;
+    
+    JitterBufferDepth _jitterBufferDepth;
 };
 
 #endif // hifi_PositionalAudioRingBuffer_h
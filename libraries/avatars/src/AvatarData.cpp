@@ -55,7 +55,9 @@ AvatarData::AvatarData() :
     _owningAvatarMixer(),
     _lastUpdateTimer()
 {
-    
+    for (int i = 0; i < NUM_AVATAR_STATE_HISTORY; i++) {
+        _receivedStateSequences[i] = -1;
+    }
 }
 
 AvatarData::~AvatarData() {
@@ -88,21 +90,17 @@ QByteArray AvatarData::toByteArray() {
     unsigned char* destinationBuffer = reinterpret_cast<unsigned char*>(avatarDataByteArray.data());
     unsigned char* startPosition = destinationBuffer;
     
-    memcpy(destinationBuffer, &_position, sizeof(_position));
-    destinationBuffer += sizeof(_position);
+    destinationBuffer += packPosition(destinationBuffer, _position);
     
-    // Body rotation (NOTE: This needs to become a quaternion to save two bytes)
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyYaw);
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyPitch);
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyRoll);
+    // Body rotation
+    destinationBuffer += packOrientationQuatToFourBytes(destinationBuffer, getOrientation());
 
     // Body scale
     destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _targetScale);
 
-    // Head rotation (NOTE: This needs to become a quaternion to save two bytes)
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalYaw());
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalPitch());
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalRoll());
+    // Head rotation, relative to the body
+    destinationBuffer += packOrientationQuatToFourBytes(destinationBuffer, glm::quat(glm::radians(
+        glm::vec3(_headData->getFinalPitch(), _headData->getFinalYaw(), _headData->getFinalRoll()))));
     
     // Head lean X,Z (head lateral and fwd/back motion relative to torso)
     memcpy(destinationBuffer, &_headData->_leanSideways, sizeof(_headData->_leanSideways));
@@ -111,8 +109,7 @@ QByteArray AvatarData::toByteArray() {
     destinationBuffer += sizeof(_headData->_leanForward);
 
     // Lookat Position
-    memcpy(destinationBuffer, &_headData->_lookAtPosition, sizeof(_headData->_lookAtPosition));
-    destinationBuffer += sizeof(_headData->_lookAtPosition);
+    destinationBuffer += packPosition(destinationBuffer, _headData->_lookAtPosition);
      
     // Instantaneous audio loudness (used to drive facial animation)
     memcpy(destinationBuffer, &_headData->_audioLoudness, sizeof(float));
@@ -178,7 +175,7 @@ QByteArray AvatarData::toByteArray() {
     }
     foreach (const JointData& data, _jointData) {
         if (data.valid) {
-            destinationBuffer += packOrientationQuatToBytes(destinationBuffer, data.rotation);
+            destinationBuffer += packOrientationQuatToFourBytes(destinationBuffer, data.rotation);
         }
     }
         
@@ -214,25 +211,21 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     quint64 now = usecTimestampNow();
 
     // The absolute minimum size of the update data is as follows:
-    // 50 bytes of "plain old data" {
-    //     position      = 12 bytes
-    //     bodyYaw       =  2 (compressed float)
-    //     bodyPitch     =  2 (compressed float)
-    //     bodyRoll      =  2 (compressed float)
+    // 40 bytes of "plain old data" {
+    //     position      =  9 (fixed point)
+    //     bodyRotation  =  4 (compressed quat)
     //     targetScale   =  2 (compressed float)
-    //     headYaw       =  2 (compressed float)
-    //     headPitch     =  2 (compressed float)
-    //     headRoll      =  2 (compressed float)
+    //     headRotation  =  4 (compressed quat)
     //     leanSideways  =  4
     //     leanForward   =  4
-    //     lookAt        = 12
+    //     lookAt        =  9 (fixed point)
     //     audioLoudness =  4
     // }
     // + 1 byte for messageSize (0)
     // + 1 byte for pupilSize
     // + 1 byte for numJoints (0)
-    // = 53 bytes
-    int minPossibleSize = 53; 
+    // = 43 bytes
+    int minPossibleSize = 43; 
     
     int maxAvailableSize = packet.size() - offset;
     if (minPossibleSize > maxAvailableSize) {
@@ -247,33 +240,13 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     }
 
     { // Body world position, rotation, and scale
-        // position
-        glm::vec3 position;
-        memcpy(&position, sourceBuffer, sizeof(position));
-        sourceBuffer += sizeof(position);
-        
-        if (glm::isnan(position.x) || glm::isnan(position.y) || glm::isnan(position.z)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::position; displayName = '" << _displayName << "'";
-            }
-            return maxAvailableSize;
-        }
-        _position = position;
+        // position, the fixed point steps cannot come out as nan
+        sourceBuffer += unpackPosition(sourceBuffer, _position);
         
-        // rotation (NOTE: This needs to become a quaternion to save two bytes)
-        float yaw, pitch, roll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
-        if (glm::isnan(yaw) || glm::isnan(pitch) || glm::isnan(roll)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::yaw,pitch,roll; displayName = '" << _displayName << "'";
-            }
-            return maxAvailableSize;
-        }
-        _bodyYaw = yaw;
-        _bodyPitch = pitch;
-        _bodyRoll = roll;
+        // rotation
+        glm::quat orientation;
+        sourceBuffer += unpackOrientationQuatFromFourBytes(sourceBuffer, orientation);
+        setOrientation(orientation);
         
         // scale
         float scale;
@@ -285,24 +258,17 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
             return maxAvailableSize;
         }
         _targetScale = scale;
-    } // 20 bytes
-    
-    { // Head rotation 
-        //(NOTE: This needs to become a quaternion to save two bytes)
-        float headYaw, headPitch, headRoll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
-        if (glm::isnan(headYaw) || glm::isnan(headPitch) || glm::isnan(headRoll)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::headYaw,headPitch,headRoll; displayName = '" << _displayName << "'";
-            }
-            return maxAvailableSize;
-        }
-        _headData->setBaseYaw(headYaw);
-        _headData->setBasePitch(headPitch);
-        _headData->setBaseRoll(headRoll);
-    } // 6 bytes
+    } // 15 bytes
+    
+    { // Head rotation, relative to the body
+        glm::quat headOrientation;
+        sourceBuffer += unpackOrientationQuatFromFourBytes(sourceBuffer, headOrientation);
+        
+        glm::vec3 headEulerAngles = glm::degrees(safeEulerAngles(headOrientation));
+        _headData->setBasePitch(headEulerAngles.x);
+        _headData->setBaseYaw(headEulerAngles.y);
+        _headData->setBaseRoll(headEulerAngles.z);
+    } // 4 bytes
         
     // Head lean (relative to pelvis)
     {
@@ -322,17 +288,8 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     } // 8 bytes
     
     { // Lookat Position
-        glm::vec3 lookAt;
-        memcpy(&lookAt, sourceBuffer, sizeof(lookAt));
-        sourceBuffer += sizeof(lookAt);
-        if (glm::isnan(lookAt.x) || glm::isnan(lookAt.y) || glm::isnan(lookAt.z)) {
-            if (shouldLogError(now)) {
-                qDebug() << "Discard nan AvatarData::lookAt; displayName = '" << _displayName << "'";
-            }
-            return maxAvailableSize;
-        }
-        _headData->_lookAtPosition = lookAt;
-    } // 12 bytes
+        sourceBuffer += unpackPosition(sourceBuffer, _headData->_lookAtPosition);
+    } // 9 bytes
     
     { // AudioLoudness
         // Instantaneous audio loudness (used to drive facial animation)
@@ -473,9 +430,8 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     }
     // 1 + bytesOfValidity bytes
 
-    // each joint rotation component is stored in two bytes (sizeof(uint16_t))
-    int COMPONENTS_PER_QUATERNION = 4;
-    minPossibleSize += numValidJoints * COMPONENTS_PER_QUATERNION * sizeof(uint16_t);
+    // each joint rotation is stored in NUM_BYTES_AVATAR_ROTATION bytes
+    minPossibleSize += numValidJoints * NUM_BYTES_AVATAR_ROTATION;
     if (minPossibleSize > maxAvailableSize) {
         if (shouldLogError(now)) {
             qDebug() << "Malformed AvatarData packet after JointData;"
@@ -490,15 +446,98 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
         for (int i = 0; i < numJoints; i++) {
             JointData& data = _jointData[i];
             if (data.valid) {
-                sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, data.rotation);
+                sourceBuffer += unpackOrientationQuatFromFourBytes(sourceBuffer, data.rotation);
             }
         }
-    } // numJoints * 8 bytes
+    } // numValidJoints * 4 bytes
     _hasNewJointRotations = true;
     
     return sourceBuffer - startPosition;
 }
 
+int AvatarData::parseStateAtOffset(const QByteArray& packet, int offset, bool& hasBaseline) {
+    quint16 sequence;
+    quint8 baselineAge;
+    
+    int maxAvailableSize = packet.size() - offset;
+    if (maxAvailableSize < (int) (sizeof(sequence) + sizeof(baselineAge))) {
+        return maxAvailableSize;
+    }
+    
+    const char* startPosition = packet.constData() + offset;
+    const char* sourceBuffer = startPosition;
+    
+    memcpy(&sequence, sourceBuffer, sizeof(sequence));
+    sourceBuffer += sizeof(sequence);
+    memcpy(&baselineAge, sourceBuffer, sizeof(baselineAge));
+    sourceBuffer += sizeof(baselineAge);
+    
+    int slot = sequence % NUM_AVATAR_STATE_HISTORY;
+    hasBaseline = true;
+    
+    if (baselineAge == 0) {
+        // a whole state
+        int stateOffset = offset + (sourceBuffer - startPosition);
+        int stateSize = parseDataAtOffset(packet, stateOffset);
+        
+        _receivedStates[slot] = packet.mid(stateOffset, stateSize);
+        _receivedStateSequences[slot] = sequence;
+        
+        return (sourceBuffer - startPosition) + stateSize;
+    }
+    
+    quint16 deltaSize;
+    if (packet.constData() + packet.size() - sourceBuffer < (int) sizeof(deltaSize)) {
+        return maxAvailableSize;
+    }
+    memcpy(&deltaSize, sourceBuffer, sizeof(deltaSize));
+    sourceBuffer += sizeof(deltaSize);
+    
+    if (packet.constData() + packet.size() - sourceBuffer < deltaSize) {
+        return maxAvailableSize;
+    }
+    
+    quint16 baselineSequence = sequence - baselineAge;
+    int baselineSlot = baselineSequence % NUM_AVATAR_STATE_HISTORY;
+    
+    QByteArray state;
+    if (_receivedStateSequences[baselineSlot] != baselineSequence
+        || !AvatarDelta::decode(_receivedStates[baselineSlot], sourceBuffer, deltaSize, state)) {
+        hasBaseline = false;
+    } else {
+        parseDataAtOffset(state, 0);
+        
+        _receivedStates[slot] = state;
+        _receivedStateSequences[slot] = sequence;
+    }
+    
+    return (sourceBuffer - startPosition) + deltaSize;
+}
+
+int AvatarData::packPosition(unsigned char* buffer, const glm::vec3& position) {
+    for (int i = 0; i < 3; i++) {
+        // the domain runs from zero to TREE_SCALE meters on each axis, an avatar outside it is held to its edge
+        // and one at nan to the corner
+        float steps = floorf(position[i] * AVATAR_POSITION_STEPS_PER_METER + 0.5f);
+        quint32 step = (steps > 0.0f) ? glm::min(steps, (float) MAX_AVATAR_POSITION_STEP) : 0.0f;
+        
+        *buffer++ = step & 0xff;
+        *buffer++ = (step >> 8) & 0xff;
+        *buffer++ = (step >> 16) & 0xff;
+    }
+    return NUM_BYTES_AVATAR_POSITION;
+}
+
+int AvatarData::unpackPosition(const unsigned char* buffer, glm::vec3& position) {
+    for (int i = 0; i < 3; i++) {
+        quint32 step = buffer[0] | (buffer[1] << 8) | (buffer[2] << 16);
+        buffer += 3;
+        
+        position[i] = step / AVATAR_POSITION_STEPS_PER_METER;
+    }
+    return NUM_BYTES_AVATAR_POSITION;
+}
+
 void AvatarData::setJointData(int index, const glm::quat& rotation) {
     if (index == -1) {
         return;
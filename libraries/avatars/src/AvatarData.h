@@ -47,6 +47,7 @@ typedef unsigned long long quint64;
 #include <RegisteredMetaTypes.h>
 #include <Node.h>
 
+#include "AvatarDelta.h"
 #include "HeadData.h"
 #include "HandData.h"
 
@@ -61,6 +62,19 @@ static const float MIN_AVATAR_SCALE = .005f;
 
 const float MAX_AUDIO_LOUDNESS = 1000.0; // close enough for mouth animation
 
+// positions go out as three byte steps from the low corner of the domain, this many to the meter, which is the
+// whole TREE_SCALE to about a millimeter
+const float AVATAR_POSITION_STEPS_PER_METER = 1024.0f;
+const int MAX_AVATAR_POSITION_STEP = (1 << 24) - 1;
+const int NUM_BYTES_AVATAR_POSITION = 9;
+
+// rotations go out in four bytes, see packOrientationQuatToFourBytes
+const int NUM_BYTES_AVATAR_ROTATION = 4;
+
+// a joint whose rotation is no further than this in any component from its default goes out as the default,
+// the four byte rotation could not tell them apart anyway
+const float JOINT_ROTATION_DEFAULT_THRESHOLD = 0.001f;
+
 const int AVATAR_IDENTITY_PACKET_SEND_INTERVAL_MSECS = 1000;
 const int AVATAR_BILLBOARD_PACKET_SEND_INTERVAL_MSECS = 5000;
 
@@ -127,6 +141,19 @@ public:
     /// \return number of bytes parsed
     virtual int parseDataAtOffset(const QByteArray& packet, int offset);
 
+    /// parses one avatar's state from a PacketTypeBulkAvatarData, either whole or as a delta against a state this
+    /// avatar parsed before, and keeps it as a baseline for the deltas that follow
+    /// \param packet byte array of data
+    /// \param offset number of bytes into packet where the state's sequence number starts
+    /// \param hasBaseline set to false when the delta is against a state no longer held and was skipped
+    /// \return number of bytes parsed
+    int parseStateAtOffset(const QByteArray& packet, int offset, bool& hasBaseline);
+    
+    /// packs a position as its steps from the corner of the domain, clamped to the domain
+    /// \return the number of bytes written, NUM_BYTES_AVATAR_POSITION
+    static int packPosition(unsigned char* buffer, const glm::vec3& position);
+    static int unpackPosition(const unsigned char* buffer, glm::vec3& position);
+
     //  Body Rotation (degrees)
     float getBodyYaw() const { return _bodyYaw; }
     void setBodyYaw(float bodyYaw) { _bodyYaw = bodyYaw; }
@@ -290,6 +317,10 @@ protected:
     QWeakPointer<Node> _owningAvatarMixer;
     QElapsedTimer _lastUpdateTimer;
     
+    // the last states parsed from the avatar mixer, each in the slot its sequence number falls in
+    QByteArray _receivedStates[NUM_AVATAR_STATE_HISTORY];
+    int _receivedStateSequences[NUM_AVATAR_STATE_HISTORY];
+    
     /// Loads the joint indices, names from the FST file (if any)
     virtual void updateJointMappings();
 
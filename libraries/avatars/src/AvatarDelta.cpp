@@ -0,0 +1,284 @@
+//
+//  AvatarDelta.cpp
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+#include <limits>
+
+#include <SharedUtil.h>
+
+#include "AvatarData.h"
+
+#include "AvatarDelta.h"
+
+// the fields of a state in the order AvatarData::toByteArray packs them, each one bit of the change mask
+enum AvatarStateSection {
+    POSITION_SECTION,
+    BODY_ROTATION_SECTION,
+    SCALE_SECTION,
+    HEAD_ROTATION_SECTION,
+    LEAN_SECTION,
+    LOOK_AT_SECTION,
+    AUDIO_LOUDNESS_SECTION,
+    CHAT_SECTION,
+    BIT_ITEMS_SECTION,
+    PUPIL_SECTION,
+    JOINTS_SECTION,
+    NUM_AVATAR_STATE_SECTIONS
+};
+
+// the bits past the sections say how a changed section was sent, when it was not sent whole
+const int POSITION_STEPS_BIT = NUM_AVATAR_STATE_SECTIONS;
+const int LOOK_AT_STEPS_BIT = NUM_AVATAR_STATE_SECTIONS + 1;
+const int JOINT_ROTATIONS_BIT = NUM_AVATAR_STATE_SECTIONS + 2;
+
+// zero for the sections whose size depends on what is in them
+const int FIXED_SECTION_BYTES[NUM_AVATAR_STATE_SECTIONS] = {
+    NUM_BYTES_AVATAR_POSITION, NUM_BYTES_AVATAR_ROTATION, 2, NUM_BYTES_AVATAR_ROTATION, 8, NUM_BYTES_AVATAR_POSITION,
+    4, 0, 0, 1, 0
+};
+
+const int NUM_FACE_FLOATS = 4;
+const int BYTES_PER_JOINT_ROTATION = NUM_BYTES_AVATAR_ROTATION;
+const int BYTES_PER_POSITION_STEP = NUM_BYTES_AVATAR_POSITION / 3;
+
+// the size of the section that starts at data, or -1 if it runs past the available bytes
+static int sectionSize(int section, const unsigned char* data, int availableBytes) {
+    int size = FIXED_SECTION_BYTES[section];
+
+    if (section == CHAT_SECTION) {
+        if (availableBytes < 1) {
+            return -1;
+        }
+        size = 1 + data[0];
+    } else if (section == BIT_ITEMS_SECTION) {
+        if (availableBytes < 1) {
+            return -1;
+        }
+        size = 1;
+        if (oneAtBit(data[0], IS_FACESHIFT_CONNECTED)) {
+            size += NUM_FACE_FLOATS * sizeof(float);
+            if (availableBytes < size + 1) {
+                return -1;
+            }
+            size += 1 + data[size] * sizeof(float);
+        }
+    } else if (section == JOINTS_SECTION) {
+        if (availableBytes < 1) {
+            return -1;
+        }
+        int numJoints = data[0];
+        int numValidityBytes = (numJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+        if (availableBytes < 1 + numValidityBytes) {
+            return -1;
+        }
+        int numValidJoints = 0;
+        for (int i = 0; i < numJoints; i++) {
+            if (data[1 + i / BITS_IN_BYTE] & (1 << (i % BITS_IN_BYTE))) {
+                numValidJoints++;
+            }
+        }
+        size = 1 + numValidityBytes + numValidJoints * BYTES_PER_JOINT_ROTATION;
+    }
+
+    return (size <= availableBytes) ? size : -1;
+}
+
+// fills offsets with where each section of state starts, followed by where the state ends
+static bool findSections(const QByteArray& state, int offsets[NUM_AVATAR_STATE_SECTIONS + 1]) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(state.constData());
+    int offset = 0;
+
+    for (int section = 0; section < NUM_AVATAR_STATE_SECTIONS; section++) {
+        offsets[section] = offset;
+
+        int size = sectionSize(section, data + offset, state.size() - offset);
+        if (size < 0) {
+            return false;
+        }
+        offset += size;
+    }
+
+    offsets[NUM_AVATAR_STATE_SECTIONS] = offset;
+    return true;
+}
+
+static int readPositionStep(const unsigned char* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16);
+}
+
+static void writePositionStep(unsigned char* data, int step) {
+    data[0] = step & 0xff;
+    data[1] = (step >> 8) & 0xff;
+    data[2] = (step >> 16) & 0xff;
+}
+
+// appends how many grid steps the position moved on each axis, if they are few enough for two bytes
+static bool appendPositionSteps(const unsigned char* was, const unsigned char* now, QByteArray& delta) {
+    qint16 steps[3];
+    for (int i = 0; i < 3; i++) {
+        int difference = readPositionStep(now + i * BYTES_PER_POSITION_STEP)
+            - readPositionStep(was + i * BYTES_PER_POSITION_STEP);
+        if (difference < std::numeric_limits<qint16>::min() || difference > std::numeric_limits<qint16>::max()) {
+            return false;
+        }
+        steps[i] = difference;
+    }
+
+    delta.append(reinterpret_cast<const char*>(steps), sizeof(steps));
+    return true;
+}
+
+// appends a mask of the joint rotations that changed and those rotations, if the same joints are valid in both
+static bool appendJointRotations(const unsigned char* was, int wasSize, const unsigned char* now, int nowSize,
+                                 QByteArray& delta) {
+    int numValidityBytes = (now[0] + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    if (wasSize != nowSize || memcmp(was, now, 1 + numValidityBytes) != 0) {
+        return false;
+    }
+
+    int numValidJoints = (nowSize - 1 - numValidityBytes) / BYTES_PER_JOINT_ROTATION;
+    int numChangedBytes = (numValidJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    int maskOffset = delta.size();
+    delta.append(QByteArray(numChangedBytes, 0));
+
+    const unsigned char* wasRotation = was + 1 + numValidityBytes;
+    const unsigned char* nowRotation = now + 1 + numValidityBytes;
+    for (int i = 0; i < numValidJoints; i++) {
+        if (memcmp(wasRotation, nowRotation, BYTES_PER_JOINT_ROTATION) != 0) {
+            delta.data()[maskOffset + i / BITS_IN_BYTE] |= (1 << (i % BITS_IN_BYTE));
+            delta.append(reinterpret_cast<const char*>(nowRotation), BYTES_PER_JOINT_ROTATION);
+        }
+        wasRotation += BYTES_PER_JOINT_ROTATION;
+        nowRotation += BYTES_PER_JOINT_ROTATION;
+    }
+
+    // when most of the skeleton moved the whole section is smaller
+    if (delta.size() - maskOffset >= nowSize) {
+        delta.resize(maskOffset);
+        return false;
+    }
+    return true;
+}
+
+QByteArray AvatarDelta::encode(const QByteArray& baseline, const QByteArray& state) {
+    int baselineOffsets[NUM_AVATAR_STATE_SECTIONS + 1];
+    int stateOffsets[NUM_AVATAR_STATE_SECTIONS + 1];
+    if (!findSections(baseline, baselineOffsets) || !findSections(state, stateOffsets)) {
+        return QByteArray();
+    }
+
+    quint16 changeMask = 0;
+    QByteArray delta(sizeof(changeMask), 0);
+
+    for (int section = 0; section < NUM_AVATAR_STATE_SECTIONS; section++) {
+        const unsigned char* was = reinterpret_cast<const unsigned char*>(baseline.constData())
+            + baselineOffsets[section];
+        const unsigned char* now = reinterpret_cast<const unsigned char*>(state.constData()) + stateOffsets[section];
+        int wasSize = baselineOffsets[section + 1] - baselineOffsets[section];
+        int nowSize = stateOffsets[section + 1] - stateOffsets[section];
+
+        if (wasSize == nowSize && memcmp(was, now, nowSize) == 0) {
+            continue;
+        }
+        changeMask |= (1 << section);
+
+        if (section == POSITION_SECTION && appendPositionSteps(was, now, delta)) {
+            changeMask |= (1 << POSITION_STEPS_BIT);
+        } else if (section == LOOK_AT_SECTION && appendPositionSteps(was, now, delta)) {
+            changeMask |= (1 << LOOK_AT_STEPS_BIT);
+        } else if (section == JOINTS_SECTION && appendJointRotations(was, wasSize, now, nowSize, delta)) {
+            changeMask |= (1 << JOINT_ROTATIONS_BIT);
+        } else {
+            delta.append(reinterpret_cast<const char*>(now), nowSize);
+        }
+    }
+
+    memcpy(delta.data(), &changeMask, sizeof(changeMask));
+    return delta;
+}
+
+bool AvatarDelta::decode(const QByteArray& baseline, const char* delta, int deltaSize, QByteArray& state) {
+    int baselineOffsets[NUM_AVATAR_STATE_SECTIONS + 1];
+    quint16 changeMask;
+    if (deltaSize < (int) sizeof(changeMask) || !findSections(baseline, baselineOffsets)) {
+        return false;
+    }
+
+    memcpy(&changeMask, delta, sizeof(changeMask));
+    const unsigned char* sourceBuffer = reinterpret_cast<const unsigned char*>(delta) + sizeof(changeMask);
+    const unsigned char* endOfDelta = reinterpret_cast<const unsigned char*>(delta) + deltaSize;
+
+    state.resize(0);
+
+    for (int section = 0; section < NUM_AVATAR_STATE_SECTIONS; section++) {
+        const unsigned char* was = reinterpret_cast<const unsigned char*>(baseline.constData())
+            + baselineOffsets[section];
+        int wasSize = baselineOffsets[section + 1] - baselineOffsets[section];
+
+        if (!(changeMask & (1 << section))) {
+            state.append(reinterpret_cast<const char*>(was), wasSize);
+
+        } else if ((section == POSITION_SECTION && (changeMask & (1 << POSITION_STEPS_BIT)))
+                   || (section == LOOK_AT_SECTION && (changeMask & (1 << LOOK_AT_STEPS_BIT)))) {
+            qint16 steps[3];
+            if (endOfDelta - sourceBuffer < (int) sizeof(steps)) {
+                return false;
+            }
+            memcpy(steps, sourceBuffer, sizeof(steps));
+            sourceBuffer += sizeof(steps);
+
+            unsigned char position[NUM_BYTES_AVATAR_POSITION];
+            for (int i = 0; i < 3; i++) {
+                int step = readPositionStep(was + i * BYTES_PER_POSITION_STEP) + steps[i];
+                if (step < 0 || step > MAX_AVATAR_POSITION_STEP) {
+                    return false;
+                }
+                writePositionStep(position + i * BYTES_PER_POSITION_STEP, step);
+            }
+            state.append(reinterpret_cast<const char*>(position), sizeof(position));
+
+        } else if (section == JOINTS_SECTION && (changeMask & (1 << JOINT_ROTATIONS_BIT))) {
+            int numValidityBytes = (was[0] + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+            int numValidJoints = (wasSize - 1 - numValidityBytes) / BYTES_PER_JOINT_ROTATION;
+            int numChangedBytes = (numValidJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+            if (endOfDelta - sourceBuffer < numChangedBytes) {
+                return false;
+            }
+            const unsigned char* changed = sourceBuffer;
+            sourceBuffer += numChangedBytes;
+
+            state.append(reinterpret_cast<const char*>(was), 1 + numValidityBytes);
+            const unsigned char* wasRotation = was + 1 + numValidityBytes;
+
+            for (int i = 0; i < numValidJoints; i++) {
+                if (changed[i / BITS_IN_BYTE] & (1 << (i % BITS_IN_BYTE))) {
+                    if (endOfDelta - sourceBuffer < BYTES_PER_JOINT_ROTATION) {
+                        return false;
+                    }
+                    state.append(reinterpret_cast<const char*>(sourceBuffer), BYTES_PER_JOINT_ROTATION);
+                    sourceBuffer += BYTES_PER_JOINT_ROTATION;
+                } else {
+                    state.append(reinterpret_cast<const char*>(wasRotation), BYTES_PER_JOINT_ROTATION);
+                }
+                wasRotation += BYTES_PER_JOINT_ROTATION;
+            }
+
+        } else {
+            int size = sectionSize(section, sourceBuffer, endOfDelta - sourceBuffer);
+            if (size < 0) {
+                return false;
+            }
+            state.append(reinterpret_cast<const char*>(sourceBuffer), size);
+            sourceBuffer += size;
+        }
+    }
+
+    return sourceBuffer == endOfDelta;
+}
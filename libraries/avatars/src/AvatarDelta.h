@@ -0,0 +1,34 @@
+//
+//  AvatarDelta.h
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarDelta_h
+#define hifi_AvatarDelta_h
+
+#include <QtCore/QByteArray>
+
+/// how many of an avatar's most recent states the mixer and each client hold on to as baselines for deltas
+/// the mixer sends a keyframe once the last state a listener acknowledged is older than this many frames
+const int NUM_AVATAR_STATE_HISTORY = 32;
+
+/// Encodes an AvatarData::toByteArray state as the fields that changed since an earlier state (the baseline), and
+/// rebuilds the state from the baseline and that delta. A delta starts with a two byte mask of the changed fields.
+/// Positions that moved less than thirty two meters go out as three two byte grid steps, and a skeleton whose
+/// joints are all still valid sends only the rotations that changed. Decoding gives back the exact bytes of the state.
+class AvatarDelta {
+public:
+    /// \return the delta from baseline to state, or an empty array if either of them is malformed
+    static QByteArray encode(const QByteArray& baseline, const QByteArray& state);
+
+    /// rebuilds state from baseline and the deltaSize bytes of delta
+    /// \return false if the delta does not fit the baseline
+    static bool decode(const QByteArray& baseline, const char* delta, int deltaSize, QByteArray& state);
+};
+
+#endif // hifi_AvatarDelta_h
@@ -9,12 +9,16 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstring>
+
+#include <NodeList.h>
 #include <PacketHeaders.h>
 
 #include "AvatarHashMap.h"
 
 AvatarHashMap::AvatarHashMap() :
-    _avatarHash()
+    _avatarHash(),
+    _pendingBulkAvatarDataAcks()
 {
     
 }
@@ -104,6 +108,15 @@ AvatarSharedPointer AvatarHashMap::matchingOrNewAvatar(const QUuid& sessionUUID,
 void AvatarHashMap::processAvatarDataPacket(const QByteArray &datagram, const QWeakPointer<Node> &mixerWeakPointer) {
     int bytesRead = numBytesForPacketHeader(datagram);
     
+    quint16 packetSequence;
+    if (datagram.size() < bytesRead + (int) sizeof(packetSequence)) {
+        return;
+    }
+    memcpy(&packetSequence, datagram.constData() + bytesRead, sizeof(packetSequence));
+    bytesRead += sizeof(packetSequence);
+    
+    bool hasAllBaselines = true;
+    
     // enumerate over all of the avatars in this packet
     // only add them if mixerWeakPointer points to something (meaning that mixer is still around)
     while (bytesRead < datagram.size() && mixerWeakPointer.data()) {
@@ -113,10 +126,32 @@ void AvatarHashMap::processAvatarDataPacket(const QByteArray &datagram, const QW
         AvatarSharedPointer matchingAvatarData = matchingOrNewAvatar(sessionUUID, mixerWeakPointer);
         
         // have the matching (or new) avatar parse the data from the packet
-        bytesRead += matchingAvatarData->parseDataAtOffset(datagram, bytesRead);
+        bool hasBaseline = true;
+        bytesRead += matchingAvatarData->parseStateAtOffset(datagram, bytesRead, hasBaseline);
+        hasAllBaselines = hasAllBaselines && hasBaseline;
+    }
+    
+    // a packet with a delta we could not apply goes unacknowledged, so the mixer falls back to whole states once
+    // the baselines we do hold are too old
+    if (hasAllBaselines && _pendingBulkAvatarDataAcks.size() < MAX_PENDING_BULK_AVATAR_DATA_ACKS) {
+        _pendingBulkAvatarDataAcks.append(packetSequence);
     }
 }
 
+void AvatarHashMap::sendBulkAvatarDataAcks() {
+    if (_pendingBulkAvatarDataAcks.isEmpty()) {
+        return;
+    }
+    
+    QByteArray ackPacket = byteArrayWithPopulatedHeader(PacketTypeBulkAvatarDataAck);
+    ackPacket.append(reinterpret_cast<const char*>(_pendingBulkAvatarDataAcks.constData()),
+                     _pendingBulkAvatarDataAcks.size() * sizeof(quint16));
+    
+    NodeList::getInstance()->broadcastToNodes(ackPacket, NodeSet() << NodeType::AvatarMixer);
+    
+    _pendingBulkAvatarDataAcks.resize(0);
+}
+
 void AvatarHashMap::processAvatarIdentityPacket(const QByteArray &packet, const QWeakPointer<Node>& mixerWeakPointer) {
     // setup a data stream to parse the packet
     QDataStream identityStream(packet);
@@ -15,6 +15,7 @@
 #include <QtCore/QHash>
 #include <QtCore/QSharedPointer>
 #include <QtCore/QUuid>
+#include <QtCore/QVector>
 
 #include <Node.h>
 
@@ -23,6 +24,9 @@
 typedef QSharedPointer<AvatarData> AvatarSharedPointer;
 typedef QHash<QUuid, AvatarSharedPointer> AvatarHash;
 
+/// the most PacketTypeBulkAvatarData sequence numbers held for the next acknowledgement, the rest go unacknowledged
+const int MAX_PENDING_BULK_AVATAR_DATA_ACKS = 256;
+
 class AvatarHashMap : public QObject {
     Q_OBJECT
 public:
@@ -33,6 +37,10 @@ public:
 
     virtual void insert(const QUuid& id, AvatarSharedPointer avatar);
     
+    /// acknowledges the PacketTypeBulkAvatarData packets parsed since the last call to the avatar mixer, which
+    /// sends later avatar states as deltas against the acknowledged ones
+    void sendBulkAvatarDataAcks();
+    
 public slots:
     void processAvatarMixerDatagram(const QByteArray& datagram, const QWeakPointer<Node>& mixerWeakPointer);
     bool containsAvatarWithDisplayName(const QString& displayName);
@@ -51,6 +59,7 @@ protected:
     void processKillAvatar(const QByteArray& datagram);
 
     AvatarHash _avatarHash;
+    QVector<quint16> _pendingBulkAvatarDataAcks;
 };
 
 #endif // hifi_AvatarHashMap_h
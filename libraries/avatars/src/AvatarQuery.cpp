@@ -0,0 +1,97 @@
+//
+//  AvatarQuery.cpp
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+
+#include "AvatarQuery.h"
+
+// position, four two byte orientation parts, four two byte lens values and the byte budget
+const int NUM_BYTES_AVATAR_QUERY = sizeof(glm::vec3) + (8 * sizeof(uint16_t)) + sizeof(qint32);
+
+AvatarQuery::AvatarQuery() :
+    _cameraPosition(0.0f, 0.0f, 0.0f),
+    _cameraOrientation(),
+    _cameraFov(0.0f),
+    _cameraAspectRatio(0.0f),
+    _cameraNearClip(0.0f),
+    _cameraFarClip(0.0f),
+    _maxBytesPerSecond(DEFAULT_MAX_AVATAR_BYTES_PER_SECOND)
+{
+
+}
+
+void AvatarQuery::setViewFrustum(const ViewFrustum& viewFrustum) {
+    _cameraPosition = viewFrustum.getPosition();
+    _cameraOrientation = viewFrustum.getOrientation();
+    _cameraFov = viewFrustum.getFieldOfView();
+    _cameraAspectRatio = viewFrustum.getAspectRatio();
+    _cameraNearClip = viewFrustum.getNearClip();
+    _cameraFarClip = viewFrustum.getFarClip();
+}
+
+void AvatarQuery::loadViewFrustum(ViewFrustum& viewFrustum) const {
+    viewFrustum.setPosition(_cameraPosition);
+    viewFrustum.setOrientation(_cameraOrientation);
+    viewFrustum.setFieldOfView(_cameraFov);
+    viewFrustum.setAspectRatio(_cameraAspectRatio);
+    viewFrustum.setNearClip(_cameraNearClip);
+    viewFrustum.setFarClip(_cameraFarClip);
+    viewFrustum.calculate();
+}
+
+int AvatarQuery::getBroadcastData(unsigned char* destinationBuffer) const {
+    unsigned char* bufferStart = destinationBuffer;
+
+    memcpy(destinationBuffer, &_cameraPosition, sizeof(_cameraPosition));
+    destinationBuffer += sizeof(_cameraPosition);
+    destinationBuffer += packOrientationQuatToBytes(destinationBuffer, _cameraOrientation);
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _cameraFov);
+    destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _cameraAspectRatio);
+    destinationBuffer += packClipValueToTwoByte(destinationBuffer, _cameraNearClip);
+    destinationBuffer += packClipValueToTwoByte(destinationBuffer, _cameraFarClip);
+
+    qint32 maxBytesPerSecond = _maxBytesPerSecond;
+    memcpy(destinationBuffer, &maxBytesPerSecond, sizeof(maxBytesPerSecond));
+    destinationBuffer += sizeof(maxBytesPerSecond);
+
+    return destinationBuffer - bufferStart;
+}
+
+int AvatarQuery::parseData(const QByteArray& packet) {
+    int numBytesPacketHeader = numBytesForPacketHeader(packet);
+
+    if (packet.size() < numBytesPacketHeader + NUM_BYTES_AVATAR_QUERY) {
+        // a truncated query leaves the last one we had in place
+        return 0;
+    }
+
+    const unsigned char* startPosition = reinterpret_cast<const unsigned char*>(packet.data());
+    const unsigned char* sourceBuffer = startPosition + numBytesPacketHeader;
+
+    memcpy(&_cameraPosition, sourceBuffer, sizeof(_cameraPosition));
+    sourceBuffer += sizeof(_cameraPosition);
+    sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, _cameraOrientation);
+    sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &_cameraFov);
+    sourceBuffer += unpackFloatRatioFromTwoByte(sourceBuffer, _cameraAspectRatio);
+    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer, _cameraNearClip);
+    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer, _cameraFarClip);
+
+    qint32 maxBytesPerSecond = 0;
+    memcpy(&maxBytesPerSecond, sourceBuffer, sizeof(maxBytesPerSecond));
+    sourceBuffer += sizeof(maxBytesPerSecond);
+
+    // zero or less leaves the budget to the mixer
+    _maxBytesPerSecond = maxBytesPerSecond > 0 ? maxBytesPerSecond : DEFAULT_MAX_AVATAR_BYTES_PER_SECOND;
+
+    return sourceBuffer - startPosition;
+}
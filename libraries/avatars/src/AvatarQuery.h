@@ -0,0 +1,54 @@
+//
+//  AvatarQuery.h
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarQuery_h
+#define hifi_AvatarQuery_h
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <QtCore/QByteArray>
+
+#include <ViewFrustum.h>
+
+/// what the avatar mixer may spend on one listener's avatar updates when the listener does not ask for less
+const int DEFAULT_MAX_AVATAR_BYTES_PER_SECOND = 200000;
+
+/// The view a client sends the avatar mixer in a PacketTypeAvatarQuery, so the mixer can favour the avatars it can
+/// see. A trimmed down OctreeQuery: the camera lens plus how many bytes of avatar updates the client wants a second.
+class AvatarQuery {
+public:
+    AvatarQuery();
+
+    /// copies the camera details from the frustum the client renders with
+    void setViewFrustum(const ViewFrustum& viewFrustum);
+
+    /// sets up and calculates viewFrustum from the camera details in this query
+    void loadViewFrustum(ViewFrustum& viewFrustum) const;
+
+    int getMaxBytesPerSecond() const { return _maxBytesPerSecond; }
+    void setMaxBytesPerSecond(int maxBytesPerSecond) { _maxBytesPerSecond = maxBytesPerSecond; }
+
+    /// packs the query after the packet header, returns the number of bytes written
+    int getBroadcastData(unsigned char* destinationBuffer) const;
+
+    /// reads the query from a PacketTypeAvatarQuery packet, returns the number of bytes read including the header
+    int parseData(const QByteArray& packet);
+private:
+    glm::vec3 _cameraPosition;
+    glm::quat _cameraOrientation;
+    float _cameraFov;
+    float _cameraAspectRatio;
+    float _cameraNearClip;
+    float _cameraFarClip;
+    int _maxBytesPerSecond;
+};
+
+#endif // hifi_AvatarQuery_h
@@ -0,0 +1,196 @@
+//
+//  DatagramBatcher.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include <QtCore/QDebug>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#endif
+
+#include "DatagramBatcher.h"
+
+DatagramBatcher::DatagramBatcher(QUdpSocket& socket) :
+    _socket(socket),
+    _queueingThread(NULL),
+    _queuedBytes(),
+    _queuedOffsets(),
+    _queuedSizes(),
+    _queuedAddresses(),
+    _queuedPorts(),
+    _numSentBeforeFlush(0),
+    _receivedBytes(),
+    _receivedSizes(),
+    _receivedSenders(),
+    _numReceived(0),
+    _nextReceived(0)
+{
+
+}
+
+void DatagramBatcher::begin() {
+    if (!_queueingThread.testAndSetOrdered(NULL, QThread::currentThread()) && !isQueueing()) {
+        qDebug() << "DatagramBatcher::begin called while another thread is batching, writes will not be queued.";
+    }
+}
+
+void DatagramBatcher::queue(const char* data, int size, const HifiSockAddr& destinationSockAddr) {
+    if ((int) _queuedSizes.size() == MAX_QUEUED_DATAGRAMS) {
+        _numSentBeforeFlush += sendQueued();
+    }
+
+    _queuedOffsets.push_back(_queuedBytes.size());
+    _queuedSizes.push_back(size);
+    _queuedAddresses.push_back(destinationSockAddr.getAddress().toIPv4Address());
+    _queuedPorts.push_back(destinationSockAddr.getPort());
+    _queuedBytes.insert(_queuedBytes.end(), data, data + size);
+}
+
+int DatagramBatcher::flush() {
+    int numSent = _numSentBeforeFlush + sendQueued();
+    _numSentBeforeFlush = 0;
+    _queueingThread.testAndSetOrdered(QThread::currentThread(), NULL);
+    return numSent;
+}
+
+int DatagramBatcher::sendQueued() {
+    int numQueued = (int) _queuedSizes.size();
+    int numSent = 0;
+
+#ifdef Q_OS_LINUX
+    // the addresses and message headers only point into the queue once it has stopped growing
+    sockaddr_in destinations[MAX_QUEUED_DATAGRAMS];
+    iovec datagrams[MAX_QUEUED_DATAGRAMS];
+    mmsghdr messages[MAX_QUEUED_DATAGRAMS];
+
+    for (int i = 0; i < numQueued; i++) {
+        memset(&destinations[i], 0, sizeof(sockaddr_in));
+        destinations[i].sin_family = AF_INET;
+        destinations[i].sin_addr.s_addr = htonl(_queuedAddresses[i]);
+        destinations[i].sin_port = htons(_queuedPorts[i]);
+
+        datagrams[i].iov_base = &_queuedBytes[_queuedOffsets[i]];
+        datagrams[i].iov_len = _queuedSizes[i];
+
+        memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_name = &destinations[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &datagrams[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int socketDescriptor = _socket.socketDescriptor();
+    int nextMessage = 0;
+
+    while (nextMessage < numQueued) {
+        int result = sendmmsg(socketDescriptor, &messages[nextMessage], numQueued - nextMessage, 0);
+
+        if (result > 0) {
+            nextMessage += result;
+            numSent += result;
+        } else if (errno != EINTR) {
+            // sendmmsg stops at the first datagram that fails, skip it like a failed writeDatagram would be
+            qDebug() << "ERROR in sendmmsg:" << strerror(errno);
+            nextMessage++;
+        }
+    }
+#else
+    for (int i = 0; i < numQueued; i++) {
+        qint64 bytesWritten = _socket.writeDatagram(&_queuedBytes[_queuedOffsets[i]], _queuedSizes[i],
+                                                    QHostAddress(_queuedAddresses[i]), _queuedPorts[i]);
+        if (bytesWritten < 0) {
+            qDebug() << "ERROR in writeDatagram:" << _socket.error() << "-" << _socket.errorString();
+        } else {
+            numSent++;
+        }
+    }
+#endif
+
+    // clear keeps the capacity, so the queue stops allocating once it has held a busy frame
+    _queuedBytes.clear();
+    _queuedOffsets.clear();
+    _queuedSizes.clear();
+    _queuedAddresses.clear();
+    _queuedPorts.clear();
+
+    return numSent;
+}
+
+bool DatagramBatcher::readDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr) {
+    if (_nextReceived == _numReceived && !receiveBatch()) {
+        return false;
+    }
+
+    destinationByteArray.resize(_receivedSizes[_nextReceived]);
+    memcpy(destinationByteArray.data(), &_receivedBytes[_nextReceived * MAX_DATAGRAM_BYTES],
+           _receivedSizes[_nextReceived]);
+    senderSockAddr = _receivedSenders[_nextReceived];
+
+    _nextReceived++;
+    return true;
+}
+
+bool DatagramBatcher::receiveBatch() {
+    _numReceived = 0;
+    _nextReceived = 0;
+
+    if (!_socket.hasPendingDatagrams()) {
+        return false;
+    }
+
+    if (_receivedBytes.empty()) {
+        _receivedBytes.resize(MAX_RECEIVED_DATAGRAMS * MAX_DATAGRAM_BYTES);
+        _receivedSizes.resize(MAX_RECEIVED_DATAGRAMS);
+        _receivedSenders.resize(MAX_RECEIVED_DATAGRAMS);
+    }
+
+    // the first datagram is read through the socket, which has it watch the descriptor for the next readyRead
+    qint64 bytesRead = _socket.readDatagram(&_receivedBytes[0], MAX_DATAGRAM_BYTES,
+                                            _receivedSenders[0].getAddressPointer(),
+                                            _receivedSenders[0].getPortPointer());
+    if (bytesRead < 0) {
+        return false;
+    }
+
+    _receivedSizes[0] = bytesRead;
+    _numReceived = 1;
+
+#ifdef Q_OS_LINUX
+    // then whatever else is waiting comes off in one call
+    sockaddr_in senders[MAX_RECEIVED_DATAGRAMS];
+    iovec datagrams[MAX_RECEIVED_DATAGRAMS];
+    mmsghdr messages[MAX_RECEIVED_DATAGRAMS];
+    int numSlots = MAX_RECEIVED_DATAGRAMS - 1;
+
+    for (int i = 0; i < numSlots; i++) {
+        datagrams[i].iov_base = &_receivedBytes[(i + 1) * MAX_DATAGRAM_BYTES];
+        datagrams[i].iov_len = MAX_DATAGRAM_BYTES;
+
+        memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_name = &senders[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &datagrams[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int numMessages = recvmmsg(_socket.socketDescriptor(), messages, numSlots, MSG_DONTWAIT, NULL);
+
+    for (int i = 0; i < numMessages; i++) {
+        _receivedSizes[_numReceived] = messages[i].msg_len;
+        _receivedSenders[_numReceived] = HifiSockAddr(reinterpret_cast<const sockaddr*>(&senders[i]));
+        _numReceived++;
+    }
+#endif
+
+    return true;
+}
@@ -0,0 +1,77 @@
+//
+//  DatagramBatcher.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_DatagramBatcher_h
+#define hifi_DatagramBatcher_h
+
+#include <vector>
+
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtNetwork/QUdpSocket>
+
+#include "HifiSockAddr.h"
+
+/// the most datagrams held before a batch is sent on its own
+const int MAX_QUEUED_DATAGRAMS = 256;
+
+/// the most datagrams drained from the socket at once, each in a slot large enough for any UDP datagram
+const int MAX_RECEIVED_DATAGRAMS = 32;
+const int MAX_DATAGRAM_BYTES = 65536;
+
+/// Moves datagrams through a QUdpSocket in batches. On Linux a batch goes out with one sendmmsg and the socket is
+/// drained with recvmmsg; elsewhere the batch is sent and read one datagram at a time through the socket.
+class DatagramBatcher {
+public:
+    DatagramBatcher(QUdpSocket& socket);
+
+    /// starts queueing the datagrams the calling thread writes, other threads keep writing straight to the socket
+    void begin();
+
+    /// true if the calling thread has begun a batch that has not been flushed
+    bool isQueueing() const { return _queueingThread.load() == QThread::currentThread(); }
+
+    /// copies a datagram into the batch, sending the batch first if it is full
+    void queue(const char* data, int size, const HifiSockAddr& destinationSockAddr);
+    void queue(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+        queue(datagram.constData(), datagram.size(), destinationSockAddr);
+    }
+
+    /// sends the queued datagrams and stops queueing, returns the number the socket accepted since begin
+    int flush();
+
+    /// reads the next datagram from the socket, returns false once the socket has no more
+    bool readDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr);
+private:
+    int sendQueued();
+    bool receiveBatch();
+
+    QUdpSocket& _socket;
+    QAtomicPointer<QThread> _queueingThread;
+
+    // the queued datagrams one after another, with where each starts, its size and the IPv4 address and port it goes
+    // to, none of which allocate once the queue has held a busy frame
+    std::vector<char> _queuedBytes;
+    std::vector<int> _queuedOffsets;
+    std::vector<int> _queuedSizes;
+    std::vector<quint32> _queuedAddresses;
+    std::vector<quint16> _queuedPorts;
+    int _numSentBeforeFlush;
+
+    // one MAX_DATAGRAM_BYTES slot per received datagram, allocated on the first read
+    std::vector<char> _receivedBytes;
+    QVector<int> _receivedSizes;
+    QVector<HifiSockAddr> _receivedSenders;
+    int _numReceived;
+    int _nextReceived;
+};
+
+#endif // hifi_DatagramBatcher_h
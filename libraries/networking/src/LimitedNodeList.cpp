@@ -24,6 +24,7 @@
 #include "HifiSockAddr.h"
 #include "Logging.h"
 #include "LimitedNodeList.h"
+#include "PacketBuffer.h"
 #include "PacketHeaders.h"
 #include "SharedUtil.h"
 #include "UUID.h"
@@ -67,6 +68,7 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _nodeHashMutex(QMutex::Recursive),
     _nodeSocket(this),
     _dtlsSocket(NULL),
+    _datagramBatcher(_nodeSocket),
     _numCollectedPackets(0),
     _numCollectedBytes(0),
     _packetStatTimer()
@@ -198,11 +200,33 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
         replaceHashInPacketGivenConnectionUUID(datagramCopy, connectionSecret);
     }
     
+    return sendDatagram(datagramCopy.constData(), datagramCopy.size(), destinationSockAddr);
+}
+
+qint64 LimitedNodeList::writeDatagram(PacketBuffer& packet, const SharedNodePointer& destinationNode) {
+    if (!destinationNode || !destinationNode->getActiveSocket()) {
+        // we don't have a socket to send to, return 0
+        return 0;
+    }
+    
+    if (!destinationNode->getConnectionSecret().isNull()) {
+        packet.writeHash(destinationNode->getConnectionSecret());
+    }
+    
+    return sendDatagram(packet.getData(), packet.getSize(), *destinationNode->getActiveSocket());
+}
+
+qint64 LimitedNodeList::sendDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr) {
     // stat collection for packets
     ++_numCollectedPackets;
-    _numCollectedBytes += datagram.size();
+    _numCollectedBytes += size;
+    
+    if (_datagramBatcher.isQueueing()) {
+        _datagramBatcher.queue(data, size, destinationSockAddr);
+        return size;
+    }
     
-    qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy,
+    qint64 bytesWritten = _nodeSocket.writeDatagram(data, size,
                                                     destinationSockAddr.getAddress(), destinationSockAddr.getPort());
     
     if (bytesWritten < 0) {
@@ -212,6 +236,10 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
     return bytesWritten;
 }
 
+bool LimitedNodeList::readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr) {
+    return _datagramBatcher.readDatagram(destinationByteArray, senderSockAddr);
+}
+
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
     if (destinationNode) {
@@ -29,6 +29,7 @@
 
 #include <gnutls/gnutls.h>
 
+#include "DatagramBatcher.h"
 #include "DomainHandler.h"
 #include "Node.h"
 
@@ -43,6 +44,7 @@ extern const QUrl DEFAULT_NODE_AUTH_URL;
 const char DEFAULT_ASSIGNMENT_SERVER_HOSTNAME[] = "localhost";
 
 class HifiSockAddr;
+class PacketBuffer;
 
 typedef QSet<NodeType_t> NodeSet;
 
@@ -76,6 +78,16 @@ public:
 
     qint64 writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                          const HifiSockAddr& overridenSockAddr = HifiSockAddr());
+    
+    /// signs the packet in place and sends it to the node's active socket straight from its buffer
+    qint64 writeDatagram(PacketBuffer& packet, const SharedNodePointer& destinationNode);
+
+    /// queues what this thread writes to the node socket until flushDatagramBatch sends it all at once
+    void beginDatagramBatch() { _datagramBatcher.begin(); }
+    int flushDatagramBatch() { return _datagramBatcher.flush(); }
+    
+    /// reads the next datagram waiting on the node socket, returns false if there are none
+    bool readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr);
 
     void(*linkedDataCreateCallback)(Node *);
 
@@ -121,6 +133,9 @@ protected:
     
     qint64 writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
                          const QUuid& connectionSecret);
+    
+    /// counts a signed datagram and queues it in the batch or writes it to the node socket
+    qint64 sendDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr);
 
     NodeHash::iterator killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill);
 
@@ -132,6 +147,7 @@ protected:
     QMutex _nodeHashMutex;
     QUdpSocket _nodeSocket;
     QUdpSocket* _dtlsSocket;
+    DatagramBatcher _datagramBatcher;
     int _numCollectedPackets;
     int _numCollectedBytes;
     QElapsedTimer _packetStatTimer;
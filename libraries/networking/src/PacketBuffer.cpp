@@ -0,0 +1,78 @@
+//
+//  PacketBuffer.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+
+#include "PacketBuffer.h"
+
+PacketBuffer::PacketBuffer() :
+    _hash(QCryptographicHash::Md5),
+    _type(PacketTypeUnknown),
+    _senderUUID(),
+    _numHeaderBytes(0),
+    _size(0)
+{
+    
+}
+
+void PacketBuffer::reset(PacketType type, const QUuid& senderUUID) {
+    if (_type != type || _senderUUID != senderUUID || _numHeaderBytes == 0) {
+        _numHeaderBytes = populatePacketHeader(_data, type, senderUUID);
+        _type = type;
+        _senderUUID = senderUUID;
+    } else if (numHashBytesInPacketHeaderGivenPacketType(type) > 0) {
+        // the last packet's hash is zeroed again, as a freshly populated header has it
+        memset(_data + _numHeaderBytes - NUM_BYTES_MD5_HASH, 0, NUM_BYTES_MD5_HASH);
+    }
+    
+    _size = _numHeaderBytes;
+}
+
+bool PacketBuffer::assign(const QByteArray& packet) {
+    // whatever header the packet brings, the next reset writes its own
+    _type = PacketTypeUnknown;
+    
+    if (packet.size() > MAX_PACKET_SIZE) {
+        _numHeaderBytes = 0;
+        _size = 0;
+        return false;
+    }
+    
+    memcpy(_data, packet.constData(), packet.size());
+    _numHeaderBytes = numBytesForPacketHeader(_data);
+    _size = packet.size();
+    return true;
+}
+
+bool PacketBuffer::append(const char* data, int size) {
+    if (size > getBytesAvailable()) {
+        return false;
+    }
+    
+    memcpy(_data + _size, data, size);
+    _size += size;
+    return true;
+}
+
+void PacketBuffer::writeHash(const QUuid& connectionSecret) {
+    if (numHashBytesInPacketHeaderGivenPacketType(packetTypeForPacket(_data)) == 0) {
+        return;
+    }
+    
+    char secretBytes[NUM_BYTES_RFC4122_UUID];
+    packRfc4122UUID(connectionSecret, secretBytes);
+    
+    // the same hash as hashForPacketAndConnectionUUID, without the copies of the payload it makes
+    _hash.reset();
+    _hash.addData(_data + _numHeaderBytes, _size - _numHeaderBytes);
+    _hash.addData(secretBytes, NUM_BYTES_RFC4122_UUID);
+    
+    memcpy(_data + _numHeaderBytes - NUM_BYTES_MD5_HASH, _hash.result().constData(), NUM_BYTES_MD5_HASH);
+}
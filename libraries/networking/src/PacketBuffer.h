@@ -0,0 +1,59 @@
+//
+//  PacketBuffer.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketBuffer_h
+#define hifi_PacketBuffer_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QUuid>
+
+#include "LimitedNodeList.h"
+#include "PacketHeaders.h"
+
+/// A packet of up to MAX_PACKET_SIZE bytes in a buffer that is never reallocated, for the send paths that build a
+/// packet per listener every frame. Buffers come from a PacketBufferPool with their header already written and go to
+/// LimitedNodeList::writeDatagram, which signs them in place.
+class PacketBuffer {
+public:
+    PacketBuffer();
+    
+    /// leaves the buffer holding only a header for type from senderUUID, which is only rewritten if it differs
+    void reset(PacketType type, const QUuid& senderUUID);
+    
+    /// replaces the whole buffer with a packet that already has its header
+    /// \return false, leaving the buffer empty, if the packet does not fit
+    bool assign(const QByteArray& packet);
+    
+    /// \return false, leaving the buffer as it was, if the data does not fit
+    bool append(const char* data, int size);
+    bool append(const QByteArray& data) { return append(data.constData(), data.size()); }
+    
+    const char* getData() const { return _data; }
+    int getSize() const { return _size; }
+    int getNumHeaderBytes() const { return _numHeaderBytes; }
+    int getBytesAvailable() const { return MAX_PACKET_SIZE - _size; }
+    PacketType getType() const { return _type; }
+    
+    /// fills in the header's hash of the payload and connectionSecret, for the types that are verified
+    void writeHash(const QUuid& connectionSecret);
+    
+private:
+    // the hash is kept rather than made for every packet, so signing does not allocate one
+    QCryptographicHash _hash;
+    
+    PacketType _type;
+    QUuid _senderUUID;
+    int _numHeaderBytes;
+    int _size;
+    char _data[MAX_PACKET_SIZE];
+};
+
+#endif // hifi_PacketBuffer_h
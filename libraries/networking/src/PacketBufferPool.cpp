@@ -0,0 +1,46 @@
+//
+//  PacketBufferPool.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "PacketBufferPool.h"
+
+PacketBufferPool::PacketBufferPool() :
+    _buffers(),
+    _freeBuffers()
+{
+    
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    for (size_t i = 0; i < _buffers.size(); i++) {
+        delete _buffers[i];
+    }
+}
+
+PacketBuffer* PacketBufferPool::acquire(PacketType type, const QUuid& senderUUID) {
+    PacketBuffer* buffer = NULL;
+    
+    if (_freeBuffers.empty()) {
+        buffer = new PacketBuffer();
+        _buffers.push_back(buffer);
+        
+        // the free list can then always take every buffer back without growing
+        _freeBuffers.reserve(_buffers.capacity());
+    } else {
+        buffer = _freeBuffers.back();
+        _freeBuffers.pop_back();
+    }
+    
+    buffer->reset(type, senderUUID.isNull() ? LimitedNodeList::getInstance()->getSessionUUID() : senderUUID);
+    return buffer;
+}
+
+void PacketBufferPool::release(PacketBuffer* buffer) {
+    _freeBuffers.push_back(buffer);
+}
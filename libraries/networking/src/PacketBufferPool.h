@@ -0,0 +1,41 @@
+//
+//  PacketBufferPool.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketBufferPool_h
+#define hifi_PacketBufferPool_h
+
+#include <vector>
+
+#include "PacketBuffer.h"
+
+/// Hands out PacketBuffers and takes them back to hand out again, so a send path that has been through a busy frame
+/// builds its packets without allocating. A pool is not locked, each thread building packets keeps its own.
+class PacketBufferPool {
+public:
+    PacketBufferPool();
+    ~PacketBufferPool();
+    
+    /// \return a buffer holding only a header for type, from senderUUID or this node's session if that is null
+    PacketBuffer* acquire(PacketType type, const QUuid& senderUUID = nullUUID);
+    
+    /// takes back a buffer acquired from this pool, once nothing reads it any more
+    void release(PacketBuffer* buffer);
+    
+    /// \return every buffer this pool has made, handed out or not
+    int getNumBuffers() const { return _buffers.size(); }
+    
+private:
+    std::vector<PacketBuffer*> _buffers;
+    
+    // the buffer released last is handed out first, so it is likely to have the header asked for already
+    std::vector<PacketBuffer*> _freeBuffers;
+};
+
+#endif // hifi_PacketBufferPool_h
@@ -48,7 +48,14 @@ int packArithmeticallyCodedValue(int value, char* destination) {
 PacketVersion versionForPacketType(PacketType type) {
     switch (type) {
         case PacketTypeAvatarData:
-            return 3;
+            return 4;
+        case PacketTypeBulkAvatarData:
+            return 2;
+        case PacketTypeMicrophoneAudioNoEcho:
+        case PacketTypeMicrophoneAudioWithEcho:
+        case PacketTypeSilentAudioFrame:
+        case PacketTypeMixedAudio:
+            return 1;
         case PacketTypeEnvironmentData:
             return 1;
         case PacketTypeParticleData:
@@ -89,8 +96,7 @@ int populatePacketHeader(char* packet, PacketType type, const QUuid& connectionU
     
     QUuid packUUID = connectionUUID.isNull() ? LimitedNodeList::getInstance()->getSessionUUID() : connectionUUID;
     
-    QByteArray rfcUUID = packUUID.toRfc4122();
-    memcpy(position, rfcUUID.constData(), NUM_BYTES_RFC4122_UUID);
+    packRfc4122UUID(packUUID, position);
     position += NUM_BYTES_RFC4122_UUID;
     
     if (!NON_VERIFIED_PACKETS.contains(type)) {
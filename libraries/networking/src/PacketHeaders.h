@@ -61,6 +61,8 @@ enum PacketType {
     PacketTypeDomainConnectRequest,
     PacketTypeDomainServerRequireDTLS,
     PacketTypeNodeJsonStats,
+    PacketTypeAvatarQuery,
+    PacketTypeBulkAvatarDataAck,
 };
 
 typedef char PacketVersion;
@@ -9,6 +9,8 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+
 #include "SharedUtil.h"
 
 #include "AABox.h"
@@ -205,6 +207,34 @@ bool AABox::findRayIntersection(const glm::vec3& origin, const glm::vec3& direct
     return false;
 }
 
+bool AABox::findRayEntry(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                         float& distance, BoxFace& face) const {
+    float entryDistance = -FLT_MAX;
+    float exitDistance = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+        // an axis the ray is parallel to gives infinities, or NaNs when the origin is on one of its planes, and the
+        // comparisons below are written so that NaNs drop out and such an axis doesn't limit the ray
+        float nearDistance = (_corner[axis] - origin[axis]) * inverseDirection[axis];
+        float farDistance = (_corner[axis] + _scale - origin[axis]) * inverseDirection[axis];
+        bool negative = inverseDirection[axis] < 0.0f;
+        if (negative) {
+            std::swap(nearDistance, farDistance);
+        }
+        if (nearDistance > entryDistance) {
+            entryDistance = nearDistance;
+            face = (BoxFace)(axis * 2 + (negative ? 1 : 0));
+        }
+        if (farDistance < exitDistance) {
+            exitDistance = farDistance;
+        }
+    }
+    if (exitDistance < entryDistance || exitDistance < 0.0f) {
+        return false;
+    }
+    distance = glm::max(entryDistance, 0.0f);
+    return true;
+}
+
 bool AABox::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration) const {
     glm::vec4 center4 = glm::vec4(center, 1.0f);
     
@@ -69,6 +69,10 @@ public:
     bool expandedContains(const glm::vec3& point, float expansion) const;
     bool expandedIntersectsSegment(const glm::vec3& start, const glm::vec3& end, float expansion) const;
     bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction, float& distance, BoxFace& face) const;
+
+    /// slab test for callers casting one ray against many boxes, which work out the ray's inverse direction once
+    /// distance is zero when the box contains the origin, and face is the face the ray enters through either way
+    bool findRayEntry(const glm::vec3& origin, const glm::vec3& inverseDirection, float& distance, BoxFace& face) const;
     bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration) const;
     bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration) const;
 
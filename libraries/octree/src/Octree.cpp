@@ -17,6 +17,7 @@
 #include <cstdio>
 #include <cmath>
 #include <fstream> // to load voxels from file
+#include <vector>
 
 #include <QDebug>
 
@@ -33,6 +34,8 @@
 #include "OctreeConstants.h"
 #include "OctreeElementBag.h"
 #include "Octree.h"
+#include "OctreeRayPacket.h"
+#include "OctreeRayVisitor.h"
 #include "ViewFrustum.h"
 
 float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeScale) {
@@ -40,6 +43,7 @@ float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeSc
 }
 
 Octree::Octree(bool shouldReaverage) :
+    _allocator(),
     _rootNode(NULL),
     _isDirty(true),
     _shouldReaverage(shouldReaverage),
@@ -157,27 +161,29 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorNode,
         return _rootNode;
     }
 
-    // find the appropriate branch index based on this ancestorNode
-    if (*needleCode > 0) {
-        int branchForNeedle = branchIndexWithDescendant(ancestorNode->getOctalCode(), needleCode);
-        OctreeElement* childNode = ancestorNode->getChildAtIndex(branchForNeedle);
-
-        if (childNode) {
-            if (*childNode->getOctalCode() == *needleCode) {
+    // the needle is parsed once, from there on each step down is a shift and a mask unless it is too deep for a key
+    OctreeKey needleKey = OctreeKey::fromOctalCode(needleCode);
+    int needleLevel = numberOfThreeBitSectionsInCode(needleCode) + 1;
 
-                // If the caller asked for the parent, then give them that too...
-                if (parentOfFoundNode) {
-                    *parentOfFoundNode = ancestorNode;
-                }
-                // the fact that the number of sections is equivalent does not always guarantee
-                // that this is the same node, however due to the recursive traversal
-                // we know that this is our node
-                return childNode;
-            } else {
-                // we need to go deeper
-                return nodeForOctalCode(childNode, needleCode, parentOfFoundNode);
+    while (ancestorNode->getLevel() < needleLevel) {
+        // find the appropriate branch index based on this ancestorNode
+        int branchForNeedle = ancestorNode->branchIndexToward(needleKey, needleCode);
+        OctreeElement* childNode = ancestorNode->getChildAtIndex(branchForNeedle);
+        if (!childNode) {
+            break;
+        }
+        if (childNode->getLevel() == needleLevel) {
+            // If the caller asked for the parent, then give them that too...
+            if (parentOfFoundNode) {
+                *parentOfFoundNode = ancestorNode;
             }
+            // the fact that the level is equivalent does not always guarantee
+            // that this is the same node, however due to the traversal
+            // we know that this is our node
+            return childNode;
         }
+        // we need to go deeper
+        ancestorNode = childNode;
     }
 
     // we've been given a code we don't have a node for
@@ -187,21 +193,27 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorNode,
 
 // returns the node created!
 OctreeElement* Octree::createMissingNode(OctreeElement* lastParentNode, const unsigned char* codeToReach) {
-    int indexOfNewChild = branchIndexWithDescendant(lastParentNode->getOctalCode(), codeToReach);
-    // If this parent node is a leaf, then you know the child path doesn't exist, so deal with
-    // breaking up the leaf first, which will also create a child path
-    if (lastParentNode->requiresSplit()) {
-        lastParentNode->splitChildren();
-    } else if (!lastParentNode->getChildAtIndex(indexOfNewChild)) {
-        // we could be coming down a branch that was already created, so don't stomp on it.
-        lastParentNode->addChildAtIndex(indexOfNewChild);
-    }
-
-    // This works because we know we traversed down the same tree so if the length is the same, then the whole code is the same
-    if (*lastParentNode->getChildAtIndex(indexOfNewChild)->getOctalCode() == *codeToReach) {
-        return lastParentNode->getChildAtIndex(indexOfNewChild);
-    } else {
-        return createMissingNode(lastParentNode->getChildAtIndex(indexOfNewChild), codeToReach);
+    OctreeKey keyToReach = OctreeKey::fromOctalCode(codeToReach);
+    int levelToReach = numberOfThreeBitSectionsInCode(codeToReach) + 1;
+
+    while (true) {
+        int indexOfNewChild = lastParentNode->branchIndexToward(keyToReach, codeToReach);
+        // If this parent node is a leaf, then you know the child path doesn't exist, so deal with
+        // breaking up the leaf first, which will also create a child path
+        if (lastParentNode->requiresSplit()) {
+            lastParentNode->splitChildren();
+        } else if (!lastParentNode->getChildAtIndex(indexOfNewChild)) {
+            // we could be coming down a branch that was already created, so don't stomp on it.
+            lastParentNode->addChildAtIndex(indexOfNewChild);
+        }
+
+        // This works because we know we traversed down the same tree so if the level is the same, then the whole code
+        // is the same
+        OctreeElement* newChild = lastParentNode->getChildAtIndex(indexOfNewChild);
+        if (newChild->getLevel() == levelToReach) {
+            return newChild;
+        }
+        lastParentNode = newChild;
     }
 }
 
@@ -300,7 +312,7 @@ void Octree::readBitstreamToTree(const unsigned char * bitstream, unsigned long
 
     while (bitstreamAt < bitstream + bufferSizeBytes) {
         OctreeElement* bitstreamRootNode = nodeForOctalCode(args.destinationNode, (unsigned char *)bitstreamAt, NULL);
-        if (*bitstreamAt != *bitstreamRootNode->getOctalCode()) {
+        if (bitstreamRootNode->getLevel() != numberOfThreeBitSectionsInCode(bitstreamAt) + 1) {
             // if the octal code returned is not on the same level as
             // the code being searched for, we have OctreeElements to create
 
@@ -341,6 +353,7 @@ class DeleteOctalCodeFromTreeArgs {
 public:
     bool collapseEmptyTrees;
     const unsigned char* codeBuffer;
+    OctreeKey key;
     int lengthOfCode;
     bool deleteLastChild;
     bool pathChanged;
@@ -354,6 +367,7 @@ void Octree::deleteOctalCodeFromTree(const unsigned char* codeBuffer, bool colla
     DeleteOctalCodeFromTreeArgs args;
     args.collapseEmptyTrees = collapseEmptyTrees;
     args.codeBuffer         = codeBuffer;
+    args.key                = OctreeKey::fromOctalCode(codeBuffer);
     args.lengthOfCode       = numberOfThreeBitSectionsInCode(codeBuffer);
     args.deleteLastChild    = false;
     args.pathChanged        = false;
@@ -366,7 +380,7 @@ void Octree::deleteOctalCodeFromTree(const unsigned char* codeBuffer, bool colla
 void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraData) {
     DeleteOctalCodeFromTreeArgs* args = (DeleteOctalCodeFromTreeArgs*)extraData;
 
-    int lengthOfNodeCode = numberOfThreeBitSectionsInCode(node->getOctalCode());
+    int lengthOfNodeCode = node->getLevel() - 1;
 
     // Since we traverse the tree in code order, we know that if our code
     // matches, then we've reached  our target node.
@@ -379,7 +393,7 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
     }
 
     // Ok, we know we haven't reached our target node yet, so keep looking
-    int childIndex = branchIndexWithDescendant(node->getOctalCode(), args->codeBuffer);
+    int childIndex = node->branchIndexToward(args->key, args->codeBuffer);
     OctreeElement* childNode = node->getChildAtIndex(childIndex);
 
     // If there is no child at the target location, and the current parent node is a colored leaf,
@@ -389,12 +403,12 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
         // we need to break up ancestors until we get to the right level
         OctreeElement* ancestorNode = node;
         while (true) {
-            int index = branchIndexWithDescendant(ancestorNode->getOctalCode(), args->codeBuffer);
+            int index = ancestorNode->branchIndexToward(args->key, args->codeBuffer);
 
             // we end up with all the children, even the one we want to delete
             ancestorNode->splitChildren();
 
-            int lengthOfAncestorNode = numberOfThreeBitSectionsInCode(ancestorNode->getOctalCode());
+            int lengthOfAncestorNode = ancestorNode->getLevel() - 1;
 
             // If we've reached the parent of the target, then stop breaking up children
             if (lengthOfAncestorNode == (args->lengthOfCode - 1)) {
@@ -454,6 +468,10 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* node, void* extraDa
 
 void Octree::eraseAllOctreeElements() {
     delete _rootNode; // this will recurse and delete all children
+    _rootNode = NULL; // so createNewElement doesn't look at the root we just deleted
+
+    // every element is gone, so the slabs can go back in one piece rather than sitting on the free lists
+    _allocator.releaseAll();
     _rootNode = createNewElement();
     _isDirty = true;
 }
@@ -530,7 +548,7 @@ void Octree::reaverageOctreeElements(OctreeElement* startNode) {
 OctreeElement* Octree::getOctreeElementAt(float x, float y, float z, float s) const {
     unsigned char* octalCode = pointToOctalCode(x,y,z,s);
     OctreeElement* node = nodeForOctalCode(_rootNode, octalCode, NULL);
-    if (*node->getOctalCode() != *octalCode) {
+    if (node->getLevel() != numberOfThreeBitSectionsInCode(octalCode) + 1) {
         node = NULL;
     }
     delete[] octalCode; // cleanup memory
@@ -549,40 +567,86 @@ OctreeElement* Octree::getOrCreateChildElementAt(float x, float y, float z, floa
 
 
 // combines the ray cast arguments into a single object
-class RayArgs {
-public:
-    glm::vec3 origin;
-    glm::vec3 direction;
-    OctreeElement*& node;
-    float& distance;
-    BoxFace& face;
-    bool found;
-};
+bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
+                                    OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType) {
+    OctreeRayVisitor visitor(origin / (float)(TREE_SCALE), direction);
 
-bool findRayIntersectionOp(OctreeElement* node, void* extraData) {
-    RayArgs* args = static_cast<RayArgs*>(extraData);
-    AABox box = node->getAABox();
-    float distance;
-    BoxFace face;
-    if (!box.findRayIntersection(args->origin, args->direction, distance, face)) {
-        return false;
+    bool gotLock = false;
+    if (lockType == Octree::Lock) {
+        lockForRead();
+        gotLock = true;
+    } else if (lockType == Octree::TryLock) {
+        gotLock = tryLockForRead();
+        if (!gotLock) {
+            return false; // if we wanted to tryLock, and we couldn't then just bail...
+        }
     }
-    if (!node->isLeaf()) {
-        return true; // recurse on children
+
+    visit(visitor);
+
+    if (gotLock) {
+        unlock();
     }
-    distance *= TREE_SCALE;
-    if (node->hasContent() && (!args->found || distance < args->distance)) {
-        args->node = node;
-        args->distance = distance;
-        args->face = face;
-        args->found = true;
+
+    if (!visitor.isFound()) {
+        return false;
     }
-    return false;
+    node = visitor.getElement();
+    distance = visitor.getDistance();
+    face = visitor.getFace();
+    return true;
 }
 
-bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
-                                    OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType) {
-    RayArgs args = { origin / (float)(TREE_SCALE), direction, node, distance, face };
+class RayPacketVisitor : public OctreeVisitor {
+public:
+    RayPacketVisitor(const OctreeRayPacket& packet, OctreeRayIntersection** rays) :
+        packet(packet),
+        rays(rays),
+        activeLanes((1 << packet.getSize()) - 1) { }
+
+    int getChildOrder() const { return packet.getChildOrder(); }
+
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        // the rays that already hit something are left out, the rest go down together while any of them enter
+        AABox box = element->getAABox();
+        float distances[OCTREE_RAY_PACKET_SIZE];
+        BoxFace faces[OCTREE_RAY_PACKET_SIZE];
+        int hitLanes = packet.findEntries(box, activeLanes, distances, faces);
+        if (!hitLanes) {
+            return OCTREE_SKIP_CHILDREN;
+        }
+        if (!element->isLeaf()) {
+            return OCTREE_VISIT_CHILDREN;
+        }
+        if (!element->hasContent()) {
+            return OCTREE_SKIP_CHILDREN;
+        }
+        // front to back, this is the nearest hit for every ray still looking that enters it
+        for (int lane = 0; lane < packet.getSize(); lane++) {
+            if (hitLanes & (1 << lane)) {
+                OctreeRayIntersection* ray = rays[lane];
+                ray->intersects = true;
+                ray->element = element;
+                ray->distance = distances[lane] * TREE_SCALE;
+                ray->face = faces[lane];
+            }
+        }
+        activeLanes &= ~hitLanes;
+        return activeLanes ? OCTREE_SKIP_CHILDREN : OCTREE_STOP_VISITING;
+    }
+
+    const OctreeRayPacket& packet;
+    OctreeRayIntersection** rays;
+    int activeLanes;
+};
+
+bool Octree::findRayIntersections(OctreeRayIntersection* rays, int numRays, Octree::lockType lockType) {
+    for (int i = 0; i < numRays; i++) {
+        rays[i].intersects = false;
+        rays[i].element = NULL;
+        rays[i].distance = 0.0f;
+        rays[i].face = UNKNOWN_FACE;
+    }
 
     bool gotLock = false;
     if (lockType == Octree::Lock) {
@@ -591,21 +655,75 @@ bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direc
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            return false; // if we wanted to tryLock, and we couldn't then just bail...
         }
     }
 
-    recurseTreeWithOperation(findRayIntersectionOp, &args);
+    std::vector<glm::vec3> inverseDirections(numRays);
+    std::vector<int> octants(numRays);
+    for (int i = 0; i < numRays; i++) {
+        const glm::vec3& direction = rays[i].direction;
+        inverseDirections[i] = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        octants[i] = OctreeRayPacket::octantOf(inverseDirections[i]);
+    }
+
+    // rays go in packets with others heading into the same octant, so that a packet has one front to back order
+    std::vector<int> octantRays;
+    for (int octant = 0; octant < NUMBER_OF_CHILDREN; octant++) {
+        octantRays.clear();
+        for (int i = 0; i < numRays; i++) {
+            if (octants[i] == octant) {
+                octantRays.push_back(i);
+            }
+        }
+        for (size_t first = 0; first < octantRays.size(); first += OCTREE_RAY_PACKET_SIZE) {
+            OctreeRayPacket packet(octant);
+            OctreeRayIntersection* packetRays[OCTREE_RAY_PACKET_SIZE];
+            for (size_t i = first; i < octantRays.size() && !packet.isFull(); i++) {
+                int rayIndex = octantRays[i];
+                int lane = packet.addRay(rays[rayIndex].origin / (float)(TREE_SCALE), inverseDirections[rayIndex]);
+                packetRays[lane] = &rays[rayIndex];
+            }
+            RayPacketVisitor visitor(packet, packetRays);
+            visit(visitor);
+        }
+    }
 
     if (gotLock) {
         unlock();
     }
-
-    return args.found;
+    return true;
 }
 
-class SphereArgs {
+class SpherePenetrationVisitor : public OctreeVisitor {
 public:
+    SpherePenetrationVisitor(const glm::vec3& center, float radius, glm::vec3& penetration) :
+        center(center),
+        radius(radius),
+        penetration(penetration),
+        found(false),
+        penetratedObject(NULL) { }
+
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        // coarse check against bounds
+        if (!element->getAABox().expandedContains(center, radius)) {
+            return OCTREE_SKIP_CHILDREN;
+        }
+        if (!element->isLeaf()) {
+            return OCTREE_VISIT_CHILDREN;
+        }
+        if (element->hasContent()) {
+            glm::vec3 elementPenetration;
+            if (element->findSpherePenetration(center, radius, elementPenetration, &penetratedObject)) {
+                // NOTE: it is possible for this penetration accumulation algorithm to produce a final penetration
+                // vector with zero length.
+                penetration = addPenetrations(penetration, elementPenetration * (float)(TREE_SCALE));
+                found = true;
+            }
+        }
+        return OCTREE_SKIP_CHILDREN;
+    }
+
     glm::vec3 center;
     float radius;
     glm::vec3& penetration;
@@ -613,37 +731,10 @@ public:
     void* penetratedObject; /// the type is defined by the type of Octree, the caller is assumed to know the type
 };
 
-bool findSpherePenetrationOp(OctreeElement* element, void* extraData) {
-    SphereArgs* args = static_cast<SphereArgs*>(extraData);
-
-    // coarse check against bounds
-    const AABox& box = element->getAABox();
-    if (!box.expandedContains(args->center, args->radius)) {
-        return false;
-    }
-    if (!element->isLeaf()) {
-        return true; // recurse on children
-    }
-    if (element->hasContent()) {
-        glm::vec3 elementPenetration;
-        if (element->findSpherePenetration(args->center, args->radius, elementPenetration, &args->penetratedObject)) {
-            // NOTE: it is possible for this penetration accumulation algorithm to produce a final penetration vector with zero length.
-            args->penetration = addPenetrations(args->penetration, elementPenetration * (float)(TREE_SCALE));
-            args->found = true;
-        }
-    }
-    return false;
-}
-
 bool Octree::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
                     void** penetratedObject, Octree::lockType lockType) {
 
-    SphereArgs args = {
-        center / (float)(TREE_SCALE),
-        radius / (float)(TREE_SCALE),
-        penetration,
-        false,
-        NULL };
+    SpherePenetrationVisitor visitor(center / (float)(TREE_SCALE), radius / (float)(TREE_SCALE), penetration);
     penetration = glm::vec3(0.0f, 0.0f, 0.0f);
 
     bool gotLock = false;
@@ -653,20 +744,20 @@ bool Octree::findSpherePenetration(const glm::vec3& center, float radius, glm::v
     } else if (lockType == Octree::TryLock) {
         gotLock = tryLockForRead();
         if (!gotLock) {
-            return args.found; // if we wanted to tryLock, and we couldn't then just bail...
+            return visitor.found; // if we wanted to tryLock, and we couldn't then just bail...
         }
     }
 
-    recurseTreeWithOperation(findSpherePenetrationOp, &args);
+    visit(visitor);
     if (penetratedObject) {
-        *penetratedObject = args.penetratedObject;
+        *penetratedObject = visitor.penetratedObject;
     }
 
     if (gotLock) {
         unlock();
     }
     
-    return args.found;
+    return visitor.found;
 }
 
 class CapsuleArgs {
@@ -853,8 +944,10 @@ int Octree::encodeTreeBitstream(OctreeElement* node,
     // write the octal code
     bool roomForOctalCode = false; // assume the worst
     int codeLength = 1; // assume root
+    unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+    const unsigned char* nodeCode = node->getOctalCode(codeBuffer);
     if (params.chopLevels) {
-        unsigned char* newCode = chopOctalCode(node->getOctalCode(), params.chopLevels);
+        unsigned char* newCode = chopOctalCode(nodeCode, params.chopLevels);
         roomForOctalCode = packetData->startSubTree(newCode);
 
         if (newCode) {
@@ -864,8 +957,8 @@ int Octree::encodeTreeBitstream(OctreeElement* node,
             codeLength = 1;
         }
     } else {
-        roomForOctalCode = packetData->startSubTree(node->getOctalCode());
-        codeLength = bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(node->getOctalCode()));
+        roomForOctalCode = packetData->startSubTree(nodeCode);
+        codeLength = bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(nodeCode));
     }
 
     // If the octalcode couldn't fit, then we can return, because no nodes below us will fit...
@@ -944,10 +1037,12 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
     }
 
     // If we've been provided a jurisdiction map, then we need to honor it.
+    unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+    const unsigned char* nodeCode = params.jurisdictionMap ? node->getOctalCode(codeBuffer) : NULL;
     if (params.jurisdictionMap) {
         // here's how it works... if we're currently above our root jurisdiction, then we proceed normally.
         // but once we're in our own jurisdiction, then we need to make sure we're not below it.
-        if (JurisdictionMap::BELOW == params.jurisdictionMap->isMyJurisdiction(node->getOctalCode(), CHECK_NODE_ONLY)) {
+        if (JurisdictionMap::BELOW == params.jurisdictionMap->isMyJurisdiction(nodeCode, CHECK_NODE_ONLY)) {
             params.stopReason = EncodeBitstreamParams::OUT_OF_JURISDICTION;
             return bytesAtThisLevel;
         }
@@ -1097,7 +1192,7 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* node,
         // even if they don't in our local tree
         bool notMyJurisdiction = false;
         if (params.jurisdictionMap) {
-            notMyJurisdiction = (JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(node->getOctalCode(), i));
+            notMyJurisdiction = (JurisdictionMap::WITHIN != params.jurisdictionMap->isMyJurisdiction(nodeCode, i));
         }
         if (params.includeExistsBits) {
             // If the child is known to exist, OR, it's not my jurisdiction, then we mark the bit as existing
@@ -1616,7 +1711,7 @@ void Octree::copySubTreeIntoNewTree(OctreeElement* startNode, Octree* destinatio
     nodeBag.insert(startNode);
     int chopLevels = 0;
     if (rebaseToRoot) {
-        chopLevels = numberOfThreeBitSectionsInCode(startNode->getOctalCode());
+        chopLevels = startNode->getLevel() - 1;
     }
 
     static OctreePacketData packetData;
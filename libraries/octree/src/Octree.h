@@ -25,6 +25,7 @@ class Shape;
 
 
 #include "JurisdictionMap.h"
+#include "OctreeAllocator.h"
 #include "ViewFrustum.h"
 #include "OctreeElement.h"
 #include "OctreeElementBag.h"
@@ -35,9 +36,54 @@ class Shape;
 
 #include <QObject>
 #include <QReadWriteLock>
+#include <QVarLengthArray>
 
 // Callback function, for recuseTreeWithOperation
 typedef bool (*RecurseOctreeOperation)(OctreeElement* node, void* extraData);
+
+/// What a visitor's preVisit tells Octree::visit to do after looking at an element
+enum OctreeVisitAction {
+    OCTREE_VISIT_CHILDREN, /// go on down into the element's children
+    OCTREE_SKIP_CHILDREN,  /// leave out the element's children, and carry on with the rest of the tree
+    OCTREE_STOP_VISITING   /// end the traversal, no further pre or post visits are made
+};
+
+/// Base for the visitors given to Octree::visit. Visitors are not virtual, their calls are compiled into the traversal
+/// so that they can be inlined. A visitor provides
+///     OctreeVisitAction preVisit(OctreeElement* element);
+/// which is called on the way down, and if it also wants to be called once an element's children are done, it
+/// redeclares WANTS_POST_VISIT as true and provides postVisit. A visitor that wants children in another order than
+/// child index order, front to back along a ray for instance, provides getChildOrder.
+class OctreeVisitor {
+public:
+    enum { WANTS_POST_VISIT = false };
+    void postVisit(OctreeElement* element) { }
+
+    /// \return the bits to flip in the child indices to get the order children are visited in, read once a visit
+    int getChildOrder() const { return 0; }
+};
+
+/// An element on Octree::visit's stack, waiting for its preVisit, or for its postVisit once its children are done
+class OctreeVisitStackEntry {
+public:
+    OctreeElement* element;
+    bool childrenDone;
+};
+
+/// the stack Octree::visit keeps in place before it goes to the heap, enough for eight children a level 32 levels down
+const int OCTREE_VISIT_STACK_RESERVE = 256;
+
+/// One of the rays given to Octree::findRayIntersections, with what it hit once cast
+class OctreeRayIntersection {
+public:
+    glm::vec3 origin; /// in meters, like findRayIntersection's
+    glm::vec3 direction;
+
+    bool intersects;
+    OctreeElement* element;
+    float distance; /// in meters along direction
+    BoxFace face;
+};
 typedef enum {GRADIENT, RANDOM, NATURAL} creationMode;
 
 const bool NO_EXISTS_BITS         = false;
@@ -220,6 +266,12 @@ public:
     void recurseTreeWithOperationDistanceSorted(RecurseOctreeOperation operation,
                                                 const glm::vec3& point, void* extraData = NULL);
 
+    /// Visits start, the root by default, and its descendants in the same depth first, child index order as
+    /// recurseTreeWithOperation unless the visitor gives another child order. The walk is off an explicit stack, with
+    /// the visitor's calls inlined rather than made through a function pointer. A visit may change the visited
+    /// element's children but not its siblings.
+    template<typename Visitor> void visit(Visitor& visitor, OctreeElement* start = NULL);
+
     int encodeTreeBitstream(OctreeElement* node, OctreePacketData* packetData, OctreeElementBag& bag,
                             EncodeBitstreamParams& params) ;
 
@@ -243,6 +295,11 @@ public:
     bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
                              OctreeElement*& node, float& distance, BoxFace& face, Octree::lockType lockType = Octree::TryLock);
 
+    /// Casts a batch of rays under one lock, in packets of rays heading the same way that go down the tree together.
+    /// Each ray gets the same hit it would from findRayIntersection.
+    /// \return false if a TryLock failed, in which case none of the rays intersect
+    bool findRayIntersections(OctreeRayIntersection* rays, int numRays, Octree::lockType lockType = Octree::TryLock);
+
     bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
                                     void** penetratedObject = NULL, Octree::lockType lockType = Octree::TryLock);
 
@@ -305,6 +362,8 @@ protected:
     int readNodeData(OctreeElement *destinationNode, const unsigned char* nodeData,
                 int bufferSizeBytes, ReadBitstreamToTreeParams& args);
 
+    /// the slabs every element of this tree lives in, declared before the root so it outlives it
+    OctreeAllocator _allocator;
     OctreeElement* _rootNode;
 
     bool _isDirty;
@@ -317,6 +376,44 @@ protected:
     bool _isViewing;
 };
 
+template<typename Visitor> inline void Octree::visit(Visitor& visitor, OctreeElement* start) {
+    QVarLengthArray<OctreeVisitStackEntry, OCTREE_VISIT_STACK_RESERVE> stack;
+    OctreeVisitStackEntry startEntry = { start ? start : _rootNode, false };
+    stack.append(startEntry);
+
+    int childOrder = visitor.getChildOrder();
+    OctreeElement* children[NUMBER_OF_CHILDREN];
+    while (!stack.isEmpty()) {
+        OctreeVisitStackEntry entry = stack[stack.size() - 1];
+        stack.resize(stack.size() - 1);
+
+        if (entry.childrenDone) {
+            visitor.postVisit(entry.element);
+            continue;
+        }
+        OctreeVisitAction action = visitor.preVisit(entry.element);
+        if (action == OCTREE_STOP_VISITING) {
+            return;
+        }
+        if (Visitor::WANTS_POST_VISIT) {
+            // goes under the children, so it comes back off once they are all done
+            entry.childrenDone = true;
+            stack.append(entry);
+        }
+        if (action == OCTREE_VISIT_CHILDREN) {
+            // pushed last to first, so they come back off in the visitor's order
+            entry.element->getChildren(children);
+            for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+                OctreeElement* child = children[i ^ childOrder];
+                if (child) {
+                    OctreeVisitStackEntry childEntry = { child, false };
+                    stack.append(childEntry);
+                }
+            }
+        }
+    }
+}
+
 float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeScale);
 
 #endif // hifi_Octree_h
@@ -0,0 +1,135 @@
+//
+//  OctreeAllocator.cpp
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+#include "OctreeAllocator.h"
+
+QAtomicInt OctreeAllocator::_totalNumSlabs(0);
+
+static void* allocateAlignedSlab() {
+#ifdef _WIN32
+    return _aligned_malloc(OCTREE_SLAB_SIZE, OCTREE_SLAB_SIZE);
+#else
+    void* slab = NULL;
+    return (posix_memalign(&slab, OCTREE_SLAB_SIZE, OCTREE_SLAB_SIZE) == 0) ? slab : NULL;
+#endif
+}
+
+static void freeAlignedSlab(void* slab) {
+#ifdef _WIN32
+    _aligned_free(slab);
+#else
+    free(slab);
+#endif
+}
+
+static int sizeClassFor(int size) {
+    return (size - 1) / OCTREE_ALLOCATION_GRANULARITY;
+}
+
+OctreeAllocator::OctreeAllocator() :
+    _slabs(NULL),
+    _numSlabs(0),
+    _usedBytes(0)
+{
+    memset(_nextUncarvedBlocks, 0, sizeof(_nextUncarvedBlocks));
+    memset(_uncarvedEnds, 0, sizeof(_uncarvedEnds));
+    memset(_freeBlocks, 0, sizeof(_freeBlocks));
+}
+
+OctreeAllocator::~OctreeAllocator() {
+    releaseAll();
+}
+
+void* OctreeAllocator::allocate(int size) {
+    assert(size > 0 && size <= MAX_OCTREE_ALLOCATION_SIZE);
+    int sizeClass = sizeClassFor(size);
+    int blockSize = (sizeClass + 1) * OCTREE_ALLOCATION_GRANULARITY;
+
+    // recently freed blocks first, they are the likeliest to still be in the cache
+    void* block = _freeBlocks[sizeClass];
+    if (block) {
+        _freeBlocks[sizeClass] = *reinterpret_cast<void**>(block);
+        _usedBytes += blockSize;
+        return block;
+    }
+
+    if (_uncarvedEnds[sizeClass] - _nextUncarvedBlocks[sizeClass] < blockSize) {
+        SlabHeader* slab = static_cast<SlabHeader*>(allocateAlignedSlab());
+        if (!slab) {
+            return NULL;
+        }
+        slab->allocator = this;
+        slab->blockSize = blockSize;
+        slab->nextSlab = _slabs;
+        _slabs = slab;
+        _numSlabs++;
+        _totalNumSlabs.fetchAndAddRelaxed(1);
+
+        // the header takes up the first blocks' worth of the slab so that every block stays aligned
+        const int HEADER_BYTES = ((sizeof(SlabHeader) + OCTREE_ALLOCATION_GRANULARITY - 1)
+            / OCTREE_ALLOCATION_GRANULARITY) * OCTREE_ALLOCATION_GRANULARITY;
+        _nextUncarvedBlocks[sizeClass] = reinterpret_cast<char*>(slab) + HEADER_BYTES;
+        _uncarvedEnds[sizeClass] = reinterpret_cast<char*>(slab) + OCTREE_SLAB_SIZE;
+    }
+
+    block = _nextUncarvedBlocks[sizeClass];
+    _nextUncarvedBlocks[sizeClass] += blockSize;
+    _usedBytes += blockSize;
+    return block;
+}
+
+void OctreeAllocator::deallocate(void* block) {
+    if (!block) {
+        return;
+    }
+    SlabHeader* slab = slabFor(block);
+    OctreeAllocator* allocator = slab->allocator;
+    int sizeClass = sizeClassFor(slab->blockSize);
+
+    *reinterpret_cast<void**>(block) = allocator->_freeBlocks[sizeClass];
+    allocator->_freeBlocks[sizeClass] = block;
+    allocator->_usedBytes -= slab->blockSize;
+}
+
+OctreeAllocator* OctreeAllocator::allocatorFor(const void* block) {
+    return slabFor(block)->allocator;
+}
+
+int OctreeAllocator::blockSizeFor(const void* block) {
+    return slabFor(block)->blockSize;
+}
+
+void OctreeAllocator::releaseAll() {
+    while (_slabs) {
+        SlabHeader* nextSlab = _slabs->nextSlab;
+        freeAlignedSlab(_slabs);
+        _slabs = nextSlab;
+    }
+    _totalNumSlabs.fetchAndAddRelaxed(-_numSlabs);
+    _numSlabs = 0;
+    _usedBytes = 0;
+
+    memset(_nextUncarvedBlocks, 0, sizeof(_nextUncarvedBlocks));
+    memset(_uncarvedEnds, 0, sizeof(_uncarvedEnds));
+    memset(_freeBlocks, 0, sizeof(_freeBlocks));
+}
+
+OctreeAllocator::SlabHeader* OctreeAllocator::slabFor(const void* block) {
+    return reinterpret_cast<SlabHeader*>(reinterpret_cast<quintptr>(block) & ~(quintptr) (OCTREE_SLAB_SIZE - 1));
+}
@@ -0,0 +1,85 @@
+//
+//  OctreeAllocator.h
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeAllocator_h
+#define hifi_OctreeAllocator_h
+
+#include <QAtomicInt>
+#include <QtGlobal>
+
+/// block sizes are rounded up to a multiple of this, which is also the alignment of every block
+const int OCTREE_ALLOCATION_GRANULARITY = 16;
+const int MAX_OCTREE_ALLOCATION_SIZE = 512;
+const int NUM_OCTREE_SIZE_CLASSES = MAX_OCTREE_ALLOCATION_SIZE / OCTREE_ALLOCATION_GRANULARITY;
+
+/// slabs are aligned to their own size, so the slab a block lives in is found by masking the block's address
+const int OCTREE_SLAB_SIZE = 65536;
+
+/// Hands out the memory for one tree's elements, external child arrays and long octal codes. Each size class carves
+/// its blocks out of its own slabs, and freed blocks go on the class's free list for the next allocation. Slabs are
+/// only given back all at once, by releaseAll() or the destructor. The allocator and size of a block are found from
+/// its address alone, so elements don't carry a pointer to their allocator. Not locked, the tree's lock covers it,
+/// except for the count of slabs held across all allocators, which trees on other threads update too.
+class OctreeAllocator {
+public:
+    OctreeAllocator();
+    ~OctreeAllocator();
+
+    /// \return a block of at least size bytes, or NULL if a new slab could not be had
+    /// size must be no larger than MAX_OCTREE_ALLOCATION_SIZE
+    void* allocate(int size);
+
+    /// puts block back on the free list of the allocator it came from
+    static void deallocate(void* block);
+
+    /// \return the allocator block came from
+    static OctreeAllocator* allocatorFor(const void* block);
+
+    /// \return the number of bytes block occupies in its slab
+    static int blockSizeFor(const void* block);
+
+    /// gives every slab back to the system, any block still handed out is invalid afterwards
+    void releaseAll();
+
+    /// \return the bytes of slab this allocator holds, used or not
+    quint64 getSlabBytes() const { return _numSlabs * (quint64) OCTREE_SLAB_SIZE; }
+
+    /// \return the bytes of slab currently handed out as blocks
+    quint64 getUsedBytes() const { return _usedBytes; }
+
+    /// \return the bytes of slab held by all allocators
+    static quint64 getTotalSlabBytes() { return _totalNumSlabs.load() * (quint64) OCTREE_SLAB_SIZE; }
+
+private:
+    struct SlabHeader {
+        OctreeAllocator* allocator;
+        int blockSize;
+        SlabHeader* nextSlab;
+    };
+
+    // disallow copying, the slabs belong to exactly one allocator
+    OctreeAllocator(const OctreeAllocator&);
+    OctreeAllocator& operator=(const OctreeAllocator&);
+
+    static SlabHeader* slabFor(const void* block);
+
+    SlabHeader* _slabs;
+    int _numSlabs;
+    quint64 _usedBytes;
+
+    // per size class, the uncarved part of the class's newest slab and the head of its free list
+    char* _nextUncarvedBlocks[NUM_OCTREE_SIZE_CLASSES];
+    char* _uncarvedEnds[NUM_OCTREE_SIZE_CLASSES];
+    void* _freeBlocks[NUM_OCTREE_SIZE_CLASSES];
+
+    static QAtomicInt _totalNumSlabs;
+};
+
+#endif // hifi_OctreeAllocator_h
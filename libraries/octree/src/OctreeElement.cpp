@@ -11,6 +11,7 @@
 
 #include <cmath>
 #include <cstring>
+#include <new>
 #include <stdio.h>
 
 #include <QtCore/QDebug>
@@ -21,6 +22,7 @@
 
 #include "AABox.h"
 #include "OctalCode.h"
+#include "OctreeAllocator.h"
 #include "OctreeConstants.h"
 #include "OctreeElement.h"
 #include "Octree.h"
@@ -37,6 +39,30 @@ void OctreeElement::resetPopulationStatistics() {
     _voxelNodeLeafCount = 0;
 }
 
+void* OctreeElement::operator new(size_t size, OctreeAllocator& allocator) {
+    void* element = allocator.allocate(size);
+    if (!element) {
+        throw std::bad_alloc();
+    }
+    _voxelMemoryUsage += OctreeAllocator::blockSizeFor(element);
+    return element;
+}
+
+void OctreeElement::operator delete(void* element, OctreeAllocator&) {
+    OctreeElement::operator delete(element);
+}
+
+void OctreeElement::operator delete(void* element) {
+    if (element) {
+        _voxelMemoryUsage -= OctreeAllocator::blockSizeFor(element);
+        OctreeAllocator::deallocate(element);
+    }
+}
+
+OctreeAllocator& OctreeElement::getAllocator() const {
+    return *OctreeAllocator::allocatorFor(this);
+}
+
 OctreeElement::OctreeElement() {
     // Note: you must call init() from your subclass, otherwise the OctreeElement will not be properly
     // initialized. You will see DEADBEEF in your memory debugger if you have not properly called init()
@@ -52,16 +78,19 @@ void OctreeElement::init(unsigned char * octalCode) {
     _voxelNodeLeafCount++; // all nodes start as leaf nodes
 
 
-    size_t octalCodeLength = bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode));
-    if (octalCodeLength > sizeof(_octalCode)) {
-        _octalCode.pointer = octalCode;
-        _octcodePointer = true;
-        _octcodeMemoryUsage += octalCodeLength;
-    } else {
+    OctreeKey key = OctreeKey::fromOctalCode(octalCode);
+    if (key.isValid()) {
         _octcodePointer = false;
-        memcpy(_octalCode.buffer, octalCode, octalCodeLength);
-        delete[] octalCode;
+        _address.key = key.getBits();
+    } else {
+        // codes too deep for a key are copied into the tree's slabs, next to the elements that use them
+        size_t octalCodeLength = bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode));
+        _address.octalCode = static_cast<unsigned char*>(getAllocator().allocate(octalCodeLength));
+        memcpy(_address.octalCode, octalCode, octalCodeLength);
+        _octcodePointer = true;
+        _octcodeMemoryUsage += OctreeAllocator::blockSizeFor(_address.octalCode);
     }
+    delete[] octalCode;
 
     // set up the _children union
     _childBitmask = 0;
@@ -93,7 +122,6 @@ void OctreeElement::init(unsigned char * octalCode) {
     _isDirty = true;
     _shouldRender = false;
     _sourceUUIDKey = 0;
-    calculateAABox();
     markWithChangedTime();
 }
 
@@ -105,8 +133,8 @@ OctreeElement::~OctreeElement() {
     }
 
     if (_octcodePointer) {
-        _octcodeMemoryUsage -= bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(getOctalCode()));
-        delete[] _octalCode.pointer;
+        _octcodeMemoryUsage -= OctreeAllocator::blockSizeFor(_address.octalCode);
+        OctreeAllocator::deallocate(_address.octalCode);
     }
 
     // delete all of this node's children, this also takes care of all population tracking data
@@ -190,15 +218,37 @@ void OctreeElement::setShouldRender(bool shouldRender) {
     }
 }
 
-void OctreeElement::calculateAABox() {
-    glm::vec3 corner;
+const unsigned char* OctreeElement::getOctalCode(unsigned char* codeBuffer) const {
+    if (_octcodePointer) {
+        return _address.octalCode;
+    }
+    OctreeKey(_address.key).writeOctalCode(codeBuffer);
+    return codeBuffer;
+}
+
+int OctreeElement::branchIndexToward(const OctreeKey& descendantKey, const unsigned char* descendantCode) const {
+    // a descendant with a key means we have one too
+    if (descendantKey.isValid()) {
+        return OctreeKey(_address.key).branchIndexToward(descendantKey);
+    }
+    unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+    return branchIndexWithDescendant(getOctalCode(codeBuffer), descendantCode);
+}
 
-    // copy corner into box
-    copyFirstVertexForCode(getOctalCode(),(float*)&corner);
+glm::vec3 OctreeElement::getCorner() const {
+    if (_octcodePointer) {
+        glm::vec3 corner;
+        copyFirstVertexForCode(_address.octalCode, (float*)&corner);
+        return corner;
+    }
+    return OctreeKey(_address.key).getCorner();
+}
 
-    // this tells you the "size" of the voxel
-    float voxelScale = 1 / powf(2, numberOfThreeBitSectionsInCode(getOctalCode()));
-    _box.setBox(corner,voxelScale);
+float OctreeElement::getScale() const {
+    if (_octcodePointer) {
+        return 1 / powf(2, numberOfThreeBitSectionsInCode(_address.octalCode));
+    }
+    return OctreeKey(_address.key).getScale();
 }
 
 void OctreeElement::deleteChildAtIndex(int childIndex) {
@@ -647,6 +697,16 @@ void OctreeElement::deleteAllChildren() {
         }
     }
 
+#ifdef SIMPLE_EXTERNAL_CHILDREN
+    // ...then the array that held them, if there was more than one
+    if (getChildCount() > 1) {
+        _externalChildrenMemoryUsage -= OctreeAllocator::blockSizeFor(_children.external);
+        OctreeAllocator::deallocate(_children.external);
+    }
+    _childBitmask = 0;
+    _children.single = NULL;
+#endif // def SIMPLE_EXTERNAL_CHILDREN
+
 #ifdef BLENDED_UNION_CHILDREN
     // now, reset our internal state and ANY and all population data
     int childCount = getChildCount();
@@ -739,19 +799,20 @@ void OctreeElement::setChildAtIndex(int childIndex, OctreeElement* child) {
         _children.single = child;
     } else if (previousChildCount == 1 && newChildCount == 2) {
         OctreeElement* previousChild = _children.single;
-        _children.external = new OctreeElement*[NUMBER_OF_CHILDREN];
+        _children.external = static_cast<OctreeElement**>(
+            getAllocator().allocate(NUMBER_OF_CHILDREN * sizeof(OctreeElement*)));
         memset(_children.external, 0, sizeof(OctreeElement*) * NUMBER_OF_CHILDREN);
         _children.external[firstIndex] = previousChild;
         _children.external[childIndex] = child;
 
-        _externalChildrenMemoryUsage += NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+        _externalChildrenMemoryUsage += OctreeAllocator::blockSizeFor(_children.external);
 
     } else if (previousChildCount == 2 && newChildCount == 1) {
         assert(!child); // we are removing a child, so this must be true!
         OctreeElement* previousFirstChild = _children.external[firstIndex];
         OctreeElement* previousSecondChild = _children.external[secondIndex];
-        delete[] _children.external;
-        _externalChildrenMemoryUsage -= NUMBER_OF_CHILDREN * sizeof(OctreeElement*);
+        _externalChildrenMemoryUsage -= OctreeAllocator::blockSizeFor(_children.external);
+        OctreeAllocator::deallocate(_children.external);
         if (childIndex == firstIndex) {
             _children.single = previousSecondChild;
         } else {
@@ -1120,7 +1181,8 @@ OctreeElement* OctreeElement::addChildAtIndex(int childIndex) {
             _voxelNodeLeafCount--;
         }
 
-        unsigned char* newChildCode = childOctalCode(getOctalCode(), childIndex);
+        unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+        unsigned char* newChildCode = childOctalCode(getOctalCode(codeBuffer), childIndex);
         childAt = createNewElement(newChildCode);
         setChildAtIndex(childIndex, childAt);
 
@@ -1176,15 +1238,17 @@ void OctreeElement::printDebugDetails(const char* label) const {
     
     QDebug elementDebug = qDebug().nospace();
 
+    glm::vec3 corner = getCorner();
     QString resultString;
     resultString.sprintf("%s - Voxel at corner=(%f,%f,%f) size=%f\n isLeaf=%s isDirty=%s shouldRender=%s\n children=", label,
-                         _box.getCorner().x, _box.getCorner().y, _box.getCorner().z, _box.getScale(),
+                         corner.x, corner.y, corner.z, getScale(),
                          debug::valueOf(isLeaf()), debug::valueOf(isDirty()), debug::valueOf(getShouldRender()));
     elementDebug << resultString;
 
     outputBits(childBits, &elementDebug);
     qDebug("octalCode=");
-    printOctalCode(getOctalCode());
+    unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+    printOctalCode(getOctalCode(codeBuffer));
 }
 
 float OctreeElement::getEnclosingRadius() const {
@@ -1192,7 +1256,7 @@ float OctreeElement::getEnclosingRadius() const {
 }
 
 ViewFrustum::location OctreeElement::inFrustum(const ViewFrustum& viewFrustum) const {
-    AABox box = _box; // use temporary box so we can scale it
+    AABox box = getAABox(); // use temporary box so we can scale it
     box.scale(TREE_SCALE);
     return viewFrustum.boxInFrustum(box);
 }
@@ -1234,20 +1298,20 @@ float OctreeElement::furthestDistanceToCamera(const ViewFrustum& viewFrustum) co
 }
 
 float OctreeElement::distanceToCamera(const ViewFrustum& viewFrustum) const {
-    glm::vec3 center = _box.calcCenter() * (float)TREE_SCALE;
+    glm::vec3 center = getAABox().calcCenter() * (float)TREE_SCALE;
     glm::vec3 temp = viewFrustum.getPosition() - center;
     float distanceToVoxelCenter = sqrtf(glm::dot(temp, temp));
     return distanceToVoxelCenter;
 }
 
 float OctreeElement::distanceSquareToPoint(const glm::vec3& point) const {
-    glm::vec3 temp = point - _box.calcCenter();
+    glm::vec3 temp = point - getAABox().calcCenter();
     float distanceSquare = glm::dot(temp, temp);
     return distanceSquare;
 }
 
 float OctreeElement::distanceToPoint(const glm::vec3& point) const {
-    glm::vec3 temp = point - _box.calcCenter();
+    glm::vec3 temp = point - getAABox().calcCenter();
     float distance = sqrtf(glm::dot(temp, temp));
     return distance;
 }
@@ -1303,7 +1367,7 @@ void OctreeElement::notifyUpdateHooks() {
 
 bool OctreeElement::findSpherePenetration(const glm::vec3& center, float radius,
                         glm::vec3& penetration, void** penetratedObject) const {
-    return _box.findSpherePenetration(center, radius, penetration);
+    return getAABox().findSpherePenetration(center, radius, penetration);
 }
 
 
@@ -1322,7 +1386,7 @@ OctreeElement* OctreeElement::getOrCreateChildElementAt(float x, float y, float
         return this;
     }
     // otherwise, we need to find which of our children we should recurse
-    glm::vec3 ourCenter = _box.calcCenter();
+    glm::vec3 ourCenter = getAABox().calcCenter();
 
     int childIndex = CHILD_UNKNOWN;
     // left half
@@ -16,8 +16,11 @@
 //#define SIMPLE_CHILD_ARRAY
 #define SIMPLE_EXTERNAL_CHILDREN
 
+#include <cstring>
+
 #include <QReadWriteLock>
 
+#include <OctreeKey.h>
 #include <SharedUtil.h>
 
 #include "AABox.h"
@@ -26,6 +29,7 @@
 //#include "Octree.h"
 
 class Octree;
+class OctreeAllocator;
 class OctreeElement;
 class OctreeElementDeleteHook;
 class OctreePacketData;
@@ -57,6 +61,11 @@ public:
     virtual void init(unsigned char * octalCode); /// Your subclass must call init on construction.
     virtual ~OctreeElement();
 
+    /// Elements live in their tree's slabs, create them with new (allocator) YourElement(octalCode).
+    static void* operator new(size_t size, OctreeAllocator& allocator);
+    static void operator delete(void* element, OctreeAllocator& allocator);
+    static void operator delete(void* element);
+
     // methods you can and should override to implement your tree functionality
     
     /// Adds a child to the current element. Override this if there is additional child initialization your class needs.
@@ -101,8 +110,22 @@ public:
                         glm::vec3& penetration, void** penetratedObject) const;
 
     // Base class methods you don't need to implement
-    const unsigned char* getOctalCode() const { return (_octcodePointer) ? _octalCode.pointer : &_octalCode.buffer[0]; }
+    /// \return the element's octal code, written out to codeBuffer unless the element is too deep for a key
+    /// codeBuffer needs MAX_OCTREE_KEY_CODE_BYTES
+    const unsigned char* getOctalCode(unsigned char* codeBuffer) const;
+
+    /// \return the element's key, which is invalid if the element is deeper than MAX_OCTREE_KEY_LEVELS
+    OctreeKey getKey() const { return OctreeKey(_octcodePointer ? 0 : _address.key); }
+
+    /// \return the index of the child on the way down to a deeper element, given as its octal code and that code's key
+    int branchIndexToward(const OctreeKey& descendantKey, const unsigned char* descendantCode) const;
+
     OctreeElement* getChildAtIndex(int childIndex) const;
+
+    /// writes the element's children to children by child index, NULL where there is none, inline so that traversals
+    /// can walk the tree without a getChildAtIndex call per index
+    void getChildren(OctreeElement* children[NUMBER_OF_CHILDREN]) const;
+
     void deleteChildAtIndex(int childIndex);
     OctreeElement* removeChildAtIndex(int childIndex);
 
@@ -110,10 +133,12 @@ public:
     bool safeDeepDeleteChildAtIndex(int childIndex, int recursionCount = 0); 
 
 
-    const AABox& getAABox() const { return _box; }
-    const glm::vec3& getCorner() const { return _box.getCorner(); }
-    float getScale() const { return _box.getScale(); }
-    int getLevel() const { return numberOfThreeBitSectionsInCode(getOctalCode()) + 1; }
+    AABox getAABox() const { return AABox(getCorner(), getScale()); }
+    glm::vec3 getCorner() const;
+    float getScale() const;
+    int getLevel() const {
+        return (_octcodePointer ? numberOfThreeBitSectionsInCode(_address.octalCode) : getKey().getLevel()) + 1;
+    }
     
     float getEnclosingRadius() const;
     bool isInView(const ViewFrustum& viewFrustum) const { return inFrustum(viewFrustum) != ViewFrustum::OUTSIDE; }
@@ -232,17 +257,18 @@ protected:
     void encodeThreeOffsets(int64_t offsetOne, int64_t offsetTwo, int64_t offsetThree);
     void checkStoreFourChildren(OctreeElement* childOne, OctreeElement* childTwo, OctreeElement* childThree, OctreeElement* childFour);
 #endif
-    void calculateAABox();
     void notifyDeleteHooks();
-    void notifyUpdateHooks();
 
-    AABox _box; /// Client and server, axis aligned box for bounds of this voxel, 48 bytes
+    /// \return the allocator of the tree this element lives in, for creating children
+    OctreeAllocator& getAllocator() const;
+    void notifyUpdateHooks();
 
-    /// Client and server, buffer containing the octal code or a pointer to octal code for this node, 8 bytes
-    union octalCode_t {
-      unsigned char buffer[8];
-      unsigned char* pointer;
-    } _octalCode;  
+    /// Client and server, the element's OctreeKey or, past MAX_OCTREE_KEY_LEVELS, a pointer to its octal code, 8 bytes
+    /// the element's bounds are worked out from this when asked for
+    union address_t {
+      quint64 key;
+      unsigned char* octalCode;
+    } _address;
 
     quint64 _lastChanged; /// Client and server, timestamp this node was last changed, 8 bytes
 
@@ -285,7 +311,7 @@ protected:
     bool _falseColored : 1, /// Client only, is this voxel false colored, 1 bit
          _isDirty : 1, /// Client only, has this voxel changed since being rendered, 1 bit
          _shouldRender : 1, /// Client only, should this voxel render at this time, 1 bit
-         _octcodePointer : 1, /// Client and Server only, is this voxel's octal code a pointer or buffer, 1 bit
+         _octcodePointer : 1, /// Client and Server only, is this voxel's address an octal code or a key, 1 bit
          _unknownBufferIndex : 1,
          _childrenExternal : 1; /// Client only, is this voxel's VBO buffer the unknown buffer index, 1 bit
 
@@ -320,4 +346,25 @@ protected:
     static quint64 _childrenCount[NUMBER_OF_CHILDREN + 1];
 };
 
+inline void OctreeElement::getChildren(OctreeElement* children[NUMBER_OF_CHILDREN]) const {
+#ifdef SIMPLE_EXTERNAL_CHILDREN
+    // two or more children are kept in an external array by index, a single one in place of the array
+    if (_childBitmask & (_childBitmask - 1)) {
+        memcpy(children, _children.external, NUMBER_OF_CHILDREN * sizeof(OctreeElement*));
+        return;
+    }
+    memset(children, 0, NUMBER_OF_CHILDREN * sizeof(OctreeElement*));
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (oneAtBit(_childBitmask, i)) {
+            children[i] = _children.single;
+            return;
+        }
+    }
+#else
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        children[i] = getChildAtIndex(i);
+    }
+#endif // def SIMPLE_EXTERNAL_CHILDREN
+}
+
 #endif // hifi_OctreeElement_h
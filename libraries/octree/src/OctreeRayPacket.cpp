@@ -0,0 +1,113 @@
+//
+//  OctreeRayPacket.cpp
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cfloat>
+#include <cstring>
+
+// SSE is part of every x86-64 target, so unlike the audio mix kernels this needs no runtime dispatch
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OCTREE_RAY_PACKET_SSE
+
+#include <xmmintrin.h>
+#endif
+
+#include "OctreeRayPacket.h"
+
+// the child order bit of each axis, x in 4, y in 2 and z in 1
+static const int AXIS_OCTANT_BITS[3] = { 4, 2, 1 };
+
+OctreeRayPacket::OctreeRayPacket(int octant) :
+    _octant(octant),
+    _size(0)
+{
+    // lanes left empty still go through the tests, so keep them to harmless numbers
+    memset(_origins, 0, sizeof(_origins));
+    memset(_inverseDirections, 0, sizeof(_inverseDirections));
+}
+
+int OctreeRayPacket::addRay(const glm::vec3& origin, const glm::vec3& inverseDirection) {
+    int lane = _size++;
+    for (int axis = 0; axis < 3; axis++) {
+        _origins[axis][lane] = origin[axis];
+        _inverseDirections[axis][lane] = inverseDirection[axis];
+    }
+    return lane;
+}
+
+glm::vec3 OctreeRayPacket::getOrigin(int lane) const {
+    return glm::vec3(_origins[0][lane], _origins[1][lane], _origins[2][lane]);
+}
+
+glm::vec3 OctreeRayPacket::getInverseDirection(int lane) const {
+    return glm::vec3(_inverseDirections[0][lane], _inverseDirections[1][lane], _inverseDirections[2][lane]);
+}
+
+int OctreeRayPacket::octantOf(const glm::vec3& inverseDirection) {
+    int octant = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        if (inverseDirection[axis] < 0.0f) {
+            octant |= AXIS_OCTANT_BITS[axis];
+        }
+    }
+    return octant;
+}
+
+int OctreeRayPacket::findEntries(const AABox& box, int laneMask, float distances[OCTREE_RAY_PACKET_SIZE],
+                                  BoxFace faces[OCTREE_RAY_PACKET_SIZE]) const {
+    const glm::vec3& corner = box.getCorner();
+    float scale = box.getScale();
+
+#ifdef OCTREE_RAY_PACKET_SSE
+    __m128 entryDistances = _mm_set1_ps(-FLT_MAX);
+    __m128 exitDistances = _mm_set1_ps(FLT_MAX);
+    // kept as floats, which hold the small face numbers exactly, so that this needs nothing past SSE
+    __m128 entryFaces = _mm_set1_ps((float)UNKNOWN_FACE);
+    for (int axis = 0; axis < 3; axis++) {
+        // every ray in the packet heads the same way, so they all enter through the same plane on each axis
+        bool negative = (_octant & AXIS_OCTANT_BITS[axis]) != 0;
+        __m128 nearPlane = _mm_set1_ps(negative ? corner[axis] + scale : corner[axis]);
+        __m128 farPlane = _mm_set1_ps(negative ? corner[axis] : corner[axis] + scale);
+        __m128 origins = _mm_loadu_ps(_origins[axis]);
+        __m128 inverseDirections = _mm_loadu_ps(_inverseDirections[axis]);
+        __m128 nearDistances = _mm_mul_ps(_mm_sub_ps(nearPlane, origins), inverseDirections);
+
+        // the lanes whose entry moves to this axis enter through its near face, and as in AABox::findRayEntry a
+        // NaN never compares greater, so it leaves the face alone
+        __m128 isEntryAxis = _mm_cmpgt_ps(nearDistances, entryDistances);
+        __m128 axisFaces = _mm_set1_ps((float)(axis * 2 + (negative ? 1 : 0)));
+        entryFaces = _mm_or_ps(_mm_and_ps(isEntryAxis, axisFaces), _mm_andnot_ps(isEntryAxis, entryFaces));
+
+        // max and min return their second operand when either is a NaN, so the NaNs of an origin on a plane the
+        // ray runs along drop out as they do in AABox::findRayEntry
+        entryDistances = _mm_max_ps(nearDistances, entryDistances);
+        exitDistances = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(farPlane, origins), inverseDirections), exitDistances);
+    }
+    __m128 hits = _mm_and_ps(_mm_cmpge_ps(exitDistances, entryDistances),
+                             _mm_cmpge_ps(exitDistances, _mm_setzero_ps()));
+    _mm_storeu_ps(distances, _mm_max_ps(entryDistances, _mm_setzero_ps()));
+
+    float laneFaces[OCTREE_RAY_PACKET_SIZE];
+    _mm_storeu_ps(laneFaces, entryFaces);
+    for (int lane = 0; lane < OCTREE_RAY_PACKET_SIZE; lane++) {
+        faces[lane] = (BoxFace)(int)laneFaces[lane];
+    }
+    return _mm_movemask_ps(hits) & laneMask;
+#else
+    int hitMask = 0;
+    for (int lane = 0; lane < OCTREE_RAY_PACKET_SIZE; lane++) {
+        faces[lane] = UNKNOWN_FACE;
+        if ((laneMask & (1 << lane)) && box.findRayEntry(getOrigin(lane), getInverseDirection(lane),
+                                                         distances[lane], faces[lane])) {
+            hitMask |= 1 << lane;
+        }
+    }
+    return hitMask;
+#endif
+}
@@ -0,0 +1,57 @@
+//
+//  OctreeRayPacket.h
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeRayPacket_h
+#define hifi_OctreeRayPacket_h
+
+#include <glm/glm.hpp>
+
+#include "AABox.h"
+
+/// the rays in a packet, one to a lane of a four float SSE register
+const int OCTREE_RAY_PACKET_SIZE = 4;
+
+/// Up to OCTREE_RAY_PACKET_SIZE rays whose directions have the same signs, stored a component to an array so that a
+/// box can be tested against all of them at once. With the same signs, the rays share a front to back child order
+/// and the near plane of a box on each axis.
+class OctreeRayPacket {
+public:
+    /// octant is the ray direction signs as a child order, see OctreeRayVisitor::getChildOrder
+    explicit OctreeRayPacket(int octant);
+
+    /// adds a ray heading into the packet's octant, origin in the unit tree
+    /// \return the lane the ray went in
+    int addRay(const glm::vec3& origin, const glm::vec3& inverseDirection);
+
+    int getSize() const { return _size; }
+    bool isFull() const { return _size == OCTREE_RAY_PACKET_SIZE; }
+    int getChildOrder() const { return _octant; }
+
+    glm::vec3 getOrigin(int lane) const;
+    glm::vec3 getInverseDirection(int lane) const;
+
+    /// the same slab test as AABox::findRayEntry, for every ray in the packet at once
+    /// \param distances gets the entry distance of every lane, including those that miss
+    /// \param faces gets the face every lane enters through, including those that miss
+    /// \return a mask, bit n for lane n, of the lanes in laneMask whose rays enter box
+    int findEntries(const AABox& box, int laneMask, float distances[OCTREE_RAY_PACKET_SIZE],
+                    BoxFace faces[OCTREE_RAY_PACKET_SIZE]) const;
+
+    /// \return the octant a ray heads into, which is also its front to back child order
+    static int octantOf(const glm::vec3& inverseDirection);
+
+private:
+    int _octant;
+    int _size;
+    float _origins[3][OCTREE_RAY_PACKET_SIZE];
+    float _inverseDirections[3][OCTREE_RAY_PACKET_SIZE];
+};
+
+#endif // hifi_OctreeRayPacket_h
@@ -0,0 +1,74 @@
+//
+//  OctreeRayVisitor.h
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeRayVisitor_h
+#define hifi_OctreeRayVisitor_h
+
+#include "Octree.h"
+
+/// Finds the nearest element with content along a ray, for Octree::visit. Children are visited front to back, in the
+/// order given by the signs of the ray's direction, so every element the ray enters is entered before any element
+/// behind it. That makes the first leaf with content the ray enters the nearest, and the traversal stops there.
+class OctreeRayVisitor : public OctreeVisitor {
+public:
+    /// origin is in the unit tree, distances found are in direction lengths times TREE_SCALE
+    OctreeRayVisitor(const glm::vec3& origin, const glm::vec3& direction) :
+        _origin(origin),
+        _inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z),
+        _childOrder((_inverseDirection.x < 0.0f ? 4 : 0) | (_inverseDirection.y < 0.0f ? 2 : 0) |
+                    (_inverseDirection.z < 0.0f ? 1 : 0)),
+        _element(NULL),
+        _distance(0.0f),
+        _face(UNKNOWN_FACE),
+        _visitedCount(0) { }
+
+    /// child indices have the x half in their 4 bit, y in 2 and z in 1, so flipping the bits of the axes the ray
+    /// runs down those makes the nearer half come first on every axis
+    int getChildOrder() const { return _childOrder; }
+
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        _visitedCount++;
+        float distance;
+        BoxFace face;
+        if (!element->getAABox().findRayEntry(_origin, _inverseDirection, distance, face)) {
+            return OCTREE_SKIP_CHILDREN;
+        }
+        if (!element->isLeaf()) {
+            return OCTREE_VISIT_CHILDREN;
+        }
+        if (!element->hasContent()) {
+            return OCTREE_SKIP_CHILDREN;
+        }
+        _element = element;
+        _distance = distance * TREE_SCALE;
+        _face = face;
+        return OCTREE_STOP_VISITING;
+    }
+
+    bool isFound() const { return _element != NULL; }
+    OctreeElement* getElement() const { return _element; }
+    float getDistance() const { return _distance; }
+    BoxFace getFace() const { return _face; }
+
+    /// \return how many elements the traversal looked at, for comparing traversals
+    int getVisitedCount() const { return _visitedCount; }
+
+private:
+    glm::vec3 _origin;
+    glm::vec3 _inverseDirection;
+    int _childOrder;
+
+    OctreeElement* _element;
+    float _distance;
+    BoxFace _face;
+    int _visitedCount;
+};
+
+#endif // hifi_OctreeRayVisitor_h
@@ -16,7 +16,7 @@ ParticleTree::ParticleTree(bool shouldReaverage) : Octree(shouldReaverage) {
 }
 
 ParticleTreeElement* ParticleTree::createNewElement(unsigned char * octalCode) {
-    ParticleTreeElement* newElement = new ParticleTreeElement(octalCode);
+    ParticleTreeElement* newElement = new (_allocator) ParticleTreeElement(octalCode);
     newElement->setTree(this);
     return newElement;
 }
@@ -340,49 +340,33 @@ void ParticleTree::findParticlesForUpdate(const AABox& box, QVector<Particle*> f
     foundParticles.swap(args._foundParticles);
 }
 
-class FindByIDArgs {
+class FindByIDVisitor : public OctreeVisitor {
 public:
-    uint32_t id;
-    bool found;
-    const Particle* foundParticle;
-};
-
-
-bool ParticleTree::findByIDOperation(OctreeElement* element, void* extraData) {
-//qDebug() << "ParticleTree::findByIDOperation()....";
-
-    FindByIDArgs* args = static_cast<FindByIDArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
+    explicit FindByIDVisitor(uint32_t id) :
+        id(id),
+        foundParticle(NULL) { }
 
-    // if already found, stop looking
-    if (args->found) {
-        return false;
-    }
-
-    // as the tree element if it has this particle
-    const Particle* foundParticle = particleTreeElement->getParticleWithID(args->id);
-    if (foundParticle) {
-        args->foundParticle = foundParticle;
-        args->found = true;
-        return false;
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        // ask the tree element if it has this particle, and stop looking once one does
+        foundParticle = static_cast<ParticleTreeElement*>(element)->getParticleWithID(id);
+        return foundParticle ? OCTREE_STOP_VISITING : OCTREE_VISIT_CHILDREN;
     }
 
-    // keep looking
-    return true;
-}
-
+    uint32_t id;
+    const Particle* foundParticle;
+};
 
 const Particle* ParticleTree::findParticleByID(uint32_t id, bool alreadyLocked) {
-    FindByIDArgs args = { id, false, NULL };
+    FindByIDVisitor visitor(id);
 
     if (!alreadyLocked) {
         lockForRead();
     }
-    recurseTreeWithOperation(findByIDOperation, &args);
+    visit(visitor);
     if (!alreadyLocked) {
         unlock();
     }
-    return args.foundParticle;
+    return visitor.foundParticle;
 }
 
 
@@ -442,12 +426,18 @@ void ParticleTree::removeNewlyCreatedHook(NewlyCreatedParticleHook* hook) {
 }
 
 
-bool ParticleTree::updateOperation(OctreeElement* element, void* extraData) {
-    ParticleTreeUpdateArgs* args = static_cast<ParticleTreeUpdateArgs*>(extraData);
-    ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
-    particleTreeElement->update(*args);
-    return true;
-}
+class UpdateVisitor : public OctreeVisitor {
+public:
+    explicit UpdateVisitor(ParticleTreeUpdateArgs& args) :
+        args(args) { }
+
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        static_cast<ParticleTreeElement*>(element)->update(args);
+        return OCTREE_VISIT_CHILDREN;
+    }
+
+    ParticleTreeUpdateArgs& args;
+};
 
 bool ParticleTree::pruneOperation(OctreeElement* element, void* extraData) {
     ParticleTreeElement* particleTreeElement = static_cast<ParticleTreeElement*>(element);
@@ -465,7 +455,8 @@ void ParticleTree::update() {
     _isDirty = true;
 
     ParticleTreeUpdateArgs args = { };
-    recurseTreeWithOperation(updateOperation, &args);
+    UpdateVisitor visitor(args);
+    visit(visitor);
 
     // now add back any of the particles that moved elements....
     int movingParticles = args._movingParticles.size();
@@ -19,7 +19,6 @@ ParticleTreeElement::ParticleTreeElement(unsigned char* octalCode) : OctreeEleme
 };
 
 ParticleTreeElement::~ParticleTreeElement() {
-    _voxelMemoryUsage -= sizeof(ParticleTreeElement);
     delete _particles;
     _particles = NULL;
 }
@@ -29,7 +28,7 @@ ParticleTreeElement::~ParticleTreeElement() {
 // specific settings that our children must have. One example is out VoxelSystem, which
 // we know must match ours.
 OctreeElement* ParticleTreeElement::createNewElement(unsigned char* octalCode) {
-    ParticleTreeElement* newChild = new ParticleTreeElement(octalCode);
+    ParticleTreeElement* newChild = new (getAllocator()) ParticleTreeElement(octalCode);
     newChild->setTree(_myTree);
     return newChild;
 }
@@ -37,7 +36,6 @@ OctreeElement* ParticleTreeElement::createNewElement(unsigned char* octalCode) {
 void ParticleTreeElement::init(unsigned char* octalCode) {
     OctreeElement::init(octalCode);
     _particles = new QList<Particle>;
-    _voxelMemoryUsage += sizeof(ParticleTreeElement);
 }
 
 ParticleTreeElement* ParticleTreeElement::addChildAtIndex(int index) {
@@ -71,6 +69,7 @@ void ParticleTreeElement::update(ParticleTreeUpdateArgs& args) {
     // TODO: early exit when _particles is empty
 
     // update our contained particles
+    AABox box = getAABox();
     QList<Particle>::iterator particleItr = _particles->begin();
     while(particleItr != _particles->end()) {
         Particle& particle = (*particleItr);
@@ -78,7 +77,7 @@ void ParticleTreeElement::update(ParticleTreeUpdateArgs& args) {
 
         // If the particle wants to die, or if it's left our bounding box, then move it
         // into the arguments moving particles. These will be added back or deleted completely
-        if (particle.getShouldDie() || !_box.contains(particle.getPosition())) {
+        if (particle.getShouldDie() || !box.contains(particle.getPosition())) {
             args._movingParticles.push_back(particle);
 
             // erase this particle
@@ -247,6 +246,7 @@ void ParticleTreeElement::getParticles(const glm::vec3& searchPosition, float se
 void ParticleTreeElement::getParticlesForUpdate(const AABox& box, QVector<Particle*>& foundParticles) {
     QList<Particle>::iterator particleItr = _particles->begin();
     QList<Particle>::iterator particleEnd = _particles->end();
+    AABox elementBox = getAABox();
     AABox particleBox;
     while(particleItr != particleEnd) {
         Particle* particle = &(*particleItr);
@@ -255,7 +255,7 @@ void ParticleTreeElement::getParticlesForUpdate(const AABox& box, QVector<Partic
         // TODO: decide whether to replace particleBox-box query with sphere-box (requires a square root
         // but will be slightly more accurate).
         particleBox.setBox(particle->getPosition() - glm::vec3(radius), 2.f * radius);
-        if (particleBox.touches(_box)) {
+        if (particleBox.touches(elementBox)) {
             foundParticles.push_back(particle);
         }
         ++particleItr;
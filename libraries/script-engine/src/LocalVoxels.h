@@ -78,6 +78,9 @@ public:
     
     /// If the scripting context has visible voxels, this will determine a ray intersection
     Q_INVOKABLE RayToVoxelIntersectionResult findRayIntersection(const PickRay& ray);
+
+    /// casts a batch of rays together, cheaper than a findRayIntersection call per ray for many rays at once
+    Q_INVOKABLE QVector<RayToVoxelIntersectionResult> findRayIntersections(const QVector<PickRay>& rays);
     
     /// returns a voxel space axis aligned vector for the face, useful in doing voxel math
     Q_INVOKABLE glm::vec3 getFaceVector(const QString& face);
@@ -19,6 +19,8 @@
 
 #include <AudioRingBuffer.h>
 #include <AvatarData.h>
+#include <FrameScheduler.h>
+#include <MixedAudioCodec.h>
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <UUID.h>
@@ -286,25 +288,14 @@ void ScriptEngine::run() {
         emit errorMessage("Uncaught exception at line" + QString::number(line) + ":" + result.toString());
     }
 
-    QElapsedTimer startTime;
-    startTime.start();
-
-    int thisFrame = 0;
+    FrameScheduler frameScheduler(SCRIPT_DATA_CALLBACK_USECS);
+    frameScheduler.start();
 
     NodeList* nodeList = NodeList::getInstance();
 
     qint64 lastUpdate = usecTimestampNow();
 
     while (!_isFinished) {
-        int usecToSleep = (thisFrame++ * SCRIPT_DATA_CALLBACK_USECS) - startTime.nsecsElapsed() / 1000; // nsec to usec
-        if (usecToSleep > 0) {
-            usleep(usecToSleep);
-        }
-
-        if (_isFinished) {
-            break;
-        }
-
         QCoreApplication::processEvents();
 
         if (_isFinished) {
@@ -388,6 +379,9 @@ void ScriptEngine::run() {
                 glm::quat headOrientation = _avatarData->getHeadOrientation();
                 packetStream.writeRawData(reinterpret_cast<const char*>(&headOrientation), sizeof(glm::quat));
 
+                // let the mixer know which encodings we can decode the mix it sends back in
+                packetStream << SUPPORTED_MIXED_AUDIO_ENCODINGS;
+
                 if (silentFrame) {
                     if (!_isListeningToAudioStream) {
                         // if we have a silent frame and we're not listening then just send nothing and break out of here
@@ -416,6 +410,9 @@ void ScriptEngine::run() {
             qDebug() << "Uncaught exception at line" << line << ":" << _engine.uncaughtException().toString();
             emit errorMessage("Uncaught exception at line" + QString::number(line) + ":" + _engine.uncaughtException().toString());
         }
+
+        // the first frame runs as soon as the script is evaluated, the rest wait for their turn
+        frameScheduler.waitForNextFrame();
     }
     emit scriptEnding();
 
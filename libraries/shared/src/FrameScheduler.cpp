@@ -0,0 +1,145 @@
+//
+//  FrameScheduler.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include <QtCore/QDebug>
+#include <QtCore/QJsonArray>
+#include <QtCore/QThread>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+
+#include "SharedUtil.h"
+
+#include "FrameScheduler.h"
+
+#ifdef Q_OS_LINUX
+// the kernel may wake a sleeping thread this much after its deadline to batch timers, the default is 50 usecs
+const unsigned long FRAME_TIMER_SLACK_NSECS = 1000;
+#else
+// a relative sleep can overshoot by the OS scheduler's granularity, so stop short and yield out the rest
+const int FRAME_SPIN_USECS = 1000;
+#endif
+
+FrameScheduler::FrameScheduler(int intervalUsecs) :
+    _intervalUsecs(intervalUsecs),
+    _pinnedCore(-1),
+    _clock(),
+    _nextFrame(0),
+    _numFrames(0),
+    _numOverruns(0),
+    _maxLatenessUsecs(0)
+{
+    resetStats();
+}
+
+void FrameScheduler::start() {
+    if (_pinnedCore >= 0 && !pinCurrentThreadToCore(_pinnedCore)) {
+        qDebug() << "Could not pin the frame thread to core" << _pinnedCore;
+    }
+
+#ifdef Q_OS_LINUX
+    prctl(PR_SET_TIMERSLACK, FRAME_TIMER_SLACK_NSECS);
+#endif
+
+    _nextFrame = 0;
+    _clock.start();
+}
+
+int FrameScheduler::waitForNextFrame() {
+    qint64 deadlineUsecs = ++_nextFrame * _intervalUsecs;
+    int usecsBeforeDeadline = deadlineUsecs - usecsSinceStart();
+
+    if (usecsBeforeDeadline > 0) {
+        sleepUntil(deadlineUsecs);
+    } else {
+        _numOverruns++;
+    }
+
+    int latenessUsecs = std::max(usecsSinceStart() - deadlineUsecs, (qint64) 0);
+
+    int bucket = 0;
+    while (bucket < NUM_FRAME_LATENESS_BUCKETS - 1 && latenessUsecs > FRAME_LATENESS_BUCKET_USECS[bucket]) {
+        bucket++;
+    }
+
+    _latenessBuckets[bucket]++;
+    _maxLatenessUsecs = std::max(_maxLatenessUsecs, latenessUsecs);
+    _numFrames++;
+
+    return usecsBeforeDeadline;
+}
+
+QJsonObject FrameScheduler::getStats() const {
+    QJsonObject statsObject;
+    statsObject["frames"] = _numFrames;
+    statsObject["overruns"] = _numOverruns;
+    statsObject["max_lateness_usecs"] = _maxLatenessUsecs;
+
+    // one count per bucket, the bucket bounds are in FRAME_LATENESS_BUCKET_USECS
+    QJsonArray latenessArray;
+    for (int i = 0; i < NUM_FRAME_LATENESS_BUCKETS; i++) {
+        latenessArray.append(_latenessBuckets[i]);
+    }
+    statsObject["lateness_histogram"] = latenessArray;
+
+    return statsObject;
+}
+
+void FrameScheduler::resetStats() {
+    _numFrames = 0;
+    _numOverruns = 0;
+    _maxLatenessUsecs = 0;
+    memset(_latenessBuckets, 0, sizeof(_latenessBuckets));
+}
+
+bool FrameScheduler::pinCurrentThreadToCore(int core) {
+#ifdef Q_OS_LINUX
+    cpu_set_t coreSet;
+    CPU_ZERO(&coreSet);
+    CPU_SET(core, &coreSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(coreSet), &coreSet) == 0;
+#else
+    Q_UNUSED(core);
+    return false;
+#endif
+}
+
+void FrameScheduler::sleepUntil(qint64 deadlineUsecs) {
+#ifdef Q_OS_LINUX
+    // take the deadline over to CLOCK_MONOTONIC once, so a sleep cut short by a signal resumes to the same deadline
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    qint64 deadlineNsecs = deadline.tv_nsec + (deadlineUsecs - usecsSinceStart()) * 1000;
+    deadline.tv_sec += deadlineNsecs / 1000000000;
+    deadline.tv_nsec = deadlineNsecs % 1000000000;
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+
+    }
+#else
+    int usecsToSleep = deadlineUsecs - usecsSinceStart() - FRAME_SPIN_USECS;
+    if (usecsToSleep > 0) {
+        usleep(usecsToSleep);
+    }
+
+    while (usecsSinceStart() < deadlineUsecs) {
+        QThread::yieldCurrentThread();
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+//
+//  FrameScheduler.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FrameScheduler_h
+#define hifi_FrameScheduler_h
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QtGlobal>
+
+/// the upper bound of each lateness bucket, the last bucket holds every wake-up later than the last bound
+const int NUM_FRAME_LATENESS_BUCKETS = 8;
+const int FRAME_LATENESS_BUCKET_USECS[NUM_FRAME_LATENESS_BUCKETS - 1] = { 100, 250, 500, 1000, 2500, 5000, 10000 };
+
+/// Paces a loop that sends a frame every intervalUsecs. Frame k is due at start() + k * intervalUsecs on a monotonic
+/// clock, so a late frame does not push back the ones after it. Records how late each wake-up was and how often the
+/// work of a frame ran past the deadline of the next one.
+class FrameScheduler {
+public:
+    FrameScheduler(int intervalUsecs);
+
+    /// pins the thread that calls start() to one core, -1 (the default) leaves it to the OS scheduler
+    void setPinnedCore(int pinnedCore) { _pinnedCore = pinnedCore; }
+    int getPinnedCore() const { return _pinnedCore; }
+
+    /// starts the clock for the first frame, call from the thread that will wait for the frames
+    void start();
+
+    /// sleeps until the next frame is due, the first call waits for the frame after the one start() began
+    /// returns the usecs that were left before the deadline when this was called, negative if the frame overran
+    int waitForNextFrame();
+
+    int getIntervalUsecs() const { return _intervalUsecs; }
+    int getNumFrames() const { return _numFrames; }
+    int getNumOverruns() const { return _numOverruns; }
+    int getMaxLatenessUsecs() const { return _maxLatenessUsecs; }
+    int getNumFramesInLatenessBucket(int bucket) const { return _latenessBuckets[bucket]; }
+
+    /// the counts since the last resetStats, for a stats packet
+    QJsonObject getStats() const;
+    void resetStats();
+
+    /// restricts the calling thread to one core, returns false where that is not supported
+    static bool pinCurrentThreadToCore(int core);
+private:
+    qint64 usecsSinceStart() const { return _clock.nsecsElapsed() / 1000; }
+    void sleepUntil(qint64 deadlineUsecs);
+
+    int _intervalUsecs;
+    int _pinnedCore;
+    QElapsedTimer _clock;
+    qint64 _nextFrame;
+    int _numFrames;
+    int _numOverruns;
+    int _maxLatenessUsecs;
+    int _latenessBuckets[NUM_FRAME_LATENESS_BUCKETS];
+};
+
+#endif // hifi_FrameScheduler_h
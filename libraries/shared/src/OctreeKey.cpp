@@ -0,0 +1,74 @@
+//
+//  OctreeKey.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "SharedUtil.h"
+#include "OctreeKey.h"
+
+// pulls every third bit of bits, starting with the lowest, together into the low bits of the result
+static quint32 compactEveryThirdBit(quint64 bits) {
+    bits &= 0x1249249249249249ULL;
+    bits = (bits ^ (bits >> 2)) & 0x10c30c30c30c30c3ULL;
+    bits = (bits ^ (bits >> 4)) & 0x100f00f00f00f00fULL;
+    bits = (bits ^ (bits >> 8)) & 0x001f0000ff0000ffULL;
+    bits = (bits ^ (bits >> 16)) & 0x001f00000000ffffULL;
+    bits = (bits ^ (bits >> 32)) & 0x00000000001fffffULL;
+    return (quint32) bits;
+}
+
+OctreeKey OctreeKey::fromOctalCode(const unsigned char* octalCode) {
+    int level = numberOfThreeBitSectionsInCode(octalCode);
+    if (level > MAX_OCTREE_KEY_LEVELS || level < 0) {
+        return OctreeKey(0);
+    }
+    if (level == 0) {
+        return OctreeKey();
+    }
+
+    // the sections follow the length byte most significant bit first, which is how they sit in the key
+    int numSectionBytes = bytesRequiredForCodeLength(level) - 1;
+    quint64 sections = 0;
+    for (int i = 0; i < numSectionBytes; i++) {
+        sections |= (quint64) octalCode[1 + i] << (BITS_IN_BYTE * (sizeof(sections) - 1 - i));
+    }
+    int numPathBits = BITS_IN_OCTAL * level;
+    return OctreeKey(((quint64) 1 << numPathBits) | (sections >> (BITS_IN_BYTE * sizeof(sections) - numPathBits)));
+}
+
+int OctreeKey::writeOctalCode(unsigned char* octalCode) const {
+    int level = getLevel();
+    octalCode[0] = level;
+    if (level == 0) {
+        return 1;
+    }
+
+    int numPathBits = BITS_IN_OCTAL * level;
+    quint64 sections = _bits << (BITS_IN_BYTE * sizeof(sections) - numPathBits);
+    int numSectionBytes = bytesRequiredForCodeLength(level) - 1;
+    for (int i = 0; i < numSectionBytes; i++) {
+        octalCode[1 + i] = sections >> (BITS_IN_BYTE * (sizeof(sections) - 1 - i));
+    }
+    return 1 + numSectionBytes;
+}
+
+unsigned char* OctreeKey::toOctalCode() const {
+    unsigned char* octalCode = new unsigned char[bytesRequiredForCodeLength(getLevel())];
+    writeOctalCode(octalCode);
+    return octalCode;
+}
+
+glm::vec3 OctreeKey::getCorner() const {
+    int level = getLevel();
+    quint64 path = _bits ^ ((quint64) 1 << (BITS_IN_OCTAL * level));
+
+    // the highest of a section's three bits picks the x half, the lowest the z half
+    float scale = getScale();
+    return glm::vec3(compactEveryThirdBit(path >> 2) * scale, compactEveryThirdBit(path >> 1) * scale,
+                     compactEveryThirdBit(path) * scale);
+}
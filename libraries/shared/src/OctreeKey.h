@@ -0,0 +1,104 @@
+//
+//  OctreeKey.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeKey_h
+#define hifi_OctreeKey_h
+
+#include <glm/glm.hpp>
+
+#include <QtGlobal>
+
+#include "OctalCode.h"
+
+/// the deepest level a key can address, three bits a level and a marker bit fill the 64 bits
+const int MAX_OCTREE_KEY_LEVELS = 21;
+
+/// the length of the longest octal code a key converts to, bytesRequiredForCodeLength(MAX_OCTREE_KEY_LEVELS)
+const int MAX_OCTREE_KEY_CODE_BYTES = 9;
+
+/// An octree element's address as one 64 bit word. The path from the root is the element's octal code sections
+/// interleaved three bits a level, with a marker bit set just above the path so the level can be read back from the
+/// position of the highest set bit. The root's key is just the marker. Walking up and down the tree and testing for
+/// ancestry are shifts and compares, and a key converts both ways to the octal code wire format without loss as long
+/// as the code is no deeper than MAX_OCTREE_KEY_LEVELS.
+class OctreeKey {
+public:
+    /// the root
+    OctreeKey() : _bits(1) { }
+    explicit OctreeKey(quint64 bits) : _bits(bits) { }
+
+    /// \return the key of octalCode, or an invalid key if the code is too deep for one
+    static OctreeKey fromOctalCode(const unsigned char* octalCode);
+
+    /// writes the octal code for this key to octalCode, which needs bytesRequiredForCodeLength(getLevel()) bytes
+    /// \return the number of bytes written
+    int writeOctalCode(unsigned char* octalCode) const;
+
+    /// \return a new[] allocated copy of the octal code for this key, the same as childOctalCode would give
+    unsigned char* toOctalCode() const;
+
+    /// \return false for keys of codes too deep to have one
+    bool isValid() const { return _bits != 0; }
+
+    quint64 getBits() const { return _bits; }
+
+    /// \return the number of three bit sections in the key's octal code, zero for the root
+    int getLevel() const;
+
+    /// \return the corner of the key's cube in the unit tree
+    glm::vec3 getCorner() const;
+
+    /// \return the size of the key's cube in the unit tree
+    float getScale() const { return 1.0f / (1 << getLevel()); }
+
+    OctreeKey getChild(int childIndex) const { return OctreeKey((_bits << BITS_IN_OCTAL) | childIndex); }
+    OctreeKey getParent() const { return OctreeKey(_bits >> BITS_IN_OCTAL); }
+
+    /// \return the ancestor of this key at level, which must be no deeper than the key itself
+    OctreeKey getAncestor(int level) const { return OctreeKey(_bits >> (BITS_IN_OCTAL * (getLevel() - level))); }
+
+    /// \return which child of its parent this key is
+    int getChildIndex() const { return _bits & CHILD_INDEX_MASK; }
+
+    /// \return true if this key is descendant or one of descendant's ancestors
+    bool contains(const OctreeKey& descendant) const;
+
+    /// \return the index of the child of this key on the way down to descendant, which must be deeper than this key
+    int branchIndexToward(const OctreeKey& descendant) const {
+        return (descendant._bits >> (BITS_IN_OCTAL * (descendant.getLevel() - getLevel() - 1))) & CHILD_INDEX_MASK;
+    }
+
+    bool operator==(const OctreeKey& other) const { return _bits == other._bits; }
+    bool operator!=(const OctreeKey& other) const { return _bits != other._bits; }
+
+private:
+    static const quint64 CHILD_INDEX_MASK = 7;
+
+    quint64 _bits;
+};
+
+inline int OctreeKey::getLevel() const {
+#ifdef __GNUC__
+    return (63 - __builtin_clzll(_bits)) / BITS_IN_OCTAL;
+#else
+    int level = 0;
+    for (quint64 bits = _bits >> BITS_IN_OCTAL; bits; bits >>= BITS_IN_OCTAL) {
+        level++;
+    }
+    return level;
+#endif
+}
+
+inline bool OctreeKey::contains(const OctreeKey& descendant) const {
+    int levelsBelow = descendant.getLevel() - getLevel();
+    return levelsBelow >= 0 && (descendant._bits >> (BITS_IN_OCTAL * levelsBelow)) == _bits;
+}
+
+#endif // hifi_OctreeKey_h
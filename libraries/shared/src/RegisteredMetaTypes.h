@@ -14,6 +14,7 @@
 
 #include <glm/glm.hpp>
 
+#include <QtCore/QVector>
 #include <QtScript/QScriptEngine>
 
 #include "CollisionInfo.h"
@@ -49,6 +50,7 @@ public:
     glm::vec3 direction;
 };
 Q_DECLARE_METATYPE(PickRay)
+Q_DECLARE_METATYPE(QVector<PickRay>)
 QScriptValue pickRayToScriptValue(QScriptEngine* engine, const PickRay& pickRay);
 void pickRayFromScriptValue(const QScriptValue& object, PickRay& pickRay);
 
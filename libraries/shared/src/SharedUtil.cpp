@@ -264,6 +264,24 @@ bool cmdOptionExists(int argc, const char * argv[],const char* option) {
     return false;
 }
 
+QString getCmdOption(const QStringList& arguments, const QString& option) {
+    int optionIndex = arguments.indexOf(option);
+    bool hasValue = optionIndex != -1 && optionIndex + 1 < arguments.size();
+    return hasValue ? arguments[optionIndex + 1] : QString();
+}
+
+QString takeCmdOption(QStringList& arguments, const QString& option, const QString& defaultValue) {
+    int optionIndex = arguments.indexOf(option);
+    if (optionIndex == -1 || optionIndex + 1 >= arguments.size()) {
+        return defaultValue;
+    }
+    
+    QString value = arguments[optionIndex + 1];
+    arguments.removeAt(optionIndex + 1);
+    arguments.removeAt(optionIndex);
+    return value;
+}
+
 void sharedMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString &message) {
     fprintf(stdout, "%s", message.toLocal8Bit().constData());
 }
@@ -556,6 +574,59 @@ int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatO
     return sizeof(quatParts);
 }
 
+const int SMALLEST_THREE_COMPONENT_BITS = 10;
+const int SMALLEST_THREE_COMPONENT_MAX = (1 << SMALLEST_THREE_COMPONENT_BITS) - 1;
+
+int packOrientationQuatToFourBytes(unsigned char* buffer, const glm::quat& quatInput) {
+    glm::quat quat = glm::normalize(quatInput);
+    
+    int largestIndex = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(quat[i]) > fabsf(quat[largestIndex])) {
+            largestIndex = i;
+        }
+    }
+    
+    // q and -q are the same rotation, so the one left out can always be taken as positive
+    if (quat[largestIndex] < 0.0f) {
+        quat = -quat;
+    }
+    
+    quint32 packedQuat = largestIndex;
+    for (int i = 0; i < 4; i++) {
+        if (i != largestIndex) {
+            float component = glm::clamp(quat[i] * SQUARE_ROOT_OF_2, -1.0f, 1.0f);
+            packedQuat = (packedQuat << SMALLEST_THREE_COMPONENT_BITS)
+                | (quint32) floorf((component + 1.0f) * 0.5f * SMALLEST_THREE_COMPONENT_MAX + 0.5f);
+        }
+    }
+    
+    memcpy(buffer, &packedQuat, sizeof(packedQuat));
+    return sizeof(packedQuat);
+}
+
+int unpackOrientationQuatFromFourBytes(const unsigned char* buffer, glm::quat& quatOutput) {
+    quint32 packedQuat;
+    memcpy(&packedQuat, buffer, sizeof(packedQuat));
+    
+    int largestIndex = packedQuat >> (3 * SMALLEST_THREE_COMPONENT_BITS);
+    float sumOfSquares = 0.0f;
+    
+    // the components were packed in order, so the last one sits in the lowest bits
+    for (int i = 3; i >= 0; i--) {
+        if (i != largestIndex) {
+            float component = (packedQuat & SMALLEST_THREE_COMPONENT_MAX) / (float) SMALLEST_THREE_COMPONENT_MAX;
+            quatOutput[i] = (component * 2.0f - 1.0f) / SQUARE_ROOT_OF_2;
+            sumOfSquares += quatOutput[i] * quatOutput[i];
+            packedQuat >>= SMALLEST_THREE_COMPONENT_BITS;
+        }
+    }
+    
+    quatOutput[largestIndex] = sqrtf(std::max(1.0f - sumOfSquares, 0.0f));
+    
+    return sizeof(packedQuat);
+}
+
 float SMALL_LIMIT = 10.f;
 float LARGE_LIMIT = 1000.f;
 
@@ -23,6 +23,7 @@
 #include <glm/gtc/quaternion.hpp>
 
 #include <QtCore/QDebug>
+#include <QtCore/QStringList>
 
 const int BYTES_PER_COLOR = 3;
 const int BYTES_PER_FLAGS = 1;
@@ -92,6 +93,14 @@ bool isInEnvironment(const char* environment);
 const char* getCmdOption(int argc, const char * argv[],const char* option);
 bool cmdOptionExists(int argc, const char * argv[],const char* option);
 
+/// \return the value following option in arguments, such as an assignment payload split on spaces, or an empty
+/// string if there is none
+QString getCmdOption(const QStringList& arguments, const QString& option);
+
+/// \return the value following option in arguments, or defaultValue if there is none
+/// the option and its value are taken out of arguments, so what is left can be passed on
+QString takeCmdOption(QStringList& arguments, const QString& option, const QString& defaultValue);
+
 void sharedMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString &message);
 
 unsigned char* pointToVoxel(float x, float y, float z, float s, unsigned char r = 0, unsigned char g = 0, unsigned char b = 0);
@@ -136,6 +145,12 @@ int unpackFloatAngleFromTwoByte(const uint16_t* byteAnglePointer, float* destina
 int packOrientationQuatToBytes(unsigned char* buffer, const glm::quat& quatInput);
 int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatOutput);
 
+// Only three components of a normalized quat need be sent, the fourth follows from them. Leaving out the largest, the
+// other three are between -1/sqrt(2) and 1/sqrt(2), this allows us to encode them in 10 bits each and the index
+// of the one left out in 2, four bytes in all, to within a quarter of a degree
+int packOrientationQuatToFourBytes(unsigned char* buffer, const glm::quat& quatInput);
+int unpackOrientationQuatFromFourBytes(const unsigned char* buffer, glm::quat& quatOutput);
+
 // Ratios need the be highly accurate when less than 10, but not very accurate above 10, and they
 // are never greater than 1000 to 1, this allows us to encode each component in 16bits
 int packFloatRatioToTwoByte(unsigned char* buffer, float ratio);
@@ -18,4 +18,7 @@ const int NUM_BYTES_RFC4122_UUID = 16;
 
 QString uuidStringWithoutCurlyBraces(const QUuid& uuid);
 
+/// writes the NUM_BYTES_RFC4122_UUID bytes of QUuid::toRfc4122 to destination, without the QByteArray
+void packRfc4122UUID(const QUuid& uuid, char* destination);
+
 #endif // hifi_UUID_h
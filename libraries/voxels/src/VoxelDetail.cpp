@@ -15,6 +15,8 @@
 void registerVoxelMetaTypes(QScriptEngine* engine) {
     qScriptRegisterMetaType(engine, voxelDetailToScriptValue, voxelDetailFromScriptValue);
     qScriptRegisterMetaType(engine, rayToVoxelIntersectionResultToScriptValue, rayToVoxelIntersectionResultFromScriptValue);
+    qScriptRegisterSequenceMetaType<QVector<PickRay> >(engine);
+    qScriptRegisterSequenceMetaType<QVector<RayToVoxelIntersectionResult> >(engine);
 }
 
 QScriptValue voxelDetailToScriptValue(QScriptEngine* engine, const VoxelDetail& voxelDetail) {
@@ -12,6 +12,7 @@
 #ifndef hifi_VoxelDetail_h
 #define hifi_VoxelDetail_h
 
+#include <QtCore/QVector>
 #include <QtScript/QScriptEngine>
 
 #include <AABox.h>
@@ -46,6 +47,7 @@ public:
 };
 
 Q_DECLARE_METATYPE(RayToVoxelIntersectionResult)
+Q_DECLARE_METATYPE(QVector<RayToVoxelIntersectionResult>)
 
 QScriptValue rayToVoxelIntersectionResultToScriptValue(QScriptEngine* engine, const RayToVoxelIntersectionResult& results);
 void rayToVoxelIntersectionResultFromScriptValue(const QScriptValue& object, RayToVoxelIntersectionResult& results);
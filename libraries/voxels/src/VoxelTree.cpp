@@ -31,7 +31,7 @@ VoxelTreeElement* VoxelTree::createNewElement(unsigned char * octalCode) {
     if (_rootNode) {
         voxelSystem = ((VoxelTreeElement*)_rootNode)->getVoxelSystem();
     }
-    VoxelTreeElement* newElement = new VoxelTreeElement(octalCode);
+    VoxelTreeElement* newElement = new (_allocator) VoxelTreeElement(octalCode);
     newElement->setVoxelSystem(voxelSystem);
     return newElement;
 }
@@ -153,18 +153,14 @@ bool VoxelTree::nudgeCheck(OctreeElement* element, void* extraData) {
 
         NodeChunkArgs* args = (NodeChunkArgs*)extraData;
 
-        // get octal code of this element
-        const unsigned char* octalCode = element->getOctalCode();
-
-        // get voxel position/size
-        VoxelPositionSize unNudgedDetails;
-        voxelDetailsForCode(octalCode, unNudgedDetails);
+        // get voxel size
+        float unNudgedScale = element->getScale();
 
         // find necessary leaf size
-        float newLeafSize = findNewLeafSize(args->nudgeVec, unNudgedDetails.s);
+        float newLeafSize = findNewLeafSize(args->nudgeVec, unNudgedScale);
 
         // check to see if this unNudged element can be nudged
-        if (unNudgedDetails.s <= newLeafSize) {
+        if (unNudgedScale <= newLeafSize) {
             args->thisVoxelTree->nudgeLeaf(voxel, extraData);
             return false;
         } else {
@@ -192,18 +188,14 @@ void VoxelTree::chunkifyLeaf(VoxelTreeElement* element) {
 void VoxelTree::nudgeLeaf(VoxelTreeElement* element, void* extraData) {
     NodeChunkArgs* args = (NodeChunkArgs*)extraData;
 
-    // get octal code of this element
-    const unsigned char* octalCode = element->getOctalCode();
-
     // get voxel position/size
-    VoxelPositionSize unNudgedDetails;
-    voxelDetailsForCode(octalCode, unNudgedDetails);
+    glm::vec3 unNudgedCorner = element->getCorner();
 
     VoxelDetail voxelDetails;
-    voxelDetails.x = unNudgedDetails.x;
-    voxelDetails.y = unNudgedDetails.y;
-    voxelDetails.z = unNudgedDetails.z;
-    voxelDetails.s = unNudgedDetails.s;
+    voxelDetails.x = unNudgedCorner.x;
+    voxelDetails.y = unNudgedCorner.y;
+    voxelDetails.z = unNudgedCorner.z;
+    voxelDetails.s = element->getScale();
     voxelDetails.red = element->getColor()[RED_INDEX];
     voxelDetails.green = element->getColor()[GREEN_INDEX];
     voxelDetails.blue = element->getColor()[BLUE_INDEX];
@@ -414,6 +406,7 @@ bool VoxelTree::readFromSchematicFile(const char *fileName) {
 class ReadCodeColorBufferToTreeArgs {
 public:
     const unsigned char* codeColorBuffer;
+    OctreeKey key;
     int lengthOfCode;
     bool destructive;
     bool pathChanged;
@@ -422,6 +415,7 @@ public:
 void VoxelTree::readCodeColorBufferToTree(const unsigned char* codeColorBuffer, bool destructive) {
     ReadCodeColorBufferToTreeArgs args;
     args.codeColorBuffer = codeColorBuffer;
+    args.key = OctreeKey::fromOctalCode(codeColorBuffer);
     args.lengthOfCode = numberOfThreeBitSectionsInCode(codeColorBuffer);
     args.destructive = destructive;
     args.pathChanged = false;
@@ -430,7 +424,7 @@ void VoxelTree::readCodeColorBufferToTree(const unsigned char* codeColorBuffer,
 }
 
 void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadCodeColorBufferToTreeArgs& args) {
-    int lengthOfNodeCode = numberOfThreeBitSectionsInCode(node->getOctalCode());
+    int lengthOfNodeCode = node->getLevel() - 1;
 
     // Since we traverse the tree in code order, we know that if our code
     // matches, then we've reached  our target node.
@@ -474,7 +468,7 @@ void VoxelTree::readCodeColorBufferToTreeRecursion(VoxelTreeElement* node, ReadC
 
     // Ok, we know we haven't reached our target node yet, so keep looking
     //printOctalCode(args.codeColorBuffer);
-    int childIndex = branchIndexWithDescendant(node->getOctalCode(), args.codeColorBuffer);
+    int childIndex = node->branchIndexToward(args.key, args.codeColorBuffer);
     VoxelTreeElement* childNode = node->getChildAtIndex(childIndex);
 
     // If the branch we need to traverse does not exist, then create it on the way down...
@@ -563,3 +557,46 @@ int VoxelTree::processEditPacketData(PacketType packetType, const unsigned char*
             return 0;
     }
 }
+
+static void setIntersectedVoxel(RayToVoxelIntersectionResult& result, const PickRay& ray, OctreeElement* element) {
+    VoxelTreeElement* voxel = (VoxelTreeElement*)element;
+    result.voxel.x = voxel->getCorner().x;
+    result.voxel.y = voxel->getCorner().y;
+    result.voxel.z = voxel->getCorner().z;
+    result.voxel.s = voxel->getScale();
+    result.voxel.red = voxel->getColor()[0];
+    result.voxel.green = voxel->getColor()[1];
+    result.voxel.blue = voxel->getColor()[2];
+    result.intersection = ray.origin + (ray.direction * result.distance);
+}
+
+RayToVoxelIntersectionResult VoxelTree::findRayToVoxelIntersection(const PickRay& ray) {
+    RayToVoxelIntersectionResult result;
+    OctreeElement* element;
+    result.intersects = findRayIntersection(ray.origin, ray.direction, element, result.distance, result.face);
+    if (result.intersects) {
+        setIntersectedVoxel(result, ray, element);
+    }
+    return result;
+}
+
+QVector<RayToVoxelIntersectionResult> VoxelTree::findRayToVoxelIntersections(const QVector<PickRay>& rays) {
+    QVector<OctreeRayIntersection> intersections(rays.size());
+    for (int i = 0; i < rays.size(); i++) {
+        intersections[i].origin = rays[i].origin;
+        intersections[i].direction = rays[i].direction;
+    }
+    findRayIntersections(intersections.data(), intersections.size());
+
+    QVector<RayToVoxelIntersectionResult> results(rays.size());
+    for (int i = 0; i < rays.size(); i++) {
+        RayToVoxelIntersectionResult& result = results[i];
+        result.intersects = intersections[i].intersects;
+        if (result.intersects) {
+            result.distance = intersections[i].distance;
+            result.face = intersections[i].face;
+            setIntersectedVoxel(result, rays[i], intersections[i].element);
+        }
+    }
+    return results;
+}
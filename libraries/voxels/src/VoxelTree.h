@@ -13,7 +13,9 @@
 #define hifi_VoxelTree_h
 
 #include <Octree.h>
+#include <RegisteredMetaTypes.h>
 
+#include "VoxelDetail.h"
 #include "VoxelTreeElement.h"
 #include "VoxelEditPacketSender.h"
 
@@ -35,6 +37,12 @@ public:
 
     void nudgeSubTree(VoxelTreeElement* elementToNudge, const glm::vec3& nudgeAmount, VoxelEditPacketSender& voxelEditSender);
 
+    /// casts a script's pick ray and fills in the voxel it hits, for the script interfaces to the tree
+    RayToVoxelIntersectionResult findRayToVoxelIntersection(const PickRay& ray);
+
+    /// casts a script's pick rays as one batch, see Octree::findRayIntersections
+    QVector<RayToVoxelIntersectionResult> findRayToVoxelIntersections(const QVector<PickRay>& rays);
+
     /// reads voxels from square image with alpha as a Y-axis
     bool readFromSquareARGB32Pixels(const char *filename);
 
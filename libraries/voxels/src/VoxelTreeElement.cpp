@@ -25,7 +25,6 @@ VoxelTreeElement::VoxelTreeElement(unsigned char* octalCode) :
 };
 
 VoxelTreeElement::~VoxelTreeElement() {
-    _voxelMemoryUsage -= sizeof(VoxelTreeElement);
 }
 
 // This will be called primarily on addChildAt(), which means we're adding a child of our
@@ -33,7 +32,7 @@ VoxelTreeElement::~VoxelTreeElement() {
 // specific settings that our children must have. One example is out VoxelSystem, which
 // we know must match ours.
 OctreeElement* VoxelTreeElement::createNewElement(unsigned char* octalCode) {
-    VoxelTreeElement* newChild = new VoxelTreeElement(octalCode);
+    VoxelTreeElement* newChild = new (getAllocator()) VoxelTreeElement(octalCode);
     newChild->setVoxelSystem(getVoxelSystem()); // our child is always part of our voxel system NULL ok
     return newChild;
 }
@@ -45,7 +44,6 @@ void VoxelTreeElement::init(unsigned char* octalCode) {
     _color[0] = _color[1] = _color[2] = _color[3] = 0;
     _density = 0.0f;
     OctreeElement::init(octalCode);
-    _voxelMemoryUsage += sizeof(VoxelTreeElement);
 }
 
 bool VoxelTreeElement::requiresSplit() const {
@@ -224,15 +222,16 @@ bool VoxelTreeElement::collapseChildren() {
 
 bool VoxelTreeElement::findSpherePenetration(const glm::vec3& center, float radius,
                                     glm::vec3& penetration, void** penetratedObject) const {
-    if (_box.findSpherePenetration(center, radius, penetration)) {
+    AABox box = getAABox();
+    if (box.findSpherePenetration(center, radius, penetration)) {
 
         // if the caller wants details about the voxel, then return them here...
         if (penetratedObject) {
             VoxelDetail* voxelDetails = new VoxelDetail;
-            voxelDetails->x = _box.getCorner().x;
-            voxelDetails->y = _box.getCorner().y;
-            voxelDetails->z = _box.getCorner().z;
-            voxelDetails->s = _box.getScale();
+            voxelDetails->x = box.getCorner().x;
+            voxelDetails->y = box.getCorner().y;
+            voxelDetails->z = box.getCorner().z;
+            voxelDetails->s = box.getScale();
             voxelDetails->red = getColor()[RED_INDEX];
             voxelDetails->green = getColor()[GREEN_INDEX];
             voxelDetails->blue = getColor()[BLUE_INDEX];
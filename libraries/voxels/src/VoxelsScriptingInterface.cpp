@@ -142,23 +142,18 @@ void VoxelsScriptingInterface::eraseVoxel(float x, float y, float z, float scale
 RayToVoxelIntersectionResult VoxelsScriptingInterface::findRayIntersection(const PickRay& ray) {
     RayToVoxelIntersectionResult result;
     if (_tree) {
-        OctreeElement* element;
-        result.intersects = _tree->findRayIntersection(ray.origin, ray.direction, element, result.distance, result.face);
-        if (result.intersects) {
-            VoxelTreeElement* voxel = (VoxelTreeElement*)element;
-            result.voxel.x = voxel->getCorner().x;
-            result.voxel.y = voxel->getCorner().y;
-            result.voxel.z = voxel->getCorner().z;
-            result.voxel.s = voxel->getScale();
-            result.voxel.red = voxel->getColor()[0];
-            result.voxel.green = voxel->getColor()[1];
-            result.voxel.blue = voxel->getColor()[2];
-            result.intersection = ray.origin + (ray.direction * result.distance);
-        }
+        result = _tree->findRayToVoxelIntersection(ray);
     }
     return result;
 }
 
+QVector<RayToVoxelIntersectionResult> VoxelsScriptingInterface::findRayIntersections(const QVector<PickRay>& rays) {
+    if (!_tree) {
+        return QVector<RayToVoxelIntersectionResult>(rays.size());
+    }
+    return _tree->findRayToVoxelIntersections(rays);
+}
+
 glm::vec3 VoxelsScriptingInterface::getFaceVector(const QString& face) {
     if (face == "MIN_X_FACE") {
         return glm::vec3(-1, 0, 0);
@@ -77,6 +77,9 @@ public slots:
     /// If the scripting context has visible voxels, this will determine a ray intersection
     RayToVoxelIntersectionResult findRayIntersection(const PickRay& ray);
 
+    /// casts a batch of rays together, cheaper than a findRayIntersection call per ray for many rays at once
+    QVector<RayToVoxelIntersectionResult> findRayIntersections(const QVector<PickRay>& rays);
+
     /// returns a voxel space axis aligned vector for the face, useful in doing voxel math
     glm::vec3 getFaceVector(const QString& face);
     
@@ -0,0 +1,176 @@
+//
+//  AudioMixerBenchmark.cpp
+//  tests/audio-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtNetwork/QUdpSocket>
+
+#include <Assignment.h>
+#include <JitterBufferDepth.h>
+#include <MixedAudioCodec.h>
+#include <NodeList.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+
+#include "AudioMixer.h"
+#include "AudioMixerClientData.h"
+
+#include "AudioMixerBenchmark.h"
+
+// enough frames for every stream to fill the deepest jitter buffer it could ask for and start mixing
+const int WARM_UP_FRAMES = 2 * (MAX_JITTER_BUFFER_FRAMES + 1);
+
+const float SIGNAL_AMPLITUDE = 8000.0f;
+const float MIN_TONE_HZ = 200.0f;
+const float MAX_TONE_HZ = 800.0f;
+
+struct SyntheticAgent {
+    SharedNodePointer node;
+    QByteArray packetPrefix;
+    float tonePhase;
+    float tonePhaseStep;
+};
+
+static AudioMixer* createAudioMixer(const QString& payload) {
+    Assignment assignment(Assignment::CreateCommand, Assignment::AudioMixerType);
+    assignment.setPayload(payload.toUtf8());
+    
+    QByteArray assignmentPacket = byteArrayWithPopulatedHeader(PacketTypeCreateAssignment);
+    QDataStream assignmentStream(&assignmentPacket, QIODevice::Append);
+    assignmentStream << assignment;
+    
+    return new AudioMixer(assignmentPacket);
+}
+
+// the microphone packet of an agent up to its samples, which is the same every frame
+static QByteArray microphonePacketPrefix(const glm::vec3& position, const glm::quat& orientation) {
+    QByteArray packetPrefix = byteArrayWithPopulatedHeader(PacketTypeMicrophoneAudioNoEcho);
+    
+    packetPrefix.append(reinterpret_cast<const char*>(&position), sizeof(position));
+    packetPrefix.append(reinterpret_cast<const char*>(&orientation), sizeof(orientation));
+    packetPrefix.append((char) SUPPORTED_MIXED_AUDIO_ENCODINGS);
+    
+    return packetPrefix;
+}
+
+static void fillSamples(SyntheticAgent& agent, bool isNoise, int16_t* samples) {
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+        if (isNoise) {
+            samples[i] = randFloatInRange(-SIGNAL_AMPLITUDE, SIGNAL_AMPLITUDE);
+        } else {
+            samples[i] = SIGNAL_AMPLITUDE * sinf(agent.tonePhase);
+            agent.tonePhase = fmodf(agent.tonePhase + agent.tonePhaseStep, TWO_PI);
+        }
+    }
+}
+
+static qint64 percentile(const std::vector<qint64>& sortedValues, float fraction) {
+    int index = std::min((int) (fraction * sortedValues.size()), (int) sortedValues.size() - 1);
+    return sortedValues[index];
+}
+
+void AudioMixerBenchmark::runBenchmark(const QStringList& arguments) {
+    QStringList mixerArguments = arguments;
+    
+    int numAgents = takeCmdOption(mixerArguments, "--agents", "100").toInt();
+    int numFrames = takeCmdOption(mixerArguments, "--frames", "1000").toInt();
+    float spread = takeCmdOption(mixerArguments, "--spread", "20").toFloat();
+    bool isFacingCenter = takeCmdOption(mixerArguments, "--facing", "random") == "center";
+    bool isNoise = takeCmdOption(mixerArguments, "--signal", "tone") == "noise";
+    srand(takeCmdOption(mixerArguments, "--seed", "1").toUInt());
+    
+    if (numAgents < 1 || numFrames < 1) {
+        std::cout << "Need at least one agent and one frame." << std::endl;
+        return;
+    }
+    
+    NodeList::createInstance(NodeType::AudioMixer);
+    
+    // the mixed audio goes to a loopback socket nothing reads, so sending costs what it would for real clients
+    QUdpSocket listenerSocket;
+    listenerSocket.bind(QHostAddress::LocalHost, 0);
+    HifiSockAddr listenerSockAddr(QHostAddress::LocalHost, listenerSocket.localPort());
+    
+    AudioMixer* audioMixer = createAudioMixer(mixerArguments.join(" "));
+    audioMixer->prepareToMix();
+    
+    NodeHash nodeHash;
+    std::vector<SyntheticAgent> agents(numAgents);
+    
+    for (int i = 0; i < numAgents; i++) {
+        glm::vec3 position = glm::vec3(randFloat(), randFloat(), randFloat()) * spread;
+        
+        glm::vec3 center = glm::vec3(0.5f, 0.5f, 0.5f) * spread;
+        float yaw = isFacingCenter ? atan2f(position.x - center.x, position.z - center.z) : randFloat() * TWO_PI;
+        glm::quat orientation = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+        
+        SyntheticAgent& agent = agents[i];
+        agent.node = SharedNodePointer(new Node(QUuid::createUuid(), NodeType::Agent,
+                                                listenerSockAddr, listenerSockAddr));
+        agent.node->activatePublicSocket();
+        agent.node->setLinkedData(new AudioMixerClientData());
+        agent.packetPrefix = microphonePacketPrefix(position, orientation);
+        agent.tonePhase = 0.0f;
+        agent.tonePhaseStep = TWO_PI * randFloatInRange(MIN_TONE_HZ, MAX_TONE_HZ) / SAMPLE_RATE;
+        
+        nodeHash.insert(agent.node->getUUID(), agent.node);
+    }
+    
+    std::vector<qint64> frameUsecs;
+    frameUsecs.reserve(numFrames);
+    int numMixes = 0;
+    int lastFrameUsecs = 0;
+    
+    int16_t samples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+    QElapsedTimer frameTimer;
+    
+    for (int frame = 0; frame < WARM_UP_FRAMES + numFrames; frame++) {
+        // every agent sends one frame for every frame mixed, parsing them is not part of the timing
+        for (int i = 0; i < numAgents; i++) {
+            fillSamples(agents[i], isNoise, samples);
+            
+            QByteArray packet = agents[i].packetPrefix;
+            packet.append(reinterpret_cast<const char*>(samples), sizeof(samples));
+            agents[i].node->getLinkedData()->parseData(packet);
+        }
+        
+        // the mixer throttles on the time the last frame left it, as if it were running in real time
+        audioMixer->updatePerformanceThrottling(BUFFER_SEND_INTERVAL_USECS - lastFrameUsecs);
+        
+        frameTimer.start();
+        int frameMixes = audioMixer->mixFrame(nodeHash);
+        lastFrameUsecs = frameTimer.nsecsElapsed() / 1000;
+        
+        if (frame >= WARM_UP_FRAMES) {
+            frameUsecs.push_back(lastFrameUsecs);
+            numMixes += frameMixes;
+        }
+    }
+    
+    std::sort(frameUsecs.begin(), frameUsecs.end());
+    
+    std::cout << "Mixed " << numAgents << " agents for " << numFrames << " frames, the frame budget is "
+        << BUFFER_SEND_INTERVAL_USECS << " usecs." << std::endl;
+    std::cout << "Frame usecs: 50% " << percentile(frameUsecs, 0.5f) << ", 90% " << percentile(frameUsecs, 0.9f)
+        << ", 99% " << percentile(frameUsecs, 0.99f) << ", max " << frameUsecs.back() << std::endl;
+    std::cout << "Average mixes per listener: " << (float) numMixes / ((float) numFrames * numAgents) << std::endl;
+    std::cout << "Performance throttling ratio reached: " << audioMixer->getPerformanceThrottlingRatio() << std::endl;
+    
+    delete audioMixer;
+}
@@ -0,0 +1,30 @@
+//
+//  AudioMixerBenchmark.h
+//  tests/audio-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixerBenchmark_h
+#define hifi_AudioMixerBenchmark_h
+
+#include <QtCore/QStringList>
+
+/// Runs the audio mixer headless against synthetic agents and reports how long its frames take.
+///
+/// Options, each given as --option value:
+///   --agents      the number of agents, each both a source and a listener (100)
+///   --frames      the number of frames timed after the jitter buffers have filled (1000)
+///   --spread      the edge in meters of the cube the agents are scattered in (20)
+///   --facing      random, or center to turn every agent towards the middle of the cube (random)
+///   --signal      tone or noise (tone)
+///   --seed        the seed for the positions and the noise (1)
+/// Anything else is passed to the mixer as its assignment payload, for example --mixThreads 4.
+namespace AudioMixerBenchmark {
+    void runBenchmark(const QStringList& arguments);
+}
+
+#endif // hifi_AudioMixerBenchmark_h
@@ -0,0 +1,19 @@
+//
+//  main.cpp
+//  tests/audio-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QCoreApplication>
+
+#include "AudioMixerBenchmark.h"
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    AudioMixerBenchmark::runBenchmark(app.arguments().mid(1));
+    return 0;
+}
@@ -0,0 +1,124 @@
+//
+//  AudioLimiterTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cmath>
+#include <iostream>
+
+#include <AudioLimiter.h>
+#include <AudioRingBuffer.h>
+
+#include "AudioLimiterTests.h"
+
+const int NUM_FRAMES = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+const int LOUD_BLOCK = 4;
+
+// a tone on both channels, LOUD_MAGNITUDE in one block and QUIET_MAGNITUDE everywhere else
+static void fillMixBus(int32_t* mixBus, int32_t quietMagnitude, int32_t loudMagnitude) {
+    const float TONE_RADIANS_PER_FRAME = 0.3f;
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        bool isLoud = i / LIMITER_BLOCK_FRAMES == LOUD_BLOCK;
+        int32_t sample = (isLoud ? loudMagnitude : quietMagnitude) * sinf(i * TONE_RADIANS_PER_FRAME);
+
+        mixBus[i * 2] = sample;
+        mixBus[(i * 2) + 1] = -sample;
+    }
+}
+
+void AudioLimiterTests::passesQuietMixUnchanged() {
+    const int32_t QUIET_MAGNITUDE = 20000;
+
+    int32_t mixBus[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t outputSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    fillMixBus(mixBus, QUIET_MAGNITUDE, QUIET_MAGNITUDE);
+
+    AudioLimiter limiter;
+    limiter.render(mixBus, outputSamples, NUM_FRAMES);
+
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; i++) {
+        if (outputSamples[i] != mixBus[i]) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: quiet sample " << i << " is " << outputSamples[i]
+                << " but we expected " << mixBus[i] << std::endl;
+            return;
+        }
+    }
+
+    if (limiter.getGain() != 1.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gain is " << limiter.getGain()
+            << " after a quiet frame but we expected 1" << std::endl;
+    }
+}
+
+void AudioLimiterTests::attenuatesAheadOfPeak() {
+    const int32_t QUIET_MAGNITUDE = 10000;
+    const int32_t LOUD_MAGNITUDE = MAX_SAMPLE_VALUE * 4;
+
+    int32_t mixBus[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t outputSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    fillMixBus(mixBus, QUIET_MAGNITUDE, LOUD_MAGNITUDE);
+
+    AudioLimiter limiter;
+    limiter.render(mixBus, outputSamples, NUM_FRAMES);
+
+    // saturating the loud block would pin most of its peaks to the rails, the limiter should reach them at most once
+    int numSamplesAtLimit = 0;
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; i++) {
+        if (outputSamples[i] == MAX_SAMPLE_VALUE || outputSamples[i] == MIN_SAMPLE_VALUE) {
+            numSamplesAtLimit++;
+        }
+    }
+
+    const int MAX_SAMPLES_AT_LIMIT = 2;
+    if (numSamplesAtLimit > MAX_SAMPLES_AT_LIMIT) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << numSamplesAtLimit
+            << " samples are at the limit but we expected at most " << MAX_SAMPLES_AT_LIMIT << std::endl;
+    }
+
+    // the block before the peak is in the look-ahead window so it should already be on its way down
+    int lastFrameBeforePeak = (LOUD_BLOCK * LIMITER_BLOCK_FRAMES) - 1;
+    float gainBeforePeak = (float) outputSamples[lastFrameBeforePeak * 2] / mixBus[lastFrameBeforePeak * 2];
+    if (mixBus[lastFrameBeforePeak * 2] != 0 && gainBeforePeak > 0.5f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gain before the peak is " << gainBeforePeak
+            << " but we expected the limiter to have attacked" << std::endl;
+    }
+}
+
+void AudioLimiterTests::releasesAfterPeak() {
+    const int32_t QUIET_MAGNITUDE = 10000;
+    const int32_t LOUD_MAGNITUDE = MAX_SAMPLE_VALUE * 4;
+    const int MAX_RELEASE_FRAMES = 50;
+
+    int32_t mixBus[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t outputSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+
+    AudioLimiter limiter;
+    fillMixBus(mixBus, QUIET_MAGNITUDE, LOUD_MAGNITUDE);
+    limiter.render(mixBus, outputSamples, NUM_FRAMES);
+
+    if (limiter.getGain() >= 1.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gain is back to 1 right after the peak" << std::endl;
+    }
+
+    fillMixBus(mixBus, QUIET_MAGNITUDE, QUIET_MAGNITUDE);
+    for (int frame = 0; frame < MAX_RELEASE_FRAMES && limiter.getGain() < 1.0f; frame++) {
+        limiter.render(mixBus, outputSamples, NUM_FRAMES);
+    }
+
+    if (limiter.getGain() != 1.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: gain is " << limiter.getGain() << " after "
+            << MAX_RELEASE_FRAMES << " quiet frames but we expected 1" << std::endl;
+    }
+}
+
+void AudioLimiterTests::runAllTests() {
+    passesQuietMixUnchanged();
+    attenuatesAheadOfPeak();
+    releasesAfterPeak();
+}
@@ -0,0 +1,22 @@
+//
+//  AudioLimiterTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioLimiterTests_h
+#define hifi_AudioLimiterTests_h
+
+namespace AudioLimiterTests {
+    void passesQuietMixUnchanged();
+    void attenuatesAheadOfPeak();
+    void releasesAfterPeak();
+
+    void runAllTests();
+}
+
+#endif // hifi_AudioLimiterTests_h
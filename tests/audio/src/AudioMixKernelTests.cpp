@@ -0,0 +1,201 @@
+//
+//  AudioMixKernelTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <AudioMixKernel.h>
+
+#include "AudioMixKernelTests.h"
+
+// the per-sample arithmetic of the MMX mix loop AudioMixer used before AudioMixKernel, adding to a 32-bit bus
+static void referenceMix(int32_t* mixBus, const int16_t* frameSamples, const int16_t* delayHistory,
+                         const SpatializedMixParameters& parameters) {
+    int delayedChannelOffset = parameters.isRightChannelDelayed ? 1 : 0;
+    int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+    const int SINGLE_STEREO_OFFSET = 2;
+
+    for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
+        int16_t correctBufferSample[2], delayBufferSample[2];
+        correctBufferSample[0] = frameSamples[s / 2] * parameters.attenuationCoefficient;
+        correctBufferSample[1] = frameSamples[(s / 2) + 1] * parameters.attenuationCoefficient;
+
+        int delayedChannelIndex = s + (parameters.numSamplesDelay * 2) + delayedChannelOffset;
+
+        delayBufferSample[0] = correctBufferSample[0] * parameters.weakChannelAmplitudeRatio;
+        delayBufferSample[1] = correctBufferSample[1] * parameters.weakChannelAmplitudeRatio;
+
+        mixBus[s + goodChannelOffset] += correctBufferSample[0];
+        mixBus[s + goodChannelOffset + SINGLE_STEREO_OFFSET] += correctBufferSample[1];
+        mixBus[delayedChannelIndex] += delayBufferSample[0];
+        mixBus[delayedChannelIndex + SINGLE_STEREO_OFFSET] += delayBufferSample[1];
+    }
+
+    float attenuationAndWeakChannelRatio = parameters.attenuationCoefficient * parameters.weakChannelAmplitudeRatio;
+    for (int i = 0; i < parameters.numSamplesDelay; i++) {
+        int16_t delaySample = delayHistory[i] * attenuationAndWeakChannelRatio;
+        mixBus[(i * 2) + delayedChannelOffset] += delaySample;
+    }
+}
+
+static int16_t randomSample(int16_t maxMagnitude) {
+    return (rand() % (2 * maxMagnitude + 1)) - maxMagnitude;
+}
+
+static float randomRatio(float min, float max) {
+    return min + (max - min) * ((float) rand() / RAND_MAX);
+}
+
+static int32_t randomBusSample(int32_t maxMagnitude) {
+    return (int32_t) (randomRatio(-1.0f, 1.0f) * maxMagnitude);
+}
+
+static bool compareAgainstReference(AudioMixKernel::InstructionSet instructionSet, int32_t startingMixMagnitude,
+                                    int numTrials) {
+    int16_t frameSamples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+    int16_t delayHistory[SAMPLE_PHASE_DELAY_AT_90];
+    int32_t referenceSamples[SPATIALIZED_MIX_BUFFER_SAMPLES];
+    int32_t kernelSamples[SPATIALIZED_MIX_BUFFER_SAMPLES];
+
+    for (int trial = 0; trial < numTrials; trial++) {
+        for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+            frameSamples[i] = randomSample(MAX_SAMPLE_VALUE);
+        }
+        for (int i = 0; i < SAMPLE_PHASE_DELAY_AT_90; i++) {
+            delayHistory[i] = randomSample(MAX_SAMPLE_VALUE);
+        }
+        for (int i = 0; i < SPATIALIZED_MIX_BUFFER_SAMPLES; i++) {
+            referenceSamples[i] = randomBusSample(startingMixMagnitude);
+        }
+        memcpy(kernelSamples, referenceSamples, sizeof(kernelSamples));
+
+        SpatializedMixParameters parameters;
+        parameters.attenuationCoefficient = randomRatio(0.0f, 1.0f);
+        parameters.weakChannelAmplitudeRatio = randomRatio(0.5f, 1.0f);
+        parameters.numSamplesDelay = trial % (SAMPLE_PHASE_DELAY_AT_90 + 1);
+        parameters.isRightChannelDelayed = (trial / 2) % 2 == 0;
+
+        referenceMix(referenceSamples, frameSamples, delayHistory, parameters);
+        AudioMixKernel::addSpatializedFrameWithInstructionSet(instructionSet, kernelSamples, frameSamples,
+                                                              delayHistory, parameters);
+
+        for (int i = 0; i < SPATIALIZED_MIX_BUFFER_SAMPLES; i++) {
+            if (kernelSamples[i] != referenceSamples[i]) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: "
+                    << AudioMixKernel::getInstructionSetName(instructionSet) << " mix sample " << i
+                    << " is " << kernelSamples[i] << " but we expected " << referenceSamples[i]
+                    << " (delay " << parameters.numSamplesDelay << ")" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void AudioMixKernelTests::matchesReferenceMix() {
+    const int NUM_TRIALS = 200;
+    const int32_t QUIET_MIX_MAGNITUDE = 1000;
+
+    for (int set = AudioMixKernel::Scalar; set <= AudioMixKernel::getBestAvailableInstructionSet(); set++) {
+        compareAgainstReference((AudioMixKernel::InstructionSet) set, QUIET_MIX_MAGNITUDE, NUM_TRIALS);
+    }
+}
+
+void AudioMixKernelTests::accumulatesPastSampleRange() {
+    const int NUM_TRIALS = 200;
+
+    // a bus that already holds several loud sources is well outside int16_t and must not clip on the add
+    const int32_t LOUD_MIX_MAGNITUDE = MAX_SAMPLE_VALUE * 8;
+
+    for (int set = AudioMixKernel::Scalar; set <= AudioMixKernel::getBestAvailableInstructionSet(); set++) {
+        compareAgainstReference((AudioMixKernel::InstructionSet) set, LOUD_MIX_MAGNITUDE, NUM_TRIALS);
+    }
+}
+
+void AudioMixKernelTests::saturatesMixBus() {
+    // an odd count so the vector paths also go through their tail
+    const int NUM_SAMPLES = 101;
+    const int32_t LOUD_MIX_MAGNITUDE = MAX_SAMPLE_VALUE * 4;
+
+    int32_t mixBus[NUM_SAMPLES];
+    int16_t outputSamples[NUM_SAMPLES];
+
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        mixBus[i] = randomBusSample(LOUD_MIX_MAGNITUDE);
+    }
+
+    for (int set = AudioMixKernel::Scalar; set <= AudioMixKernel::getBestAvailableInstructionSet(); set++) {
+        AudioMixKernel::saturateMixBusWithInstructionSet((AudioMixKernel::InstructionSet) set, mixBus, outputSamples,
+                                                         NUM_SAMPLES);
+
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            int32_t expected = std::max(std::min(mixBus[i], (int32_t) MAX_SAMPLE_VALUE), (int32_t) MIN_SAMPLE_VALUE);
+
+            if (outputSamples[i] != expected) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: "
+                    << AudioMixKernel::getInstructionSetName((AudioMixKernel::InstructionSet) set)
+                    << " saturated sample " << i << " is " << outputSamples[i] << " but we expected " << expected
+                    << std::endl;
+                break;
+            }
+        }
+    }
+}
+
+void AudioMixKernelTests::clearsReusedMixBus() {
+    // a mixer reuses one bus for every frame, as long as it stays up
+    const int NUM_FRAMES = 10000;
+
+    int16_t frameSamples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+    int16_t delayHistory[SAMPLE_PHASE_DELAY_AT_90];
+    int32_t reusedMixBus[SPATIALIZED_MIX_BUFFER_SAMPLES];
+    int32_t freshMixBus[SPATIALIZED_MIX_BUFFER_SAMPLES];
+    memset(reusedMixBus, 0, sizeof(reusedMixBus));
+
+    // loud and delayed as far as it goes, so that the most lands in the tail past the network buffer
+    SpatializedMixParameters parameters;
+    parameters.attenuationCoefficient = 1.0f;
+    parameters.weakChannelAmplitudeRatio = 1.0f;
+    parameters.numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90;
+
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+            frameSamples[i] = randomSample(MAX_SAMPLE_VALUE);
+        }
+        for (int i = 0; i < SAMPLE_PHASE_DELAY_AT_90; i++) {
+            delayHistory[i] = randomSample(MAX_SAMPLE_VALUE);
+        }
+        parameters.isRightChannelDelayed = frame % 2 == 0;
+
+        AudioMixKernel::clearMixBus(reusedMixBus);
+        AudioMixKernel::addSpatializedFrame(reusedMixBus, frameSamples, delayHistory, parameters);
+
+        memset(freshMixBus, 0, sizeof(freshMixBus));
+        referenceMix(freshMixBus, frameSamples, delayHistory, parameters);
+
+        for (int i = 0; i < SPATIALIZED_MIX_BUFFER_SAMPLES; i++) {
+            if (reusedMixBus[i] != freshMixBus[i]) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: frame " << frame << " reused mix sample " << i
+                    << " is " << reusedMixBus[i] << " but a fresh bus has " << freshMixBus[i] << std::endl;
+                return;
+            }
+        }
+    }
+}
+
+void AudioMixKernelTests::runAllTests() {
+    matchesReferenceMix();
+    accumulatesPastSampleRange();
+    saturatesMixBus();
+    clearsReusedMixBus();
+}
@@ -0,0 +1,23 @@
+//
+//  AudioMixKernelTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixKernelTests_h
+#define hifi_AudioMixKernelTests_h
+
+namespace AudioMixKernelTests {
+    void matchesReferenceMix();
+    void accumulatesPastSampleRange();
+    void saturatesMixBus();
+    void clearsReusedMixBus();
+
+    void runAllTests();
+}
+
+#endif // hifi_AudioMixKernelTests_h
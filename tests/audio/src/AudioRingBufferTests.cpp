@@ -0,0 +1,185 @@
+//
+//  AudioRingBufferTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <QtCore/QThread>
+
+#include <AudioRingBuffer.h>
+#include <MixedAudioRingBuffer.h>
+#include <PacketHeaders.h>
+
+#include "AudioRingBufferTests.h"
+
+const int FRAME_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+
+// every sample written is the running sample count, so a reader can tell a skipped or torn frame
+static void fillFrame(int16_t* frame, int frameNumber) {
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        frame[i] = (frameNumber * FRAME_SAMPLES + i) & MAX_SAMPLE_VALUE;
+    }
+}
+
+static bool checkFrame(const int16_t* frame, int frameNumber, int line) {
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        int16_t expectedSample = (frameNumber * FRAME_SAMPLES + i) & MAX_SAMPLE_VALUE;
+        if (frame[i] != expectedSample) {
+            std::cout << __FILE__ << ":" << line << " ERROR: sample " << i << " of frame " << frameNumber << " is "
+                << frame[i] << " but we expected " << expectedSample << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void AudioRingBufferTests::readsAcrossWrap() {
+    AudioRingBuffer ringBuffer(FRAME_SAMPLES, false, true);
+    int16_t frame[FRAME_SAMPLES];
+
+    // keep the buffer a few frames deep so the positions go around the end more than once
+    const int BUFFERED_FRAMES = 3;
+    const int NUM_FRAMES = RING_BUFFER_LENGTH_FRAMES * 3;
+    int numFramesRead = 0;
+
+    for (int frameNumber = 0; frameNumber < NUM_FRAMES; frameNumber++) {
+        fillFrame(frame, frameNumber);
+        ringBuffer.writeSamples(frame, FRAME_SAMPLES);
+
+        if (frameNumber >= BUFFERED_FRAMES) {
+            if (ringBuffer.readSamples(frame, FRAME_SAMPLES) != FRAME_SAMPLES * (int) sizeof(int16_t)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: could not read frame " << numFramesRead
+                    << std::endl;
+                return;
+            }
+            if (!checkFrame(frame, numFramesRead++, __LINE__)) {
+                return;
+            }
+        }
+    }
+
+    if ((int) ringBuffer.samplesAvailable() != BUFFERED_FRAMES * FRAME_SAMPLES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << ringBuffer.samplesAvailable()
+            << " samples left but we expected " << BUFFERED_FRAMES * FRAME_SAMPLES << std::endl;
+    }
+}
+
+void AudioRingBufferTests::dropsWhenFullInLockFreeMode() {
+    AudioRingBuffer ringBuffer(FRAME_SAMPLES, false, true);
+    int16_t frame[FRAME_SAMPLES];
+
+    // one frame stays clear behind the read position, so one fewer than the ring's length fits
+    const int MAX_BUFFERED_FRAMES = RING_BUFFER_LENGTH_FRAMES - 1;
+
+    for (int frameNumber = 0; frameNumber < RING_BUFFER_LENGTH_FRAMES + 2; frameNumber++) {
+        fillFrame(frame, frameNumber);
+        ringBuffer.writeSamples(frame, FRAME_SAMPLES);
+    }
+
+    if ((int) ringBuffer.samplesAvailable() != MAX_BUFFERED_FRAMES * FRAME_SAMPLES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << ringBuffer.samplesAvailable()
+            << " samples buffered but we expected " << MAX_BUFFERED_FRAMES * FRAME_SAMPLES << std::endl;
+        return;
+    }
+
+    // the frames that did not fit are the ones lost, what was already buffered is untouched
+    for (int frameNumber = 0; frameNumber < MAX_BUFFERED_FRAMES; frameNumber++) {
+        ringBuffer.readSamples(frame, FRAME_SAMPLES);
+        if (!checkFrame(frame, frameNumber, __LINE__)) {
+            return;
+        }
+    }
+}
+
+// writes numbered frames as fast as the ring has room for them
+class RingBufferWriter : public QThread {
+public:
+    RingBufferWriter(AudioRingBuffer& ringBuffer, int numFrames) : _ringBuffer(ringBuffer), _numFrames(numFrames) { }
+
+protected:
+    void run() {
+        int16_t frame[FRAME_SAMPLES];
+
+        for (int frameNumber = 0; frameNumber < _numFrames; frameNumber++) {
+            // wait for room rather than have the ring drop the frame
+            while (_ringBuffer.getSampleCapacity() - (int) _ringBuffer.samplesAvailable() < 2 * FRAME_SAMPLES) {
+                yieldCurrentThread();
+            }
+
+            fillFrame(frame, frameNumber);
+            _ringBuffer.writeSamples(frame, FRAME_SAMPLES);
+        }
+    }
+
+private:
+    AudioRingBuffer& _ringBuffer;
+    int _numFrames;
+};
+
+void AudioRingBufferTests::passesFramesBetweenThreads() {
+    const int NUM_THREADED_FRAMES = 20000;
+
+    AudioRingBuffer ringBuffer(FRAME_SAMPLES, false, true);
+    RingBufferWriter writer(ringBuffer, NUM_THREADED_FRAMES);
+    writer.start();
+
+    // read the frames in place as the mixer does, then give their space back
+    for (int frameNumber = 0; frameNumber < NUM_THREADED_FRAMES; frameNumber++) {
+        while ((int) ringBuffer.samplesAvailable() < FRAME_SAMPLES) {
+            QThread::yieldCurrentThread();
+        }
+
+        if (!checkFrame(ringBuffer.getNextOutput(), frameNumber, __LINE__)) {
+            break;
+        }
+        ringBuffer.shiftReadPosition(FRAME_SAMPLES);
+    }
+
+    writer.wait();
+}
+
+void AudioRingBufferTests::dropsMalformedSilentFrames() {
+    MixedAudioRingBuffer ringBuffer(NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+    
+    // a packet cut off before its count, then counts that are negative or more than the ring holds
+    QByteArray truncatedPacket = byteArrayWithPopulatedHeader(PacketTypeSilentAudioFrame);
+    ringBuffer.parseData(truncatedPacket);
+    
+    const int16_t BAD_SILENT_SAMPLE_COUNTS[] = { -NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, 0, MAX_SAMPLE_VALUE };
+    for (int i = 0; i < (int) (sizeof(BAD_SILENT_SAMPLE_COUNTS) / sizeof(int16_t)); i++) {
+        QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeSilentAudioFrame);
+        packet.append((const char*) &BAD_SILENT_SAMPLE_COUNTS[i], sizeof(int16_t));
+        ringBuffer.parseData(packet);
+    }
+    
+    if (ringBuffer.samplesAvailable() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << ringBuffer.samplesAvailable()
+            << " samples of silence added from malformed packets but we expected none" << std::endl;
+        return;
+    }
+    
+    // silence asked of the ring directly is clamped to what it holds, which leaves it usable afterwards
+    AudioRingBuffer directRingBuffer(FRAME_SAMPLES);
+    directRingBuffer.addSilentFrame(directRingBuffer.getSampleCapacity() * 2);
+    directRingBuffer.addSilentFrame(-FRAME_SAMPLES);
+    directRingBuffer.reset();
+    
+    int16_t frame[FRAME_SAMPLES];
+    fillFrame(frame, 0);
+    directRingBuffer.writeSamples(frame, FRAME_SAMPLES);
+    directRingBuffer.readSamples(frame, FRAME_SAMPLES);
+    checkFrame(frame, 0, __LINE__);
+}
+
+void AudioRingBufferTests::runAllTests() {
+    readsAcrossWrap();
+    dropsWhenFullInLockFreeMode();
+    passesFramesBetweenThreads();
+    dropsMalformedSilentFrames();
+}
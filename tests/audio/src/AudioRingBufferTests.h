@@ -0,0 +1,23 @@
+//
+//  AudioRingBufferTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioRingBufferTests_h
+#define hifi_AudioRingBufferTests_h
+
+namespace AudioRingBufferTests {
+    void readsAcrossWrap();
+    void dropsWhenFullInLockFreeMode();
+    void passesFramesBetweenThreads();
+    void dropsMalformedSilentFrames();
+
+    void runAllTests();
+}
+
+#endif // hifi_AudioRingBufferTests_h
@@ -0,0 +1,190 @@
+//
+//  AudioSourceGeometryTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstdlib>
+#include <iostream>
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/vector_angle.hpp>
+
+#include <AudioSourceGeometry.h>
+#include <PositionalAudioRingBuffer.h>
+#include <SharedUtil.h>
+
+#include "AudioSourceGeometryTests.h"
+
+const float LOUDNESS_THRESHOLD = 0.0015f;
+
+// lets the tests place a microphone buffer without building audio packets
+class PlacedAudioRingBuffer : public PositionalAudioRingBuffer {
+public:
+    PlacedAudioRingBuffer() : PositionalAudioRingBuffer(PositionalAudioRingBuffer::Microphone) { }
+
+    void place(const glm::vec3& position, const glm::quat& orientation, float loudness) {
+        _position = position;
+        _orientation = orientation;
+        _nextOutputTrailingLoudness = loudness;
+    }
+};
+
+// the per-pair spatialization math AudioMixer used before AudioSourceGeometry, for microphone sources
+static SpatializedMixParameters referenceParameters(const PositionalAudioRingBuffer& source,
+                                                    const PositionalAudioRingBuffer& listener) {
+    glm::vec3 relativePosition = source.getPosition() - listener.getPosition();
+
+    glm::vec3 rotatedListenerPosition = glm::inverse(source.getOrientation()) * relativePosition;
+    float angleOfDelivery = glm::angle(glm::vec3(0.0f, 0.0f, -1.0f), glm::normalize(rotatedListenerPosition));
+
+    const float MAX_OFF_AXIS_ATTENUATION = 0.2f;
+    const float OFF_AXIS_ATTENUATION_FORMULA_STEP = (1 - MAX_OFF_AXIS_ATTENUATION) / 2.0f;
+    float attenuationCoefficient = MAX_OFF_AXIS_ATTENUATION
+        + (OFF_AXIS_ATTENUATION_FORMULA_STEP * (angleOfDelivery / PI_OVER_TWO));
+
+    const float DISTANCE_SCALE = 2.5f;
+    const float GEOMETRIC_AMPLITUDE_SCALAR = 0.3f;
+    const float DISTANCE_LOG_BASE = 2.5f;
+    const float DISTANCE_SCALE_LOG = logf(DISTANCE_SCALE) / logf(DISTANCE_LOG_BASE);
+
+    float distanceSquareToSource = glm::dot(relativePosition, relativePosition);
+    float distanceCoefficient = powf(GEOMETRIC_AMPLITUDE_SCALAR,
+                                     DISTANCE_SCALE_LOG +
+                                     (0.5f * logf(distanceSquareToSource) / logf(DISTANCE_LOG_BASE)) - 1);
+    attenuationCoefficient *= std::min(1.0f, distanceCoefficient);
+
+    glm::vec3 rotatedSourcePosition = glm::inverse(listener.getOrientation()) * relativePosition;
+    rotatedSourcePosition.y = 0.0f;
+
+    float bearingRelativeAngleToSource = glm::orientedAngle(glm::vec3(0.0f, 0.0f, -1.0f),
+                                                            glm::normalize(rotatedSourcePosition),
+                                                            glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const float PHASE_AMPLITUDE_RATIO_AT_90 = 0.5;
+    float sinRatio = fabsf(sinf(bearingRelativeAngleToSource));
+
+    SpatializedMixParameters parameters;
+    parameters.attenuationCoefficient = attenuationCoefficient;
+    parameters.numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90 * sinRatio;
+    parameters.weakChannelAmplitudeRatio = 1 - (PHASE_AMPLITUDE_RATIO_AT_90 * sinRatio);
+    parameters.isRightChannelDelayed = bearingRelativeAngleToSource > 0.0f;
+    return parameters;
+}
+
+static glm::quat randomOrientation() {
+    return glm::normalize(glm::quat(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                    randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f)));
+}
+
+static glm::vec3 randomPosition(float range) {
+    return glm::vec3(randFloatInRange(-range, range), randFloatInRange(-range, range), randFloatInRange(-range, range));
+}
+
+void AudioSourceGeometryTests::matchesPerPairMath() {
+    const int NUM_SOURCES = 103;
+    const float POSITION_RANGE = 20.0f;
+
+    // enough loudness that every source is audible
+    const float LOUD = 1.0f;
+
+    PlacedAudioRingBuffer listener;
+    listener.place(randomPosition(POSITION_RANGE), randomOrientation(), LOUD);
+
+    PlacedAudioRingBuffer sources[NUM_SOURCES];
+    AudioSourceGeometry geometry;
+    QVector<int> sourceIndices;
+
+    for (int i = 0; i < NUM_SOURCES; i++) {
+        sources[i].place(randomPosition(POSITION_RANGE), randomOrientation(), LOUD);
+        geometry.addSource(&sources[i]);
+        sourceIndices.append(i);
+    }
+
+    QVector<int> audibleSourceIndices;
+    QVector<SpatializedMixParameters> audibleParameters;
+    geometry.computeAudibleMixParameters(listener.getPosition(), listener.getOrientation(), LOUDNESS_THRESHOLD,
+                                         sourceIndices, -1, audibleSourceIndices, audibleParameters);
+
+    if (audibleSourceIndices.size() != NUM_SOURCES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << audibleSourceIndices.size()
+            << " sources were audible but we expected " << NUM_SOURCES << std::endl;
+        return;
+    }
+
+    const float MAX_RELATIVE_ATTENUATION_ERROR = 0.001f;
+    const float MAX_WEAK_CHANNEL_ERROR = 0.001f;
+
+    for (int i = 0; i < NUM_SOURCES; i++) {
+        SpatializedMixParameters expected = referenceParameters(sources[i], listener);
+        const SpatializedMixParameters& actual = audibleParameters[i];
+
+        float attenuationError = fabsf(actual.attenuationCoefficient - expected.attenuationCoefficient)
+            / expected.attenuationCoefficient;
+        if (attenuationError > MAX_RELATIVE_ATTENUATION_ERROR) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: source " << i << " attenuation is "
+                << actual.attenuationCoefficient << " but we expected " << expected.attenuationCoefficient << std::endl;
+        }
+
+        if (fabsf(actual.weakChannelAmplitudeRatio - expected.weakChannelAmplitudeRatio) > MAX_WEAK_CHANNEL_ERROR) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: source " << i << " weak channel ratio is "
+                << actual.weakChannelAmplitudeRatio << " but we expected " << expected.weakChannelAmplitudeRatio
+                << std::endl;
+        }
+
+        // truncation of an approximated ratio can land one sample either side
+        if (abs(actual.numSamplesDelay - expected.numSamplesDelay) > 1) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: source " << i << " delay is "
+                << actual.numSamplesDelay << " but we expected " << expected.numSamplesDelay << std::endl;
+        }
+
+        if (expected.numSamplesDelay > 0 && actual.isRightChannelDelayed != expected.isRightChannelDelayed) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: source " << i << " delays the wrong channel" << std::endl;
+        }
+    }
+}
+
+void AudioSourceGeometryTests::skipsInaudibleSources() {
+    const float LOUDNESS = 0.03f;
+    const float AUDIBLE_DISTANCE = LOUDNESS / LOUDNESS_THRESHOLD;
+
+    PlacedAudioRingBuffer listener;
+    listener.place(glm::vec3(0.0f), glm::quat(), LOUDNESS);
+
+    PlacedAudioRingBuffer nearSource;
+    nearSource.place(glm::vec3(0.0f, 0.0f, -0.5f * AUDIBLE_DISTANCE), glm::quat(), LOUDNESS);
+
+    PlacedAudioRingBuffer farSource;
+    farSource.place(glm::vec3(0.0f, 0.0f, -2.0f * AUDIBLE_DISTANCE), glm::quat(), LOUDNESS);
+
+    AudioSourceGeometry geometry;
+    geometry.addSource(&listener);
+    geometry.addSource(&nearSource);
+    geometry.addSource(&farSource);
+
+    QVector<int> sourceIndices;
+    sourceIndices << 0 << 1 << 2;
+
+    QVector<int> audibleSourceIndices;
+    QVector<SpatializedMixParameters> audibleParameters;
+    geometry.computeAudibleMixParameters(listener.getPosition(), listener.getOrientation(), LOUDNESS_THRESHOLD,
+                                         sourceIndices, 0, audibleSourceIndices, audibleParameters);
+
+    if (audibleSourceIndices.size() != 2 || audibleSourceIndices[0] != 0 || audibleSourceIndices[1] != 1) {
+        std::cout << __FILE__ << ":" << __LINE__
+            << " ERROR: expected only the listener's own buffer and the near source to be audible" << std::endl;
+    } else if (audibleParameters[0].attenuationCoefficient != 1.0f || audibleParameters[0].numSamplesDelay != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the listener's own buffer should not be spatialized"
+            << std::endl;
+    }
+}
+
+void AudioSourceGeometryTests::runAllTests() {
+    matchesPerPairMath();
+    skipsInaudibleSources();
+}
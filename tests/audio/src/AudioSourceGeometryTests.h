@@ -0,0 +1,21 @@
+//
+//  AudioSourceGeometryTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceGeometryTests_h
+#define hifi_AudioSourceGeometryTests_h
+
+namespace AudioSourceGeometryTests {
+    void matchesPerPairMath();
+    void skipsInaudibleSources();
+
+    void runAllTests();
+}
+
+#endif // hifi_AudioSourceGeometryTests_h
@@ -0,0 +1,117 @@
+//
+//  JitterBufferDepthTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <AudioRingBuffer.h>
+#include <JitterBufferDepth.h>
+
+#include "JitterBufferDepthTests.h"
+
+const int NUM_PACKETS = 2000;
+const quint64 FIRST_ARRIVAL_USECS = 1000 * 1000;
+
+void JitterBufferDepthTests::staysShallowForSteadyStream() {
+    JitterBufferDepth jitterBufferDepth;
+
+    for (int i = 0; i < NUM_PACKETS; i++) {
+        jitterBufferDepth.packetArrived(FIRST_ARRIVAL_USECS + (quint64) i * BUFFER_SEND_INTERVAL_USECS);
+        jitterBufferDepth.frameMixed(0);
+    }
+
+    if (jitterBufferDepth.getDesiredFrames() != MIN_JITTER_BUFFER_FRAMES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: desired depth is " << jitterBufferDepth.getDesiredFrames()
+            << " frames for a steady stream but we expected " << MIN_JITTER_BUFFER_FRAMES << std::endl;
+    }
+}
+
+void JitterBufferDepthTests::deepensForJitteryStream() {
+    // every other packet is late by most of a frame
+    const quint64 LATENESS_USECS = BUFFER_SEND_INTERVAL_USECS * 3 / 4;
+
+    JitterBufferDepth jitterBufferDepth;
+
+    for (int i = 0; i < NUM_PACKETS; i++) {
+        quint64 lateness = (i % 2) ? LATENESS_USECS : 0;
+        jitterBufferDepth.packetArrived(FIRST_ARRIVAL_USECS + (quint64) i * BUFFER_SEND_INTERVAL_USECS + lateness);
+        jitterBufferDepth.frameMixed(jitterBufferDepth.getDesiredFrames());
+    }
+
+    if (jitterBufferDepth.getJitterUsecs() < (int) (LATENESS_USECS / 2)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: jitter is " << jitterBufferDepth.getJitterUsecs()
+            << " usecs but we expected at least " << LATENESS_USECS / 2 << std::endl;
+    }
+
+    // the late packets need more than a frame of cover, but no more than the bounds allow
+    if (jitterBufferDepth.getDesiredFrames() < 2 || jitterBufferDepth.getDesiredFrames() > MAX_JITTER_BUFFER_FRAMES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: desired depth is " << jitterBufferDepth.getDesiredFrames()
+            << " frames for a jittery stream" << std::endl;
+    }
+}
+
+void JitterBufferDepthTests::settlesAfterStarves() {
+    const int NUM_STARVES = 2;
+
+    JitterBufferDepth jitterBufferDepth;
+
+    for (int i = 0; i < NUM_STARVES; i++) {
+        jitterBufferDepth.streamStarved();
+    }
+
+    if (jitterBufferDepth.getDesiredFrames() != NUM_STARVES || jitterBufferDepth.getNumStarves() != NUM_STARVES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: desired depth is " << jitterBufferDepth.getDesiredFrames()
+            << " frames after " << jitterBufferDepth.getNumStarves() << " starves but we expected "
+            << NUM_STARVES << std::endl;
+        return;
+    }
+
+    // with no jitter and no more starves it comes down one frame every settle period
+    const int SETTLE_FRAMES = JITTER_BUFFER_SETTLE_WINDOWS * JITTER_BUFFER_WINDOW_FRAMES;
+
+    for (int i = 0; i < SETTLE_FRAMES; i++) {
+        jitterBufferDepth.frameMixed(jitterBufferDepth.getDesiredFrames());
+    }
+
+    if (jitterBufferDepth.getDesiredFrames() != NUM_STARVES - 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: desired depth is " << jitterBufferDepth.getDesiredFrames()
+            << " frames after settling but we expected " << NUM_STARVES - 1 << std::endl;
+    }
+}
+
+void JitterBufferDepthTests::dropsFramesHeldTooLong() {
+    const int NUM_BUFFERED_FRAMES = 3;
+
+    JitterBufferDepth jitterBufferDepth;
+    int numFramesDropped = 0;
+
+    // one window at a steady depth above the desired one drops a single frame at its end
+    for (int i = 0; i < JITTER_BUFFER_WINDOW_FRAMES; i++) {
+        int numFramesToDrop = jitterBufferDepth.frameMixed(NUM_BUFFERED_FRAMES);
+
+        if (numFramesToDrop > 0 && i != JITTER_BUFFER_WINDOW_FRAMES - 1) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: dropped a frame " << i
+                << " frames into the window" << std::endl;
+            return;
+        }
+        numFramesDropped += numFramesToDrop;
+    }
+
+    if (numFramesDropped != 1 || jitterBufferDepth.getNumDroppedFrames() != 1) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: dropped " << numFramesDropped
+            << " frames in a window but we expected 1" << std::endl;
+    }
+}
+
+void JitterBufferDepthTests::runAllTests() {
+    staysShallowForSteadyStream();
+    deepensForJitteryStream();
+    settlesAfterStarves();
+    dropsFramesHeldTooLong();
+}
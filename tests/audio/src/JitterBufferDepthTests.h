@@ -0,0 +1,23 @@
+//
+//  JitterBufferDepthTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_JitterBufferDepthTests_h
+#define hifi_JitterBufferDepthTests_h
+
+namespace JitterBufferDepthTests {
+    void staysShallowForSteadyStream();
+    void deepensForJitteryStream();
+    void settlesAfterStarves();
+    void dropsFramesHeldTooLong();
+
+    void runAllTests();
+}
+
+#endif // hifi_JitterBufferDepthTests_h
@@ -0,0 +1,134 @@
+//
+//  MixedAudioCodecTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <MixedAudioCodec.h>
+
+#include "MixedAudioCodecTests.h"
+
+const int NUM_TEST_FRAMES = 20;
+
+// two tones, a little louder on the left than the right
+static void fillStereoFrame(int16_t* stereoSamples, int frameIndex) {
+    const float LOW_TONE_RADIANS_PER_FRAME = 0.05f;
+    const float HIGH_TONE_RADIANS_PER_FRAME = 0.4f;
+
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+        int frame = (frameIndex * NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL) + i;
+        float sample = 12000.0f * sinf(frame * LOW_TONE_RADIANS_PER_FRAME)
+            + 4000.0f * sinf(frame * HIGH_TONE_RADIANS_PER_FRAME);
+
+        stereoSamples[i * 2] = sample;
+        stereoSamples[(i * 2) + 1] = sample * 0.8f;
+    }
+}
+
+void MixedAudioCodecTests::roundTripsRawFrames() {
+    MixedAudioEncoder encoder;
+    int16_t stereoSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t decodedSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    char encodedFrame[MAX_NUM_BYTES_MIXED_AUDIO_FRAME];
+
+    fillStereoFrame(stereoSamples, 0);
+    int numEncodedBytes = encoder.encodeFrame(MixedAudioEncodingRaw, stereoSamples, encodedFrame);
+
+    if (numEncodedBytes != MAX_NUM_BYTES_MIXED_AUDIO_FRAME) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: raw frame is " << numEncodedBytes
+            << " bytes but we expected " << MAX_NUM_BYTES_MIXED_AUDIO_FRAME << std::endl;
+    }
+
+    int numDecodedSamples = MixedAudioCodec::decodeFrame(encodedFrame, numEncodedBytes, decodedSamples);
+
+    if (numDecodedSamples != NETWORK_BUFFER_LENGTH_SAMPLES_STEREO
+        || memcmp(stereoSamples, decodedSamples, sizeof(stereoSamples)) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: raw frame did not decode to the samples encoded"
+            << std::endl;
+    }
+}
+
+void MixedAudioCodecTests::roundTripsADPCMFrames() {
+    // IMA-ADPCM gives roughly 20 to 30 dB of signal to noise on program material
+    const float MIN_SIGNAL_TO_NOISE_DB = 20.0f;
+
+    MixedAudioEncoder encoder;
+    int16_t stereoSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t decodedSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    char encodedFrame[MAX_NUM_BYTES_MIXED_AUDIO_FRAME];
+
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+
+    for (int frame = 0; frame < NUM_TEST_FRAMES; frame++) {
+        fillStereoFrame(stereoSamples, frame);
+        int numEncodedBytes = encoder.encodeFrame(MixedAudioEncodingMidSideADPCM, stereoSamples, encodedFrame);
+
+        if (numEncodedBytes != (int) sizeof(quint8) + NUM_BYTES_MID_SIDE_ADPCM_FRAME) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ADPCM frame is " << numEncodedBytes
+                << " bytes but we expected " << sizeof(quint8) + NUM_BYTES_MID_SIDE_ADPCM_FRAME << std::endl;
+            return;
+        }
+
+        if (MixedAudioCodec::decodeFrame(encodedFrame, numEncodedBytes, decodedSamples)
+            != NETWORK_BUFFER_LENGTH_SAMPLES_STEREO) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ADPCM frame " << frame << " did not decode"
+                << std::endl;
+            return;
+        }
+
+        // the first frame is where the encoder adapts its step size from nothing
+        if (frame > 0) {
+            for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; i++) {
+                double error = decodedSamples[i] - stereoSamples[i];
+                signalEnergy += (double) stereoSamples[i] * stereoSamples[i];
+                noiseEnergy += error * error;
+            }
+        }
+    }
+
+    float signalToNoise = 10.0f * log10f(signalEnergy / std::max(noiseEnergy, 1.0));
+    if (signalToNoise < MIN_SIGNAL_TO_NOISE_DB) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ADPCM signal to noise is " << signalToNoise
+            << " dB but we expected at least " << MIN_SIGNAL_TO_NOISE_DB << " dB" << std::endl;
+    }
+}
+
+void MixedAudioCodecTests::rejectsTruncatedFrames() {
+    MixedAudioEncoder encoder;
+    int16_t stereoSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t decodedSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    char encodedFrame[MAX_NUM_BYTES_MIXED_AUDIO_FRAME];
+
+    fillStereoFrame(stereoSamples, 0);
+
+    MixedAudioEncoding encodings[] = { MixedAudioEncodingRaw, MixedAudioEncodingMidSideADPCM };
+    for (int i = 0; i < (int) (sizeof(encodings) / sizeof(encodings[0])); i++) {
+        int numEncodedBytes = encoder.encodeFrame(encodings[i], stereoSamples, encodedFrame);
+
+        if (MixedAudioCodec::decodeFrame(encodedFrame, numEncodedBytes - 1, decodedSamples) != 0) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: truncated frame in encoding " << encodings[i]
+                << " was decoded" << std::endl;
+        }
+    }
+
+    const char UNKNOWN_ENCODING = 100;
+    if (MixedAudioCodec::decodeFrame(&UNKNOWN_ENCODING, sizeof(UNKNOWN_ENCODING), decodedSamples) != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: frame in an unknown encoding was decoded" << std::endl;
+    }
+}
+
+void MixedAudioCodecTests::runAllTests() {
+    roundTripsRawFrames();
+    roundTripsADPCMFrames();
+    rejectsTruncatedFrames();
+}
@@ -0,0 +1,22 @@
+//
+//  MixedAudioCodecTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MixedAudioCodecTests_h
+#define hifi_MixedAudioCodecTests_h
+
+namespace MixedAudioCodecTests {
+    void roundTripsRawFrames();
+    void roundTripsADPCMFrames();
+    void rejectsTruncatedFrames();
+
+    void runAllTests();
+}
+
+#endif // hifi_MixedAudioCodecTests_h
@@ -0,0 +1,26 @@
+//
+//  main.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AudioLimiterTests.h"
+#include "AudioMixKernelTests.h"
+#include "AudioRingBufferTests.h"
+#include "AudioSourceGeometryTests.h"
+#include "JitterBufferDepthTests.h"
+#include "MixedAudioCodecTests.h"
+
+int main(int argc, char** argv) {
+    AudioMixKernelTests::runAllTests();
+    AudioLimiterTests::runAllTests();
+    AudioSourceGeometryTests::runAllTests();
+    AudioRingBufferTests::runAllTests();
+    JitterBufferDepthTests::runAllTests();
+    MixedAudioCodecTests::runAllTests();
+    return 0;
+}
@@ -0,0 +1,377 @@
+//
+//  AvatarMixerBenchmark.cpp
+//  tests/avatar-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QUrl>
+
+#include <Assignment.h>
+#include <AvatarData.h>
+#include <AvatarQuery.h>
+#include <NodeList.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+
+#include "AvatarMixer.h"
+#include "AvatarMixerClientData.h"
+
+#include "AvatarMixerBenchmark.h"
+
+// a second in which every avatar joins, is sent the identities and billboards around it and goes through its low rate
+// turns, the frames after it are the ones timed
+const int WARM_UP_FRAMES = AVATAR_DATA_SENDS_PER_SECOND;
+
+// clients query the mixer about once a second, each avatar's query falls in a different frame
+const int QUERY_INTERVAL_FRAMES = AVATAR_DATA_SENDS_PER_SECOND;
+
+// the crowd stands on a square starting here, well inside the domain positions are packed across
+const glm::vec3 CROWD_ORIGIN(100.0f, 1.0f, 100.0f);
+
+const float WALKING_SPEED = 1.4f;
+const float MIN_WALK_RADIUS = 2.0f;
+const float MAX_WALK_RADIUS = 10.0f;
+
+// the joints every avatar poses, swinging back and forth about once a second
+const int NUM_POSED_JOINTS = 24;
+const float MAX_JOINT_SWING = 0.5f;
+const float JOINT_SWING_STEP = TWO_PI / AVATAR_DATA_SENDS_PER_SECOND;
+
+const int NUM_BILLBOARD_BYTES = 1000;
+
+const int CLIENT_PORT = 40000;
+
+struct BenchmarkOptions {
+    int numAvatars;
+    int numFrames;
+    float walkingFraction;
+    bool isAcking;
+    int maxFrameUsecs;
+    QString payload;
+};
+
+struct SimulatedAvatar {
+    SharedNodePointer node;
+    AvatarMixerClientData* nodeData; // kept alive by node
+    AvatarData* avatar; // the client's side, which packs what it sends
+    glm::vec3 center;
+    float walkRadius; // zero for an avatar standing at its center
+    float walkAngle;
+    float walkAngleStep;
+    float swingPhase;
+};
+
+// stands in for the node list, counting what would have been sent and collecting the sequence numbers each listener
+// would acknowledge
+class CountingPacketSender : public AvatarMixerPacketSender {
+public:
+    CountingPacketSender() : _numPackets(0), _numBytes(0), _ackPackets() { }
+    
+    void sendPacket(PacketBuffer& packet, const SharedNodePointer& destinationNode) {
+        countPacket(packet.getData(), packet.getSize(), destinationNode);
+    }
+    
+    void sendPacket(const QByteArray& packet, const SharedNodePointer& destinationNode) {
+        countPacket(packet.constData(), packet.size(), destinationNode);
+    }
+    
+    /// hands every listener the acknowledgement of what it was sent since the last call
+    void deliverAcks(const NodeHash& nodeHash) {
+        for (QHash<QUuid, QByteArray>::const_iterator ackPacket = _ackPackets.constBegin();
+                ackPacket != _ackPackets.constEnd(); ++ackPacket) {
+            AvatarMixerClientData* nodeData =
+                static_cast<AvatarMixerClientData*>(nodeHash.value(ackPacket.key())->getLinkedData());
+            nodeData->queueListenerPacket(ackPacket.value());
+        }
+        _ackPackets.clear();
+    }
+    
+    void resetCounts() { _numPackets = 0; _numBytes = 0; }
+    
+    int getNumPackets() const { return _numPackets; }
+    qint64 getNumBytes() const { return _numBytes; }
+
+private:
+    void countPacket(const char* packet, int size, const SharedNodePointer& destinationNode) {
+        ++_numPackets;
+        _numBytes += size;
+        
+        if (packetTypeForPacket(packet) == PacketTypeBulkAvatarData) {
+            QByteArray& ackPacket = _ackPackets[destinationNode->getUUID()];
+            if (ackPacket.isEmpty()) {
+                ackPacket = byteArrayWithPopulatedHeader(PacketTypeBulkAvatarDataAck, destinationNode->getUUID());
+            }
+            ackPacket.append(packet + numBytesForPacketHeader(packet), sizeof(quint16));
+        }
+    }
+    
+    int _numPackets;
+    qint64 _numBytes;
+    QHash<QUuid, QByteArray> _ackPackets;
+};
+
+static AvatarMixer* createAvatarMixer(const QString& payload) {
+    Assignment assignment(Assignment::CreateCommand, Assignment::AvatarMixerType);
+    assignment.setPayload(payload.toUtf8());
+    
+    QByteArray assignmentPacket = byteArrayWithPopulatedHeader(PacketTypeCreateAssignment);
+    QDataStream assignmentStream(&assignmentPacket, QIODevice::Append);
+    assignmentStream << assignment;
+    
+    return new AvatarMixer(assignmentPacket);
+}
+
+static qint64 percentile(const std::vector<qint64>& sortedValues, float fraction) {
+    int index = std::min((int) (fraction * sortedValues.size()), (int) sortedValues.size() - 1);
+    return sortedValues[index];
+}
+
+// the identity and billboard a client sends as it joins, handled the way the mixer's readPendingDatagrams does
+static void joinMixer(SimulatedAvatar& simulatedAvatar, int avatarIndex) {
+    const QUuid& nodeUUID = simulatedAvatar.node->getUUID();
+    AvatarData& mixerAvatar = simulatedAvatar.nodeData->getAvatar();
+    
+    QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity, nodeUUID);
+    QDataStream identityStream(&identityPacket, QIODevice::Append);
+    identityStream << QUuid() << QUrl("http://example.com/face.fst") << QUrl("http://example.com/skeleton.fst")
+        << QString("Avatar %1").arg(avatarIndex);
+    
+    if (mixerAvatar.hasIdentityChangedAfterParsing(identityPacket)) {
+        simulatedAvatar.nodeData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
+    }
+    
+    QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard, nodeUUID);
+    billboardPacket.append(QByteArray(NUM_BILLBOARD_BYTES, (char) avatarIndex));
+    
+    if (mixerAvatar.hasBillboardChangedAfterParsing(billboardPacket)) {
+        simulatedAvatar.nodeData->setBillboardChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
+    }
+    
+    simulatedAvatar.nodeData->publishSnapshot(nodeUUID);
+}
+
+// moves the avatar along its path and sends the mixer its new state
+static void moveAvatar(SimulatedAvatar& simulatedAvatar) {
+    AvatarData* avatar = simulatedAvatar.avatar;
+    
+    simulatedAvatar.walkAngle = fmodf(simulatedAvatar.walkAngle + simulatedAvatar.walkAngleStep, TWO_PI);
+    simulatedAvatar.swingPhase = fmodf(simulatedAvatar.swingPhase + JOINT_SWING_STEP, TWO_PI);
+    
+    glm::vec3 offset(cosf(simulatedAvatar.walkAngle), 0.0f, sinf(simulatedAvatar.walkAngle));
+    avatar->setPosition(simulatedAvatar.center + offset * simulatedAvatar.walkRadius);
+    
+    // walking avatars face along their circle
+    avatar->setBodyYaw(glm::degrees(-simulatedAvatar.walkAngle));
+    
+    for (int i = 0; i < NUM_POSED_JOINTS; i++) {
+        float swing = MAX_JOINT_SWING * sinf(simulatedAvatar.swingPhase + i);
+        avatar->setJointData(i, glm::angleAxis(swing, glm::vec3(1.0f, 0.0f, 0.0f)));
+    }
+    
+    QByteArray avatarDataPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarData, simulatedAvatar.node->getUUID());
+    avatarDataPacket.append(avatar->toByteArray());
+    simulatedAvatar.nodeData->parseData(avatarDataPacket);
+}
+
+// the view of a client looking the way its avatar faces
+static void queryMixer(SimulatedAvatar& simulatedAvatar) {
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(simulatedAvatar.avatar->getPosition());
+    viewFrustum.setOrientation(simulatedAvatar.avatar->getOrientation());
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(DEFAULT_FAR_CLIP);
+    viewFrustum.calculate();
+    
+    AvatarQuery avatarQuery;
+    avatarQuery.setViewFrustum(viewFrustum);
+    
+    QByteArray avatarQueryPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarQuery, simulatedAvatar.node->getUUID());
+    int numPacketHeaderBytes = avatarQueryPacket.size();
+    
+    avatarQueryPacket.resize(MAX_PACKET_SIZE);
+    unsigned char* queryData = reinterpret_cast<unsigned char*>(avatarQueryPacket.data()) + numPacketHeaderBytes;
+    avatarQueryPacket.resize(numPacketHeaderBytes + avatarQuery.getBroadcastData(queryData));
+    
+    simulatedAvatar.nodeData->queueListenerPacket(avatarQueryPacket);
+}
+
+static void printPacketsPerFrame(const char* name, const QJsonObject& joinStats, const QJsonObject& stats) {
+    QString statName = QString("average_%1_packets_per_frame").arg(name);
+    std::cout << "Average " << name << " packets per frame: " << stats[statName].toDouble() << ", "
+        << joinStats[statName].toDouble() << " while joining" << std::endl;
+}
+
+// runs numFrames frames of a crowd at density, returns the 90th percentile frame time
+static qint64 benchmarkDensity(const BenchmarkOptions& options, float density) {
+    AvatarMixer* avatarMixer = createAvatarMixer(options.payload);
+    avatarMixer->prepareToBroadcast();
+    
+    float crowdSize = sqrtf(options.numAvatars / density);
+    
+    // nothing is written to the clients, the stand-in sender only needs them to have a socket
+    HifiSockAddr clientSockAddr(QHostAddress::LocalHost, CLIENT_PORT);
+    
+    NodeHash nodeHash;
+    std::vector<SimulatedAvatar> simulatedAvatars(options.numAvatars);
+    
+    for (int i = 0; i < options.numAvatars; i++) {
+        SimulatedAvatar& simulatedAvatar = simulatedAvatars[i];
+        simulatedAvatar.node = SharedNodePointer(new Node(QUuid::createUuid(), NodeType::Agent,
+                                                          clientSockAddr, clientSockAddr));
+        simulatedAvatar.node->activatePublicSocket();
+        simulatedAvatar.nodeData = new AvatarMixerClientData();
+        simulatedAvatar.node->setLinkedData(simulatedAvatar.nodeData);
+        simulatedAvatar.avatar = new AvatarData();
+        
+        simulatedAvatar.center = CROWD_ORIGIN + glm::vec3(randFloat(), 0.0f, randFloat()) * crowdSize;
+        simulatedAvatar.walkRadius = randFloat() < options.walkingFraction
+            ? randFloatInRange(MIN_WALK_RADIUS, MAX_WALK_RADIUS) : 0.0f;
+        simulatedAvatar.walkAngle = randFloat() * TWO_PI;
+        simulatedAvatar.walkAngleStep = simulatedAvatar.walkRadius > 0.0f
+            ? WALKING_SPEED / (simulatedAvatar.walkRadius * AVATAR_DATA_SENDS_PER_SECOND) : 0.0f;
+        simulatedAvatar.swingPhase = randFloat() * TWO_PI;
+        
+        joinMixer(simulatedAvatar, i);
+        nodeHash.insert(simulatedAvatar.node->getUUID(), simulatedAvatar.node);
+    }
+    
+    CountingPacketSender sender;
+    QJsonObject joinStats;
+    
+    std::vector<qint64> frameUsecs;
+    frameUsecs.reserve(options.numFrames);
+    int lastFrameUsecs = 0;
+    
+    QElapsedTimer frameTimer;
+    
+    for (int frame = 0; frame < WARM_UP_FRAMES + options.numFrames; frame++) {
+        // every avatar sends one state for every frame broadcast, parsing them is not part of the timing
+        for (int i = 0; i < options.numAvatars; i++) {
+            moveAvatar(simulatedAvatars[i]);
+            
+            if (frame % QUERY_INTERVAL_FRAMES == i % QUERY_INTERVAL_FRAMES) {
+                queryMixer(simulatedAvatars[i]);
+            }
+        }
+        
+        // the mixer throttles on the time the last frame left it, as if it were running in real time
+        int idleMsecs = (int) AVATAR_DATA_SEND_INTERVAL_MSECS - lastFrameUsecs / (int) USECS_PER_MSEC;
+        avatarMixer->updatePerformanceThrottling(idleMsecs);
+        
+        frameTimer.start();
+        avatarMixer->broadcastFrame(nodeHash, sender);
+        lastFrameUsecs = frameTimer.nsecsElapsed() / 1000;
+        
+        if (options.isAcking) {
+            sender.deliverAcks(nodeHash);
+        }
+        
+        if (frame >= WARM_UP_FRAMES) {
+            frameUsecs.push_back(lastFrameUsecs);
+        } else if (frame == WARM_UP_FRAMES - 1) {
+            joinStats = avatarMixer->collectStats();
+            sender.resetCounts();
+        }
+    }
+    
+    QJsonObject stats = avatarMixer->collectStats();
+    std::sort(frameUsecs.begin(), frameUsecs.end());
+    
+    float numSeconds = (float) options.numFrames / AVATAR_DATA_SENDS_PER_SECOND;
+    float bytesPerListenerPerSecond = sender.getNumBytes() / (numSeconds * options.numAvatars);
+    
+    std::cout << std::endl << "Broadcast " << options.numAvatars << " avatars at " << density
+        << " per square meter, on a square of " << crowdSize << " meters, for " << options.numFrames
+        << " frames. The frame budget is " << AVATAR_DATA_SEND_INTERVAL_MSECS * USECS_PER_MSEC << " usecs."
+        << std::endl;
+    std::cout << "Frame usecs: 50% " << percentile(frameUsecs, 0.5f) << ", 90% " << percentile(frameUsecs, 0.9f)
+        << ", 99% " << percentile(frameUsecs, 0.99f) << ", max " << frameUsecs.back() << std::endl;
+    std::cout << "Bytes per listener per second: " << bytesPerListenerPerSecond << " in "
+        << sender.getNumPackets() / (numSeconds * options.numAvatars) << " packets" << std::endl;
+    
+    std::cout << "Updates per second by distance:";
+    QJsonObject updateRates = stats["update_rate_by_distance"].toObject();
+    for (int i = 0; i < NUM_AVATAR_DISTANCE_BANDS; i++) {
+        const char* bandName = AVATAR_DISTANCE_BAND_NAMES[i];
+        if (updateRates.contains(bandName)) {
+            std::cout << " " << bandName << " " << updateRates[bandName].toDouble();
+        }
+    }
+    std::cout << std::endl;
+    
+    printPacketsPerFrame("identity", joinStats, stats);
+    printPacketsPerFrame("billboard", joinStats, stats);
+    std::cout << "Performance throttling ratio reached: " << avatarMixer->getPerformanceThrottlingRatio() << std::endl;
+    
+    qint64 ninetiethPercentileUsecs = percentile(frameUsecs, 0.9f);
+    
+    delete avatarMixer;
+    for (int i = 0; i < options.numAvatars; i++) {
+        delete simulatedAvatars[i].avatar;
+    }
+    
+    return ninetiethPercentileUsecs;
+}
+
+bool AvatarMixerBenchmark::runBenchmark(const QStringList& arguments) {
+    QStringList mixerArguments = arguments;
+    
+    BenchmarkOptions options;
+    options.numAvatars = takeCmdOption(mixerArguments, "--avatars", "1000").toInt();
+    options.numFrames = takeCmdOption(mixerArguments, "--frames", "300").toInt();
+    QStringList densities = takeCmdOption(mixerArguments, "--densities", "0.01,0.1,1").split(",");
+    options.walkingFraction = takeCmdOption(mixerArguments, "--walking", "0.5").toFloat();
+    options.isAcking = takeCmdOption(mixerArguments, "--acks", "on") == "on";
+    options.maxFrameUsecs = takeCmdOption(mixerArguments, "--maxFrameUsecs", "0").toInt();
+    srand(takeCmdOption(mixerArguments, "--seed", "1").toUInt());
+    options.payload = mixerArguments.join(" ");
+    
+    if (options.numAvatars < 1 || options.numFrames < 1) {
+        std::cout << "Need at least one avatar and one frame." << std::endl;
+        return false;
+    }
+    
+    NodeList::createInstance(NodeType::AvatarMixer);
+    
+    bool isWithinLimit = true;
+    
+    foreach (const QString& densityValue, densities) {
+        float density = densityValue.toFloat();
+        if (density <= 0.0f) {
+            std::cout << "Skipping density " << densityValue.toStdString() << ", it needs to be above zero."
+                << std::endl;
+            continue;
+        }
+        
+        qint64 ninetiethPercentileUsecs = benchmarkDensity(options, density);
+        
+        if (options.maxFrameUsecs > 0 && ninetiethPercentileUsecs > options.maxFrameUsecs) {
+            std::cout << "FAILED: 90% of frames took up to " << ninetiethPercentileUsecs << " usecs, over the limit of "
+                << options.maxFrameUsecs << "." << std::endl;
+            isWithinLimit = false;
+        }
+    }
+    
+    return isWithinLimit;
+}
@@ -0,0 +1,34 @@
+//
+//  AvatarMixerBenchmark.h
+//  tests/avatar-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarMixerBenchmark_h
+#define hifi_AvatarMixerBenchmark_h
+
+#include <QtCore/QStringList>
+
+/// Runs the avatar mixer headless against simulated avatars at several crowd densities. The packets go to a stand-in
+/// that counts them instead of a socket. For each density it reports frame times, bytes per listener, update rates by
+/// distance and identity and billboard packets.
+///
+/// Options, each given as --option value:
+///   --avatars         the number of avatars, each both sent and a listener (1000)
+///   --frames          the number of frames timed at each density, after a second in which the avatars join (300)
+///   --densities       comma separated avatars per square meter of the square the crowd stands in (0.01,0.1,1)
+///   --walking         the fraction of avatars walking in circles, the rest stand and swing their arms (0.5)
+///   --acks            on to acknowledge every packet before the next frame, as a client with no loss would (on)
+///   --maxFrameUsecs   fails the run if the 90th percentile frame at any density takes longer, 0 for no limit (0)
+///   --seed            the seed for the positions and paths (1)
+/// Anything else is passed to the mixer as its assignment payload, for example --broadcastThreads 4.
+namespace AvatarMixerBenchmark {
+    /// \return false if a density went over --maxFrameUsecs
+    bool runBenchmark(const QStringList& arguments);
+}
+
+#endif // hifi_AvatarMixerBenchmark_h
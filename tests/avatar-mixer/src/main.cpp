@@ -0,0 +1,20 @@
+//
+//  main.cpp
+//  tests/avatar-mixer/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QCoreApplication>
+
+#include "AvatarMixerBenchmark.h"
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    
+    // a run over its frame limit fails, so a CI job running the benchmark catches the regression
+    return AvatarMixerBenchmark::runBenchmark(app.arguments().mid(1)) ? 0 : 1;
+}
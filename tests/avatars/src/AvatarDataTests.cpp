@@ -0,0 +1,277 @@
+//
+//  AvatarDataTests.cpp
+//  tests/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cmath>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <AvatarData.h>
+#include <AvatarDelta.h>
+#include <OctreeConstants.h>
+#include <SharedUtil.h>
+
+#include "AvatarDataTests.h"
+
+const int NUM_TEST_ROTATIONS = 10000;
+const int NUM_TEST_POSITIONS = 10000;
+const int NUM_TEST_JOINTS = 40;
+
+// the four byte rotation is good to a quarter of a degree, a rotation relative to another one to twice that
+const float MAX_ROTATION_ERROR_DEGREES = 0.25f;
+const float MAX_RELATIVE_ROTATION_ERROR_DEGREES = 0.5f;
+
+// a float holds a millimeter step exactly up to a few kilometers, the tests stay inside that
+const float TEST_DOMAIN_SIZE = 4096.0f;
+const float MAX_POSITION_ERROR = 0.5f / AVATAR_POSITION_STEPS_PER_METER + EPSILON;
+
+static float angleBetween(const glm::quat& a, const glm::quat& b) {
+    float cosHalfAngle = glm::min(fabsf(glm::dot(a, b)), 1.0f);
+    return glm::degrees(2.0f * acosf(cosHalfAngle));
+}
+
+static glm::quat randomRotation() {
+    return glm::normalize(glm::quat(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                    randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f)));
+}
+
+static glm::vec3 randomPosition() {
+    return glm::vec3(randFloatInRange(0.0f, TEST_DOMAIN_SIZE), randFloatInRange(0.0f, TEST_DOMAIN_SIZE),
+                     randFloatInRange(0.0f, TEST_DOMAIN_SIZE));
+}
+
+// an avatar turned, moved and posed away from its defaults, with every third joint left at its default rotation
+static void poseAvatar(AvatarData& avatar) {
+    // the head is only allocated once the avatar is first packed
+    avatar.toByteArray();
+    
+    avatar.setPosition(glm::vec3(1234.5678f, 12.25f, 3000.1f));
+    avatar.setBodyYaw(30.0f);
+    avatar.setBodyPitch(10.0f);
+    avatar.setBodyRoll(-5.0f);
+    avatar.setHeadPitch(20.0f);
+    
+    for (int i = 0; i < NUM_TEST_JOINTS; i++) {
+        avatar.setJointData(i, randomRotation());
+        if (i % 3 == 0) {
+            avatar.clearJointData(i);
+        }
+    }
+}
+
+void AvatarDataTests::roundTripsRotations() {
+    unsigned char buffer[NUM_BYTES_AVATAR_ROTATION];
+    
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        glm::quat rotation = randomRotation();
+        
+        // the rotations whose largest component is negative or shared with another are the edge cases
+        if (i == 0) {
+            rotation = glm::quat();
+        } else if (i == 1) {
+            rotation = glm::quat(0.0f, 0.0f, -1.0f, 0.0f);
+        } else if (i == 2) {
+            rotation = glm::normalize(glm::quat(-1.0f, 1.0f, 0.0f, 0.0f));
+        }
+        
+        int numBytesPacked = packOrientationQuatToFourBytes(buffer, rotation);
+        
+        glm::quat unpackedRotation;
+        int numBytesUnpacked = unpackOrientationQuatFromFourBytes(buffer, unpackedRotation);
+        
+        if (numBytesPacked != NUM_BYTES_AVATAR_ROTATION || numBytesUnpacked != NUM_BYTES_AVATAR_ROTATION) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: rotation packed to " << numBytesPacked
+                << " bytes and unpacked from " << numBytesUnpacked << " but we expected "
+                << NUM_BYTES_AVATAR_ROTATION << std::endl;
+            return;
+        }
+        
+        float error = angleBetween(rotation, unpackedRotation);
+        if (error > MAX_ROTATION_ERROR_DEGREES) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: rotation came back " << error
+                << " degrees off but we expected at most " << MAX_ROTATION_ERROR_DEGREES << std::endl;
+            return;
+        }
+        
+        if (fabsf(glm::length(unpackedRotation) - 1.0f) > MAX_ROTATION_ERROR_DEGREES / 180.0f) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: rotation came back with length "
+                << glm::length(unpackedRotation) << " but we expected 1" << std::endl;
+            return;
+        }
+    }
+}
+
+void AvatarDataTests::roundTripsPositions() {
+    unsigned char buffer[NUM_BYTES_AVATAR_POSITION];
+    
+    for (int i = 0; i < NUM_TEST_POSITIONS; i++) {
+        glm::vec3 position = randomPosition();
+        
+        int numBytesPacked = AvatarData::packPosition(buffer, position);
+        
+        glm::vec3 unpackedPosition;
+        int numBytesUnpacked = AvatarData::unpackPosition(buffer, unpackedPosition);
+        
+        if (numBytesPacked != NUM_BYTES_AVATAR_POSITION || numBytesUnpacked != NUM_BYTES_AVATAR_POSITION) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: position packed to " << numBytesPacked
+                << " bytes and unpacked from " << numBytesUnpacked << " but we expected "
+                << NUM_BYTES_AVATAR_POSITION << std::endl;
+            return;
+        }
+        
+        for (int axis = 0; axis < 3; axis++) {
+            if (fabsf(unpackedPosition[axis] - position[axis]) > MAX_POSITION_ERROR) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: position came back "
+                    << fabsf(unpackedPosition[axis] - position[axis]) << " meters off but we expected at most "
+                    << MAX_POSITION_ERROR << std::endl;
+                return;
+            }
+        }
+    }
+    
+    // positions outside the domain are held to its edges
+    glm::vec3 outsidePosition(-10.0f, TREE_SCALE + 10.0f, 100.0f);
+    glm::vec3 unpackedPosition;
+    AvatarData::packPosition(buffer, outsidePosition);
+    AvatarData::unpackPosition(buffer, unpackedPosition);
+    
+    float maxPosition = MAX_AVATAR_POSITION_STEP / AVATAR_POSITION_STEPS_PER_METER;
+    if (unpackedPosition.x != 0.0f || unpackedPosition.y != maxPosition || unpackedPosition.z != 100.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: position outside the domain came back as "
+            << unpackedPosition.x << "," << unpackedPosition.y << "," << unpackedPosition.z
+            << " but we expected 0," << maxPosition << ",100" << std::endl;
+    }
+}
+
+void AvatarDataTests::roundTripsAvatarState() {
+    AvatarData sentAvatar;
+    poseAvatar(sentAvatar);
+    
+    QByteArray state = sentAvatar.toByteArray();
+    
+    AvatarData receivedAvatar;
+    int numBytesParsed = receivedAvatar.parseDataAtOffset(state, 0);
+    
+    if (numBytesParsed != state.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: parsed " << numBytesParsed << " bytes of a "
+            << state.size() << " byte state" << std::endl;
+        return;
+    }
+    
+    float positionError = glm::distance(sentAvatar.getPosition(), receivedAvatar.getPosition());
+    if (positionError > MAX_POSITION_ERROR * 2.0f) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: avatar position came back " << positionError
+            << " meters off" << std::endl;
+    }
+    
+    float bodyError = angleBetween(sentAvatar.getOrientation(), receivedAvatar.getOrientation());
+    if (bodyError > MAX_ROTATION_ERROR_DEGREES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: body rotation came back " << bodyError
+            << " degrees off" << std::endl;
+    }
+    
+    float headError = angleBetween(sentAvatar.getHeadOrientation(), receivedAvatar.getHeadOrientation());
+    if (headError > MAX_RELATIVE_ROTATION_ERROR_DEGREES) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: head rotation came back " << headError
+            << " degrees off" << std::endl;
+    }
+    
+    const QVector<JointData>& sentJoints = sentAvatar.getJointData();
+    const QVector<JointData>& receivedJoints = receivedAvatar.getJointData();
+    
+    if (receivedJoints.size() != sentJoints.size()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << receivedJoints.size()
+            << " joints came back but we sent " << sentJoints.size() << std::endl;
+        return;
+    }
+    
+    for (int i = 0; i < sentJoints.size(); i++) {
+        if (receivedJoints[i].valid != sentJoints[i].valid) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: joint " << i << " came back "
+                << (receivedJoints[i].valid ? "valid" : "default") << std::endl;
+        } else if (sentJoints[i].valid
+                   && angleBetween(sentJoints[i].rotation, receivedJoints[i].rotation) > MAX_ROTATION_ERROR_DEGREES) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: joint " << i << " rotation came back "
+                << angleBetween(sentJoints[i].rotation, receivedJoints[i].rotation) << " degrees off" << std::endl;
+        }
+    }
+}
+
+void AvatarDataTests::roundTripsDeltas() {
+    AvatarData avatar;
+    poseAvatar(avatar);
+    
+    QByteArray baseline = avatar.toByteArray();
+    
+    // a small step and one joint turning is the common case between two frames
+    avatar.setPosition(avatar.getPosition() + glm::vec3(0.05f, 0.0f, -0.02f));
+    avatar.setJointData(1, randomRotation());
+    
+    QByteArray state = avatar.toByteArray();
+    QByteArray delta = AvatarDelta::encode(baseline, state);
+    
+    QByteArray decodedState;
+    if (delta.isEmpty() || !AvatarDelta::decode(baseline, delta.constData(), delta.size(), decodedState)) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: delta of " << delta.size()
+            << " bytes did not decode" << std::endl;
+        return;
+    }
+    
+    if (decodedState != state) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: delta did not decode to the state encoded" << std::endl;
+    }
+    
+    if (delta.size() >= state.size() / 2) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: delta is " << delta.size() << " bytes of a "
+            << state.size() << " byte state but we expected under half" << std::endl;
+    }
+}
+
+void AvatarDataTests::comparesBytesPerAvatar() {
+    // the state before positions went out as steps and rotations as four bytes: twelve byte positions, two bytes for
+    // each euler angle and eight for each joint rotation
+    const int NUM_LEGACY_FIXED_BYTES = 54;
+    const int NUM_LEGACY_BYTES_PER_JOINT = 8;
+    
+    const int NUM_FIXED_BYTES = 44;
+    
+    AvatarData avatar;
+    poseAvatar(avatar);
+    
+    int numValidJoints = 0;
+    foreach (const JointData& joint, avatar.getJointData()) {
+        if (joint.valid) {
+            numValidJoints++;
+        }
+    }
+    int numValidityBytes = (NUM_TEST_JOINTS + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+    
+    int numBytes = avatar.toByteArray().size();
+    int numExpectedBytes = NUM_FIXED_BYTES + numValidityBytes + numValidJoints * NUM_BYTES_AVATAR_ROTATION;
+    int numLegacyBytes = NUM_LEGACY_FIXED_BYTES + numValidityBytes + numValidJoints * NUM_LEGACY_BYTES_PER_JOINT;
+    
+    if (numBytes != numExpectedBytes) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: avatar with " << numValidJoints << " posed joints is "
+            << numBytes << " bytes but we expected " << numExpectedBytes << std::endl;
+        return;
+    }
+    
+    std::cout << "Avatar with " << numValidJoints << " posed joints is " << numBytes << " bytes, was "
+        << numLegacyBytes << "." << std::endl;
+}
+
+void AvatarDataTests::runAllTests() {
+    roundTripsRotations();
+    roundTripsPositions();
+    roundTripsAvatarState();
+    roundTripsDeltas();
+    comparesBytesPerAvatar();
+}
@@ -0,0 +1,24 @@
+//
+//  AvatarDataTests.h
+//  tests/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarDataTests_h
+#define hifi_AvatarDataTests_h
+
+namespace AvatarDataTests {
+    void roundTripsRotations();
+    void roundTripsPositions();
+    void roundTripsAvatarState();
+    void roundTripsDeltas();
+    void comparesBytesPerAvatar();
+
+    void runAllTests();
+}
+
+#endif // hifi_AvatarDataTests_h
@@ -0,0 +1,127 @@
+//
+//  OctreeAllocatorTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+#include <vector>
+
+#include <OctreeAllocator.h>
+#include <OctreeElement.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeAllocatorTests.h"
+
+const int NUM_TEST_BLOCKS = 10000;
+const int NUM_TEST_VOXELS = 5000;
+
+// deep enough that the voxels' octal codes no longer fit in the element and go in the slabs too
+const float TEST_VOXEL_SIZE = 1.0f / (1 << 20);
+
+void OctreeAllocatorTests::roundsAndAlignsBlocks() {
+    OctreeAllocator allocator;
+
+    for (int size = 1; size <= MAX_OCTREE_ALLOCATION_SIZE; size++) {
+        void* block = allocator.allocate(size);
+        int blockSize = OctreeAllocator::blockSizeFor(block);
+
+        if (blockSize < size || blockSize - size >= OCTREE_ALLOCATION_GRANULARITY) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a " << size << " byte allocation got a "
+                << blockSize << " byte block" << std::endl;
+            return;
+        }
+        if (reinterpret_cast<quintptr>(block) % OCTREE_ALLOCATION_GRANULARITY != 0) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a " << size << " byte block is not "
+                << OCTREE_ALLOCATION_GRANULARITY << " byte aligned" << std::endl;
+            return;
+        }
+        if (OctreeAllocator::allocatorFor(block) != &allocator) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a " << size << " byte block was not found to come "
+                << "from its allocator" << std::endl;
+            return;
+        }
+    }
+}
+
+void OctreeAllocatorTests::reusesFreedBlocks() {
+    OctreeAllocator allocator;
+    const int BLOCK_SIZE = 64;
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < NUM_TEST_BLOCKS; i++) {
+        blocks.push_back(allocator.allocate(BLOCK_SIZE));
+    }
+    quint64 slabBytes = allocator.getSlabBytes();
+
+    if (allocator.getUsedBytes() != (quint64) NUM_TEST_BLOCKS * BLOCK_SIZE) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << NUM_TEST_BLOCKS << " blocks use "
+            << allocator.getUsedBytes() << " bytes but we expected " << NUM_TEST_BLOCKS * BLOCK_SIZE << std::endl;
+        return;
+    }
+
+    // freeing every other block and asking for as many again should need no new slab
+    for (int i = 0; i < NUM_TEST_BLOCKS; i += 2) {
+        OctreeAllocator::deallocate(blocks[i]);
+    }
+    for (int i = 0; i < NUM_TEST_BLOCKS; i += 2) {
+        blocks[i] = allocator.allocate(BLOCK_SIZE);
+    }
+    if (allocator.getSlabBytes() != slabBytes) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: reallocating freed blocks grew the slabs from "
+            << slabBytes << " to " << allocator.getSlabBytes() << " bytes" << std::endl;
+        return;
+    }
+
+    allocator.releaseAll();
+    if (allocator.getSlabBytes() != 0 || allocator.getUsedBytes() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: released allocator still holds "
+            << allocator.getSlabBytes() << " bytes of slab" << std::endl;
+        return;
+    }
+}
+
+void OctreeAllocatorTests::releasesSlabsWhenTreeIsErased() {
+    VoxelTree tree;
+
+    quint64 emptyTreeSlabBytes = OctreeAllocator::getTotalSlabBytes();
+    quint64 emptyTreeElementBytes = OctreeElement::getVoxelMemoryUsage();
+
+    for (int i = 0; i < NUM_TEST_VOXELS; i++) {
+        tree.createVoxel(randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE), randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE),
+                         randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE), TEST_VOXEL_SIZE, 255, 255, 255);
+    }
+
+    if (OctreeElement::getOctcodeMemoryUsage() == 0 || OctreeElement::getExternalChildrenMemoryUsage() == 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: deep voxels used no slab space for octal codes "
+            << "or child arrays" << std::endl;
+        return;
+    }
+    if (OctreeElement::getTotalMemoryUsage() > OctreeAllocator::getTotalSlabBytes()) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: elements use " << OctreeElement::getTotalMemoryUsage()
+            << " bytes, more than the " << OctreeAllocator::getTotalSlabBytes() << " bytes of slab" << std::endl;
+        return;
+    }
+
+    tree.eraseAllOctreeElements();
+
+    if (OctreeAllocator::getTotalSlabBytes() != emptyTreeSlabBytes ||
+            OctreeElement::getVoxelMemoryUsage() != emptyTreeElementBytes ||
+            OctreeElement::getOctcodeMemoryUsage() != 0 || OctreeElement::getExternalChildrenMemoryUsage() != 0) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: erased tree still holds "
+            << OctreeAllocator::getTotalSlabBytes() << " bytes of slab and " << OctreeElement::getTotalMemoryUsage()
+            << " bytes of elements" << std::endl;
+        return;
+    }
+}
+
+void OctreeAllocatorTests::runAllTests() {
+    roundsAndAlignsBlocks();
+    reusesFreedBlocks();
+    releasesSlabsWhenTreeIsErased();
+}
@@ -0,0 +1,22 @@
+//
+//  OctreeAllocatorTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeAllocatorTests_h
+#define hifi_OctreeAllocatorTests_h
+
+namespace OctreeAllocatorTests {
+    void roundsAndAlignsBlocks();
+    void reusesFreedBlocks();
+    void releasesSlabsWhenTreeIsErased();
+
+    void runAllTests();
+}
+
+#endif // hifi_OctreeAllocatorTests_h
@@ -0,0 +1,167 @@
+//
+//  OctreeKeyTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cstring>
+#include <iostream>
+
+#include <OctalCode.h>
+#include <OctreeKey.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeKeyTests.h"
+
+const int NUM_TEST_PATHS = 10000;
+const int NUM_TEST_PAIRS = 100000;
+
+// one level deeper than a key reaches, so the walk also covers the codes that stay octal codes
+const int MAX_TEST_LEVELS = MAX_OCTREE_KEY_LEVELS + 1;
+
+void OctreeKeyTests::roundTripsOctalCodes() {
+    for (int i = 0; i < NUM_TEST_PATHS; i++) {
+        // walk down a random path from the root, stepping both the octal code and the key
+        unsigned char* octalCode = new unsigned char[1];
+        octalCode[0] = 0;
+        OctreeKey key;
+
+        int levels = randIntInRange(1, MAX_TEST_LEVELS);
+        for (int level = 1; level <= levels; level++) {
+            int childIndex = randIntInRange(0, NUMBER_OF_CHILDREN - 1);
+            unsigned char* childCode = childOctalCode(octalCode, childIndex);
+            OctreeKey childKey = key.getChild(childIndex);
+            OctreeKey parsedKey = OctreeKey::fromOctalCode(childCode);
+
+            if (level > MAX_OCTREE_KEY_LEVELS) {
+                if (parsedKey.isValid()) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: a " << level << " level code got a key"
+                        << std::endl;
+                }
+                delete[] childCode;
+                break;
+            }
+            if (parsedKey != childKey || childKey.getLevel() != level || childKey.getParent() != key ||
+                    childKey.getChildIndex() != childIndex) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << level << " key " << childKey.getBits()
+                    << " does not match the key " << parsedKey.getBits() << " of its octal code" << std::endl;
+                delete[] childCode;
+                break;
+            }
+
+            unsigned char writtenCode[MAX_OCTREE_KEY_CODE_BYTES];
+            int numCodeBytes = childKey.writeOctalCode(writtenCode);
+            if (numCodeBytes != (int) bytesRequiredForCodeLength(level) ||
+                    memcmp(writtenCode, childCode, numCodeBytes) != 0) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << level << " key wrote a different "
+                    << "octal code than childOctalCode made" << std::endl;
+                delete[] childCode;
+                break;
+            }
+
+            glm::vec3 corner;
+            copyFirstVertexForCode(childCode, (float*)&corner);
+            if (corner != childKey.getCorner() || childKey.getScale() != 1.0f / (1 << level)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << level << " key has a different cube "
+                    << "than its octal code" << std::endl;
+                delete[] childCode;
+                break;
+            }
+
+            if (branchIndexWithDescendant(octalCode, childCode) != key.branchIndexToward(childKey)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << level << " key branches differently "
+                    << "than its octal code" << std::endl;
+                delete[] childCode;
+                break;
+            }
+
+            delete[] octalCode;
+            octalCode = childCode;
+            key = childKey;
+        }
+        delete[] octalCode;
+    }
+}
+
+void OctreeKeyTests::matchesOctalCodeAncestry() {
+    // shallow keys down only two branches, so that ancestors come up often
+    const int MAX_PAIR_LEVELS = 8;
+
+    for (int i = 0; i < NUM_TEST_PAIRS; i++) {
+        OctreeKey possibleAncestor;
+        OctreeKey possibleDescendant;
+        for (int level = randIntInRange(0, MAX_PAIR_LEVELS); level > 0; level--) {
+            possibleAncestor = possibleAncestor.getChild(randIntInRange(0, 1));
+        }
+        for (int level = randIntInRange(0, MAX_PAIR_LEVELS); level > 0; level--) {
+            possibleDescendant = possibleDescendant.getChild(randIntInRange(0, 1));
+        }
+
+        unsigned char* ancestorCode = possibleAncestor.toOctalCode();
+        unsigned char* descendantCode = possibleDescendant.toOctalCode();
+        bool isAncestor = isAncestorOf(ancestorCode, descendantCode);
+        delete[] ancestorCode;
+        delete[] descendantCode;
+
+        if (possibleAncestor.contains(possibleDescendant) != isAncestor) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: key " << possibleAncestor.getBits()
+                << (isAncestor ? " should" : " should not") << " contain key " << possibleDescendant.getBits()
+                << std::endl;
+            return;
+        }
+        if (isAncestor && possibleDescendant.getAncestor(possibleAncestor.getLevel()) != possibleAncestor) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: key " << possibleDescendant.getBits()
+                << " has the wrong ancestor at level " << possibleAncestor.getLevel() << std::endl;
+            return;
+        }
+    }
+}
+
+void OctreeKeyTests::findsElementsByKey() {
+    VoxelTree tree;
+
+    // one voxel a key can address and one too deep for a key, at corners every level agrees on exactly
+    const int NUM_TEST_VOXELS = 2;
+    const int TEST_LEVELS[NUM_TEST_VOXELS] = { 10, MAX_OCTREE_KEY_LEVELS + 3 };
+
+    for (int i = 0; i < NUM_TEST_VOXELS; i++) {
+        float scale = 1.0f / (1 << TEST_LEVELS[i]);
+        glm::vec3 corner = glm::vec3(3.0f, 5.0f, 7.0f) * scale;
+        tree.createVoxel(corner.x, corner.y, corner.z, scale, 255, 0, 0);
+
+        VoxelTreeElement* voxel = tree.getVoxelAt(corner.x, corner.y, corner.z, scale);
+        if (!voxel) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << TEST_LEVELS[i]
+                << " voxel was not found" << std::endl;
+            continue;
+        }
+        if (voxel->getLevel() != TEST_LEVELS[i] + 1 || voxel->getCorner() != corner || voxel->getScale() != scale) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << TEST_LEVELS[i]
+                << " voxel is at the wrong place" << std::endl;
+            continue;
+        }
+
+        unsigned char* octalCode = pointToOctalCode(corner.x, corner.y, corner.z, scale);
+        unsigned char codeBuffer[MAX_OCTREE_KEY_CODE_BYTES];
+        const unsigned char* voxelCode = voxel->getOctalCode(codeBuffer);
+        bool sameCode = memcmp(voxelCode, octalCode, bytesRequiredForCodeLength(TEST_LEVELS[i])) == 0;
+        bool rightKey = voxel->getKey() == OctreeKey::fromOctalCode(octalCode);
+        delete[] octalCode;
+
+        if (!sameCode || !rightKey) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: level " << TEST_LEVELS[i]
+                << " voxel has the wrong address" << std::endl;
+        }
+    }
+}
+
+void OctreeKeyTests::runAllTests() {
+    roundTripsOctalCodes();
+    matchesOctalCodeAncestry();
+    findsElementsByKey();
+}
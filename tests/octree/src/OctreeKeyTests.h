@@ -0,0 +1,22 @@
+//
+//  OctreeKeyTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeKeyTests_h
+#define hifi_OctreeKeyTests_h
+
+namespace OctreeKeyTests {
+    void roundTripsOctalCodes();
+    void matchesOctalCodeAncestry();
+    void findsElementsByKey();
+
+    void runAllTests();
+}
+
+#endif // hifi_OctreeKeyTests_h
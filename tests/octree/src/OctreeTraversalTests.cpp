@@ -0,0 +1,365 @@
+//
+//  OctreeTraversalTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <GeometryUtil.h>
+#include <Octree.h>
+#include <OctreeRayVisitor.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeTraversalTests.h"
+
+const int NUM_TEST_VOXELS = 20000;
+const int NUM_TEST_QUERIES = 1000;
+const int NUM_BENCHMARK_QUERIES = 20000;
+
+const float TEST_VOXEL_SIZE = 1.0f / 256.0f;
+const float TEST_SPHERE_RADIUS = 0.05f * TREE_SCALE;
+
+// meters, the slab test and the face by face test round differently
+const float RAY_DISTANCE_TOLERANCE = 0.01f;
+
+static void populateTree(VoxelTree& tree) {
+    for (int i = 0; i < NUM_TEST_VOXELS; i++) {
+        tree.createVoxel(randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE), randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE),
+                         randFloatInRange(0.0f, 1.0f - TEST_VOXEL_SIZE), TEST_VOXEL_SIZE, 255, 255, 255);
+    }
+}
+
+static glm::vec3 randomPointInTree() {
+    return glm::vec3(randFloatInRange(0.0f, 1.0f), randFloatInRange(0.0f, 1.0f), randFloatInRange(0.0f, 1.0f)) *
+        (float) TREE_SCALE;
+}
+
+static glm::vec3 randomDirection() {
+    return glm::normalize(glm::vec3(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                    randFloatInRange(-1.0f, 1.0f)));
+}
+
+// the queries as they were written against recurseTreeWithOperation, for the visitors to be checked and timed against
+
+class CallbackRayArgs {
+public:
+    glm::vec3 origin;
+    glm::vec3 direction;
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
+    bool found;
+    int visitedCount;
+};
+
+static bool callbackRayOperation(OctreeElement* element, void* extraData) {
+    CallbackRayArgs* args = static_cast<CallbackRayArgs*>(extraData);
+    args->visitedCount++;
+    float distance;
+    BoxFace face;
+    if (!element->getAABox().findRayIntersection(args->origin, args->direction, distance, face)) {
+        return false;
+    }
+    if (!element->isLeaf()) {
+        return true; // recurse on children
+    }
+    distance *= TREE_SCALE;
+    if (element->hasContent() && (!args->found || distance < args->distance)) {
+        args->element = element;
+        args->distance = distance;
+        args->face = face;
+        args->found = true;
+    }
+    return false;
+}
+
+static bool callbackRayIntersection(VoxelTree& tree, const glm::vec3& origin, const glm::vec3& direction,
+                                    OctreeElement*& element, float& distance, int* visitedCount = NULL) {
+    CallbackRayArgs args = { origin / (float) TREE_SCALE, direction, NULL, 0.0f, MIN_X_FACE, false, 0 };
+    tree.recurseTreeWithOperation(callbackRayOperation, &args);
+    element = args.element;
+    distance = args.distance;
+    if (visitedCount) {
+        *visitedCount = args.visitedCount;
+    }
+    return args.found;
+}
+
+class CallbackSphereArgs {
+public:
+    glm::vec3 center;
+    float radius;
+    glm::vec3 penetration;
+    bool found;
+    void* penetratedObject;
+};
+
+static bool callbackSphereOperation(OctreeElement* element, void* extraData) {
+    CallbackSphereArgs* args = static_cast<CallbackSphereArgs*>(extraData);
+    if (!element->getAABox().expandedContains(args->center, args->radius)) {
+        return false;
+    }
+    if (!element->isLeaf()) {
+        return true; // recurse on children
+    }
+    if (element->hasContent()) {
+        glm::vec3 elementPenetration;
+        if (element->findSpherePenetration(args->center, args->radius, elementPenetration, &args->penetratedObject)) {
+            args->penetration = addPenetrations(args->penetration, elementPenetration * (float) TREE_SCALE);
+            args->found = true;
+        }
+    }
+    return false;
+}
+
+static bool callbackSpherePenetration(VoxelTree& tree, const glm::vec3& center, float radius, glm::vec3& penetration) {
+    CallbackSphereArgs args = { center / (float) TREE_SCALE, radius / (float) TREE_SCALE, glm::vec3(), false, NULL };
+    tree.recurseTreeWithOperation(callbackSphereOperation, &args);
+    penetration = args.penetration;
+    return args.found;
+}
+
+static bool collectOperation(OctreeElement* element, void* extraData) {
+    static_cast<std::vector<OctreeElement*>*>(extraData)->push_back(element);
+    return true;
+}
+
+class CollectVisitor : public OctreeVisitor {
+public:
+    enum { WANTS_POST_VISIT = true };
+
+    OctreeVisitAction preVisit(OctreeElement* element) {
+        preVisited.push_back(element);
+        return OCTREE_VISIT_CHILDREN;
+    }
+    void postVisit(OctreeElement* element) { postVisited.push_back(element); }
+
+    std::vector<OctreeElement*> preVisited;
+    std::vector<OctreeElement*> postVisited;
+};
+
+void OctreeTraversalTests::visitsInCallbackOrder() {
+    VoxelTree tree;
+    populateTree(tree);
+
+    std::vector<OctreeElement*> operated;
+    tree.recurseTreeWithOperation(collectOperation, &operated);
+    std::vector<OctreeElement*> postOperated;
+    tree.recurseTreeWithPostOperation(collectOperation, &postOperated);
+
+    CollectVisitor visitor;
+    tree.visit(visitor);
+
+    if (visitor.preVisited != operated) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: visited " << visitor.preVisited.size()
+            << " elements in a different order than the " << operated.size() << " the callback reached" << std::endl;
+    }
+    if (visitor.postVisited != postOperated) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: post visited " << visitor.postVisited.size()
+            << " elements in a different order than the " << postOperated.size() << " the post operation reached"
+            << std::endl;
+    }
+}
+
+void OctreeTraversalTests::matchesCallbackQueries() {
+    VoxelTree tree;
+    populateTree(tree);
+
+    for (int i = 0; i < NUM_TEST_QUERIES; i++) {
+        glm::vec3 origin = randomPointInTree();
+        glm::vec3 direction = randomDirection();
+
+        OctreeElement* callbackElement;
+        float callbackDistance;
+        bool callbackFound = callbackRayIntersection(tree, origin, direction, callbackElement, callbackDistance);
+
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        bool found = tree.findRayIntersection(origin, direction, element, distance, face, Octree::NoLock);
+
+        if (found != callbackFound || (found && (element != callbackElement ||
+                fabsf(distance - callbackDistance) > RAY_DISTANCE_TOLERANCE))) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: ray query " << i << " hit a different voxel than "
+                << "the callback" << std::endl;
+            return;
+        }
+
+        glm::vec3 callbackPenetration;
+        callbackFound = callbackSpherePenetration(tree, origin, TEST_SPHERE_RADIUS, callbackPenetration);
+
+        glm::vec3 penetration;
+        found = tree.findSpherePenetration(origin, TEST_SPHERE_RADIUS, penetration, NULL, Octree::NoLock);
+
+        if (found != callbackFound || penetration != callbackPenetration) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: sphere query " << i << " found a different "
+                << "penetration than the callback" << std::endl;
+            return;
+        }
+    }
+}
+
+void OctreeTraversalTests::benchmarkAgainstCallbacks() {
+    VoxelTree tree;
+    populateTree(tree);
+
+    // the same queries both ways, so that the timings differ only by the traversal
+    std::vector<glm::vec3> origins;
+    std::vector<glm::vec3> directions;
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        origins.push_back(randomPointInTree());
+        directions.push_back(randomDirection());
+    }
+
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
+    glm::vec3 penetration;
+    int hits = 0;
+
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        hits += callbackRayIntersection(tree, origins[i], directions[i], element, distance) ? 1 : 0;
+    }
+    quint64 callbackRayUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        hits += tree.findRayIntersection(origins[i], directions[i], element, distance, face, Octree::NoLock) ? 1 : 0;
+    }
+    quint64 visitorRayUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        hits += callbackSpherePenetration(tree, origins[i], TEST_SPHERE_RADIUS, penetration) ? 1 : 0;
+    }
+    quint64 callbackSphereUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        hits += tree.findSpherePenetration(origins[i], TEST_SPHERE_RADIUS, penetration, NULL, Octree::NoLock) ? 1 : 0;
+    }
+    quint64 visitorSphereUsecs = usecTimestampNow() - start;
+
+    std::cout << NUM_BENCHMARK_QUERIES << " queries of a " << NUM_TEST_VOXELS << " voxel tree, " << hits << " hits"
+        << std::endl;
+    std::cout << "  ray: callback " << callbackRayUsecs << " usecs, visitor " << visitorRayUsecs << " usecs"
+        << std::endl;
+    std::cout << "  sphere: callback " << callbackSphereUsecs << " usecs, visitor " << visitorSphereUsecs << " usecs"
+        << std::endl;
+}
+
+void OctreeTraversalTests::benchmarkFrontToBackRays() {
+    VoxelTree tree;
+    populateTree(tree);
+
+    // rays from outside the tree toward random points inside, so that most of them cross the whole tree
+    std::vector<glm::vec3> origins;
+    std::vector<glm::vec3> directions;
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        glm::vec3 direction = randomDirection();
+        origins.push_back(randomPointInTree() - direction * (float) TREE_SCALE);
+        directions.push_back(direction);
+    }
+
+    OctreeElement* element;
+    float distance;
+    int visitedCount;
+    quint64 callbackVisited = 0;
+    int callbackHits = 0;
+
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        if (callbackRayIntersection(tree, origins[i], directions[i], element, distance, &visitedCount)) {
+            callbackHits++;
+        }
+        callbackVisited += visitedCount;
+    }
+    quint64 callbackUsecs = usecTimestampNow() - start;
+
+    quint64 frontToBackVisited = 0;
+    int frontToBackHits = 0;
+
+    start = usecTimestampNow();
+    for (int i = 0; i < NUM_BENCHMARK_QUERIES; i++) {
+        OctreeRayVisitor visitor(origins[i] / (float) TREE_SCALE, directions[i]);
+        tree.visit(visitor);
+        frontToBackHits += visitor.isFound() ? 1 : 0;
+        frontToBackVisited += visitor.getVisitedCount();
+    }
+    quint64 frontToBackUsecs = usecTimestampNow() - start;
+
+    if (frontToBackHits != callbackHits) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: front to back rays hit " << frontToBackHits
+            << " times, and the callback " << callbackHits << " times" << std::endl;
+    }
+    std::cout << NUM_BENCHMARK_QUERIES << " rays across a " << NUM_TEST_VOXELS << " voxel tree, " << callbackHits
+        << " hits" << std::endl;
+    std::cout << "  callback: " << (float) callbackVisited / NUM_BENCHMARK_QUERIES << " elements a ray, "
+        << callbackUsecs << " usecs" << std::endl;
+    std::cout << "  front to back: " << (float) frontToBackVisited / NUM_BENCHMARK_QUERIES << " elements a ray, "
+        << frontToBackUsecs << " usecs" << std::endl;
+}
+
+void OctreeTraversalTests::batchesRaysLikeSingleCasts() {
+    VoxelTree tree;
+    populateTree(tree);
+
+    // the reflector's kind of batch, many rays from a few points, some of them along the axes
+    const int NUM_BATCH_ORIGINS = 50;
+    const int RAYS_PER_ORIGIN = 20;
+    std::vector<OctreeRayIntersection> rays;
+    for (int i = 0; i < NUM_BATCH_ORIGINS; i++) {
+        glm::vec3 origin = randomPointInTree();
+        for (int j = 0; j < RAYS_PER_ORIGIN; j++) {
+            OctreeRayIntersection ray;
+            ray.origin = origin;
+            ray.direction = randomDirection();
+            if (j % 5 == 0) {
+                ray.direction[j % 3] = 0.0f;
+            }
+            rays.push_back(ray);
+        }
+    }
+
+    quint64 start = usecTimestampNow();
+    tree.findRayIntersections(&rays[0], rays.size(), Octree::NoLock);
+    quint64 batchUsecs = usecTimestampNow() - start;
+
+    quint64 singleUsecs = 0;
+    for (size_t i = 0; i < rays.size(); i++) {
+        OctreeElement* element;
+        float distance;
+        BoxFace face;
+        start = usecTimestampNow();
+        bool found = tree.findRayIntersection(rays[i].origin, rays[i].direction, element, distance, face,
+                                              Octree::NoLock);
+        singleUsecs += usecTimestampNow() - start;
+
+        if (found != rays[i].intersects || (found && (element != rays[i].element || distance != rays[i].distance ||
+                face != rays[i].face))) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batched ray " << i << " hit differently than the same "
+                << "ray cast alone" << std::endl;
+            return;
+        }
+    }
+
+    std::cout << rays.size() << " rays in a batch: " << batchUsecs << " usecs, one at a time: " << singleUsecs
+        << " usecs" << std::endl;
+}
+
+void OctreeTraversalTests::runAllTests() {
+    visitsInCallbackOrder();
+    matchesCallbackQueries();
+    benchmarkAgainstCallbacks();
+    benchmarkFrontToBackRays();
+    batchesRaysLikeSingleCasts();
+}
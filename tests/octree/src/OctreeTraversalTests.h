@@ -0,0 +1,24 @@
+//
+//  OctreeTraversalTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeTraversalTests_h
+#define hifi_OctreeTraversalTests_h
+
+namespace OctreeTraversalTests {
+    void visitsInCallbackOrder();
+    void matchesCallbackQueries();
+    void benchmarkAgainstCallbacks();
+    void benchmarkFrontToBackRays();
+    void batchesRaysLikeSingleCasts();
+
+    void runAllTests();
+}
+
+#endif // hifi_OctreeTraversalTests_h
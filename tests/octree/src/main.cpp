@@ -0,0 +1,20 @@
+//
+//  main.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OctreeAllocatorTests.h"
+#include "OctreeKeyTests.h"
+#include "OctreeTraversalTests.h"
+
+int main(int argc, char** argv) {
+    OctreeAllocatorTests::runAllTests();
+    OctreeKeyTests::runAllTests();
+    OctreeTraversalTests::runAllTests();
+    return 0;
+}